@@ -8,7 +8,7 @@ using namespace wi::scene;
 void AnimationWindow::Create(EditorComponent* editor)
 {
 	wi::gui::Window::Create("Animation Window");
-	SetSize(XMFLOAT2(520, 140));
+	SetSize(XMFLOAT2(520, 160));
 
 	float x = 140;
 	float y = 0;
@@ -114,6 +114,32 @@ void AnimationWindow::Create(EditorComponent* editor)
 	speedSlider.SetTooltip("Set the animation speed.");
 	AddWidget(&speedSlider);
 
+	compressButton.Create("Compress All");
+	compressButton.SetTooltip("Compress the keyframes of all animations in the scene with key reduction and quantization.\nThis reduces memory usage, but it can't be undone. The result is written to the backlog.");
+	compressButton.SetSize(XMFLOAT2(250, hei));
+	compressButton.SetPos(XMFLOAT2(x, y += step));
+	compressButton.OnClick([&](wi::gui::EventArgs args) {
+		Scene& scene = wi::scene::GetScene();
+		size_t memory_before = 0;
+		for (size_t i = 0; i < scene.animation_datas.GetCount(); ++i)
+		{
+			memory_before += scene.animation_datas[i].GetMemorySize();
+		}
+		wi::Timer timer;
+		const size_t compressed = scene.CompressAnimations();
+		const double elapsed = timer.elapsed_milliseconds();
+		size_t memory_after = 0;
+		for (size_t i = 0; i < scene.animation_datas.GetCount(); ++i)
+		{
+			memory_after += scene.animation_datas[i].GetMemorySize();
+		}
+		wi::backlog::post(
+			"Compressed " + std::to_string(compressed) + " / " + std::to_string(scene.animation_datas.GetCount()) + " animation data in " + std::to_string(elapsed) + " ms, "
+			"keyframe memory: " + std::to_string(memory_before) + " bytes -> " + std::to_string(memory_after) + " bytes"
+		);
+	});
+	AddWidget(&compressButton);
+
 
 
 	Translate(XMFLOAT3(100, 50, 0));
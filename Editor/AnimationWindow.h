@@ -17,6 +17,7 @@ public:
 	wi::gui::Slider	timerSlider;
 	wi::gui::Slider	amountSlider;
 	wi::gui::Slider	speedSlider;
+	wi::gui::Button	compressButton;
 
 	void Update();
 };
@@ -33,6 +33,34 @@ void Editor::Initialize()
 
 	wi::renderer::SetOcclusionCullingEnabled(true);
 
+	// Headless glTF import benchmark, started with the import_benchmark=<file> command line argument:
+	//	The model is imported without starting the editor, then the import timings are logged and the application exits
+	const std::string import_benchmark = wi::arguments::GetArgumentValue("import_benchmark");
+	if (!import_benchmark.empty())
+	{
+		wi::initializer::WaitForInitializationsToFinish();
+
+		Scene scene;
+		GLTFImportStatistics stats;
+		ImportModel_GLTF(import_benchmark, scene, &stats);
+
+		std::string ss;
+		ss += "\n[Import benchmark] " + import_benchmark;
+		ss += "\n\timages: " + std::to_string(stats.image_count);
+		ss += "\n\tprimitives: " + std::to_string(stats.primitive_count);
+		ss += "\n\tvertices: " + std::to_string(stats.vertex_count);
+		ss += "\n\tindices: " + std::to_string(stats.index_count);
+		ss += "\n\tparse: " + std::to_string(stats.parse) + " ms";
+		ss += "\n\ttextures: " + std::to_string(stats.textures) + " ms";
+		ss += "\n\tmeshes: " + std::to_string(stats.meshes) + " ms";
+		ss += "\n\trender data: " + std::to_string(stats.render_data) + " ms";
+		ss += "\n\ttotal: " + std::to_string(stats.total) + " ms\n";
+		wi::backlog::post(ss);
+
+		wi::platform::Exit();
+		return;
+	}
+
 	loader.Load();
 
 	renderComponent.main = this;
@@ -375,39 +403,39 @@ void EditorComponent::Load()
 	terrainWnd_Toggle.SetTooltip("Terrain Generator");
 	terrainWnd_Toggle.OnClick([&](wi::gui::EventArgs args) {
 
-		if (terragen.terrainEntity == INVALID_ENTITY)
+		if (terragen.terrain.terrainEntity == INVALID_ENTITY)
 		{
 			// Customize terrain generator before it's initialized:
-			terragen.material_Base.SetRoughness(1);
-			terragen.material_Base.SetReflectance(0.005f);
-			terragen.material_Slope.SetRoughness(0.1f);
-			terragen.material_LowAltitude.SetRoughness(1);
-			terragen.material_HighAltitude.SetRoughness(1);
-			terragen.material_Base.textures[MaterialComponent::BASECOLORMAP].name = "terrain/base.jpg";
-			terragen.material_Base.textures[MaterialComponent::NORMALMAP].name = "terrain/base_nor.jpg";
-			terragen.material_Slope.textures[MaterialComponent::BASECOLORMAP].name = "terrain/slope.jpg";
-			terragen.material_Slope.textures[MaterialComponent::NORMALMAP].name = "terrain/slope_nor.jpg";
-			terragen.material_LowAltitude.textures[MaterialComponent::BASECOLORMAP].name = "terrain/low_altitude.jpg";
-			terragen.material_LowAltitude.textures[MaterialComponent::NORMALMAP].name = "terrain/low_altitude_nor.jpg";
-			terragen.material_HighAltitude.textures[MaterialComponent::BASECOLORMAP].name = "terrain/high_altitude.jpg";
-			terragen.material_HighAltitude.textures[MaterialComponent::NORMALMAP].name = "terrain/high_altitude_nor.jpg";
-			terragen.material_GrassParticle.textures[MaterialComponent::BASECOLORMAP].name = "terrain/grassparticle.png";
-			terragen.material_GrassParticle.alphaRef = 0.75f;
-			terragen.grass_properties.length = 5;
-			terragen.grass_properties.frameCount = 2;
-			terragen.grass_properties.framesX = 1;
-			terragen.grass_properties.framesY = 2;
-			terragen.grass_properties.frameStart = 0;
-			terragen.material_Base.CreateRenderData();
-			terragen.material_Slope.CreateRenderData();
-			terragen.material_LowAltitude.CreateRenderData();
-			terragen.material_HighAltitude.CreateRenderData();
-			terragen.material_GrassParticle.CreateRenderData();
+			terragen.terrain.material_Base.SetRoughness(1);
+			terragen.terrain.material_Base.SetReflectance(0.005f);
+			terragen.terrain.material_Slope.SetRoughness(0.1f);
+			terragen.terrain.material_LowAltitude.SetRoughness(1);
+			terragen.terrain.material_HighAltitude.SetRoughness(1);
+			terragen.terrain.material_Base.textures[MaterialComponent::BASECOLORMAP].name = "terrain/base.jpg";
+			terragen.terrain.material_Base.textures[MaterialComponent::NORMALMAP].name = "terrain/base_nor.jpg";
+			terragen.terrain.material_Slope.textures[MaterialComponent::BASECOLORMAP].name = "terrain/slope.jpg";
+			terragen.terrain.material_Slope.textures[MaterialComponent::NORMALMAP].name = "terrain/slope_nor.jpg";
+			terragen.terrain.material_LowAltitude.textures[MaterialComponent::BASECOLORMAP].name = "terrain/low_altitude.jpg";
+			terragen.terrain.material_LowAltitude.textures[MaterialComponent::NORMALMAP].name = "terrain/low_altitude_nor.jpg";
+			terragen.terrain.material_HighAltitude.textures[MaterialComponent::BASECOLORMAP].name = "terrain/high_altitude.jpg";
+			terragen.terrain.material_HighAltitude.textures[MaterialComponent::NORMALMAP].name = "terrain/high_altitude_nor.jpg";
+			terragen.terrain.material_GrassParticle.textures[MaterialComponent::BASECOLORMAP].name = "terrain/grassparticle.png";
+			terragen.terrain.material_GrassParticle.alphaRef = 0.75f;
+			terragen.terrain.grass_properties.length = 5;
+			terragen.terrain.grass_properties.frameCount = 2;
+			terragen.terrain.grass_properties.framesX = 1;
+			terragen.terrain.grass_properties.framesY = 2;
+			terragen.terrain.grass_properties.frameStart = 0;
+			terragen.terrain.material_Base.CreateRenderData();
+			terragen.terrain.material_Slope.CreateRenderData();
+			terragen.terrain.material_LowAltitude.CreateRenderData();
+			terragen.terrain.material_HighAltitude.CreateRenderData();
+			terragen.terrain.material_GrassParticle.CreateRenderData();
 			// Tree prop:
 			{
 				Scene props_scene;
 				wi::scene::LoadModel(props_scene, "terrain/tree.wiscene");
-				TerrainGenerator::Prop& prop = terragen.props.emplace_back();
+				wi::terrain::Prop& prop = terragen.terrain.props.emplace_back();
 				prop.name = "tree";
 				prop.min_count_per_chunk = 0;
 				prop.max_count_per_chunk = 10;
@@ -437,7 +465,7 @@ void EditorComponent::Load()
 			{
 				Scene props_scene;
 				wi::scene::LoadModel(props_scene, "terrain/rock.wiscene");
-				TerrainGenerator::Prop& prop = terragen.props.emplace_back();
+				wi::terrain::Prop& prop = terragen.terrain.props.emplace_back();
 				prop.name = "rock";
 				prop.min_count_per_chunk = 0;
 				prop.max_count_per_chunk = 8;
@@ -467,7 +495,7 @@ void EditorComponent::Load()
 			{
 				Scene props_scene;
 				wi::scene::LoadModel(props_scene, "terrain/bush.wiscene");
-				TerrainGenerator::Prop& prop = terragen.props.emplace_back();
+				wi::terrain::Prop& prop = terragen.terrain.props.emplace_back();
 				prop.name = "bush";
 				prop.min_count_per_chunk = 0;
 				prop.max_count_per_chunk = 10;
@@ -498,7 +526,7 @@ void EditorComponent::Load()
 		}
 
 		terragen.SetVisible(!terragen.IsVisible());
-		if (terragen.IsVisible() && !wi::scene::GetScene().transforms.Contains(terragen.terrainEntity))
+		if (terragen.IsVisible() && !wi::scene::GetScene().transforms.Contains(terragen.terrain.terrainEntity))
 		{
 			terragen.Generation_Restart();
 			RefreshSceneGraphView();
@@ -757,7 +785,7 @@ void EditorComponent::Load()
 					wi::resourcemanager::Mode embed_mode = (wi::resourcemanager::Mode)saveModeComboBox.GetItemUserData(saveModeComboBox.GetSelected());
 					wi::resourcemanager::SetMode(embed_mode);
 
-					terragen.BakeVirtualTexturesToFiles();
+					terragen.terrain.BakeVirtualTexturesToFiles();
 					scene.Serialize(archive);
 
 					if (dump_to_header)
@@ -805,18 +833,30 @@ void EditorComponent::Load()
 					{
 						Scene scene;
 						ImportModel_OBJ(fileName, scene);
+						if (meshWnd.lodImportCheckBox.GetCheck())
+						{
+							scene.GenerateMeshLODs(meshWnd.GetLODGenerationParams());
+						}
 						wi::scene::GetScene().Merge(scene);
 					}
 					else if (!extension.compare("GLTF")) // text-based gltf
 					{
 						Scene scene;
 						ImportModel_GLTF(fileName, scene);
+						if (meshWnd.lodImportCheckBox.GetCheck())
+						{
+							scene.GenerateMeshLODs(meshWnd.GetLODGenerationParams());
+						}
 						wi::scene::GetScene().Merge(scene);
 					}
 					else if (!extension.compare("GLB")) // binary gltf
 					{
 						Scene scene;
 						ImportModel_GLTF(fileName, scene);
+						if (meshWnd.lodImportCheckBox.GetCheck())
+						{
+							scene.GenerateMeshLODs(meshWnd.GetLODGenerationParams());
+						}
 						wi::scene::GetScene().Merge(scene);
 					}
 					});
@@ -882,7 +922,7 @@ void EditorComponent::Load()
 	clearButton.SetColor(wi::Color(255, 235, 173, 255), wi::gui::WIDGETSTATE::FOCUS);
 	clearButton.OnClick([&](wi::gui::EventArgs args) {
 
-		terragen.Generation_Cancel();
+		terragen.terrain.Generation_Cancel();
 		// This is to recreate the terragen from scratch, but it has implicitly deleted copy ctor so it's weird:
 		terragen.~TerrainGenerator();
 		new (&terragen) TerrainGenerator;
@@ -965,7 +1005,7 @@ void EditorComponent::Load()
 	exitButton.SetColor(wi::Color(190, 0, 0, 180), wi::gui::WIDGETSTATE::IDLE);
 	exitButton.SetColor(wi::Color(255, 0, 0, 255), wi::gui::WIDGETSTATE::FOCUS);
 	exitButton.OnClick([this](wi::gui::EventArgs args) {
-		terragen.Generation_Cancel();
+		terragen.terrain.Generation_Cancel();
 		wi::platform::Exit();
 	});
 	GetGUI().AddWidget(&exitButton);
@@ -1918,7 +1958,7 @@ void EditorComponent::Update(float dt)
 		pathTraceStatisticsLabel.SetText(ss);
 	}
 
-	terragen.Generation_Update(camera);
+	terragen.terrain.Generation_Update(camera);
 
 	wi::profiler::EndRange(profrange);
 
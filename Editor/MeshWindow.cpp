@@ -4,7 +4,7 @@
 
 #include "Utility/stb_image.h"
 
-#include "meshoptimizer/meshoptimizer.h"
+#include "Utility/meshoptimizer/meshoptimizer.h"
 
 #include <string>
 
@@ -14,7 +14,7 @@ using namespace wi::scene;
 void MeshWindow::Create(EditorComponent* editor)
 {
 	wi::gui::Window::Create("Mesh Window");
-	SetSize(XMFLOAT2(580, 380));
+	SetSize(XMFLOAT2(580, 400));
 
 	float x = 150;
 	float y = 0;
@@ -212,7 +212,7 @@ void MeshWindow::Create(EditorComponent* editor)
 	AddWidget(&flipNormalsButton);
 
 	computeNormalsSmoothButton.Create("Compute Normals [SMOOTH]");
-	computeNormalsSmoothButton.SetTooltip("Compute surface normals of the mesh. Resulting normals will be unique per vertex. This can reduce vertex count, but is slow.");
+	computeNormalsSmoothButton.SetTooltip("Compute surface normals of the mesh. Resulting normals will be unique per vertex. This can reduce vertex count.");
 	computeNormalsSmoothButton.SetSize(XMFLOAT2(200, hei));
 	computeNormalsSmoothButton.SetPos(XMFLOAT2(x - 50, y += step));
 	computeNormalsSmoothButton.OnClick([&](wi::gui::EventArgs args) {
@@ -541,103 +541,7 @@ void MeshWindow::Create(EditorComponent* editor)
 		MeshComponent* mesh = wi::scene::GetScene().meshes.GetComponent(entity);
 		if (mesh != nullptr)
 		{
-			if (mesh->subsets_per_lod == 0)
-			{
-				// if there were no lods before, record the subset count without lods:
-				mesh->subsets_per_lod = (uint32_t)mesh->subsets.size();
-			}
-
-			// https://github.com/zeux/meshoptimizer/blob/bedaaaf6e710d3b42d49260ca738c15d171b1a8f/demo/main.cpp
-			size_t index_count = mesh->indices.size();
-			size_t vertex_count = mesh->vertex_positions.size();
-
-			const size_t lod_count = (size_t)lodCountSlider.GetValue();
-			struct LOD
-			{
-				struct Subset
-				{
-					wi::vector<uint32_t> indices;
-				};
-				wi::vector<Subset> subsets;
-			};
-			wi::vector<LOD> lods(lod_count);
-
-			const float target_error = lodErrorSlider.GetValue();
-
-			for (size_t i = 0; i < lod_count; ++i)
-			{
-				lods[i].subsets.resize(mesh->subsets_per_lod);
-				for (uint32_t subsetIndex = 0; subsetIndex < mesh->subsets_per_lod; ++subsetIndex)
-				{
-					const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
-					lods[i].subsets[subsetIndex].indices.resize(subset.indexCount);
-					for (uint32_t ind = 0; ind < subset.indexCount; ++ind)
-					{
-						lods[i].subsets[subsetIndex].indices[ind] = mesh->indices[subset.indexOffset + ind];
-					}
-				}
-			}
-
-			for (uint32_t subsetIndex = 0; subsetIndex < mesh->subsets_per_lod; ++subsetIndex)
-			{
-				const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
-
-				float threshold = wi::math::Lerp(0, 0.9f, wi::math::saturate(lodQualitySlider.GetValue()));
-				for (size_t i = 1; i < lod_count; ++i)
-				{
-					wi::vector<unsigned int>& lod = lods[i].subsets[subsetIndex].indices;
-
-					size_t target_index_count = size_t(mesh->indices.size() * threshold) / 3 * 3;
-
-					// we can simplify all the way from base level or from the last result
-					// simplifying from the base level sometimes produces better results, but simplifying from last level is faster
-					//const wi::vector<unsigned int>& source = lods[0].subsets[subsetIndex].indices;
-					const wi::vector<unsigned int>& source = lods[i - 1].subsets[subsetIndex].indices;
-
-					if (source.size() < target_index_count)
-						target_index_count = source.size();
-
-					lod.resize(source.size());
-					if (lodSloppyCheckBox.GetCheck())
-					{
-						lod.resize(meshopt_simplifySloppy(&lod[0], &source[0], source.size(), &mesh->vertex_positions[0].x, mesh->vertex_positions.size(), sizeof(XMFLOAT3), target_index_count, target_error));
-					}
-					else
-					{
-						lod.resize(meshopt_simplify(&lod[0], &source[0], source.size(), &mesh->vertex_positions[0].x, mesh->vertex_positions.size(), sizeof(XMFLOAT3), target_index_count, target_error));
-					}
-
-					threshold *= threshold;
-				}
-
-				// optimize each individual LOD for vertex cache & overdraw
-				for (size_t i = 0; i < lod_count; ++i)
-				{
-					wi::vector<unsigned int>& lod = lods[i].subsets[subsetIndex].indices;
-
-					meshopt_optimizeVertexCache(&lod[0], &lod[0], lod.size(), mesh->vertex_positions.size());
-					meshopt_optimizeOverdraw(&lod[0], &lod[0], lod.size(), &mesh->vertex_positions[0].x, mesh->vertex_positions.size(), sizeof(XMFLOAT3), 1.0f);
-				}
-			}
-
-			mesh->indices.clear();
-			wi::vector<MeshComponent::MeshSubset> subsets;
-			for (size_t i = 0; i < lod_count; ++i)
-			{
-				for (uint32_t subsetIndex = 0; subsetIndex < mesh->subsets_per_lod; ++subsetIndex)
-				{
-					const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
-					subsets.emplace_back();
-					subsets.back() = subset;
-					subsets.back().indexOffset = (uint32_t)mesh->indices.size();
-					subsets.back().indexCount = (uint32_t)lods[i].subsets[subsetIndex].indices.size();
-					for (auto& x : lods[i].subsets[subsetIndex].indices)
-					{
-						mesh->indices.push_back(x);
-					}
-				}
-			}
-			mesh->subsets = subsets;
+			mesh->GenerateLODs(GetLODGenerationParams());
 
 			mesh->CreateRenderData();
 			SetEntity(entity, subset);
@@ -652,13 +556,13 @@ void MeshWindow::Create(EditorComponent* editor)
 	AddWidget(&lodCountSlider);
 
 	lodQualitySlider.Create(0.1f, 1.0f, 0.5f, 10000, "LOD Quality: ");
-	lodQualitySlider.SetTooltip("Lower values will make LODs more agressively simplified.");
+	lodQualitySlider.SetTooltip("The index count of every LOD compared to the previous one. Lower values will make LODs more agressively simplified.");
 	lodQualitySlider.SetSize(XMFLOAT2(100, hei));
 	lodQualitySlider.SetPos(XMFLOAT2(x + 280, y += step));
 	AddWidget(&lodQualitySlider);
 
 	lodErrorSlider.Create(0.01f, 0.1f, 0.03f, 10000, "LOD Error: ");
-	lodErrorSlider.SetTooltip("Lower values will make more precise levels of detail.");
+	lodErrorSlider.SetTooltip("The allowed simplification error of the first LOD relative to the mesh size, it doubles with every further LOD. Lower values will make more precise levels of detail.");
 	lodErrorSlider.SetSize(XMFLOAT2(100, hei));
 	lodErrorSlider.SetPos(XMFLOAT2(x + 280, y += step));
 	AddWidget(&lodErrorSlider);
@@ -669,12 +573,28 @@ void MeshWindow::Create(EditorComponent* editor)
 	lodSloppyCheckBox.SetPos(XMFLOAT2(x + 280, y += step));
 	AddWidget(&lodSloppyCheckBox);
 
+	lodImportCheckBox.Create("LOD on import: ");
+	lodImportCheckBox.SetTooltip("Generate LODs with the above settings for the meshes of imported models (OBJ, GLTF) that don't have LODs.");
+	lodImportCheckBox.SetSize(XMFLOAT2(hei, hei));
+	lodImportCheckBox.SetPos(XMFLOAT2(x + 280, y += step));
+	AddWidget(&lodImportCheckBox);
+
 	Translate(XMFLOAT3((float)editor->GetLogicalWidth() - 1000, 80, 0));
 	SetVisible(false);
 
 	SetEntity(INVALID_ENTITY, -1);
 }
 
+MeshComponent::LODGenerationParams MeshWindow::GetLODGenerationParams() const
+{
+	MeshComponent::LODGenerationParams params;
+	params.lod_count = (uint32_t)lodCountSlider.GetValue();
+	params.reduction = lodQualitySlider.GetValue();
+	params.target_error = lodErrorSlider.GetValue();
+	params.sloppy = lodSloppyCheckBox.GetCheck();
+	return params;
+}
+
 void MeshWindow::SetEntity(Entity entity, int subset)
 {
 	subset = std::max(0, subset);
@@ -695,6 +615,15 @@ void MeshWindow::SetEntity(Entity entity, int subset)
 		ss += "Vertex count: " + std::to_string(mesh->vertex_positions.size()) + "\n";
 		ss += "Index count: " + std::to_string(mesh->indices.size()) + "\n";
 		ss += "Subset count: " + std::to_string(mesh->subsets.size()) + " (" + std::to_string(mesh->GetLODCount()) + " LODs)\n";
+		if (!mesh->lod_errors.empty())
+		{
+			ss += "LOD errors: ";
+			for (float error : mesh->lod_errors)
+			{
+				ss += std::to_string(error) + "; ";
+			}
+			ss += "\n";
+		}
 		ss += "GPU memory: " + std::to_string((mesh->generalBuffer.GetDesc().size + mesh->streamoutBuffer.GetDesc().size) / 1024.0f / 1024.0f) + " MB\n";
 		ss += "\nVertex buffers: ";
 		if (mesh->vb_pos_nor_wind.IsValid()) ss += "position; ";
@@ -40,5 +40,9 @@ public:
 	wi::gui::Slider lodQualitySlider;
 	wi::gui::Slider lodErrorSlider;
 	wi::gui::CheckBox lodSloppyCheckBox;
+	wi::gui::CheckBox lodImportCheckBox;
+
+	// LOD generation settings from the LOD sliders
+	wi::scene::MeshComponent::LODGenerationParams GetLODGenerationParams() const;
 };
 
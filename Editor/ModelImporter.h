@@ -6,6 +6,20 @@ namespace wi::scene
 	struct Scene;
 }
 
+// Timings of the last glTF import phases in milliseconds
+struct GLTFImportStatistics
+{
+	double parse = 0; // json and buffer parsing
+	double textures = 0; // image decoding and texture creation
+	double meshes = 0; // index and vertex attribute conversion
+	double render_data = 0; // mesh GPU buffer creation
+	double total = 0;
+	size_t image_count = 0;
+	size_t primitive_count = 0;
+	size_t vertex_count = 0;
+	size_t index_count = 0;
+};
+
 void ImportModel_OBJ(const std::string& fileName, wi::scene::Scene& scene);
-void ImportModel_GLTF(const std::string& fileName, wi::scene::Scene& scene);
+void ImportModel_GLTF(const std::string& fileName, wi::scene::Scene& scene, GLTFImportStatistics* statistics = nullptr);
 
@@ -8,6 +8,7 @@
 #include <string>
 #include <limits>
 #include <fstream>
+#include <cstring>
 
 #define TINYGLTF_IMPLEMENTATION
 #define TINYGLTF_NO_FS
@@ -89,12 +90,37 @@ namespace tinygltf
 		return wi::helper::FileWrite(filepath, contents.data(), contents.size());
 	}
 
+	// Images are only gathered while parsing, the texture creation is done afterwards on multiple threads:
+	struct ImageLoader
+	{
+		struct PendingImage
+		{
+			int image_idx = -1;
+			std::string name;
+			wi::vector<uint8_t> filedata;
+			wi::Resource resource;
+		};
+		wi::vector<PendingImage> images;
+
+		bool Contains(const std::string& name) const
+		{
+			for (auto& x : images)
+			{
+				if (x.name == name)
+					return true;
+			}
+			return false;
+		}
+	};
+
 	bool LoadImageData(Image *image, const int image_idx, std::string *err,
 		std::string *warn, int req_width, int req_height,
 		const unsigned char *bytes, int size, void *userdata)
 	{
 		(void)warn;
 
+		ImageLoader* imageLoader = (ImageLoader*)userdata;
+
 		if (image->uri.empty())
 		{
 			// Force some image resource name:
@@ -102,28 +128,16 @@ namespace tinygltf
 			do {
 				ss.clear();
 				ss += "gltfimport_" + std::to_string(wi::random::GetRandom(std::numeric_limits<int>::max())) + ".png";
-			} while (wi::resourcemanager::Contains(ss)); // this is to avoid overwriting an existing imported image
+			} while (wi::resourcemanager::Contains(ss) || imageLoader->Contains(ss)); // this is to avoid overwriting an existing imported image
 			image->uri = ss;
 		}
 
-		auto resource = wi::resourcemanager::Load(
-			image->uri,
-			wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA,
-			(const uint8_t*)bytes,
-			(size_t)size
-		);
-
-		if (!resource.IsValid())
-		{
-			return false;
-		}
-
-		image->width = resource.GetTexture().desc.width;
-		image->height = resource.GetTexture().desc.height;
-		image->component = 4;
-
-		wi::resourcemanager::ResourceSerializer* seri = (wi::resourcemanager::ResourceSerializer*)userdata;
-		seri->resources.push_back(resource);
+		// The bytes are only valid within this callback, so they are copied:
+		ImageLoader::PendingImage& pending = imageLoader->images.emplace_back();
+		pending.image_idx = image_idx;
+		pending.name = image->uri;
+		pending.filedata.resize((size_t)size);
+		std::memcpy(pending.filedata.data(), bytes, (size_t)size);
 
 		return true;
 	}
@@ -259,8 +273,337 @@ void LoadNode(int nodeIndex, Entity parent, LoaderState& state)
 	}
 }
 
-void ImportModel_GLTF(const std::string& fileName, Scene& scene)
+// Mesh primitive that will be converted into the mesh arrays, which are already sized up to hold it
+struct PrimitiveConversion
+{
+	static constexpr uint32_t chunk_vertices = 64 * 1024; // vertices per conversion job
+	static constexpr uint32_t chunk_indices = chunk_vertices * 3; // indices per conversion job
+
+	Entity meshEntity = INVALID_ENTITY;
+	MeshComponent* mesh = nullptr; // resolved after all meshes are created
+	const tinygltf::Primitive* prim = nullptr;
+	uint32_t indexOffset = 0;
+	uint32_t indexCount = 0;
+	uint32_t vertexOffset = 0;
+	uint32_t vertexCount = 0; // the most elements of any attribute of the primitive
+};
+
+template<typename T>
+static void GrowAttribute(wi::vector<T>& attribute, size_t size)
+{
+	if (attribute.size() < size)
+	{
+		attribute.resize(size);
+	}
+}
+
+// Copies accessor elements [begin, end) into a tightly packed array, with one bulk copy if the source is also tightly packed
+template<typename T>
+static void CopyAccessorData(T* dst, const uint8_t* src, size_t stride, size_t begin, size_t end)
+{
+	if (begin >= end)
+		return;
+	if (stride == sizeof(T))
+	{
+		std::memcpy(dst + begin, src + begin * sizeof(T), (end - begin) * sizeof(T));
+		return;
+	}
+	for (size_t i = begin; i < end; ++i)
+	{
+		std::memcpy(dst + i, src + i * stride, sizeof(T));
+	}
+}
+
+// Reads a normalized unsigned integer component as float in [0, 1] range
+template<typename T>
+static float ReadNormalized(const uint8_t* src)
+{
+	T value;
+	std::memcpy(&value, src, sizeof(T));
+	return float(value) / float(std::numeric_limits<T>::max());
+}
+
+template<typename T>
+static uint32_t ReadUint(const uint8_t* src)
+{
+	T value;
+	std::memcpy(&value, src, sizeof(T));
+	return uint32_t(value);
+}
+
+// Converts one chunk of indices and vertex attributes of the primitive, chunks don't overlap so they can run in parallel
+static void ConvertPrimitive(const tinygltf::Model& model, const PrimitiveConversion& conversion, uint32_t chunk)
+{
+	MeshComponent& mesh = *conversion.mesh;
+	const tinygltf::Primitive& prim = *conversion.prim;
+
+	// Fill indices:
+	{
+		const tinygltf::Accessor& accessor = model.accessors[prim.indices];
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+
+		const int stride = accessor.ByteStride(bufferView);
+		const size_t begin = std::min(size_t(chunk) * PrimitiveConversion::chunk_indices, accessor.count);
+		const size_t end = std::min(begin + PrimitiveConversion::chunk_indices, accessor.count);
+		const uint8_t* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+		uint32_t* indices = mesh.indices.data() + conversion.indexOffset;
+		const uint32_t vertexOffset = conversion.vertexOffset;
+
+		int index_remap[3];
+		if (transform_to_LH)
+		{
+			index_remap[0] = 0;
+			index_remap[1] = 1;
+			index_remap[2] = 2;
+		}
+		else
+		{
+			index_remap[0] = 0;
+			index_remap[1] = 2;
+			index_remap[2] = 1;
+		}
+
+		if (stride == 1)
+		{
+			for (size_t i = begin; i + 2 < end; i += 3)
+			{
+				indices[i + 0] = vertexOffset + data[i + index_remap[0]];
+				indices[i + 1] = vertexOffset + data[i + index_remap[1]];
+				indices[i + 2] = vertexOffset + data[i + index_remap[2]];
+			}
+		}
+		else if (stride == 2)
+		{
+			for (size_t i = begin; i + 2 < end; i += 3)
+			{
+				indices[i + 0] = vertexOffset + ReadUint<uint16_t>(data + (i + index_remap[0]) * sizeof(uint16_t));
+				indices[i + 1] = vertexOffset + ReadUint<uint16_t>(data + (i + index_remap[1]) * sizeof(uint16_t));
+				indices[i + 2] = vertexOffset + ReadUint<uint16_t>(data + (i + index_remap[2]) * sizeof(uint16_t));
+			}
+		}
+		else if (stride == 4)
+		{
+			if (index_remap[1] == 1)
+			{
+				// Winding order is kept, so this is a bulk copy:
+				CopyAccessorData(indices, data, sizeof(uint32_t), begin, end);
+				if (vertexOffset > 0)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						indices[i] += vertexOffset;
+					}
+				}
+			}
+			else
+			{
+				for (size_t i = begin; i + 2 < end; i += 3)
+				{
+					indices[i + 0] = vertexOffset + ReadUint<uint32_t>(data + (i + index_remap[0]) * sizeof(uint32_t));
+					indices[i + 1] = vertexOffset + ReadUint<uint32_t>(data + (i + index_remap[1]) * sizeof(uint32_t));
+					indices[i + 2] = vertexOffset + ReadUint<uint32_t>(data + (i + index_remap[2]) * sizeof(uint32_t));
+				}
+			}
+		}
+		else
+		{
+			assert(0 && "unsupported index stride!");
+		}
+	}
+
+	const size_t vertexBegin = size_t(chunk) * PrimitiveConversion::chunk_vertices;
+	const size_t vertexOffset = conversion.vertexOffset;
+
+	for (auto& attr : prim.attributes)
+	{
+		const std::string& attr_name = attr.first;
+		int attr_data = attr.second;
+
+		const tinygltf::Accessor& accessor = model.accessors[attr_data];
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+
+		const size_t stride = (size_t)accessor.ByteStride(bufferView);
+		const size_t begin = std::min(vertexBegin, accessor.count);
+		const size_t end = std::min(vertexBegin + PrimitiveConversion::chunk_vertices, accessor.count);
+		if (begin >= end)
+			continue;
+
+		const uint8_t* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+
+		if (!attr_name.compare("POSITION"))
+		{
+			CopyAccessorData(mesh.vertex_positions.data() + vertexOffset, data, stride, begin, end);
+		}
+		else if (!attr_name.compare("NORMAL"))
+		{
+			CopyAccessorData(mesh.vertex_normals.data() + vertexOffset, data, stride, begin, end);
+		}
+		else if (!attr_name.compare("TANGENT"))
+		{
+			CopyAccessorData(mesh.vertex_tangents.data() + vertexOffset, data, stride, begin, end);
+		}
+		else if (!attr_name.compare("TEXCOORD_0") || !attr_name.compare("TEXCOORD_1"))
+		{
+			XMFLOAT2* uvset = (!attr_name.compare("TEXCOORD_0") ? mesh.vertex_uvset_0.data() : mesh.vertex_uvset_1.data()) + vertexOffset;
+			if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+			{
+				CopyAccessorData(uvset, data, stride, begin, end);
+			}
+			else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					uvset[i].x = ReadNormalized<uint8_t>(data + i * stride + 0);
+					uvset[i].y = ReadNormalized<uint8_t>(data + i * stride + 1);
+				}
+			}
+			else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					uvset[i].x = ReadNormalized<uint16_t>(data + i * stride + 0 * sizeof(uint16_t));
+					uvset[i].y = ReadNormalized<uint16_t>(data + i * stride + 1 * sizeof(uint16_t));
+				}
+			}
+		}
+		else if (!attr_name.compare("JOINTS_0"))
+		{
+			XMUINT4* boneindices = mesh.vertex_boneindices.data() + vertexOffset;
+			if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					boneindices[i].x = ReadUint<uint8_t>(data + i * stride + 0);
+					boneindices[i].y = ReadUint<uint8_t>(data + i * stride + 1);
+					boneindices[i].z = ReadUint<uint8_t>(data + i * stride + 2);
+					boneindices[i].w = ReadUint<uint8_t>(data + i * stride + 3);
+				}
+			}
+			else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					boneindices[i].x = ReadUint<uint16_t>(data + i * stride + 0 * sizeof(uint16_t));
+					boneindices[i].y = ReadUint<uint16_t>(data + i * stride + 1 * sizeof(uint16_t));
+					boneindices[i].z = ReadUint<uint16_t>(data + i * stride + 2 * sizeof(uint16_t));
+					boneindices[i].w = ReadUint<uint16_t>(data + i * stride + 3 * sizeof(uint16_t));
+				}
+			}
+			else
+			{
+				assert(0);
+			}
+		}
+		else if (!attr_name.compare("WEIGHTS_0"))
+		{
+			XMFLOAT4* boneweights = mesh.vertex_boneweights.data() + vertexOffset;
+			if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+			{
+				CopyAccessorData(boneweights, data, stride, begin, end);
+			}
+			else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					boneweights[i].x = ReadNormalized<uint8_t>(data + i * stride + 0);
+					boneweights[i].y = ReadNormalized<uint8_t>(data + i * stride + 1);
+					boneweights[i].z = ReadNormalized<uint8_t>(data + i * stride + 2);
+					boneweights[i].w = ReadNormalized<uint8_t>(data + i * stride + 3);
+				}
+			}
+			else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					boneweights[i].x = ReadNormalized<uint16_t>(data + i * stride + 0 * sizeof(uint16_t));
+					boneweights[i].y = ReadNormalized<uint16_t>(data + i * stride + 1 * sizeof(uint16_t));
+					boneweights[i].z = ReadNormalized<uint16_t>(data + i * stride + 2 * sizeof(uint16_t));
+					boneweights[i].w = ReadNormalized<uint16_t>(data + i * stride + 3 * sizeof(uint16_t));
+				}
+			}
+		}
+		else if (!attr_name.compare("COLOR_0"))
+		{
+			uint32_t* colors = mesh.vertex_colors.data() + vertexOffset;
+			const bool has_alpha = accessor.type == TINYGLTF_TYPE_VEC4;
+			if (accessor.type != TINYGLTF_TYPE_VEC3 && !has_alpha)
+				continue;
+			if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					XMFLOAT4 color = XMFLOAT4(1, 1, 1, 1);
+					std::memcpy(&color, data + i * stride, has_alpha ? sizeof(XMFLOAT4) : sizeof(XMFLOAT3));
+					colors[i] = has_alpha ? wi::math::CompressColor(color) : wi::math::CompressColor(XMFLOAT3(color.x, color.y, color.z));
+				}
+			}
+			else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const uint8_t* rgba = data + i * stride;
+					colors[i] = wi::Color(rgba[0], rgba[1], rgba[2], has_alpha ? rgba[3] : 0xFF);
+				}
+			}
+			else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const uint8_t* rgba = data + i * stride;
+					const float r = ReadNormalized<uint16_t>(rgba + 0 * sizeof(uint16_t));
+					const float g = ReadNormalized<uint16_t>(rgba + 1 * sizeof(uint16_t));
+					const float b = ReadNormalized<uint16_t>(rgba + 2 * sizeof(uint16_t));
+					if (has_alpha)
+					{
+						const float a = ReadNormalized<uint16_t>(rgba + 3 * sizeof(uint16_t));
+						colors[i] = wi::math::CompressColor(XMFLOAT4(r, g, b, a));
+					}
+					else
+					{
+						colors[i] = wi::math::CompressColor(XMFLOAT3(r, g, b));
+					}
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < std::min(mesh.targets.size(), prim.targets.size()); i++)
+	{
+		for (auto& attr : prim.targets[i])
+		{
+			const std::string& attr_name = attr.first;
+			int attr_data = attr.second;
+
+			const tinygltf::Accessor& accessor = model.accessors[attr_data];
+			const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+
+			const size_t stride = (size_t)accessor.ByteStride(bufferView);
+			const size_t begin = std::min(vertexBegin, accessor.count);
+			const size_t end = std::min(vertexBegin + PrimitiveConversion::chunk_vertices, accessor.count);
+
+			const uint8_t* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+
+			if (!attr_name.compare("POSITION"))
+			{
+				CopyAccessorData(mesh.targets[i].vertex_positions.data() + vertexOffset, data, stride, begin, end);
+			}
+			else if (!attr_name.compare("NORMAL"))
+			{
+				CopyAccessorData(mesh.targets[i].vertex_normals.data() + vertexOffset, data, stride, begin, end);
+			}
+		}
+	}
+}
+
+void ImportModel_GLTF(const std::string& fileName, Scene& scene, GLTFImportStatistics* statistics)
 {
+	wi::Timer timer;
+	wi::Timer total_timer;
+	GLTFImportStatistics stats;
+
 	std::string directory = wi::helper::GetDirectoryFromPath(fileName);
 	std::string name = wi::helper::GetFileNameFromPath(fileName);
 	std::string extension = wi::helper::toUpper(wi::helper::GetExtensionFromFileName(name));
@@ -279,7 +622,8 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	loader.SetFsCallbacks(callbacks);
 
 	wi::resourcemanager::ResourceSerializer seri; // keep this alive to not delete loaded images while importing gltf
-	loader.SetImageLoader(tinygltf::LoadImageData, &seri);
+	tinygltf::ImageLoader imageLoader;
+	loader.SetImageLoader(tinygltf::LoadImageData, &imageLoader);
 	loader.SetImageWriter(tinygltf::WriteImageData, nullptr);
 	
 	LoaderState state;
@@ -313,6 +657,39 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	if (!ret) {
 		wi::helper::messageBox(err, "GLTF error!");
 	}
+	stats.parse = timer.elapsed_milliseconds();
+	timer.record();
+
+	// Create textures in parallel, the material textures will then be found by name in the resource manager:
+	wi::jobsystem::context ctx;
+	wi::jobsystem::Dispatch(ctx, (uint32_t)imageLoader.images.size(), 1, [&](wi::jobsystem::JobArgs args) {
+		tinygltf::ImageLoader::PendingImage& pending = imageLoader.images[args.jobIndex];
+		pending.resource = wi::resourcemanager::Load(
+			pending.name,
+			wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA,
+			pending.filedata.data(),
+			pending.filedata.size()
+		);
+		pending.filedata.clear();
+		pending.filedata.shrink_to_fit();
+	});
+	wi::jobsystem::Wait(ctx);
+	for (auto& pending : imageLoader.images)
+	{
+		if (!pending.resource.IsValid())
+		{
+			wi::backlog::post("[ImportModel_GLTF] failed to load image: " + pending.name, wi::backlog::LogLevel::Warning);
+			continue;
+		}
+		tinygltf::Image& image = state.gltfModel.images[pending.image_idx];
+		image.width = pending.resource.GetTexture().desc.width;
+		image.height = pending.resource.GetTexture().desc.height;
+		image.component = 4;
+		seri.resources.push_back(pending.resource);
+	}
+	stats.image_count = imageLoader.images.size();
+	stats.textures = timer.elapsed_milliseconds();
+	timer.record();
 
 	Entity rootEntity = CreateEntity();
 	scene.transforms.Create(rootEntity);
@@ -761,11 +1138,16 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	}
 
 	// Create meshes:
+	//	The entities, subsets and attribute array sizes are set up serially,
+	//	then the primitives are converted in parallel, each into its own range of the mesh arrays
+	wi::vector<Entity> meshEntities;
+	wi::vector<PrimitiveConversion> conversions;
 	for (auto& x : state.gltfModel.meshes)
 	{
 		Entity meshEntity = scene.Entity_CreateMesh(x.name);
 		scene.Component_Attach(meshEntity, rootEntity);
 		MeshComponent& mesh = *scene.meshes.GetComponent(meshEntity);
+		meshEntities.push_back(meshEntity);
 
 		mesh.targets.resize(x.weights.size());
 		for (size_t i = 0; i < mesh.targets.size(); i++)
@@ -777,395 +1159,131 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 		{
 			assert(prim.indices >= 0);
 
-			// Fill indices:
 			const tinygltf::Accessor& accessor = state.gltfModel.accessors[prim.indices];
-			const tinygltf::BufferView& bufferView = state.gltfModel.bufferViews[accessor.bufferView];
-			const tinygltf::Buffer& buffer = state.gltfModel.buffers[bufferView.buffer];
 
-			int stride = accessor.ByteStride(bufferView);
-			size_t indexCount = accessor.count;
-			size_t indexOffset = mesh.indices.size();
-			mesh.indices.resize(indexOffset + indexCount);
+			PrimitiveConversion& conversion = conversions.emplace_back();
+			conversion.meshEntity = meshEntity;
+			conversion.prim = &prim;
+			conversion.indexOffset = (uint32_t)mesh.indices.size();
+			conversion.indexCount = (uint32_t)accessor.count;
+			conversion.vertexOffset = (uint32_t)mesh.vertex_positions.size();
+			mesh.indices.resize(conversion.indexOffset + conversion.indexCount);
 
 			mesh.subsets.push_back(MeshComponent::MeshSubset());
-			mesh.subsets.back().indexOffset = (uint32_t)indexOffset;
-			mesh.subsets.back().indexCount = (uint32_t)indexCount;
+			mesh.subsets.back().indexOffset = conversion.indexOffset;
+			mesh.subsets.back().indexCount = conversion.indexCount;
 
 			mesh.subsets.back().materialID = scene.materials.GetEntity(std::max(0, prim.material));
 			MaterialComponent* material = scene.materials.GetComponent(mesh.subsets.back().materialID);
 
-			uint32_t vertexOffset = (uint32_t)mesh.vertex_positions.size();
-
-			const unsigned char* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
-
-			int index_remap[3];
-			if (transform_to_LH)
-			{
-				index_remap[0] = 0;
-				index_remap[1] = 1;
-				index_remap[2] = 2;
-			}
-			else
-			{
-				index_remap[0] = 0;
-				index_remap[1] = 2;
-				index_remap[2] = 1;
-			}
-
-			if (stride == 1)
-			{
-				for (size_t i = 0; i < indexCount; i += 3)
-				{
-					mesh.indices[indexOffset + i + 0] = vertexOffset + data[i + index_remap[0]];
-					mesh.indices[indexOffset + i + 1] = vertexOffset + data[i + index_remap[1]];
-					mesh.indices[indexOffset + i + 2] = vertexOffset + data[i + index_remap[2]];
-				}
-			}
-			else if (stride == 2)
-			{
-				for (size_t i = 0; i < indexCount; i += 3)
-				{
-					mesh.indices[indexOffset + i + 0] = vertexOffset + ((uint16_t*)data)[i + index_remap[0]];
-					mesh.indices[indexOffset + i + 1] = vertexOffset + ((uint16_t*)data)[i + index_remap[1]];
-					mesh.indices[indexOffset + i + 2] = vertexOffset + ((uint16_t*)data)[i + index_remap[2]];
-				}
-			}
-			else if (stride == 4)
-			{
-				for (size_t i = 0; i < indexCount; i += 3)
-				{
-					mesh.indices[indexOffset + i + 0] = vertexOffset + ((uint32_t*)data)[i + index_remap[0]];
-					mesh.indices[indexOffset + i + 1] = vertexOffset + ((uint32_t*)data)[i + index_remap[1]];
-					mesh.indices[indexOffset + i + 2] = vertexOffset + ((uint32_t*)data)[i + index_remap[2]];
-				}
-			}
-			else
-			{
-				assert(0 && "unsupported index stride!");
-			}
-
 			for (auto& attr : prim.attributes)
 			{
 				const std::string& attr_name = attr.first;
-				int attr_data = attr.second;
-
-				const tinygltf::Accessor& accessor = state.gltfModel.accessors[attr_data];
-				const tinygltf::BufferView& bufferView = state.gltfModel.bufferViews[accessor.bufferView];
-				const tinygltf::Buffer& buffer = state.gltfModel.buffers[bufferView.buffer];
-
-				int stride = accessor.ByteStride(bufferView);
-				size_t vertexCount = accessor.count;
-
-				const unsigned char* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+				const size_t vertexCount = state.gltfModel.accessors[attr.second].count;
+				const size_t required = conversion.vertexOffset + vertexCount;
+				conversion.vertexCount = std::max(conversion.vertexCount, (uint32_t)vertexCount);
 
 				if (!attr_name.compare("POSITION"))
 				{
-					mesh.vertex_positions.resize(vertexOffset + vertexCount);
-					for (size_t i = 0; i < vertexCount; ++i)
-					{
-						mesh.vertex_positions[vertexOffset + i] = *(XMFLOAT3*)((size_t)data + i * stride);
-					}
+					GrowAttribute(mesh.vertex_positions, required);
 				}
 				else if (!attr_name.compare("NORMAL"))
 				{
-					mesh.vertex_normals.resize(vertexOffset + vertexCount);
-					for (size_t i = 0; i < vertexCount; ++i)
-					{
-						mesh.vertex_normals[vertexOffset + i] = *(XMFLOAT3*)((size_t)data + i * stride);
-					}
+					GrowAttribute(mesh.vertex_normals, required);
 				}
 				else if (!attr_name.compare("TANGENT"))
 				{
-					mesh.vertex_tangents.resize(vertexOffset + vertexCount);
-					for (size_t i = 0; i < vertexCount; ++i)
-					{
-						mesh.vertex_tangents[vertexOffset + i] = *(XMFLOAT4*)((size_t)data + i * stride);
-					}
+					GrowAttribute(mesh.vertex_tangents, required);
 				}
 				else if (!attr_name.compare("TEXCOORD_0"))
 				{
-					mesh.vertex_uvset_0.resize(vertexOffset + vertexCount);
-					if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const XMFLOAT2& tex = *(XMFLOAT2*)((size_t)data + i * stride);
-
-							mesh.vertex_uvset_0[vertexOffset + i].x = tex.x;
-							mesh.vertex_uvset_0[vertexOffset + i].y = tex.y;
-						}
-					}
-					else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const uint8_t& s = *(uint8_t*)((size_t)data + i * stride + 0);
-							const uint8_t& t = *(uint8_t*)((size_t)data + i * stride + 1);
-
-							mesh.vertex_uvset_0[vertexOffset + i].x = s / 255.0f;
-							mesh.vertex_uvset_0[vertexOffset + i].y = t / 255.0f;
-						}
-					}
-					else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const uint16_t& s = *(uint16_t*)((size_t)data + i * stride + 0 * sizeof(uint16_t));
-							const uint16_t& t = *(uint16_t*)((size_t)data + i * stride + 1 * sizeof(uint16_t));
-
-							mesh.vertex_uvset_0[vertexOffset + i].x = s / 65535.0f;
-							mesh.vertex_uvset_0[vertexOffset + i].y = t / 65535.0f;
-						}
-					}
+					GrowAttribute(mesh.vertex_uvset_0, required);
 				}
 				else if (!attr_name.compare("TEXCOORD_1"))
 				{
-					mesh.vertex_uvset_1.resize(vertexOffset + vertexCount);
-					if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const XMFLOAT2& tex = *(XMFLOAT2*)((size_t)data + i * stride);
-
-							mesh.vertex_uvset_1[vertexOffset + i].x = tex.x;
-							mesh.vertex_uvset_1[vertexOffset + i].y = tex.y;
-						}
-					}
-					else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const uint8_t& s = *(uint8_t*)((size_t)data + i * stride + 0);
-							const uint8_t& t = *(uint8_t*)((size_t)data + i * stride + 1);
-
-							mesh.vertex_uvset_1[vertexOffset + i].x = s / 255.0f;
-							mesh.vertex_uvset_1[vertexOffset + i].y = t / 255.0f;
-						}
-					}
-					else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const uint16_t& s = *(uint16_t*)((size_t)data + i * stride + 0 * sizeof(uint16_t));
-							const uint16_t& t = *(uint16_t*)((size_t)data + i * stride + 1 * sizeof(uint16_t));
-
-							mesh.vertex_uvset_1[vertexOffset + i].x = s / 65535.0f;
-							mesh.vertex_uvset_1[vertexOffset + i].y = t / 65535.0f;
-						}
-					}
+					GrowAttribute(mesh.vertex_uvset_1, required);
 				}
 				else if (!attr_name.compare("JOINTS_0"))
 				{
-					mesh.vertex_boneindices.resize(vertexOffset + vertexCount);
-					if (stride == 4)
-					{
-						struct JointTmp
-						{
-							uint8_t ind[4];
-						};
-
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const JointTmp& joint = ((JointTmp*)data)[i];
-
-							mesh.vertex_boneindices[vertexOffset + i].x = joint.ind[0];
-							mesh.vertex_boneindices[vertexOffset + i].y = joint.ind[1];
-							mesh.vertex_boneindices[vertexOffset + i].z = joint.ind[2];
-							mesh.vertex_boneindices[vertexOffset + i].w = joint.ind[3];
-						}
-					}
-					else if (stride == 8)
-					{
-						struct JointTmp
-						{
-							uint16_t ind[4];
-						};
-
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const JointTmp& joint = ((JointTmp*)data)[i];
-
-							mesh.vertex_boneindices[vertexOffset + i].x = joint.ind[0];
-							mesh.vertex_boneindices[vertexOffset + i].y = joint.ind[1];
-							mesh.vertex_boneindices[vertexOffset + i].z = joint.ind[2];
-							mesh.vertex_boneindices[vertexOffset + i].w = joint.ind[3];
-						}
-					}
-					else
-					{
-						assert(0);
-					}
+					GrowAttribute(mesh.vertex_boneindices, required);
 				}
 				else if (!attr_name.compare("WEIGHTS_0"))
 				{
-					mesh.vertex_boneweights.resize(vertexOffset + vertexCount);
-					if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							mesh.vertex_boneweights[vertexOffset + i] = *(XMFLOAT4*)((size_t)data + i * stride);
-						}
-					}
-					else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const uint8_t& x = *(uint8_t*)((size_t)data + i * stride + 0);
-							const uint8_t& y = *(uint8_t*)((size_t)data + i * stride + 1);
-							const uint8_t& z = *(uint8_t*)((size_t)data + i * stride + 2);
-							const uint8_t& w = *(uint8_t*)((size_t)data + i * stride + 3);
-
-							mesh.vertex_boneweights[vertexOffset + i].x = x / 255.0f;
-							mesh.vertex_boneweights[vertexOffset + i].x = y / 255.0f;
-							mesh.vertex_boneweights[vertexOffset + i].x = z / 255.0f;
-							mesh.vertex_boneweights[vertexOffset + i].x = w / 255.0f;
-						}
-					}
-					else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-					{
-						for (size_t i = 0; i < vertexCount; ++i)
-						{
-							const uint16_t& x = *(uint8_t*)((size_t)data + i * stride + 0 * sizeof(uint16_t));
-							const uint16_t& y = *(uint8_t*)((size_t)data + i * stride + 1 * sizeof(uint16_t));
-							const uint16_t& z = *(uint8_t*)((size_t)data + i * stride + 2 * sizeof(uint16_t));
-							const uint16_t& w = *(uint8_t*)((size_t)data + i * stride + 3 * sizeof(uint16_t));
-
-							mesh.vertex_boneweights[vertexOffset + i].x = x / 65535.0f;
-							mesh.vertex_boneweights[vertexOffset + i].x = y / 65535.0f;
-							mesh.vertex_boneweights[vertexOffset + i].x = z / 65535.0f;
-							mesh.vertex_boneweights[vertexOffset + i].x = w / 65535.0f;
-						}
-					}
+					GrowAttribute(mesh.vertex_boneweights, required);
 				}
 				else if (!attr_name.compare("COLOR_0"))
 				{
-					if(material != nullptr)
+					if (material != nullptr)
 					{
 						material->SetUseVertexColors(true);
 					}
-					mesh.vertex_colors.resize(vertexOffset + vertexCount);
-					if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
-					{
-						if (accessor.type == TINYGLTF_TYPE_VEC3)
-						{
-							for (size_t i = 0; i < vertexCount; ++i)
-							{
-								const XMFLOAT3& color = *(XMFLOAT3*)((size_t)data + i * stride);
-								uint32_t rgba = wi::math::CompressColor(color);
-
-								mesh.vertex_colors[vertexOffset + i] = rgba;
-							}
-						}
-						else if (accessor.type == TINYGLTF_TYPE_VEC4)
-						{
-							for (size_t i = 0; i < vertexCount; ++i)
-							{
-								const XMFLOAT4& color = *(XMFLOAT4*)((size_t)data + i * stride);
-								uint32_t rgba = wi::math::CompressColor(color);
-
-								mesh.vertex_colors[vertexOffset + i] = rgba;
-							}
-						}
-					}
-					else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
-					{
-						if (accessor.type == TINYGLTF_TYPE_VEC3)
-						{
-							for (size_t i = 0; i < vertexCount; ++i)
-							{
-								const uint8_t& r = *(uint8_t*)((size_t)data + i * stride + 0);
-								const uint8_t& g = *(uint8_t*)((size_t)data + i * stride + 1);
-								const uint8_t& b = *(uint8_t*)((size_t)data + i * stride + 2);
-								const uint8_t a = 0xFF;
-								wi::Color color = wi::Color(r, g, b, a);
-
-								mesh.vertex_colors[vertexOffset + i] = color;
-							}
-						}
-						else if (accessor.type == TINYGLTF_TYPE_VEC4)
-						{
-							for (size_t i = 0; i < vertexCount; ++i)
-							{
-								const uint8_t& r = *(uint8_t*)((size_t)data + i * stride + 0);
-								const uint8_t& g = *(uint8_t*)((size_t)data + i * stride + 1);
-								const uint8_t& b = *(uint8_t*)((size_t)data + i * stride + 2);
-								const uint8_t& a = *(uint8_t*)((size_t)data + i * stride + 3);
-								wi::Color color = wi::Color(r, g, b, a);
-
-								mesh.vertex_colors[vertexOffset + i] = color;
-							}
-						}
-					}
-					else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-					{
-						if (accessor.type == TINYGLTF_TYPE_VEC3)
-						{
-							for (size_t i = 0; i < vertexCount; ++i)
-							{
-								const uint16_t& r = *(uint16_t*)((size_t)data + i * stride + 0 * sizeof(uint16_t));
-								const uint16_t& g = *(uint16_t*)((size_t)data + i * stride + 1 * sizeof(uint16_t));
-								const uint16_t& b = *(uint16_t*)((size_t)data + i * stride + 2 * sizeof(uint16_t));
-								uint32_t rgba = wi::math::CompressColor(XMFLOAT3(r / 65535.0f, g / 65535.0f, b / 65535.0f));
-
-								mesh.vertex_colors[vertexOffset + i] = rgba;
-							}
-						}
-						else if (accessor.type == TINYGLTF_TYPE_VEC4)
-						{
-							for (size_t i = 0; i < vertexCount; ++i)
-							{
-								const uint16_t& r = *(uint16_t*)((size_t)data + i * stride + 0 * sizeof(uint16_t));
-								const uint16_t& g = *(uint16_t*)((size_t)data + i * stride + 1 * sizeof(uint16_t));
-								const uint16_t& b = *(uint16_t*)((size_t)data + i * stride + 2 * sizeof(uint16_t));
-								const uint16_t& a = *(uint16_t*)((size_t)data + i * stride + 3 * sizeof(uint16_t));
-								uint32_t rgba = wi::math::CompressColor(XMFLOAT4(r / 65535.0f, g / 65535.0f, b / 65535.0f, a / 65535.0f));
-
-								mesh.vertex_colors[vertexOffset + i] = rgba;
-							}
-						}
-					}
+					GrowAttribute(mesh.vertex_colors, required);
 				}
+			}
 
-				for (size_t i = 0; i < mesh.targets.size(); i++)
+			for (size_t i = 0; i < std::min(mesh.targets.size(), prim.targets.size()); i++)
+			{
+				for (auto& attr : prim.targets[i])
 				{
-					for (auto& attr : prim.targets[i])
+					const std::string& attr_name = attr.first;
+					const size_t vertexCount = state.gltfModel.accessors[attr.second].count;
+					const size_t required = conversion.vertexOffset + vertexCount;
+					conversion.vertexCount = std::max(conversion.vertexCount, (uint32_t)vertexCount);
+
+					if (!attr_name.compare("POSITION"))
+					{
+						GrowAttribute(mesh.targets[i].vertex_positions, required);
+					}
+					else if (!attr_name.compare("NORMAL"))
 					{
-						const std::string& attr_name = attr.first;
-						int attr_data = attr.second;
-
-						const tinygltf::Accessor& accessor = state.gltfModel.accessors[attr_data];
-						const tinygltf::BufferView& bufferView = state.gltfModel.bufferViews[accessor.bufferView];
-						const tinygltf::Buffer& buffer = state.gltfModel.buffers[bufferView.buffer];
-
-						int stride = accessor.ByteStride(bufferView);
-						size_t vertexCount = accessor.count;
-
-						const unsigned char* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
-
-						if (!attr_name.compare("POSITION"))
-						{
-							mesh.targets[i].vertex_positions.resize(vertexOffset + vertexCount);
-							for (size_t j = 0; j < vertexCount; ++j)
-							{
-								mesh.targets[i].vertex_positions[vertexOffset + j] = ((XMFLOAT3*)data)[j];
-							}
-						}
-						else if (!attr_name.compare("NORMAL"))
-						{
-							mesh.targets[i].vertex_normals.resize(vertexOffset + vertexCount);
-							for (size_t j = 0; j < vertexCount; ++j)
-							{
-								mesh.targets[i].vertex_normals[vertexOffset + j] = ((XMFLOAT3*)data)[j];
-							}
-						}
+						GrowAttribute(mesh.targets[i].vertex_normals, required);
 					}
 				}
 			}
-
 		}
+	}
 
-		mesh.CreateRenderData();
+	// Big primitives are split into multiple conversion jobs:
+	struct ConversionJob
+	{
+		uint32_t conversion;
+		uint32_t chunk;
+	};
+	wi::vector<ConversionJob> conversionJobs;
+	for (size_t i = 0; i < conversions.size(); ++i)
+	{
+		PrimitiveConversion& conversion = conversions[i];
+		conversion.mesh = scene.meshes.GetComponent(conversion.meshEntity);
+		const size_t vertexChunks = (conversion.vertexCount + PrimitiveConversion::chunk_vertices - 1) / PrimitiveConversion::chunk_vertices;
+		const size_t indexChunks = (conversion.indexCount + PrimitiveConversion::chunk_indices - 1) / PrimitiveConversion::chunk_indices;
+		const size_t chunks = std::max(size_t(1), std::max(vertexChunks, indexChunks));
+		for (size_t chunk = 0; chunk < chunks; ++chunk)
+		{
+			conversionJobs.push_back({ (uint32_t)i, (uint32_t)chunk });
+		}
+	}
+	wi::jobsystem::Dispatch(ctx, (uint32_t)conversionJobs.size(), 1, [&](wi::jobsystem::JobArgs args) {
+		const ConversionJob& job = conversionJobs[args.jobIndex];
+		ConvertPrimitive(state.gltfModel, conversions[job.conversion], job.chunk);
+	});
+	wi::jobsystem::Wait(ctx);
+	stats.primitive_count = conversions.size();
+	stats.meshes = timer.elapsed_milliseconds();
+	timer.record();
+
+	wi::vector<MeshComponent*> meshes(meshEntities.size());
+	for (size_t i = 0; i < meshEntities.size(); ++i)
+	{
+		meshes[i] = scene.meshes.GetComponent(meshEntities[i]);
+		stats.vertex_count += meshes[i]->vertex_positions.size();
+		stats.index_count += meshes[i]->indices.size();
 	}
+	wi::jobsystem::Dispatch(ctx, (uint32_t)meshes.size(), 1, [&](wi::jobsystem::JobArgs args) {
+		meshes[args.jobIndex]->CreateRenderData();
+	});
+	wi::jobsystem::Wait(ctx);
+	stats.render_data = timer.elapsed_milliseconds();
+	timer.record();
 
 	// Create armatures:
 	for (auto& skin : state.gltfModel.skins)
@@ -1416,4 +1534,17 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	// Update the scene, to have up to date values immediately after loading:
 	//	For example, snap to camera functionality relies on this
 	scene.Update(0);
+
+	stats.total = total_timer.elapsed_milliseconds();
+	wi::backlog::post(
+		"[ImportModel_GLTF] " + name + " imported in " + std::to_string(stats.total) + " ms"
+		" (parse: " + std::to_string(stats.parse) + " ms"
+		", textures: " + std::to_string(stats.textures) + " ms"
+		", meshes: " + std::to_string(stats.meshes) + " ms"
+		", render data: " + std::to_string(stats.render_data) + " ms)"
+	);
+	if (statistics != nullptr)
+	{
+		*statistics = stats;
+	}
 }
@@ -3,259 +3,12 @@
 #include "ObjectWindow.h"
 #include "wiScene.h"
 
-#include "xatlas.h"
-
 #include <string>
 
 using namespace wi::ecs;
 using namespace wi::scene;
 
 
-static void SetPixel(uint8_t *dest, int destWidth, int x, int y, const uint8_t *color)
-{
-	uint8_t *pixel = &dest[x * 4 + y * (destWidth * 4)];
-	pixel[0] = color[0];
-	pixel[1] = color[1];
-	pixel[2] = color[2];
-	pixel[3] = color[3];
-}
-
-// https://github.com/miloyip/line/blob/master/line_bresenham.c
-static void RasterizeLine(uint8_t *dest, int destWidth, const int *p1, const int *p2, const uint8_t *color)
-{
-	const int dx = abs(p2[0] - p1[0]), sx = p1[0] < p2[0] ? 1 : -1;
-	const int dy = abs(p2[1] - p1[1]), sy = p1[1] < p2[1] ? 1 : -1;
-	int err = (dx > dy ? dx : -dy) / 2;
-	int current[2];
-	current[0] = p1[0];
-	current[1] = p1[1];
-	while (SetPixel(dest, destWidth, current[0], current[1], color), current[0] != p2[0] || current[1] != p2[1])
-	{
-		const int e2 = err;
-		if (e2 > -dx) { err -= dy; current[0] += sx; }
-		if (e2 < dy) { err += dx; current[1] += sy; }
-	}
-}
-
-// https://github.com/ssloy/tinyrenderer/wiki/Lesson-2:-Triangle-rasterization-and-back-face-culling
-static void RasterizeTriangle(uint8_t *dest, int destWidth, const int *t0, const int *t1, const int *t2, const uint8_t *color)
-{
-	if (t0[1] > t1[1]) std::swap(t0, t1);
-	if (t0[1] > t2[1]) std::swap(t0, t2);
-	if (t1[1] > t2[1]) std::swap(t1, t2);
-	int total_height = t2[1] - t0[1];
-	for (int i = 0; i < total_height; i++) {
-		bool second_half = i > t1[1] - t0[1] || t1[1] == t0[1];
-		int segment_height = second_half ? t2[1] - t1[1] : t1[1] - t0[1];
-		float alpha = (float)i / total_height;
-		float beta = (float)(i - (second_half ? t1[1] - t0[1] : 0)) / segment_height;
-		int A[2], B[2];
-		for (int j = 0; j < 2; j++) {
-			A[j] = int(t0[j] + (t2[j] - t0[j]) * alpha);
-			B[j] = int(second_half ? t1[j] + (t2[j] - t1[j]) * beta : t0[j] + (t1[j] - t0[j]) * beta);
-		}
-		if (A[0] > B[0]) std::swap(A, B);
-		for (int j = A[0]; j <= B[0]; j++)
-			SetPixel(dest, destWidth, j, t0[1] + i, color);
-	}
-}
-
-struct Atlas_Dim
-{
-	uint32_t width = 0;
-	uint32_t height = 0;
-};
-static Atlas_Dim GenerateMeshAtlas(MeshComponent& meshcomponent, uint32_t resolution)
-{
-	Atlas_Dim dim;
-
-	xatlas::Atlas* atlas = xatlas::Create();
-
-	// Prepare mesh to be processed by xatlas:
-	{
-		xatlas::MeshDecl mesh;
-		mesh.vertexCount = (int)meshcomponent.vertex_positions.size();
-		mesh.vertexPositionData = meshcomponent.vertex_positions.data();
-		mesh.vertexPositionStride = sizeof(float) * 3;
-		if (!meshcomponent.vertex_normals.empty()) {
-			mesh.vertexNormalData = meshcomponent.vertex_normals.data();
-			mesh.vertexNormalStride = sizeof(float) * 3;
-		}
-		if (!meshcomponent.vertex_uvset_0.empty()) {
-			mesh.vertexUvData = meshcomponent.vertex_uvset_0.data();
-			mesh.vertexUvStride = sizeof(float) * 2;
-		}
-		mesh.indexCount = (int)meshcomponent.indices.size();
-		mesh.indexData = meshcomponent.indices.data();
-		mesh.indexFormat = xatlas::IndexFormat::UInt32;
-		xatlas::AddMeshError::Enum error = xatlas::AddMesh(atlas, mesh);
-		if (error != xatlas::AddMeshError::Success) {
-			wi::helper::messageBox(xatlas::StringForEnum(error), "Adding mesh to xatlas failed!");
-			return dim;
-		}
-	}
-
-	// Generate atlas:
-	{
-		xatlas::ChartOptions chartoptions;
-		xatlas::ParameterizeOptions parametrizeoptions;
-		xatlas::PackOptions packoptions;
-
-		packoptions.resolution = resolution;
-		packoptions.blockAlign = true;
-
-		xatlas::Generate(atlas, chartoptions, parametrizeoptions, packoptions);
-		dim.width = atlas->width;
-		dim.height = atlas->height;
-
-		xatlas::Mesh& mesh = atlas->meshes[0];
-
-		// Note: we must recreate all vertex buffers, because the index buffer will be different (the atlas could have removed shared vertices)
-		meshcomponent.indices.clear();
-		meshcomponent.indices.resize(mesh.indexCount);
-		wi::vector<XMFLOAT3> positions(mesh.vertexCount);
-		wi::vector<XMFLOAT2> atlas(mesh.vertexCount);
-		wi::vector<XMFLOAT3> normals;
-		wi::vector<XMFLOAT4> tangents;
-		wi::vector<XMFLOAT2> uvset_0;
-		wi::vector<XMFLOAT2> uvset_1;
-		wi::vector<uint32_t> colors;
-		wi::vector<XMUINT4> boneindices;
-		wi::vector<XMFLOAT4> boneweights;
-		if (!meshcomponent.vertex_normals.empty())
-		{
-			normals.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_tangents.empty())
-		{
-			tangents.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_uvset_0.empty())
-		{
-			uvset_0.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_uvset_1.empty())
-		{
-			uvset_1.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_colors.empty())
-		{
-			colors.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_boneindices.empty())
-		{
-			boneindices.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_boneweights.empty())
-		{
-			boneweights.resize(mesh.vertexCount);
-		}
-
-		for (uint32_t j = 0; j < mesh.indexCount; ++j)
-		{
-			const uint32_t ind = mesh.indexArray[j];
-			const xatlas::Vertex &v = mesh.vertexArray[ind];
-			meshcomponent.indices[j] = ind;
-			atlas[ind].x = v.uv[0] / float(dim.width);
-			atlas[ind].y = v.uv[1] / float(dim.height);
-			positions[ind] = meshcomponent.vertex_positions[v.xref];
-			if (!normals.empty())
-			{
-				normals[ind] = meshcomponent.vertex_normals[v.xref];
-			}
-			if (!tangents.empty())
-			{
-				tangents[ind] = meshcomponent.vertex_tangents[v.xref];
-			}
-			if (!uvset_0.empty())
-			{
-				uvset_0[ind] = meshcomponent.vertex_uvset_0[v.xref];
-			}
-			if (!uvset_1.empty())
-			{
-				uvset_1[ind] = meshcomponent.vertex_uvset_1[v.xref];
-			}
-			if (!colors.empty())
-			{
-				colors[ind] = meshcomponent.vertex_colors[v.xref];
-			}
-			if (!boneindices.empty())
-			{
-				boneindices[ind] = meshcomponent.vertex_boneindices[v.xref];
-			}
-			if (!boneweights.empty())
-			{
-				boneweights[ind] = meshcomponent.vertex_boneweights[v.xref];
-			}
-		}
-
-		meshcomponent.vertex_positions = positions;
-		meshcomponent.vertex_atlas = atlas;
-		if (!normals.empty())
-		{
-			meshcomponent.vertex_normals = normals;
-		}
-		if (!tangents.empty())
-		{
-			meshcomponent.vertex_tangents = tangents;
-		}
-		if (!uvset_0.empty())
-		{
-			meshcomponent.vertex_uvset_0 = uvset_0;
-		}
-		if (!uvset_1.empty())
-		{
-			meshcomponent.vertex_uvset_1 = uvset_1;
-		}
-		if (!colors.empty())
-		{
-			meshcomponent.vertex_colors = colors;
-		}
-		if (!boneindices.empty())
-		{
-			meshcomponent.vertex_boneindices = boneindices;
-		}
-		if (!boneweights.empty())
-		{
-			meshcomponent.vertex_boneweights = boneweights;
-		}
-		meshcomponent.CreateRenderData();
-
-	}
-
-	//// DEBUG
-	//{
-	//	const uint32_t width = objectcomponent.lightmapWidth;
-	//	const uint32_t height = objectcomponent.lightmapHeight;
-	//	objectcomponent.lightmapTextureData.resize(width * height * 4);
-	//	const xatlas::OutputMesh *mesh = xatlas::GetOutputMeshes(atlas)[0];
-	//	// Rasterize mesh triangles.
-	//	const uint8_t white[] = { 255, 255, 255 };
-	//	for (uint32_t j = 0; j < mesh->indexCount; j += 3) {
-	//		int verts[3][2];
-	//		uint8_t color[4];
-	//		for (int k = 0; k < 3; k++) {
-	//			const xatlas::OutputVertex &v = mesh->vertexArray[mesh->indexArray[j + k]];
-	//			verts[k][0] = int(v.uv[0]);
-	//			verts[k][1] = int(v.uv[1]);
-	//			color[k] = rand() % 255;
-	//		}
-	//		color[3] = 255;
-	//		if (!verts[0][0] && !verts[0][1] && !verts[1][0] && !verts[1][1] && !verts[2][0] && !verts[2][1])
-	//			continue; // Skip triangles that weren't atlased.
-	//		RasterizeTriangle(objectcomponent.lightmapTextureData.data(), width, verts[0], verts[1], verts[2], color);
-	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[0], verts[1], white);
-	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[1], verts[2], white);
-	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[2], verts[0], white);
-	//	}
-	//}
-
-	xatlas::Destroy(atlas);
-
-	return dim;
-}
-
-
 void ObjectWindow::Create(EditorComponent* editor)
 {
 	this->editor = editor;
@@ -302,6 +55,20 @@ void ObjectWindow::Create(EditorComponent* editor)
 		});
 	AddWidget(&shadowCheckBox);
 
+	occluderCheckBox.Create("Occluder: ");
+	occluderCheckBox.SetTooltip("Set object to be an occluder for CPU occlusion culling.\nOccluders should be big, simple, non-skinned meshes that are not bigger than the rendered geometry, like walls or buildings.");
+	occluderCheckBox.SetSize(XMFLOAT2(hei, hei));
+	occluderCheckBox.SetPos(XMFLOAT2(x + 120, y));
+	occluderCheckBox.SetCheck(false);
+	occluderCheckBox.OnClick([&](wi::gui::EventArgs args) {
+		ObjectComponent* object = wi::scene::GetScene().objects.GetComponent(entity);
+		if (object != nullptr)
+		{
+			object->SetOccluder(args.bValue);
+		}
+	});
+	AddWidget(&occluderCheckBox);
+
 	ditherSlider.Create(0, 1, 0, 1000, "Transparency: ");
 	ditherSlider.SetTooltip("Adjust transparency of the object. Opaque materials will use dithered transparency in this case!");
 	ditherSlider.SetSize(XMFLOAT2(100, hei));
@@ -663,7 +430,8 @@ void ObjectWindow::Create(EditorComponent* editor)
 		UV_GEN_TYPE gen_type = (UV_GEN_TYPE)lightmapSourceUVSetComboBox.GetSelected();
 
 		wi::unordered_set<ObjectComponent*> gen_objects;
-		wi::unordered_map<MeshComponent*, Atlas_Dim> gen_meshes;
+		wi::unordered_set<MeshComponent*> gen_meshes;
+		wi::vector<Entity> gen_mesh_entities;
 
 		for (auto& x : this->editor->translator.selected)
 		{
@@ -675,48 +443,65 @@ void ObjectWindow::Create(EditorComponent* editor)
 				if (meshcomponent != nullptr)
 				{
 					gen_objects.insert(objectcomponent);
-					gen_meshes[meshcomponent] = Atlas_Dim();
+					if (gen_meshes.insert(meshcomponent).second)
+					{
+						gen_mesh_entities.push_back(objectcomponent->meshID);
+					}
 				}
 			}
 
 		}
 
-		wi::jobsystem::context ctx;
+		const uint32_t resolution = (uint32_t)lightmapResolutionSlider.GetValue();
 
-		for (auto& it : gen_meshes)
+		if (gen_type == UV_GEN_GENERATE_ATLAS)
 		{
-			MeshComponent& mesh = *it.first;
-			if (gen_type == UV_GEN_COPY_UVSET_0)
-			{
-				mesh.vertex_atlas = mesh.vertex_uvset_0;
-				mesh.CreateRenderData();
-			}
-			else if (gen_type == UV_GEN_COPY_UVSET_1)
+			Scene::AtlasGenerationStatistics statistics = scene.GenerateMeshAtlases(gen_mesh_entities, resolution, [](uint32_t finished, uint32_t total) {
+				// Report every 10%:
+				if (finished == total || (finished * 10 / total) != ((finished - 1) * 10 / total))
+				{
+					wi::backlog::post("Lightmap atlas generation: " + std::to_string(finished) + " / " + std::to_string(total) + " meshes");
+				}
+			});
+			std::string str = "Lightmap atlas generation finished in " + std::to_string(statistics.total_milliseconds) + " ms\n";
+			str += "\tgenerated: " + std::to_string(statistics.generated) + ", up to date: " + std::to_string(statistics.skipped) + ", failed: " + std::to_string(statistics.failed) + "\n";
+			str += "\tsum of mesh times: " + std::to_string(statistics.mesh_milliseconds_sum) + " ms, slowest mesh: " + std::to_string(statistics.mesh_milliseconds_max) + " ms";
+			const NameComponent* slowest_name = scene.names.GetComponent(statistics.slowest_mesh);
+			if (slowest_name != nullptr)
 			{
-				mesh.vertex_atlas = mesh.vertex_uvset_1;
-				mesh.CreateRenderData();
+				str += " (" + slowest_name->name + ")";
 			}
-			else if (gen_type == UV_GEN_GENERATE_ATLAS)
+			wi::backlog::post(str, statistics.failed > 0 ? wi::backlog::LogLevel::Warning : wi::backlog::LogLevel::Default);
+		}
+		else
+		{
+			for (MeshComponent* mesh : gen_meshes)
 			{
-				wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
-					it.second = GenerateMeshAtlas(mesh, (uint32_t)lightmapResolutionSlider.GetValue());
-				});
+				if (gen_type == UV_GEN_COPY_UVSET_0)
+				{
+					mesh->vertex_atlas = mesh->vertex_uvset_0;
+					mesh->CreateRenderData();
+				}
+				else if (gen_type == UV_GEN_COPY_UVSET_1)
+				{
+					mesh->vertex_atlas = mesh->vertex_uvset_1;
+					mesh->CreateRenderData();
+				}
 			}
 		}
-		wi::jobsystem::Wait(ctx);
 
 		for (auto& x : gen_objects)
 		{
 			x->ClearLightmap();
 			MeshComponent* meshcomponent = scene.meshes.GetComponent(x->meshID);
-			if (gen_type == UV_GEN_GENERATE_ATLAS)
+			if (gen_type == UV_GEN_GENERATE_ATLAS || (gen_type == UV_GEN_KEEP_ATLAS && meshcomponent->atlas_width > 0))
 			{
-				x->lightmapWidth = gen_meshes.at(meshcomponent).width;
-				x->lightmapHeight = gen_meshes.at(meshcomponent).height;
+				x->lightmapWidth = meshcomponent->atlas_width;
+				x->lightmapHeight = meshcomponent->atlas_height;
 			}
 			else
 			{
-				x->lightmapWidth = x->lightmapHeight = (uint32_t)lightmapResolutionSlider.GetValue();
+				x->lightmapWidth = x->lightmapHeight = resolution;
 			}
 			x->SetLightmapRenderRequest(true);
 		}
@@ -830,6 +615,7 @@ void ObjectWindow::SetEntity(Entity entity)
 
 		renderableCheckBox.SetCheck(object->IsRenderable());
 		shadowCheckBox.SetCheck(object->IsCastingShadow());
+		occluderCheckBox.SetCheck(object->IsOccluder());
 		cascadeMaskSlider.SetValue((float)object->cascadeMask);
 		ditherSlider.SetValue(object->GetTransparency());
 		lodSlider.SetValue(object->lod_distance_multiplier);
@@ -15,6 +15,7 @@ public:
 	wi::gui::Label nameLabel;
 	wi::gui::CheckBox renderableCheckBox;
 	wi::gui::CheckBox shadowCheckBox;
+	wi::gui::CheckBox occluderCheckBox;
 	wi::gui::Slider ditherSlider;
 	wi::gui::Slider cascadeMaskSlider;
 	wi::gui::Slider lodSlider;
@@ -45,6 +45,16 @@ void RendererWindow::Create(EditorComponent* editor)
 	occlusionCullingCheckBox.SetCheck(wi::renderer::GetOcclusionCullingEnabled());
 	AddWidget(&occlusionCullingCheckBox);
 
+	occlusionCullingCPUCheckBox.Create("CPU: ");
+	occlusionCullingCPUCheckBox.SetTooltip("Toggle CPU occlusion culling. Objects marked as occluders are rasterized into a software depth buffer,\nand objects hidden behind them will be culled in the same frame, before render queues are built.");
+	occlusionCullingCPUCheckBox.SetPos(XMFLOAT2(x + 60, y));
+	occlusionCullingCPUCheckBox.SetSize(XMFLOAT2(itemheight, itemheight));
+	occlusionCullingCPUCheckBox.OnClick([](wi::gui::EventArgs args) {
+		wi::renderer::SetOcclusionCullingCPUEnabled(args.bValue);
+	});
+	occlusionCullingCPUCheckBox.SetCheck(wi::renderer::GetOcclusionCullingCPUEnabled());
+	AddWidget(&occlusionCullingCPUCheckBox);
+
 	visibilityComputeShadingCheckBox.Create("VCS: ");
 	visibilityComputeShadingCheckBox.SetTooltip("Visibility Compute Shading (experimental)\nThis will shade the scene in compute shaders instead of pixel shaders\nThis has a higher initial performance cost, but it will be faster in high polygon scenes");
 	visibilityComputeShadingCheckBox.SetPos(XMFLOAT2(x + 120, y));
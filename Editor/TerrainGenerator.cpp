@@ -17,146 +17,7 @@ enum PRESET
 
 void TerrainGenerator::init()
 {
-	terrainEntity = CreateEntity();
-
-	indices.clear();
-	lods.clear();
-	lods.resize(max_lod);
-	for (int lod = 0; lod < max_lod; ++lod)
-	{
-		lods[lod].indexOffset = (uint32_t)indices.size();
-
-		if (lod == 0)
-		{
-			for (int x = 0; x < chunk_width - 1; x++)
-			{
-				for (int z = 0; z < chunk_width - 1; z++)
-				{
-					int lowerLeft = x + z * chunk_width;
-					int lowerRight = (x + 1) + z * chunk_width;
-					int topLeft = x + (z + 1) * chunk_width;
-					int topRight = (x + 1) + (z + 1) * chunk_width;
-
-					indices.push_back(topLeft);
-					indices.push_back(lowerLeft);
-					indices.push_back(lowerRight);
-
-					indices.push_back(topLeft);
-					indices.push_back(lowerRight);
-					indices.push_back(topRight);
-				}
-			}
-		}
-		else
-		{
-			const int step = 1 << lod;
-			// inner grid:
-			for (int x = 1; x < chunk_width - 2; x += step)
-			{
-				for (int z = 1; z < chunk_width - 2; z += step)
-				{
-					int lowerLeft = x + z * chunk_width;
-					int lowerRight = (x + step) + z * chunk_width;
-					int topLeft = x + (z + step) * chunk_width;
-					int topRight = (x + step) + (z + step) * chunk_width;
-
-					indices.push_back(topLeft);
-					indices.push_back(lowerLeft);
-					indices.push_back(lowerRight);
-
-					indices.push_back(topLeft);
-					indices.push_back(lowerRight);
-					indices.push_back(topRight);
-				}
-			}
-			// bottom border:
-			for (int x = 0; x < chunk_width - 1; ++x)
-			{
-				const int z = 0;
-				int current = x + z * chunk_width;
-				int neighbor = x + 1 + z * chunk_width;
-				int connection = 1 + ((x + (step + 1) / 2 - 1) / step) * step + (z + 1) * chunk_width;
-
-				indices.push_back(current);
-				indices.push_back(neighbor);
-				indices.push_back(connection);
-
-				if (((x - 1) % (step)) == step / 2) // halfway fill triangle
-				{
-					int connection1 = 1 + (((x - 1) + (step + 1) / 2 - 1) / step) * step + (z + 1) * chunk_width;
-
-					indices.push_back(current);
-					indices.push_back(connection);
-					indices.push_back(connection1);
-				}
-			}
-			// top border:
-			for (int x = 0; x < chunk_width - 1; ++x)
-			{
-				const int z = chunk_width - 1;
-				int current = x + z * chunk_width;
-				int neighbor = x + 1 + z * chunk_width;
-				int connection = 1 + ((x + (step + 1) / 2 - 1) / step) * step + (z - 1) * chunk_width;
-
-				indices.push_back(current);
-				indices.push_back(connection);
-				indices.push_back(neighbor);
-
-				if (((x - 1) % (step)) == step / 2) // halfway fill triangle
-				{
-					int connection1 = 1 + (((x - 1) + (step + 1) / 2 - 1) / step) * step + (z - 1) * chunk_width;
-
-					indices.push_back(current);
-					indices.push_back(connection1);
-					indices.push_back(connection);
-				}
-			}
-			// left border:
-			for (int z = 0; z < chunk_width - 1; ++z)
-			{
-				const int x = 0;
-				int current = x + z * chunk_width;
-				int neighbor = x + (z + 1) * chunk_width;
-				int connection = x + 1 + (((z + (step + 1) / 2 - 1) / step) * step + 1) * chunk_width;
-
-				indices.push_back(current);
-				indices.push_back(connection);
-				indices.push_back(neighbor);
-
-				if (((z - 1) % (step)) == step / 2) // halfway fill triangle
-				{
-					int connection1 = x + 1 + ((((z - 1) + (step + 1) / 2 - 1) / step) * step + 1) * chunk_width;
-
-					indices.push_back(current);
-					indices.push_back(connection1);
-					indices.push_back(connection);
-				}
-			}
-			// right border:
-			for (int z = 0; z < chunk_width - 1; ++z)
-			{
-				const int x = chunk_width - 1;
-				int current = x + z * chunk_width;
-				int neighbor = x + (z + 1) * chunk_width;
-				int connection = x - 1 + (((z + (step + 1) / 2 - 1) / step) * step + 1) * chunk_width;
-
-				indices.push_back(current);
-				indices.push_back(neighbor);
-				indices.push_back(connection);
-
-				if (((z - 1) % (step)) == step / 2) // halfway fill triangle
-				{
-					int connection1 = x - 1 + ((((z - 1) + (step + 1) / 2 - 1) / step) * step + 1) * chunk_width;
-
-					indices.push_back(current);
-					indices.push_back(connection);
-					indices.push_back(connection1);
-				}
-			}
-		}
-
-		lods[lod].indexCount = (uint32_t)indices.size() - lods[lod].indexOffset;
-	}
+	terrain.terrainEntity = CreateEntity();
 
 	RemoveWidgets();
 	ClearTransform();
@@ -174,6 +35,9 @@ void TerrainGenerator::init()
 	centerToCamCheckBox.SetSize(XMFLOAT2(hei, hei));
 	centerToCamCheckBox.SetPos(XMFLOAT2(x, y));
 	centerToCamCheckBox.SetCheck(true);
+	centerToCamCheckBox.OnClick([this](wi::gui::EventArgs args) {
+		terrain.center_to_cam = args.bValue;
+		});
 	AddWidget(&centerToCamCheckBox);
 
 	removalCheckBox.Create("Removal: ");
@@ -181,6 +45,9 @@ void TerrainGenerator::init()
 	removalCheckBox.SetSize(XMFLOAT2(hei, hei));
 	removalCheckBox.SetPos(XMFLOAT2(x + 100, y));
 	removalCheckBox.SetCheck(true);
+	removalCheckBox.OnClick([this](wi::gui::EventArgs args) {
+		terrain.removal = args.bValue;
+		});
 	AddWidget(&removalCheckBox);
 
 	lodSlider.Create(0.0001f, 0.01f, 0.005f, 10000, "Mesh LOD Distance: ");
@@ -188,12 +55,13 @@ void TerrainGenerator::init()
 	lodSlider.SetSize(XMFLOAT2(200, hei));
 	lodSlider.SetPos(XMFLOAT2(x, y += step));
 	lodSlider.OnSlide([this](wi::gui::EventArgs args) {
-		for (auto& it : chunks)
+		terrain.lod_multiplier = args.fValue;
+		for (auto& it : terrain.chunks)
 		{
-			const ChunkData& chunk_data = it.second;
+			const wi::terrain::ChunkData& chunk_data = it.second;
 			if (chunk_data.entity != INVALID_ENTITY)
 			{
-				ObjectComponent* object = scene->objects.GetComponent(chunk_data.entity);
+				ObjectComponent* object = terrain.scene->objects.GetComponent(chunk_data.entity);
 				if (object != nullptr)
 				{
 					object->lod_distance_multiplier = args.fValue;
@@ -207,12 +75,18 @@ void TerrainGenerator::init()
 	texlodSlider.SetTooltip("Set the LOD (Level Of Detail) distance multiplier.\nLow values increase LOD detail in distance");
 	texlodSlider.SetSize(XMFLOAT2(200, hei));
 	texlodSlider.SetPos(XMFLOAT2(x, y += step));
+	texlodSlider.OnSlide([this](wi::gui::EventArgs args) {
+		terrain.texlod = args.fValue;
+		});
 	AddWidget(&texlodSlider);
 
 	generationSlider.Create(0, 16, 12, 16, "Generation Distance: ");
 	generationSlider.SetTooltip("How far out chunks will be generated (value is in number of chunks)");
 	generationSlider.SetSize(XMFLOAT2(200, hei));
 	generationSlider.SetPos(XMFLOAT2(x, y += step));
+	generationSlider.OnSlide([this](wi::gui::EventArgs args) {
+		terrain.generation = (int)args.fValue;
+		});
 	AddWidget(&generationSlider);
 
 	presetCombo.Create("Preset: ");
@@ -439,27 +313,27 @@ void TerrainGenerator::init()
 			wi::eventhandler::Subscribe_Once(wi::eventhandler::EVENT_THREAD_SAFE_POINT, [=](uint64_t userdata) {
 
 				wi::primitive::AABB aabb;
-				for (auto& chunk : chunks)
+				for (auto& chunk : terrain.chunks)
 				{
-					const wi::primitive::AABB* object_aabb = scene->aabb_objects.GetComponent(chunk.second.entity);
+					const wi::primitive::AABB* object_aabb = terrain.scene->aabb_objects.GetComponent(chunk.second.entity);
 					if (object_aabb != nullptr)
 					{
 						aabb = wi::primitive::AABB::Merge(aabb, *object_aabb);
 					}
 				}
 
-				HeightmapTexture saved_heightmap;
+				wi::terrain::Heightmap saved_heightmap;
 				saved_heightmap.width = int(aabb.getHalfWidth().x * 2 + 1);
 				saved_heightmap.height = int(aabb.getHalfWidth().z * 2 + 1);
 				saved_heightmap.data.resize(saved_heightmap.width * saved_heightmap.height);
 				std::fill(saved_heightmap.data.begin(), saved_heightmap.data.end(), 0u);
 
-				for (auto& chunk : chunks)
+				for (auto& chunk : terrain.chunks)
 				{
-					const ObjectComponent* object = scene->objects.GetComponent(chunk.second.entity);
+					const ObjectComponent* object = terrain.scene->objects.GetComponent(chunk.second.entity);
 					if (object != nullptr)
 					{
-						const MeshComponent* mesh = scene->meshes.GetComponent(object->meshID);
+						const MeshComponent* mesh = terrain.scene->meshes.GetComponent(object->meshID);
 						if (mesh != nullptr)
 						{
 							const XMMATRIX W = XMLoadFloat4x4(&object->worldMatrix);
@@ -498,6 +372,8 @@ void TerrainGenerator::init()
 		wi::helper::FileDialog(params, [=](std::string fileName) {
 			wi::eventhandler::Subscribe_Once(wi::eventhandler::EVENT_THREAD_SAFE_POINT, [=](uint64_t userdata) {
 
+				terrain.Generation_Cancel(); // the heightmap is sampled by the generation thread
+				wi::terrain::Heightmap& heightmap = terrain.heightmap;
 				heightmap = {};
 				int bpp = 0;
 				stbi_uc* rgba = stbi_load(fileName.c_str(), &heightmap.width, &heightmap.height, &bpp, 1);
@@ -515,7 +391,8 @@ void TerrainGenerator::init()
 			});
 		});
 
-	heightmap = {};
+	terrain.heightmap = {};
+	ApplyParameters();
 
 	SetPos(XMFLOAT2(50, 110));
 	SetVisible(false);
@@ -524,19 +401,38 @@ void TerrainGenerator::init()
 	presetCombo.SetSelectedByUserdata(PRESET_HILLS);
 }
 
-void TerrainGenerator::Generation_Restart()
+void TerrainGenerator::ApplyParameters()
 {
-	Generation_Cancel();
-	generation_scene.Clear();
-
-	chunks.clear();
+	terrain.center_to_cam = centerToCamCheckBox.GetCheck();
+	terrain.removal = removalCheckBox.GetCheck();
+	terrain.lod_multiplier = lodSlider.GetValue();
+	terrain.texlod = texlodSlider.GetValue();
+	terrain.generation = (int)generationSlider.GetValue();
+	terrain.seed = (uint32_t)seedSlider.GetValue();
+	terrain.bottomLevel = bottomLevelSlider.GetValue();
+	terrain.topLevel = topLevelSlider.GetValue();
+	terrain.heightmapBlend = heightmapBlendSlider.GetValue();
+	terrain.perlinBlend = perlinBlendSlider.GetValue();
+	terrain.perlinFrequency = perlinFrequencySlider.GetValue();
+	terrain.perlinOctaves = (int)perlinOctavesSlider.GetValue();
+	terrain.voronoiBlend = voronoiBlendSlider.GetValue();
+	terrain.voronoiFrequency = voronoiFrequencySlider.GetValue();
+	terrain.voronoiFade = voronoiFadeSlider.GetValue();
+	terrain.voronoiShape = voronoiShapeSlider.GetValue();
+	terrain.voronoiFalloff = voronoiFalloffSlider.GetValue();
+	terrain.voronoiPerturbation = voronoiPerturbationSlider.GetValue();
+	terrain.region1 = region1Slider.GetValue();
+	terrain.region2 = region2Slider.GetValue();
+	terrain.region3 = region3Slider.GetValue();
+}
 
-	scene->Entity_Remove(terrainEntity);
-	scene->transforms.Create(terrainEntity);
-	scene->names.Create(terrainEntity) = "terrain";
+void TerrainGenerator::Generation_Restart()
+{
+	terrain.Generation_Cancel(); // the generation thread must not be running while the parameters change
+	ApplyParameters();
+	terrain.Generation_Restart();
 
-	const uint32_t seed = (uint32_t)seedSlider.GetValue();
-	perlin.init(seed);
+	wi::scene::Scene* scene = terrain.scene;
 
 	// Add some nice weather and lighting if there is none yet:
 	if (scene->weathers.GetCount() == 0)
@@ -544,7 +440,7 @@ void TerrainGenerator::Generation_Restart()
 		Entity weatherEntity = CreateEntity();
 		WeatherComponent& weather = scene->weathers.Create(weatherEntity);
 		scene->names.Create(weatherEntity) = "terrainWeather";
-		scene->Component_Attach(weatherEntity, terrainEntity);
+		scene->Component_Attach(weatherEntity, terrain.terrainEntity);
 		weather.ambient = XMFLOAT3(0.2f, 0.2f, 0.2f);
 		weather.SetRealisticSky(true);
 		weather.SetVolumetricClouds(true);
@@ -575,7 +471,7 @@ void TerrainGenerator::Generation_Restart()
 	if (scene->lights.GetCount() == 0)
 	{
 		Entity sunEntity = scene->Entity_CreateLight("terrainSun");
-		scene->Component_Attach(sunEntity, terrainEntity);
+		scene->Component_Attach(sunEntity, terrain.terrainEntity);
 		LightComponent& light = *scene->lights.GetComponent(sunEntity);
 		light.SetType(LightComponent::LightType::DIRECTIONAL);
 		light.intensity = 16;
@@ -586,629 +482,3 @@ void TerrainGenerator::Generation_Restart()
 		transform.Translate(XMFLOAT3(0, 2, 0));
 	}
 }
-
-void TerrainGenerator::Generation_Update(const wi::scene::CameraComponent& camera)
-{
-	// The generation task is always cancelled every frame so we are sure that generation is not running at this point
-	Generation_Cancel();
-
-	if (terrainEntity == INVALID_ENTITY || !scene->transforms.Contains(terrainEntity))
-	{
-		chunks.clear();
-		return;
-	}
-
-	// What was generated, will be merged in to the main scene
-	scene->Merge(generation_scene);
-
-	if (centerToCamCheckBox.GetCheck())
-	{
-		center_chunk.x = (int)std::floor((camera.Eye.x + chunk_half_width) * chunk_width_rcp * chunk_scale_rcp);
-		center_chunk.z = (int)std::floor((camera.Eye.z + chunk_half_width) * chunk_width_rcp * chunk_scale_rcp);
-	}
-
-	const int removal_threshold = (int)generationSlider.GetValue() + 2;
-	const float texlodMultiplier = texlodSlider.GetValue();
-	GraphicsDevice* device = GetDevice();
-	virtual_texture_updates.clear();
-	virtual_texture_barriers_begin.clear();
-	virtual_texture_barriers_end.clear();
-
-	// Check whether there are any materials that would write to virtual textures:
-	uint32_t max_texture_resolution = 0;
-	bool virtual_texture_available[MaterialComponent::TEXTURESLOT_COUNT] = {};
-	virtual_texture_available[MaterialComponent::SURFACEMAP] = true; // this is always needed to bake individual material properties
-	MaterialComponent* virtual_materials[4] = {
-		&material_Base,
-		&material_Slope,
-		&material_LowAltitude,
-		&material_HighAltitude,
-	};
-	for (auto& material : virtual_materials)
-	{
-		for (int i = 0; i < MaterialComponent::TEXTURESLOT_COUNT; ++i)
-		{
-			switch (i)
-			{
-			case MaterialComponent::BASECOLORMAP:
-			case MaterialComponent::NORMALMAP:
-			case MaterialComponent::SURFACEMAP:
-				if (material->textures[i].resource.IsValid())
-				{
-					virtual_texture_available[i] = true;
-					const TextureDesc& desc = material->textures[i].resource.GetTexture().GetDesc();
-					max_texture_resolution = std::max(max_texture_resolution, desc.width);
-					max_texture_resolution = std::max(max_texture_resolution, desc.height);
-				}
-				break;
-			default:
-				break;
-			}
-		}
-	}
-
-	for (auto it = chunks.begin(); it != chunks.end();)
-	{
-		const Chunk& chunk = it->first;
-		ChunkData& chunk_data = it->second;
-		const int dist = std::max(std::abs(center_chunk.x - chunk.x), std::abs(center_chunk.z - chunk.z));
-
-		// chunk removal:
-		if (removalCheckBox.GetCheck())
-		{
-			if (dist > removal_threshold)
-			{
-				scene->Entity_Remove(it->second.entity);
-				it = chunks.erase(it);
-				continue; // don't increment iterator
-			}
-			else
-			{
-				// Grass patch removal:
-				if (chunk_data.grass.meshID != INVALID_ENTITY)
-				{
-					if (dist > 1)
-					{
-						scene->Entity_Remove(chunk_data.grass_entity);
-						chunk_data.grass_exists = false; // grass can be generated here by generation thread...
-					}
-				}
-			}
-		}
-
-		// Collect virtual texture update requests:
-		if (max_texture_resolution > 0)
-		{
-			uint32_t texture_lod = 0;
-			const float distsq = wi::math::DistanceSquared(camera.Eye, chunk_data.sphere.center);
-			const float radius = chunk_data.sphere.radius;
-			const float radiussq = radius * radius;
-			if (distsq < radiussq)
-			{
-				texture_lod = 0;
-			}
-			else
-			{
-				const float dist = std::sqrt(distsq);
-				const float dist_to_sphere = dist - radius;
-				texture_lod = uint32_t(dist_to_sphere * texlodMultiplier);
-			}
-
-			uint32_t chunk_required_texture_resolution = uint32_t(max_texture_resolution / std::pow(2.0f, (float)std::max(0u, texture_lod)));
-			chunk_required_texture_resolution = std::max(8u, chunk_required_texture_resolution);
-			if (chunk_data.virtual_texture_resolution != chunk_required_texture_resolution)
-			{
-				chunk_data.virtual_texture_resolution = chunk_required_texture_resolution;
-
-				MaterialComponent* material = scene->materials.GetComponent(chunk_data.entity);
-				if (material != nullptr)
-				{
-					for (int i = 0; i < MaterialComponent::TEXTURESLOT_COUNT; ++i)
-					{
-						if (virtual_texture_available[i])
-						{
-							TextureDesc desc;
-							desc.width = chunk_required_texture_resolution;
-							desc.height = chunk_required_texture_resolution;
-							desc.format = Format::R8G8B8A8_UNORM;
-							desc.bind_flags = BindFlag::SHADER_RESOURCE | BindFlag::UNORDERED_ACCESS;
-							Texture texture;
-							bool success = device->CreateTexture(&desc, nullptr, &texture);
-							assert(success);
-
-							material->textures[i].resource.SetTexture(texture);
-							virtual_texture_barriers_begin.push_back(GPUBarrier::Image(&material->textures[i].resource.GetTexture(), desc.layout, ResourceState::UNORDERED_ACCESS));
-							virtual_texture_barriers_end.push_back(GPUBarrier::Image(&material->textures[i].resource.GetTexture(), ResourceState::UNORDERED_ACCESS, desc.layout));
-						}
-					}
-
-					virtual_texture_updates.push_back(chunk);
-				}
-
-			}
-		}
-
-		it++;
-	}
-
-	// Execute batched virtual texture updates:
-	if (!virtual_texture_updates.empty())
-	{
-		CommandList cmd = device->BeginCommandList();
-		device->EventBegin("TerrainVirtualTextureUpdate", cmd);
-		auto range = wi::profiler::BeginRangeGPU("TerrainVirtualTextureUpdate", cmd);
-		device->Barrier(virtual_texture_barriers_begin.data(), (uint32_t)virtual_texture_barriers_begin.size(), cmd);
-
-		device->BindComputeShader(wi::renderer::GetShader(wi::enums::CSTYPE_TERRAIN_VIRTUALTEXTURE_UPDATE), cmd);
-
-		ShaderMaterial materials[4];
-		material_Base.WriteShaderMaterial(&materials[0]);
-		material_Slope.WriteShaderMaterial(&materials[1]);
-		material_LowAltitude.WriteShaderMaterial(&materials[2]);
-		material_HighAltitude.WriteShaderMaterial(&materials[3]);
-		device->BindDynamicConstantBuffer(materials, 10, cmd);
-
-		for (auto& chunk : virtual_texture_updates)
-		{
-			auto it = chunks.find(chunk);
-			if (it == chunks.end())
-				continue;
-			ChunkData& chunk_data = it->second;
-
-			const GPUResource* res[] = {
-				&chunk_data.region_weights_texture,
-			};
-			device->BindResources(res, 0, arraysize(res), cmd);
-
-			MaterialComponent* material = scene->materials.GetComponent(chunk_data.entity);
-			if (material != nullptr)
-			{
-				// Shrink the uvs to avoid wrap sampling across edge by object rendering shaders:
-				float virtual_texture_resolution_rcp = 1.0f / float(chunk_data.virtual_texture_resolution);
-				material->texMulAdd.x = float(chunk_data.virtual_texture_resolution - 1) * virtual_texture_resolution_rcp;
-				material->texMulAdd.y = float(chunk_data.virtual_texture_resolution - 1) * virtual_texture_resolution_rcp;
-				material->texMulAdd.z = 0.5f * virtual_texture_resolution_rcp;
-				material->texMulAdd.w = 0.5f * virtual_texture_resolution_rcp;
-
-				for (int i = 0; i < MaterialComponent::TEXTURESLOT_COUNT; ++i)
-				{
-					if (virtual_texture_available[i])
-					{
-						device->BindUAV(material->textures[i].GetGPUResource(), i, cmd);
-					}
-				}
-			}
-
-			device->Dispatch(chunk_data.virtual_texture_resolution / 8u, chunk_data.virtual_texture_resolution / 8u, 1, cmd);
-		}
-
-		device->Barrier(virtual_texture_barriers_end.data(), (uint32_t)virtual_texture_barriers_end.size(), cmd);
-		wi::profiler::EndRange(range);
-		device->EventEnd(cmd);
-	}
-
-	// Start the generation on a background thread and keep it running until the next frame
-	wi::jobsystem::Execute(generation_workload, [=](wi::jobsystem::JobArgs args) {
-
-		wi::Timer timer;
-		const float lodMultiplier = lodSlider.GetValue();
-		const int generation = (int)generationSlider.GetValue();
-		const float bottomLevel = bottomLevelSlider.GetValue();
-		const float topLevel = topLevelSlider.GetValue();
-		const float heightmapBlend = heightmapBlendSlider.GetValue();
-		const float perlinBlend = perlinBlendSlider.GetValue();
-		const uint32_t seed = (uint32_t)seedSlider.GetValue();
-		const int perlinOctaves = (int)perlinOctavesSlider.GetValue();
-		const float perlinFrequency = perlinFrequencySlider.GetValue();
-		const float voronoiBlend = voronoiBlendSlider.GetValue();
-		const float voronoiFrequency = voronoiFrequencySlider.GetValue();
-		const float voronoiFade = voronoiFadeSlider.GetValue();
-		const float voronoiShape = voronoiShapeSlider.GetValue();
-		const float voronoiFalloff = voronoiFalloffSlider.GetValue();
-		const float voronoiPerturbation = voronoiPerturbationSlider.GetValue();
-		const float region1 = region1Slider.GetValue();
-		const float region2 = region2Slider.GetValue();
-		const float region3 = region3Slider.GetValue();
-		bool generated_something = false;
-
-		auto request_chunk = [&](int offset_x, int offset_z)
-		{
-			Chunk chunk = center_chunk;
-			chunk.x += offset_x;
-			chunk.z += offset_z;
-			auto it = chunks.find(chunk);
-			if (it == chunks.end() || it->second.entity == INVALID_ENTITY)
-			{
-				// Generate a new chunk:
-				ChunkData& chunk_data = chunks[chunk];
-
-				chunk_data.entity = generation_scene.Entity_CreateObject("chunk_" + std::to_string(chunk.x) + "_" + std::to_string(chunk.z));
-				ObjectComponent& object = *generation_scene.objects.GetComponent(chunk_data.entity);
-				object.lod_distance_multiplier = lodMultiplier;
-				generation_scene.Component_Attach(chunk_data.entity, terrainEntity);
-
-				TransformComponent& transform = *generation_scene.transforms.GetComponent(chunk_data.entity);
-				transform.ClearTransform();
-				const XMFLOAT3 chunk_pos = XMFLOAT3(float(chunk.x * (chunk_width - 1)) * chunk_scale, 0, float(chunk.z * (chunk_width - 1)) * chunk_scale);
-				transform.Translate(chunk_pos);
-				transform.UpdateTransform();
-
-				MaterialComponent& material = generation_scene.materials.Create(chunk_data.entity);
-				// material params will be 1 because they will be created from only texture maps
-				//	because region materials are blended together into one texture
-				material.SetRoughness(1);
-				material.SetMetalness(1);
-				material.SetReflectance(1);
-
-				MeshComponent& mesh = generation_scene.meshes.Create(chunk_data.entity);
-				object.meshID = chunk_data.entity;
-				mesh.indices = indices;
-				for (auto& lod : lods)
-				{
-					mesh.subsets.emplace_back();
-					mesh.subsets.back().materialID = chunk_data.entity;
-					mesh.subsets.back().indexCount = lod.indexCount;
-					mesh.subsets.back().indexOffset = lod.indexOffset;
-				}
-				mesh.subsets_per_lod = 1;
-				mesh.vertex_positions.resize(vertexCount);
-				mesh.vertex_normals.resize(vertexCount);
-				mesh.vertex_uvset_0.resize(vertexCount);
-
-				wi::HairParticleSystem grass = grass_properties;
-				grass.vertex_lengths.resize(vertexCount);
-				std::atomic<uint32_t> grass_valid_vertex_count{ 0 };
-
-				// Do a parallel for loop over all the chunk's vertices and compute their properties:
-				wi::jobsystem::context ctx;
-				wi::jobsystem::Dispatch(ctx, vertexCount, chunk_width, [&](wi::jobsystem::JobArgs args) {
-					uint32_t index = args.jobIndex;
-					const float x = (float(index % chunk_width) - chunk_half_width) * chunk_scale;
-					const float z = (float(index / chunk_width) - chunk_half_width) * chunk_scale;
-					XMVECTOR corners[3];
-					XMFLOAT2 corner_offsets[3] = {
-						XMFLOAT2(0, 0),
-						XMFLOAT2(1, 0),
-						XMFLOAT2(0, 1),
-					};
-					for (int i = 0; i < arraysize(corners); ++i)
-					{
-						float height = 0;
-						const XMFLOAT2 world_pos = XMFLOAT2(chunk_pos.x + x + corner_offsets[i].x, chunk_pos.z + z + corner_offsets[i].y);
-						if (perlinBlend > 0)
-						{
-							XMFLOAT2 p = world_pos;
-							p.x *= perlinFrequency;
-							p.y *= perlinFrequency;
-							height += (perlin.compute(p.x, p.y, 0, perlinOctaves) * 0.5f + 0.5f) * perlinBlend;
-						}
-						if (voronoiBlend > 0)
-						{
-							XMFLOAT2 p = world_pos;
-							p.x *= voronoiFrequency;
-							p.y *= voronoiFrequency;
-							if (voronoiPerturbation > 0)
-							{
-								const float angle = perlin.compute(p.x, p.y, 0, 6) * XM_2PI;
-								p.x += std::sin(angle) * voronoiPerturbation;
-								p.y += std::cos(angle) * voronoiPerturbation;
-							}
-							wi::noise::voronoi::Result res = wi::noise::voronoi::compute(p.x, p.y, (float)seed);
-							float weight = std::pow(1 - wi::math::saturate((res.distance - voronoiShape) * voronoiFade), std::max(0.0001f, voronoiFalloff));
-							height *= weight * voronoiBlend;
-						}
-						if (!heightmap.data.empty())
-						{
-							XMFLOAT2 pixel = XMFLOAT2(world_pos.x + heightmap.width * 0.5f, world_pos.y + heightmap.height * 0.5f);
-							if (pixel.x >= 0 && pixel.x < heightmap.width && pixel.y >= 0 && pixel.y < heightmap.height)
-							{
-								const int idx = int(pixel.x) + int(pixel.y) * heightmap.width;
-								height = ((float)heightmap.data[idx] / 255.0f) * heightmapBlend;
-							}
-						}
-						height = wi::math::Lerp(bottomLevel, topLevel, height);
-						corners[i] = XMVectorSet(world_pos.x, height, world_pos.y, 0);
-					}
-					const float height = XMVectorGetY(corners[0]);
-					const XMVECTOR T = XMVectorSubtract(corners[2], corners[1]);
-					const XMVECTOR B = XMVectorSubtract(corners[1], corners[0]);
-					const XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
-					XMFLOAT3 normal;
-					XMStoreFloat3(&normal, N);
-
-					const float region_base = 1;
-					const float region_slope = std::pow(1.0f - wi::math::saturate(normal.y), region1);
-					const float region_low_altitude = bottomLevel == 0 ? 0 : std::pow(wi::math::saturate(wi::math::InverseLerp(0, bottomLevel, height)), region2);
-					const float region_high_altitude = topLevel == 0 ? 0 : std::pow(wi::math::saturate(wi::math::InverseLerp(0, topLevel, height)), region3);
-
-					XMFLOAT4 materialBlendWeights(region_base, 0, 0, 0);
-					materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 1, 0, 0), region_slope);
-					materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 0, 1, 0), region_low_altitude);
-					materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 0, 0, 1), region_high_altitude);
-					const float weight_norm = 1.0f / (materialBlendWeights.x + materialBlendWeights.y + materialBlendWeights.z + materialBlendWeights.w);
-					materialBlendWeights.x *= weight_norm;
-					materialBlendWeights.y *= weight_norm;
-					materialBlendWeights.z *= weight_norm;
-					materialBlendWeights.w *= weight_norm;
-
-					chunk_data.region_weights[index] = wi::Color::fromFloat4(materialBlendWeights);
-
-					mesh.vertex_positions[index] = XMFLOAT3(x, height, z);
-					mesh.vertex_normals[index] = normal;
-					const XMFLOAT2 uv = XMFLOAT2(x * chunk_scale_rcp * chunk_width_rcp + 0.5f, z * chunk_scale_rcp * chunk_width_rcp + 0.5f);
-					mesh.vertex_uvset_0[index] = uv;
-
-					XMFLOAT3 vertex_pos(chunk_pos.x + x, height, chunk_pos.z + z);
-
-					const float grass_noise_frequency = 0.1f;
-					const float grass_noise = perlin.compute(vertex_pos.x * grass_noise_frequency, vertex_pos.y * grass_noise_frequency, vertex_pos.z * grass_noise_frequency) * 0.5f + 0.5f;
-					const float region_grass = std::pow(materialBlendWeights.x * (1 - materialBlendWeights.w), 8.0f) * grass_noise;
-					if (region_grass > 0.1f)
-					{
-						grass_valid_vertex_count.fetch_add(1);
-						grass.vertex_lengths[index] = region_grass;
-					}
-					else
-					{
-						grass.vertex_lengths[index] = 0;
-					}
-					});
-				wi::jobsystem::Wait(ctx); // wait until chunk's vertex buffer is fully generated
-
-				wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
-					mesh.CreateRenderData();
-					chunk_data.sphere.center = mesh.aabb.getCenter();
-					chunk_data.sphere.center.x += chunk_pos.x;
-					chunk_data.sphere.center.y += chunk_pos.y;
-					chunk_data.sphere.center.z += chunk_pos.z;
-					chunk_data.sphere.radius = mesh.aabb.getRadius();
-					});
-
-				// If there were any vertices in this chunk that could be valid for grass, store the grass particle system:
-				if (grass_valid_vertex_count.load() > 0)
-				{
-					chunk_data.grass_entity = CreateEntity();
-					chunk_data.grass = std::move(grass); // the grass will be added to the scene later, only when the chunk is close to the camera (center chunk's neighbors)
-					chunk_data.grass.meshID = chunk_data.entity;
-					chunk_data.grass.strandCount = grass_valid_vertex_count.load() * 3;
-					chunk_data.grass.viewDistance = chunk_width;
-				}
-
-				// Prop placement:
-				chunk_data.prop_rand.seed((uint32_t)chunk.compute_hash() ^ seed);
-				for (auto& prop : props)
-				{
-					std::uniform_int_distribution<uint32_t> gen_distr(prop.min_count_per_chunk, prop.max_count_per_chunk);
-					int gen_count = gen_distr(chunk_data.prop_rand);
-					for (int i = 0; i < gen_count; ++i)
-					{
-						std::uniform_real_distribution<float> float_distr(0.0f, 1.0f);
-						std::uniform_int_distribution<uint32_t> ind_distr(0, lods[0].indexCount / 3 - 1);
-						uint32_t tri = ind_distr(chunk_data.prop_rand); // random triangle on the chunk mesh
-						uint32_t ind0 = mesh.indices[tri * 3 + 0];
-						uint32_t ind1 = mesh.indices[tri * 3 + 1];
-						uint32_t ind2 = mesh.indices[tri * 3 + 2];
-						const XMFLOAT3& pos0 = mesh.vertex_positions[ind0];
-						const XMFLOAT3& pos1 = mesh.vertex_positions[ind1];
-						const XMFLOAT3& pos2 = mesh.vertex_positions[ind2];
-						const XMFLOAT4 region0 = chunk_data.region_weights[ind0];
-						const XMFLOAT4 region1 = chunk_data.region_weights[ind1];
-						const XMFLOAT4 region2 = chunk_data.region_weights[ind2];
-						// random barycentric coords on the triangle:
-						float f = float_distr(chunk_data.prop_rand);
-						float g = float_distr(chunk_data.prop_rand);
-						if (f + g > 1)
-						{
-							f = 1 - f;
-							g = 1 - g;
-						}
-						XMFLOAT3 vertex_pos;
-						vertex_pos.x = pos0.x + f * (pos1.x - pos0.x) + g * (pos2.x - pos0.x);
-						vertex_pos.y = pos0.y + f * (pos1.y - pos0.y) + g * (pos2.y - pos0.y);
-						vertex_pos.z = pos0.z + f * (pos1.z - pos0.z) + g * (pos2.z - pos0.z);
-						vertex_pos.x += chunk_pos.x;
-						vertex_pos.z += chunk_pos.z;
-						XMFLOAT4 region;
-						region.x = region0.x + f * (region1.x - region0.x) + g * (region2.x - region0.x);
-						region.y = region0.y + f * (region1.y - region0.y) + g * (region2.y - region0.y);
-						region.z = region0.z + f * (region1.z - region0.z) + g * (region2.z - region0.z);
-						region.w = region0.w + f * (region1.w - region0.w) + g * (region2.w - region0.w);
-
-						const float noise = std::pow(perlin.compute(vertex_pos.x * prop.noise_frequency, vertex_pos.y * prop.noise_frequency, vertex_pos.z * prop.noise_frequency) * 0.5f + 0.5f, prop.noise_power);
-						const float chance = std::pow(((float*)&region)[prop.region], prop.region_power) * noise;
-						if (chance > prop.threshold)
-						{
-							Entity entity = generation_scene.Entity_CreateObject(prop.name + std::to_string(i));
-							ObjectComponent* object = generation_scene.objects.GetComponent(entity);
-							*object = prop.object;
-							TransformComponent* transform = generation_scene.transforms.GetComponent(entity);
-							XMFLOAT3 offset = vertex_pos;
-							offset.y += wi::math::Lerp(prop.min_y_offset, prop.max_y_offset, float_distr(chunk_data.prop_rand));
-							transform->Translate(offset);
-							const float scaling = wi::math::Lerp(prop.min_size, prop.max_size, float_distr(chunk_data.prop_rand));
-							transform->Scale(XMFLOAT3(scaling, scaling, scaling));
-							transform->RotateRollPitchYaw(XMFLOAT3(0, XM_2PI * float_distr(chunk_data.prop_rand), 0));
-							transform->UpdateTransform();
-							generation_scene.Component_Attach(entity, chunk_data.entity);
-						}
-					}
-				}
-
-				// Create the blend weights texture for virtual texture update:
-				{
-					TextureDesc desc;
-					desc.width = (uint32_t)chunk_width;
-					desc.height = (uint32_t)chunk_width;
-					desc.format = Format::R8G8B8A8_UNORM;
-					desc.bind_flags = BindFlag::SHADER_RESOURCE;
-					SubresourceData data;
-					data.data_ptr = chunk_data.region_weights;
-					data.row_pitch = chunk_width * sizeof(chunk_data.region_weights[0]);
-					bool success = device->CreateTexture(&desc, &data, &chunk_data.region_weights_texture);
-					assert(success);
-				}
-
-				wi::jobsystem::Wait(ctx); // wait until mesh.CreateRenderData() async task finishes
-				generated_something = true;
-			}
-
-			// Grass patch placement:
-			const int dist = std::max(std::abs(center_chunk.x - chunk.x), std::abs(center_chunk.z - chunk.z));
-			if (dist <= 1)
-			{
-				it = chunks.find(chunk);
-				if (it != chunks.end() && it->second.entity != INVALID_ENTITY)
-				{
-					ChunkData& chunk_data = it->second;
-					if (chunk_data.grass.meshID != INVALID_ENTITY)
-					{
-						if (!chunk_data.grass_exists)
-						{
-							// add patch for this chunk
-							wi::HairParticleSystem& grass = generation_scene.hairs.Create(chunk_data.grass_entity);
-							grass = chunk_data.grass;
-							generation_scene.materials.Create(chunk_data.grass_entity) = material_GrassParticle;
-							generation_scene.transforms.Create(chunk_data.grass_entity);
-							generation_scene.names.Create(chunk_data.grass_entity) = "grass";
-							generation_scene.Component_Attach(chunk_data.grass_entity, chunk_data.entity, true);
-							chunk_data.grass_exists = true; // don't generate more grass here
-							generated_something = true;
-						}
-					}
-				}
-			}
-
-			if (generated_something && timer.elapsed_milliseconds() > generation_time_budget_milliseconds)
-			{
-				generation_cancelled.store(true);
-			}
-
-		};
-
-		// generate center chunk first:
-		request_chunk(0, 0);
-		if (generation_cancelled.load()) return;
-
-		// then generate neighbor chunks in outward spiral:
-		for (int growth = 0; growth < generation; ++growth)
-		{
-			const int side = 2 * (growth + 1);
-			int x = -growth - 1;
-			int z = -growth - 1;
-			for (int i = 0; i < side; ++i)
-			{
-				request_chunk(x, z);
-				if (generation_cancelled.load()) return;
-				x++;
-			}
-			for (int i = 0; i < side; ++i)
-			{
-				request_chunk(x, z);
-				if (generation_cancelled.load()) return;
-				z++;
-			}
-			for (int i = 0; i < side; ++i)
-			{
-				request_chunk(x, z);
-				if (generation_cancelled.load()) return;
-				x--;
-			}
-			for (int i = 0; i < side; ++i)
-			{
-				request_chunk(x, z);
-				if (generation_cancelled.load()) return;
-				z--;
-			}
-		}
-
-		});
-
-}
-
-void TerrainGenerator::Generation_Cancel()
-{
-	generation_cancelled.store(true); // tell the generation thread that work must be stopped
-	wi::jobsystem::Wait(generation_workload); // waits until generation thread exits
-	generation_cancelled.store(false); // the next generation can run
-}
-
-void TerrainGenerator::BakeVirtualTexturesToFiles()
-{
-	if (terrainEntity == INVALID_ENTITY)
-	{
-		return;
-	}
-
-	wi::jobsystem::context ctx;
-
-	static const std::string extension = "PNG";
-
-	for (auto it = chunks.begin(); it != chunks.end(); it++)
-	{
-		const Chunk& chunk = it->first;
-		ChunkData& chunk_data = it->second;
-		MaterialComponent* material = scene->materials.GetComponent(chunk_data.entity);
-		if (material != nullptr)
-		{
-			for (int i = 0; i < MaterialComponent::TEXTURESLOT_COUNT; ++i)
-			{
-				auto& tex = material->textures[i];
-				switch (i)
-				{
-				case MaterialComponent::BASECOLORMAP:
-				case MaterialComponent::SURFACEMAP:
-				case MaterialComponent::NORMALMAP:
-					if (tex.name.empty() && tex.GetGPUResource() != nullptr)
-					{
-						wi::vector<uint8_t> filedata;
-						if (wi::helper::saveTextureToMemory(tex.resource.GetTexture(), filedata))
-						{
-							tex.resource.SetFileData(std::move(filedata));
-							wi::jobsystem::Execute(ctx, [i, &tex, chunk](wi::jobsystem::JobArgs args) {
-								wi::vector<uint8_t> filedata_ktx2;
-								if (wi::helper::saveTextureToMemoryFile(tex.resource.GetFileData(), tex.resource.GetTexture().desc, extension, filedata_ktx2))
-								{
-									tex.name = std::to_string(chunk.x) + "_" + std::to_string(chunk.z);
-									switch (i)
-									{
-									case MaterialComponent::BASECOLORMAP:
-										tex.name += "_basecolormap";
-										break;
-									case MaterialComponent::SURFACEMAP:
-										tex.name += "_surfacemap";
-										break;
-									case MaterialComponent::NORMALMAP:
-										tex.name += "_normalmap";
-										break;
-									default:
-										break;
-									}
-									tex.name += "." + extension;
-									tex.resource = wi::resourcemanager::Load(tex.name, wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA, filedata_ktx2.data(), filedata_ktx2.size());
-								}
-								});
-						}
-					}
-					break;
-				default:
-					break;
-				}
-			}
-		}
-	}
-
-	wi::helper::messageBox("Baking terrain virtual textures, this could take a while!", "Attention!");
-
-	wi::jobsystem::Wait(ctx);
-
-	for (auto it = chunks.begin(); it != chunks.end(); it++)
-	{
-		const Chunk& chunk = it->first;
-		ChunkData& chunk_data = it->second;
-		MaterialComponent* material = scene->materials.GetComponent(chunk_data.entity);
-		if (material != nullptr)
-		{
-			material->CreateRenderData();
-		}
-	}
-}
@@ -69,7 +69,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 		}
 	}
 
-	editor.renderComponent.terragen.Generation_Cancel();
+	editor.renderComponent.terragen.terrain.Generation_Cancel();
 
     return (int) msg.wParam;
 }
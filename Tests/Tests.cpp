@@ -6,6 +6,7 @@
 #include <thread>
 #include <unordered_map>
 #include <vector>
+#include <random>
 
 using namespace wi::ecs;
 using namespace wi::scene;
@@ -32,6 +33,18 @@ enum TEST_TYPE
 	INVERSEKINEMATICSTEST,
 	INSTANCESTEST,
 	CONTAINERPERF,
+	RADIXSORTPERF,
+	FORWARDCULLINGPERF,
+	ANIMATIONPERF,
+	PHYSICSPERF,
+	PARTICLEPERF,
+	OCEANPERF,
+	MESHNORMALSPERF,
+	DRAWMERGETEST,
+	OCCLUSIONTEST,
+	CLUSTERTEST,
+	CONVEXHULLTEST,
+	PHYSICSQUERYTEST,
 };
 
 // Controller Test UI Data, info down below will be using Xbox Controller as reference
@@ -173,6 +186,18 @@ void TestsRenderer::Load()
 	testSelector.AddItem("Inverse Kinematics", INVERSEKINEMATICSTEST);
 	testSelector.AddItem("65k Instances", INSTANCESTEST);
 	testSelector.AddItem("Container perf", CONTAINERPERF);
+	testSelector.AddItem("Radix sort perf", RADIXSORTPERF);
+	testSelector.AddItem("Forward culling perf", FORWARDCULLINGPERF);
+	testSelector.AddItem("Animation crowd perf", ANIMATIONPERF);
+	testSelector.AddItem("Physics perf", PHYSICSPERF);
+	testSelector.AddItem("Particle perf", PARTICLEPERF);
+	testSelector.AddItem("Ocean CPU perf", OCEANPERF);
+	testSelector.AddItem("Mesh normals perf", MESHNORMALSPERF);
+	testSelector.AddItem("Draw merging test", DRAWMERGETEST);
+	testSelector.AddItem("Occlusion buffer test", OCCLUSIONTEST);
+	testSelector.AddItem("Mesh cluster test", CLUSTERTEST);
+	testSelector.AddItem("Convex hull test", CONVEXHULLTEST);
+	testSelector.AddItem("Physics query test", PHYSICSQUERYTEST);
 	testSelector.SetMaxVisibleItemCount(10);
 	testSelector.OnSelect([=](wi::gui::EventArgs args) {
 
@@ -429,6 +454,50 @@ void TestsRenderer::Load()
 			ContainerTest();
 			break;
 
+		case RADIXSORTPERF:
+			RadixSortTest();
+			break;
+
+		case FORWARDCULLINGPERF:
+			ForwardEntityCullingTest();
+			break;
+
+		case ANIMATIONPERF:
+			AnimationCrowdTest();
+			break;
+
+		case PHYSICSPERF:
+			PhysicsBenchmarkTest();
+			break;
+
+		case PARTICLEPERF:
+			ParticleBenchmarkTest();
+			break;
+
+		case OCEANPERF:
+			OceanBenchmarkTest();
+			break;
+
+		case MESHNORMALSPERF:
+			MeshNormalsBenchmarkTest();
+			break;
+
+		case DRAWMERGETEST:
+			DrawMergeTest();
+			break;
+		case OCCLUSIONTEST:
+			OcclusionBufferTest();
+			break;
+		case CLUSTERTEST:
+			ClusterCullingTest();
+			break;
+		case CONVEXHULLTEST:
+			ConvexHullTest();
+			break;
+		case PHYSICSQUERYTEST:
+			PhysicsQueryTest();
+			break;
+
 		default:
 			assert(0);
 			break;
@@ -1219,3 +1288,1577 @@ void TestsRenderer::ContainerTest()
 	font.params.size = 24;
 	this->AddFont(&font);
 }
+void TestsRenderer::RadixSortTest()
+{
+	wi::Timer timer;
+
+	std::string ss = "Render queue sort test with " + std::to_string(wi::jobsystem::GetThreadCount()) + " worker threads:\n";
+
+	const size_t counts[] = { 1000, 10000, 50000, 200000, 1000000 };
+	for (size_t count : counts)
+	{
+		// Generate keys similar to render queue keys: 6-bit pipeline | 20-bit mesh index | 14-bit distance | 24-bit instance index
+		wi::vector<uint64_t> keys(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t meshIndex = wi::random::GetRandom(0u, 2000u);
+			const uint64_t pipelineKey = meshIndex % 13;
+			const uint64_t distance = (XMConvertFloatToHalf(wi::random::GetRandom(0.0f, 1000.0f)) >> 1) & 0x3FFF;
+			const uint64_t instanceIndex = i;
+			keys[i] = (pipelineKey << 58ull) | (meshIndex << 38ull) | (distance << 24ull) | instanceIndex;
+		}
+		wi::vector<uint64_t> scratch(count);
+		wi::vector<uint32_t> histograms;
+
+		ss += "\n" + std::to_string(count) + " keys:\n";
+
+		wi::vector<uint64_t> reference = keys;
+		timer.record();
+		std::sort(reference.begin(), reference.end());
+		ss += "std::sort: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		wi::vector<uint64_t> sorted = keys;
+		timer.record();
+		wi::sort::RadixSort(sorted.data(), scratch.data(), count);
+		ss += "wi::sort::RadixSort: " + std::to_string(timer.elapsed_milliseconds()) + " ms";
+		ss += sorted == reference ? "\n" : " (INCORRECT RESULT!)\n";
+
+		sorted = keys;
+		timer.record();
+		wi::sort::RadixSortParallel(sorted.data(), scratch.data(), count, histograms);
+		ss += "wi::sort::RadixSortParallel: " + std::to_string(timer.elapsed_milliseconds()) + " ms";
+		ss += sorted == reference ? "\n" : " (INCORRECT RESULT!)\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::ForwardEntityCullingTest()
+{
+	wi::Timer timer;
+
+	// Random lights, decals and env probes are placed into a scene, only their bounds are needed for culling:
+	static wi::scene::Scene scene;
+	scene.Clear();
+	static wi::renderer::Visibility vis;
+	vis.Clear();
+	vis.scene = &scene;
+	auto random_aabb = [](float extent, float min_size, float max_size) {
+		const XMFLOAT3 center = XMFLOAT3(wi::random::GetRandom(-extent, extent), wi::random::GetRandom(-extent, extent), wi::random::GetRandom(-extent, extent));
+		const float size = wi::random::GetRandom(min_size, max_size);
+		wi::primitive::AABB aabb;
+		aabb.createFromHalfWidth(center, XMFLOAT3(size, size, size));
+		return aabb;
+	};
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		vis.visibleLights.push_back((uint32_t)scene.aabb_lights.GetCount());
+		scene.aabb_lights.Create(wi::ecs::CreateEntity()) = random_aabb(100, 2, 30);
+	}
+	for (uint32_t i = 0; i < 32; ++i)
+	{
+		vis.visibleDecals.push_back((uint32_t)scene.aabb_decals.GetCount());
+		scene.aabb_decals.Create(wi::ecs::CreateEntity()) = random_aabb(100, 1, 10);
+		vis.visibleEnvProbes.push_back((uint32_t)scene.aabb_probes.GetCount());
+		scene.aabb_probes.Create(wi::ecs::CreateEntity()) = random_aabb(100, 10, 40);
+	}
+
+	std::string ss = "Forward entity culling test with 64 lights, 32 decals and 32 env probes:\n";
+
+	const size_t counts[] = { 100, 1000, 10000, 100000 };
+	for (size_t count : counts)
+	{
+		wi::vector<wi::primitive::AABB> batches(count);
+		for (auto& aabb : batches)
+		{
+			aabb = random_aabb(100, 0.5f, 10);
+		}
+		ss += "\n" + std::to_string(count) + " batches:\n";
+
+		wi::vector<ForwardEntityMaskCB> reference(count);
+		timer.record();
+		for (size_t i = 0; i < count; ++i)
+		{
+			reference[i] = wi::renderer::ForwardEntityCullingCPU(vis, batches[i], wi::enums::RENDERPASS_VOXELIZE);
+		}
+		ss += "Brute force: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		static wi::renderer::ForwardEntityClusters clusters;
+		wi::vector<ForwardEntityMaskCB> clustered(count);
+		timer.record();
+		wi::primitive::AABB bounds;
+		for (auto& aabb : batches)
+		{
+			bounds = wi::primitive::AABB::Merge(bounds, aabb);
+		}
+		clusters.Build(vis, bounds, wi::enums::RENDERPASS_VOXELIZE);
+		for (size_t i = 0; i < count; ++i)
+		{
+			clustered[i] = clusters.Cull(batches[i]);
+		}
+		ss += "Clustered: " + std::to_string(timer.elapsed_milliseconds()) + " ms";
+
+		bool correct = true;
+		for (size_t i = 0; i < count; ++i)
+		{
+			correct &= reference[i].xForwardLightMask.x == clustered[i].xForwardLightMask.x;
+			correct &= reference[i].xForwardLightMask.y == clustered[i].xForwardLightMask.y;
+			correct &= reference[i].xForwardDecalMask == clustered[i].xForwardDecalMask;
+			correct &= reference[i].xForwardEnvProbeMask == clustered[i].xForwardEnvProbeMask;
+		}
+		ss += correct ? "\n" : " (INCORRECT RESULT!)\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+// The previous serial animation update with linear keyframe search (only linear translation, rotation, scale), for comparison:
+static void RunAnimationUpdateReference(wi::scene::Scene& scene)
+{
+	for (size_t i = 0; i < scene.animations.GetCount(); ++i)
+	{
+		AnimationComponent& animation = scene.animations[i];
+		if (!animation.IsPlaying() && animation.timer == 0.0f)
+		{
+			continue;
+		}
+
+		for (const AnimationComponent::AnimationChannel& channel : animation.channels)
+		{
+			const AnimationComponent::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+			const AnimationDataComponent* animationdata = scene.animation_datas.GetComponent(sampler.data);
+			TransformComponent* target_transform = scene.transforms.GetComponent(channel.target);
+			if (animationdata == nullptr || target_transform == nullptr)
+				continue;
+
+			int keyLeft = 0;
+			int keyRight = 0;
+			if (animationdata->keyframe_times.back() < animation.timer)
+			{
+				keyLeft = keyRight = (int)animationdata->keyframe_times.size() - 1;
+			}
+			else
+			{
+				while (animationdata->keyframe_times[keyRight++] < animation.timer) {}
+				keyRight--;
+				keyLeft = std::max(0, keyRight - 1);
+			}
+
+			float t = 0;
+			if (keyLeft != keyRight)
+			{
+				const float left = animationdata->keyframe_times[keyLeft];
+				const float right = animationdata->keyframe_times[keyRight];
+				t = (animation.timer - left) / (right - left);
+			}
+
+			TransformComponent transform = *target_transform;
+			switch (channel.path)
+			{
+			default:
+			case AnimationComponent::AnimationChannel::Path::TRANSLATION:
+			{
+				const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
+				XMStoreFloat3(&transform.translation_local, XMVectorLerp(XMLoadFloat3(&data[keyLeft]), XMLoadFloat3(&data[keyRight]), t));
+			}
+			break;
+			case AnimationComponent::AnimationChannel::Path::ROTATION:
+			{
+				const XMFLOAT4* data = (const XMFLOAT4*)animationdata->keyframe_data.data();
+				XMStoreFloat4(&transform.rotation_local, XMQuaternionNormalize(XMQuaternionSlerp(XMLoadFloat4(&data[keyLeft]), XMLoadFloat4(&data[keyRight]), t)));
+			}
+			break;
+			case AnimationComponent::AnimationChannel::Path::SCALE:
+			{
+				const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
+				XMStoreFloat3(&transform.scale_local, XMVectorLerp(XMLoadFloat3(&data[keyLeft]), XMLoadFloat3(&data[keyRight]), t));
+			}
+			break;
+			}
+
+			target_transform->SetDirty();
+			const float amount = animation.amount;
+			XMStoreFloat3(&target_transform->scale_local, XMVectorLerp(XMLoadFloat3(&target_transform->scale_local), XMLoadFloat3(&transform.scale_local), amount));
+			XMStoreFloat4(&target_transform->rotation_local, XMQuaternionSlerp(XMLoadFloat4(&target_transform->rotation_local), XMLoadFloat4(&transform.rotation_local), amount));
+			XMStoreFloat3(&target_transform->translation_local, XMVectorLerp(XMLoadFloat3(&target_transform->translation_local), XMLoadFloat3(&transform.translation_local), amount));
+		}
+
+		if (animation.IsPlaying())
+		{
+			animation.timer += scene.dt * animation.speed;
+		}
+		if (animation.IsLooped() && animation.timer > animation.end)
+		{
+			animation.timer = animation.start;
+		}
+	}
+}
+
+void TestsRenderer::AnimationCrowdTest()
+{
+	wi::Timer timer;
+
+	// 500 characters with 60 bones play the same 30 second clip with different time offsets:
+	const uint32_t characterCount = 500;
+	const uint32_t boneCount = 60;
+	const uint32_t keyframeCount = 30 * 30 + 1;
+	static wi::scene::Scene scene;
+	scene.Clear();
+	scene.dt = 1.0f / 60.0f;
+
+	Entity datas[boneCount][3];
+	for (uint32_t bone = 0; bone < boneCount; ++bone)
+	{
+		for (uint32_t path = 0; path < 3; ++path)
+		{
+			datas[bone][path] = CreateEntity();
+			AnimationDataComponent& data = scene.animation_datas.Create(datas[bone][path]);
+			const uint32_t components = path == AnimationComponent::AnimationChannel::Path::ROTATION ? 4 : 3;
+			data.keyframe_times.resize(keyframeCount);
+			data.keyframe_data.resize(keyframeCount * components);
+			// Smooth motion like motion capture data, some components are constant:
+			XMFLOAT3 frequency = XMFLOAT3(wi::random::GetRandom(0.1f, 2.0f), wi::random::GetRandom(0.1f, 2.0f), wi::random::GetRandom(0.0f, 1.0f) < 0.5f ? 0.0f : 1.0f);
+			XMFLOAT3 phase = XMFLOAT3(wi::random::GetRandom(0.0f, XM_2PI), wi::random::GetRandom(0.0f, XM_2PI), wi::random::GetRandom(0.0f, XM_2PI));
+			for (uint32_t key = 0; key < keyframeCount; ++key)
+			{
+				const float time = key / 30.0f;
+				data.keyframe_times[key] = time;
+				const XMFLOAT3 wave = XMFLOAT3(std::sin(time * frequency.x + phase.x), std::sin(time * frequency.y + phase.y), std::sin(time * frequency.z + phase.z));
+				if (path == AnimationComponent::AnimationChannel::Path::ROTATION)
+				{
+					XMFLOAT4 q;
+					XMStoreFloat4(&q, XMQuaternionRotationRollPitchYaw(wave.x * 0.5f, wave.y * 0.5f, wave.z * 0.5f));
+					std::memcpy(&data.keyframe_data[key * 4], &q, sizeof(q));
+				}
+				else
+				{
+					data.keyframe_data[key * 3 + 0] = 1 + wave.x * 0.1f;
+					data.keyframe_data[key * 3 + 1] = 1 + wave.y * 0.1f;
+					data.keyframe_data[key * 3 + 2] = 1 + wave.z * 0.1f;
+				}
+			}
+		}
+	}
+
+	for (uint32_t character = 0; character < characterCount; ++character)
+	{
+		AnimationComponent& animation = scene.animations.Create(CreateEntity());
+		animation.start = 0;
+		animation.end = (keyframeCount - 1) / 30.0f;
+		animation.timer = wi::random::GetRandom(0.0f, animation.end);
+		animation.Play();
+		for (uint32_t bone = 0; bone < boneCount; ++bone)
+		{
+			Entity entity = CreateEntity();
+			scene.transforms.Create(entity);
+			for (uint32_t path = 0; path < 3; ++path)
+			{
+				AnimationComponent::AnimationChannel& channel = animation.channels.emplace_back();
+				channel.target = entity;
+				channel.path = (AnimationComponent::AnimationChannel::Path)path;
+				channel.samplerIndex = (int)animation.samplers.size();
+				AnimationComponent::AnimationSampler& sampler = animation.samplers.emplace_back();
+				sampler.data = datas[bone][path];
+			}
+		}
+	}
+
+	wi::vector<float> timers(scene.animations.GetCount());
+	for (size_t i = 0; i < scene.animations.GetCount(); ++i)
+	{
+		timers[i] = scene.animations[i].timer;
+	}
+	auto reset = [&]() {
+		for (size_t i = 0; i < scene.animations.GetCount(); ++i)
+		{
+			scene.animations[i].timer = timers[i];
+		}
+		for (size_t i = 0; i < scene.transforms.GetCount(); ++i)
+		{
+			scene.transforms[i] = TransformComponent();
+		}
+	};
+
+	const int frameCount = 60;
+	wi::jobsystem::context ctx;
+
+	std::string ss = "Animation update of " + std::to_string(characterCount) + " characters, " + std::to_string(characterCount * boneCount * 3) + " channels, " + std::to_string(keyframeCount) + " keyframes per channel:\n";
+
+	reset();
+	timer.record();
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		RunAnimationUpdateReference(scene);
+	}
+	ss += "Serial, linear keyframe search: " + std::to_string(timer.elapsed_milliseconds() / frameCount) + " ms / frame\n";
+	wi::vector<TransformComponent> reference(scene.transforms.GetCount());
+	for (size_t i = 0; i < scene.transforms.GetCount(); ++i)
+	{
+		reference[i] = scene.transforms[i];
+	}
+
+	reset();
+	timer.record();
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		scene.RunAnimationUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+	}
+	ss += "Parallel, keyframe cursors (" + std::to_string(wi::jobsystem::GetThreadCount()) + " threads): " + std::to_string(timer.elapsed_milliseconds() / frameCount) + " ms / frame";
+
+	auto get_max_error = [&]() {
+		float max_error = 0;
+		for (size_t i = 0; i < scene.transforms.GetCount(); ++i)
+		{
+			const TransformComponent& a = reference[i];
+			const TransformComponent& b = scene.transforms[i];
+			max_error = std::max(max_error, wi::math::Distance(a.translation_local, b.translation_local));
+			max_error = std::max(max_error, wi::math::Distance(a.scale_local, b.scale_local));
+			max_error = std::max(max_error, std::abs(std::abs(XMVectorGetX(XMQuaternionDot(XMLoadFloat4(&a.rotation_local), XMLoadFloat4(&b.rotation_local)))) - 1));
+		}
+		return max_error;
+	};
+	ss += get_max_error() < 0.001f ? "\n" : " (INCORRECT RESULT!)\n";
+
+	// Compressed keyframes:
+	size_t memory_before = 0;
+	for (size_t i = 0; i < scene.animation_datas.GetCount(); ++i)
+	{
+		memory_before += scene.animation_datas[i].GetMemorySize();
+	}
+	timer.record();
+	const size_t compressed = scene.CompressAnimations();
+	const double compression_time = timer.elapsed_milliseconds();
+	size_t memory_after = 0;
+	for (size_t i = 0; i < scene.animation_datas.GetCount(); ++i)
+	{
+		memory_after += scene.animation_datas[i].GetMemorySize();
+	}
+	ss += "\nCompressed " + std::to_string(compressed) + " tracks in " + std::to_string(compression_time) + " ms\n";
+	ss += "Keyframe memory: " + std::to_string(memory_before / 1024) + " KB -> " + std::to_string(memory_after / 1024) + " KB\n";
+
+	reset();
+	timer.record();
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		scene.RunAnimationUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+	}
+	ss += "Parallel, compressed: " + std::to_string(timer.elapsed_milliseconds() / frameCount) + " ms / frame\n";
+	ss += "Max error compared to uncompressed: " + std::to_string(get_max_error()) + "\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::PhysicsBenchmarkTest()
+{
+	wi::Timer timer;
+
+	// 5000 rigid bodies are dropped onto a ground box, the scene is generated from a fixed seed, so every run simulates the same thing:
+	const uint32_t bodyCount = 5000;
+	const int frameCount = 300;
+	const float dt = 1.0f / 60.0f;
+	static wi::scene::Scene scene;
+	wi::jobsystem::context ctx;
+
+	const bool simulation_enabled = wi::physics::IsSimulationEnabled();
+	const bool multithreading_enabled = wi::physics::IsMultithreadingEnabled();
+	const bool deterministic_enabled = wi::physics::IsDeterministicEnabled();
+	wi::physics::SetDeterministicEnabled(true); // one fixed step per update, the results of every run must be bit-identical
+
+	auto clear = [&]() {
+		// This also destroys the physics world of the scene:
+		scene.Clear();
+	};
+
+	auto create = [&](wi::scene::Scene& scene, uint32_t bodyCount) {
+		scene.Clear();
+
+		Entity ground = CreateEntity();
+		scene.transforms.Create(ground).Translate(XMFLOAT3(0, -1, 0));
+		RigidBodyPhysicsComponent& groundbody = scene.rigidbodies.Create(ground);
+		groundbody.shape = RigidBodyPhysicsComponent::CollisionShape::BOX;
+		groundbody.box.halfextents = XMFLOAT3(100, 1, 100);
+		groundbody.mass = 0;
+
+		std::mt19937 rand(2022);
+		std::uniform_real_distribution<float> horizontal(-30.0f, 30.0f);
+		std::uniform_real_distribution<float> vertical(1.0f, 80.0f);
+		for (uint32_t i = 0; i < bodyCount; ++i)
+		{
+			Entity entity = CreateEntity();
+			TransformComponent& transform = scene.transforms.Create(entity);
+			const float x = horizontal(rand);
+			const float y = vertical(rand);
+			const float z = horizontal(rand);
+			transform.Translate(XMFLOAT3(x, y, z));
+			RigidBodyPhysicsComponent& rigidbody = scene.rigidbodies.Create(entity);
+			rigidbody.shape = (RigidBodyPhysicsComponent::CollisionShape)(i % 3);
+			rigidbody.box.halfextents = XMFLOAT3(0.5f, 0.5f, 0.5f);
+			rigidbody.sphere.radius = 0.5f;
+			rigidbody.capsule.radius = 0.3f;
+			rigidbody.capsule.height = 0.6f;
+		}
+	};
+
+	auto simulate = [&](bool multithreaded, double& checksum) {
+		wi::physics::SetMultithreadingEnabled(multithreaded);
+		create(scene, bodyCount);
+		timer.record();
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			wi::physics::RunPhysicsUpdateSystem(ctx, scene, dt);
+			wi::jobsystem::Wait(ctx);
+		}
+		const double milliseconds = timer.elapsed_milliseconds() / frameCount;
+		checksum = 0;
+		for (size_t i = 0; i < scene.transforms.GetCount(); ++i)
+		{
+			const XMFLOAT3& position = scene.transforms[i].translation_local;
+			checksum += position.x * 3 + position.y * 5 + position.z * 7;
+		}
+		return milliseconds;
+	};
+
+	std::string ss = "Physics simulation of " + std::to_string(bodyCount) + " rigid bodies, " + std::to_string(frameCount) + " frames:\n";
+
+	double checksum_serial = 0;
+	const double serial = simulate(false, checksum_serial);
+	ss += "Single threaded: " + std::to_string(serial) + " ms / frame, checksum: " + std::to_string(checksum_serial) + "\n";
+
+	double checksum_parallel[2] = {};
+	const double parallel = simulate(true, checksum_parallel[0]);
+	ss += "Multithreaded (" + std::to_string(wi::jobsystem::GetThreadCount()) + " threads): " + std::to_string(parallel) + " ms / frame, checksum: " + std::to_string(checksum_parallel[0]) + "\n";
+
+	double checksum_replay = 0;
+	simulate(false, checksum_replay);
+	ss += checksum_serial == checksum_replay ? "Single threaded replay is bit-identical\n" : "Single threaded replay is NOT bit-identical!\n";
+
+	simulate(true, checksum_parallel[1]);
+	ss += checksum_parallel[0] == checksum_parallel[1] ? "Multithreaded replay is bit-identical\n" : "Multithreaded replay is NOT bit-identical!\n";
+
+	// Batched line of sight queries against the simulated bodies, like AI visibility checks:
+	{
+		const uint32_t rayCount = 10000;
+		wi::vector<wi::primitive::Ray> rays(rayCount);
+		wi::vector<wi::physics::RayHit> hits(rayCount);
+		std::mt19937 rand(7);
+		std::uniform_real_distribution<float> horizontal(-30.0f, 30.0f);
+		for (auto& ray : rays)
+		{
+			const XMFLOAT3 from = XMFLOAT3(horizontal(rand), 2, horizontal(rand));
+			const XMFLOAT3 to = XMFLOAT3(horizontal(rand), 2, horizontal(rand));
+			const XMVECTOR F = XMLoadFloat3(&from);
+			const XMVECTOR T = XMLoadFloat3(&to);
+			ray = wi::primitive::Ray(F, XMVector3Normalize(T - F), 0, XMVectorGetX(XMVector3Length(T - F)));
+		}
+		timer.record();
+		wi::physics::RayCast(scene, rays.data(), hits.data(), rays.size(), true);
+		const double milliseconds = timer.elapsed_milliseconds();
+		uint32_t blocked = 0;
+		for (auto& hit : hits)
+		{
+			blocked += hit.entity != INVALID_ENTITY ? 1 : 0;
+		}
+		ss += "\n" + std::to_string(rayCount) + " line of sight rays: " + std::to_string(milliseconds) + " ms, blocked: " + std::to_string(blocked) + "\n";
+	}
+
+	// Many small scenes with their own physics worlds, like match instances on a server, updated one by one and in parallel:
+	{
+		const uint32_t sceneCount = 16;
+		const uint32_t sceneBodyCount = 200;
+		static wi::scene::Scene scenes[sceneCount];
+		auto simulate_scenes = [&](bool parallel) {
+			for (auto& x : scenes)
+			{
+				create(x, sceneBodyCount);
+			}
+			wi::physics::SetMultithreadingEnabled(false);
+			timer.record();
+			for (int frame = 0; frame < frameCount; ++frame)
+			{
+				for (auto& x : scenes)
+				{
+					if (parallel)
+					{
+						wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+							wi::jobsystem::context scene_ctx;
+							wi::physics::RunPhysicsUpdateSystem(scene_ctx, x, dt);
+							wi::jobsystem::Wait(scene_ctx);
+						});
+					}
+					else
+					{
+						wi::physics::RunPhysicsUpdateSystem(ctx, x, dt);
+						wi::jobsystem::Wait(ctx);
+					}
+				}
+				wi::jobsystem::Wait(ctx);
+			}
+			return timer.elapsed_milliseconds() / frameCount;
+		};
+		const double serial_scenes = simulate_scenes(false);
+		const double parallel_scenes = simulate_scenes(true);
+		for (auto& x : scenes)
+		{
+			x.Clear();
+		}
+		ss += "\n" + std::to_string(sceneCount) + " scenes of " + std::to_string(sceneBodyCount) + " rigid bodies: " + std::to_string(serial_scenes) + " ms / frame one by one, " + std::to_string(parallel_scenes) + " ms / frame in parallel\n";
+	}
+
+	// Static triangle mesh instances of the same mesh with different scales share one BVH:
+	{
+		clear();
+		const int grid = 64;
+		Entity meshID = CreateEntity();
+		MeshComponent& mesh = scene.meshes.Create(meshID);
+		for (int z = 0; z < grid; ++z)
+		{
+			for (int x = 0; x < grid; ++x)
+			{
+				mesh.vertex_positions.push_back(XMFLOAT3(float(x), std::sin(x * 0.3f) * std::cos(z * 0.3f), float(z)));
+			}
+		}
+		for (int z = 0; z < grid - 1; ++z)
+		{
+			for (int x = 0; x < grid - 1; ++x)
+			{
+				const uint32_t i = uint32_t(z * grid + x);
+				mesh.indices.push_back(i);
+				mesh.indices.push_back(i + grid);
+				mesh.indices.push_back(i + 1);
+				mesh.indices.push_back(i + 1);
+				mesh.indices.push_back(i + grid);
+				mesh.indices.push_back(i + grid + 1);
+			}
+		}
+		MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+		subset.indexCount = (uint32_t)mesh.indices.size();
+		mesh.CreateRenderData();
+
+		const uint32_t instanceCount = 1000;
+		for (uint32_t i = 0; i < instanceCount; ++i)
+		{
+			Entity entity = CreateEntity();
+			TransformComponent& transform = scene.transforms.Create(entity);
+			transform.Scale(XMFLOAT3(1 + (i % 4) * 0.5f, 1, 1 + (i % 4) * 0.5f));
+			transform.Translate(XMFLOAT3(float(i % 32) * grid * 3, 0, float(i / 32) * grid * 3));
+			scene.objects.Create(entity).meshID = meshID;
+			RigidBodyPhysicsComponent& rigidbody = scene.rigidbodies.Create(entity);
+			rigidbody.shape = RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH;
+			rigidbody.mass = 0;
+		}
+
+		const wi::physics::ShapeCacheStatistics before = wi::physics::GetShapeCacheStatistics();
+		timer.record();
+		wi::physics::SetSimulationEnabled(false);
+		wi::physics::RunPhysicsUpdateSystem(ctx, scene, dt);
+		wi::jobsystem::Wait(ctx);
+		wi::physics::SetSimulationEnabled(true);
+		const double spawn = timer.elapsed_milliseconds();
+		const wi::physics::ShapeCacheStatistics after = wi::physics::GetShapeCacheStatistics();
+
+		ss += "\nSpawned " + std::to_string(instanceCount) + " triangle mesh instances in " + std::to_string(spawn) + " ms\n";
+		ss += "Shared shapes: " + std::to_string(after.shape_count - before.shape_count) + ", BVH memory: " + std::to_string((after.memory - before.memory) / 1024) + " KB\n";
+		ss += "Memory saved by sharing: " + std::to_string((after.memory_saved - before.memory_saved) / 1024) + " KB\n";
+		ss += "Build time saved by sharing: " + std::to_string(after.saved_milliseconds - before.saved_milliseconds) + " ms\n";
+	}
+
+	clear();
+	wi::physics::SetSimulationEnabled(simulation_enabled);
+	wi::physics::SetMultithreadingEnabled(multithreading_enabled);
+	wi::physics::SetDeterministicEnabled(deterministic_enabled);
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::ParticleBenchmarkTest()
+{
+	wi::Timer timer;
+
+	// CPU particle simulation, emitted from a volume in one burst, then simulated for a fixed number of frames:
+	const int frameCount = 60;
+	const float dt = 1.0f / 60.0f;
+
+	auto simulate = [&](uint32_t particleCount, bool sph) {
+		wi::EmittedParticleSystem emitter;
+		emitter.SetCPUSimulationEnabled(true);
+		emitter.SetSPHEnabled(sph);
+		emitter.SetVolumeEnabled(true);
+		emitter.SetMaxParticleCount(particleCount);
+		emitter.FIXED_TIMESTEP = dt;
+		emitter.life = 1000;
+		emitter.size = 0.1f;
+		emitter.gravity = XMFLOAT3(0, -9.8f * 2, 0);
+		emitter.drag = 0.98f;
+
+		TransformComponent transform;
+		transform.Scale(XMFLOAT3(20, 10, 20));
+		transform.Translate(XMFLOAT3(0, 12, 0));
+		transform.UpdateTransform();
+
+		emitter.Burst((int)particleCount);
+		emitter.UpdateCPU(transform, dt); // emit
+
+		uint64_t simulated = 0;
+		timer.record();
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			simulated += emitter.cpu_particles.alive_count;
+			emitter.UpdateCPU(transform, dt);
+		}
+		return double(simulated) / timer.elapsed_milliseconds();
+	};
+
+	std::string ss = "CPU particle simulation, " + std::to_string(frameCount) + " frames, " + std::to_string(wi::jobsystem::GetThreadCount()) + " threads:\n";
+
+	const uint32_t particleCount = 1000000;
+	ss += std::to_string(particleCount) + " particles: " + std::to_string((uint64_t)simulate(particleCount, false)) + " particles / ms\n";
+
+	const uint32_t sphParticleCount = 100000;
+	ss += std::to_string(sphParticleCount) + " SPH fluid particles: " + std::to_string((uint64_t)simulate(sphParticleCount, true)) + " particles / ms\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::OceanBenchmarkTest()
+{
+	wi::Timer timer;
+
+	// The CPU ocean is evaluated at lower resolutions and compared against the full resolution evaluation of the same spectrum:
+	const wi::Ocean::OceanParameters params;
+	const float time = 12.3f;
+	const uint32_t queryCount = 10000;
+	wi::vector<XMFLOAT3> positions(queryCount);
+	std::mt19937 rand(2022);
+	std::uniform_real_distribution<float> horizontal(-500.0f, 500.0f);
+	for (auto& x : positions)
+	{
+		x = XMFLOAT3(horizontal(rand), 0, horizontal(rand));
+	}
+
+	static wi::Ocean ocean;
+	ocean.Create(params);
+
+	ocean.cpu_dim = params.dmap_dim;
+	ocean.UpdateDisplacementMapCPU(params, time);
+	wi::vector<XMFLOAT3> reference(queryCount);
+	ocean.GetDisplacedPositions(positions.data(), reference.data(), queryCount);
+
+	std::string ss = "CPU ocean evaluation, " + std::to_string(queryCount) + " queries compared to " + std::to_string(params.dmap_dim) + "x" + std::to_string(params.dmap_dim) + ":\n";
+
+	wi::vector<XMFLOAT3> displaced(queryCount);
+	wi::vector<float> heights(queryCount);
+	for (int dim : { 32, 64, 128, 256, 512 })
+	{
+		ocean.cpu_dim = dim;
+		timer.record();
+		ocean.UpdateDisplacementMapCPU(params, time);
+		const double update = timer.elapsed_milliseconds();
+
+		timer.record();
+		ocean.GetDisplacedPositions(positions.data(), displaced.data(), queryCount);
+		const double query_displaced = timer.elapsed_milliseconds();
+
+		timer.record();
+		ocean.GetHeights(positions.data(), heights.data(), queryCount);
+		const double query_heights = timer.elapsed_milliseconds();
+
+		float max_error = 0;
+		for (uint32_t i = 0; i < queryCount; ++i)
+		{
+			max_error = std::max(max_error, XMVectorGetX(XMVector3Length(XMLoadFloat3(&displaced[i]) - XMLoadFloat3(&reference[i]))));
+		}
+
+		ss += std::to_string(dim) + "x" + std::to_string(dim) + ": update: " + std::to_string(update) + " ms, displaced positions: " + std::to_string(query_displaced) + " ms, heights: " + std::to_string(query_heights) + " ms, max error: " + std::to_string(max_error) + "\n";
+	}
+
+	// The full resolution CPU evaluation must match the GPU simulation with the same time:
+	//	The GPU displacement map is read back and its texels are compared to CPU queries at the texel centers,
+	//	this verifies the half texel offset, the sign correction and the axis order of the CPU path
+	{
+		using namespace wi::graphics;
+		GraphicsDevice* device = GetDevice();
+
+		// The GPU simulation reads the time from the frame constants, those are provided here instead of the renderer:
+		FrameCB frameCB = {};
+		frameCB.time = time;
+		GPUBufferDesc desc;
+		desc.size = sizeof(FrameCB);
+		desc.bind_flags = BindFlag::CONSTANT_BUFFER;
+		GPUBuffer frameBuffer;
+		device->CreateBuffer(&desc, &frameCB, &frameBuffer);
+
+		CommandList cmd = device->BeginCommandList();
+		device->BindConstantBuffer(&frameBuffer, CBSLOT_RENDERER_FRAME, cmd);
+		ocean.UpdateDisplacementMap(params, cmd);
+		device->SubmitCommandLists();
+		device->WaitForGPU();
+
+		wi::vector<uint8_t> texturedata;
+		if (wi::helper::saveTextureToMemory(*ocean.getDisplacementMap(), texturedata) && texturedata.size() >= size_t(params.dmap_dim) * params.dmap_dim * sizeof(XMFLOAT4))
+		{
+			ocean.cpu_dim = params.dmap_dim;
+			ocean.UpdateDisplacementMapCPU(params, time);
+
+			// GPU texels store (choppy x, choppy z, height), the surface shader uses them as the xzy world displacement:
+			const XMFLOAT4* texels = (const XMFLOAT4*)texturedata.data();
+			const float texel_size = params.patch_length / params.dmap_dim;
+			float max_error = 0;
+			float max_displacement = 0;
+			double squared_error = 0;
+			for (int y = 0; y < params.dmap_dim; ++y)
+			{
+				for (int x = 0; x < params.dmap_dim; ++x)
+				{
+					const XMFLOAT3 position = XMFLOAT3((x + 0.5f) * texel_size, 0, (y + 0.5f) * texel_size);
+					const XMFLOAT3 displaced = ocean.GetDisplacedPosition(position);
+					const XMVECTOR cpu = XMLoadFloat3(&displaced) - XMVectorSet(position.x, params.waterHeight, position.z, 0);
+					const XMFLOAT4& texel = texels[y * params.dmap_dim + x];
+					const XMVECTOR gpu = XMVectorSet(texel.x, texel.z, texel.y, 0);
+					const float error = XMVectorGetX(XMVector3Length(cpu - gpu));
+					max_error = std::max(max_error, error);
+					max_displacement = std::max(max_displacement, XMVectorGetX(XMVector3Length(gpu)));
+					squared_error += double(error) * double(error);
+				}
+			}
+			const double rms_error = std::sqrt(squared_error / (double(params.dmap_dim) * params.dmap_dim));
+			ss += "\nCPU " + std::to_string(params.dmap_dim) + "x" + std::to_string(params.dmap_dim) + " compared to GPU displacement map: max error: " + std::to_string(max_error) + ", RMS error: " + std::to_string(rms_error) + ", max displacement: " + std::to_string(max_displacement);
+			if (max_displacement <= 0 || max_error > max_displacement * 0.01f)
+			{
+				ss += " (INCORRECT RESULT!)";
+			}
+			ss += "\n";
+		}
+		else
+		{
+			ss += "\nGPU displacement map readback failed (INCORRECT RESULT!)\n";
+		}
+	}
+	ocean.cpu_dim = 0;
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::DrawMergeTest()
+{
+	// A small scene with two meshes, rendered as an interleaved render queue: A B A B A B A B
+	//	The third instance overrides the stencil ref, so it can never be merged with the other instances of mesh A
+	static Scene scene;
+	scene.Clear();
+
+	scene.materials.Create(CreateEntity());
+
+	const uint32_t subsetCounts[] = { 2, 1 };
+	for (uint32_t subsetCount : subsetCounts)
+	{
+		MeshComponent& mesh = scene.meshes.Create(CreateEntity());
+		for (uint32_t i = 0; i < subsetCount; ++i)
+		{
+			MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+			subset.materialIndex = 0;
+			subset.indexOffset = i * 3;
+			subset.indexCount = 3;
+		}
+	}
+
+	const uint32_t instanceCount = 8;
+	wi::vector<wi::renderer::RenderBatch> queue;
+	for (uint32_t i = 0; i < instanceCount; ++i)
+	{
+		Entity entity = CreateEntity();
+		ObjectComponent& object = scene.objects.Create(entity);
+		scene.aabb_objects.Create(entity);
+		object.mesh_index = i % 2;
+		object.radius = 1;
+		object.fadeDistance = i == 5 ? 5.0f : 100.0f; // the sixth instance is faded, this must force alpha test on its batch
+		object.userStencilRef = i == 2 ? 5 : 0;
+		queue.emplace_back().Create(i % 2, i, 10.0f, 0);
+	}
+
+	struct Expected
+	{
+		bool orderIndependent;
+		uint32_t frustum_count;
+		uint32_t batches;
+		uint32_t consecutiveBatches;
+		uint32_t instances;
+	};
+	const Expected expectations[] = {
+		{ false, 1, 8, 8, 8 },
+		{ true, 1, 3, 8, 8 },
+		{ true, 2, 3, 8, 16 },
+	};
+
+	bool correct = true;
+	std::string ss = "Draw merging of an interleaved render queue with " + std::to_string(instanceCount) + " instances:\n";
+	wi::renderer::MeshDrawGrouping grouping;
+	for (const Expected& expected : expectations)
+	{
+		grouping.GroupInstances(scene, queue.data(), queue.size(), expected.orderIndependent, false, nullptr, expected.frustum_count);
+
+		bool result =
+			grouping.instancedBatches.size() == expected.batches &&
+			grouping.consecutiveBatchCount == expected.consecutiveBatches &&
+			grouping.instanceCount == expected.instances
+			;
+
+		// Every queue entry must land in a batch of its own mesh, and the instance ranges must be contiguous:
+		uint32_t offset = 0;
+		for (auto& batch : grouping.instancedBatches)
+		{
+			result = result && batch.instanceOffset == offset;
+			offset += batch.instanceCount;
+		}
+		for (size_t i = 0; i < queue.size(); ++i)
+		{
+			const auto& batch = grouping.instancedBatches[grouping.queueBatchIndices[i]];
+			result = result && batch.meshIndex == queue[i].GetMeshIndex();
+			result = result && batch.userStencilRefOverride == scene.objects[i].userStencilRef;
+			result = result && grouping.queueFrustumMasks[i] == (1u << expected.frustum_count) - 1;
+		}
+
+		if (expected.orderIndependent)
+		{
+			// Merged batches in order of first appearance: mesh A, mesh B, mesh A with stencil override
+			result = result && grouping.instancedBatches.size() == 3;
+			result = result && grouping.instancedBatches[0].instanceCount == 3 * expected.frustum_count;
+			result = result && grouping.instancedBatches[1].instanceCount == 4 * expected.frustum_count;
+			result = result && grouping.instancedBatches[2].instanceCount == 1 * expected.frustum_count;
+			result = result && !grouping.instancedBatches[0].forceAlphatestForDithering;
+			result = result && grouping.instancedBatches[1].forceAlphatestForDithering;
+		}
+
+		ss += std::string(expected.orderIndependent ? "order independent" : "ordered") + ", " + std::to_string(expected.frustum_count) + " frusta: ";
+		ss += std::to_string(grouping.consecutiveBatchCount) + " consecutive batches -> " + std::to_string(grouping.instancedBatches.size()) + " merged batches, ";
+		ss += std::to_string(grouping.instanceCount) + " instances";
+		if (!result)
+		{
+			ss += " (INCORRECT RESULT!)";
+			correct = false;
+		}
+		ss += "\n";
+	}
+
+	// Subset draws: mesh A has 2 subsets in two batches, mesh B has 1 subset, so 5 draws are expected, ordered by pipeline state
+	grouping.GroupInstances(scene, queue.data(), queue.size(), true, false);
+	grouping.GatherSubsetDraws(scene, wi::enums::RENDERPASS_MAIN, wi::enums::RENDERTYPE_OPAQUE, false, true);
+	ss += "Subset draws: " + std::to_string(grouping.subsetDraws.size());
+	bool sorted = std::is_sorted(grouping.subsetDraws.begin(), grouping.subsetDraws.end(), [](const auto& a, const auto& b) {
+		if (a.pso != b.pso)
+			return a.pso < b.pso;
+		if (a.batchIndex != b.batchIndex)
+			return a.batchIndex < b.batchIndex;
+		return a.subsetIndex < b.subsetIndex;
+	});
+	if (grouping.subsetDraws.size() != 5 || !sorted)
+	{
+		ss += " (INCORRECT RESULT!)";
+		correct = false;
+	}
+	ss += "\n";
+	ss += correct ? "All results are correct" : "Some results are INCORRECT!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::OcclusionBufferTest()
+{
+	// A 10x10 quad occluder at view depth 10 in front of a 90 degree perspective camera:
+	//	With the 256x128 default resolution, the quad covers the pixel rectangle [96, 160) x [32, 96) with inverse depth 0.1
+	const XMMATRIX VP = XMMatrixPerspectiveFovLH(XM_PIDIV2, 2.0f, 0.1f, 1000.0f);
+	const XMFLOAT3 positions[] = {
+		XMFLOAT3(-5, -5, 10),
+		XMFLOAT3(5, -5, 10),
+		XMFLOAT3(5, 5, 10),
+		XMFLOAT3(-5, 5, 10),
+	};
+	const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+
+	static wi::OcclusionBuffer occlusionBuffer;
+	occlusionBuffer.Begin(VP);
+	occlusionBuffer.AddOccluder(positions, arraysize(positions), indices, arraysize(indices), XMMatrixIdentity());
+	occlusionBuffer.Rasterize();
+
+	bool correct = true;
+	std::string ss = "Occlusion buffer " + std::to_string(occlusionBuffer.GetWidth()) + "x" + std::to_string(occlusionBuffer.GetHeight()) + ":\n";
+
+	uint32_t depth_errors = 0;
+	const float* depth = occlusionBuffer.GetDepth();
+	for (uint32_t y = 0; y < occlusionBuffer.GetHeight(); ++y)
+	{
+		for (uint32_t x = 0; x < occlusionBuffer.GetWidth(); ++x)
+		{
+			const bool inside = x >= 96 && x < 160 && y >= 32 && y < 96;
+			const float expected = inside ? 0.1f : 0.0f;
+			if (std::abs(depth[x + y * occlusionBuffer.GetWidth()] - expected) > 1e-4f)
+			{
+				depth_errors++;
+			}
+		}
+	}
+	ss += "Depth buffer texels different from golden reference: " + std::to_string(depth_errors);
+	if (depth_errors > 0)
+	{
+		ss += " (INCORRECT RESULT!)";
+		correct = false;
+	}
+	ss += "\n";
+
+	struct Query
+	{
+		const char* name;
+		wi::primitive::AABB aabb;
+		bool occluded;
+	};
+	const Query queries[] = {
+		{ "box behind occluder", wi::primitive::AABB(XMFLOAT3(-1, -1, 20), XMFLOAT3(1, 1, 21)), true },
+		{ "box in front of occluder", wi::primitive::AABB(XMFLOAT3(-1, -1, 5), XMFLOAT3(1, 1, 6)), false },
+		{ "box intersecting occluder", wi::primitive::AABB(XMFLOAT3(-1, -1, 9), XMFLOAT3(1, 1, 11)), false },
+		{ "box behind occluder edge", wi::primitive::AABB(XMFLOAT3(-1, -1, 20), XMFLOAT3(15, 1, 21)), false },
+		{ "box beside occluder", wi::primitive::AABB(XMFLOAT3(30, -1, 20), XMFLOAT3(31, 1, 21)), false },
+		{ "box behind camera", wi::primitive::AABB(XMFLOAT3(-1, -1, -21), XMFLOAT3(1, 1, -20)), false },
+	};
+	for (const Query& query : queries)
+	{
+		const bool occluded = occlusionBuffer.IsOccluded(query.aabb);
+		ss += std::string(query.name) + ": " + (occluded ? "occluded" : "visible");
+		if (occluded != query.occluded)
+		{
+			ss += " (INCORRECT RESULT!)";
+			correct = false;
+		}
+		ss += "\n";
+	}
+	ss += correct ? "All results are correct" : "Some results are INCORRECT!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::ClusterCullingTest()
+{
+	// Two 16x16 quad grids in the XY plane with opposite winding, each in its own subset:
+	//	subset 0 is at z = 0, subset 1 is at z = 10, both span [0, 16] on the X and Y axes
+	const uint32_t grid = 16;
+	MeshComponent mesh;
+	for (uint32_t subsetIndex = 0; subsetIndex < 2; ++subsetIndex)
+	{
+		const uint32_t vertexOffset = (uint32_t)mesh.vertex_positions.size();
+		for (uint32_t y = 0; y <= grid; ++y)
+		{
+			for (uint32_t x = 0; x <= grid; ++x)
+			{
+				mesh.vertex_positions.push_back(XMFLOAT3(float(x), float(y), subsetIndex * 10.0f));
+			}
+		}
+		MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+		subset.indexOffset = (uint32_t)mesh.indices.size();
+		for (uint32_t y = 0; y < grid; ++y)
+		{
+			for (uint32_t x = 0; x < grid; ++x)
+			{
+				const uint32_t i0 = vertexOffset + x + y * (grid + 1);
+				const uint32_t i1 = i0 + 1;
+				const uint32_t i2 = i0 + grid + 1;
+				const uint32_t i3 = i2 + 1;
+				const uint32_t quad[2][6] = {
+					{ i0, i2, i1, i1, i2, i3 },
+					{ i0, i1, i2, i1, i3, i2 },
+				};
+				mesh.indices.insert(mesh.indices.end(), quad[subsetIndex], quad[subsetIndex] + 6);
+			}
+		}
+		subset.indexCount = (uint32_t)mesh.indices.size() - subset.indexOffset;
+	}
+	mesh.BuildClusters();
+
+	bool correct = true;
+	std::string ss = "Mesh clusters of two " + std::to_string(grid) + "x" + std::to_string(grid) + " quad grids with opposite facing: " + std::to_string(mesh.clusters.size()) + " clusters\n";
+
+	// Cluster limits, triangle coverage, bounding spheres and normal cones:
+	uint32_t triangleCounts[2] = {};
+	float coneAxisZ[2] = {};
+	bool limits = true;
+	bool spheres = true;
+	bool cones = true;
+	for (const MeshComponent::MeshCluster& cluster : mesh.clusters)
+	{
+		limits = limits && cluster.subsetIndex < 2;
+		limits = limits && cluster.vertexCount <= MeshComponent::CLUSTER_MAX_VERTICES && cluster.triangleCount <= MeshComponent::CLUSTER_MAX_TRIANGLES;
+		if (!limits)
+			break;
+		triangleCounts[cluster.subsetIndex] += cluster.triangleCount;
+
+		for (uint32_t i = 0; i < cluster.vertexCount; ++i)
+		{
+			const XMFLOAT3& position = mesh.vertex_positions[mesh.cluster_vertices[cluster.vertexOffset + i]];
+			const float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&position) - XMLoadFloat3(&cluster.center)));
+			spheres = spheres && distance <= cluster.radius * 1.001f + 0.001f;
+			spheres = spheres && position.z == cluster.subsetIndex * 10.0f;
+		}
+
+		// Every cluster is flat, so its normal cone is a single direction along the Z axis:
+		cones = cones && cluster.cone_cutoff < 0.01f;
+		cones = cones && std::abs(cluster.cone_axis.x) < 0.01f && std::abs(cluster.cone_axis.y) < 0.01f && std::abs(std::abs(cluster.cone_axis.z) - 1) < 0.01f;
+		if (coneAxisZ[cluster.subsetIndex] == 0)
+		{
+			coneAxisZ[cluster.subsetIndex] = cluster.cone_axis.z;
+		}
+		cones = cones && coneAxisZ[cluster.subsetIndex] * cluster.cone_axis.z > 0;
+	}
+	limits = limits && triangleCounts[0] == grid * grid * 2 && triangleCounts[1] == grid * grid * 2;
+	cones = cones && coneAxisZ[0] * coneAxisZ[1] < 0;
+	ss += std::string("Cluster limits and triangle coverage: ") + (limits ? "ok" : "(INCORRECT RESULT!)") + "\n";
+	ss += std::string("Bounding spheres: ") + (spheres ? "ok" : "(INCORRECT RESULT!)") + "\n";
+	ss += std::string("Normal cones: ") + (cones ? "ok" : "(INCORRECT RESULT!)") + "\n";
+	correct = correct && limits && spheres && cones;
+
+	// Frustum culling against an orthographic box that contains only the X < 4 quarter of the grids, also with a translated object:
+	for (float offset : { 0.0f, 100.0f })
+	{
+		wi::primitive::Frustum frustum;
+		frustum.Create(XMMatrixOrthographicOffCenterLH(offset, offset + 4, -100, 100, -100, 100));
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, XMMatrixTranslation(offset, 0, 0));
+
+		wi::vector<uint32_t> visible_clusters;
+		mesh.CullClusters(frustum, world, 0, visible_clusters);
+
+		bool result = !visible_clusters.empty() && visible_clusters.size() < mesh.clusters.size();
+		for (uint32_t clusterIndex = 0; clusterIndex < (uint32_t)mesh.clusters.size(); ++clusterIndex)
+		{
+			const MeshComponent::MeshCluster& cluster = mesh.clusters[clusterIndex];
+			const bool visible = std::find(visible_clusters.begin(), visible_clusters.end(), clusterIndex) != visible_clusters.end();
+			bool inside = false;
+			for (uint32_t i = 0; i < cluster.vertexCount; ++i)
+			{
+				inside = inside || mesh.vertex_positions[mesh.cluster_vertices[cluster.vertexOffset + i]].x < 3.99f;
+			}
+			if (inside && !visible)
+				result = false; // culling must be conservative
+			if (cluster.center.x - cluster.radius > 4.01f && visible)
+				result = false; // sphere is fully outside
+		}
+		ss += "Frustum culling (object offset " + std::to_string(int(offset)) + "): " + std::to_string(visible_clusters.size()) + " visible clusters";
+		if (!result)
+		{
+			ss += " (INCORRECT RESULT!)";
+			correct = false;
+		}
+		ss += "\n";
+	}
+
+	// Backface culling from an eye that sees both grids from the -Z side, only the grid facing towards the eye must remain:
+	{
+		wi::primitive::Frustum frustum;
+		frustum.Create(XMMatrixOrthographicOffCenterLH(-100, 100, -100, 100, -100, 100));
+		const XMFLOAT4X4 world = wi::math::IDENTITY_MATRIX;
+		const XMFLOAT3 eye = XMFLOAT3(8, 8, -20);
+
+		wi::vector<uint32_t> visible_clusters;
+		mesh.CullClusters(frustum, world, 0, visible_clusters, &eye);
+
+		bool result = !visible_clusters.empty();
+		for (uint32_t clusterIndex = 0; clusterIndex < (uint32_t)mesh.clusters.size(); ++clusterIndex)
+		{
+			const MeshComponent::MeshCluster& cluster = mesh.clusters[clusterIndex];
+			const bool visible = std::find(visible_clusters.begin(), visible_clusters.end(), clusterIndex) != visible_clusters.end();
+			const bool facing_eye = cluster.cone_axis.z < 0;
+			result = result && visible == facing_eye;
+		}
+		ss += "Backface culling: " + std::to_string(visible_clusters.size()) + " visible clusters";
+		if (!result)
+		{
+			ss += " (INCORRECT RESULT!)";
+			correct = false;
+		}
+		ss += "\n";
+	}
+	ss += correct ? "All results are correct" : "Some results are INCORRECT!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::ConvexHullTest()
+{
+	auto add_box = [](MeshComponent& mesh, const XMFLOAT3& min, const XMFLOAT3& max) {
+		const uint32_t offset = (uint32_t)mesh.vertex_positions.size();
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			mesh.vertex_positions.push_back(XMFLOAT3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z));
+		}
+		const uint32_t faces[6][4] = {
+			{ 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 },
+			{ 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 },
+		};
+		for (auto& face : faces)
+		{
+			const uint32_t quad[] = { face[0], face[1], face[2], face[0], face[2], face[3] };
+			for (uint32_t index : quad)
+			{
+				mesh.indices.push_back(offset + index);
+			}
+		}
+	};
+	auto finish = [](MeshComponent& mesh) {
+		MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+		subset.indexOffset = 0;
+		subset.indexCount = (uint32_t)mesh.indices.size();
+	};
+	auto hull_inside = [](const RigidBodyPhysicsComponent& physicscomponent, size_t offset, uint32_t count, const XMFLOAT3& min, const XMFLOAT3& max) {
+		for (size_t i = offset; i < offset + count; ++i)
+		{
+			const XMFLOAT3& p = physicscomponent.convex_hull_vertices[i];
+			if (p.x < min.x - 0.001f || p.y < min.y - 0.001f || p.z < min.z - 0.001f || p.x > max.x + 0.001f || p.y > max.y + 0.001f || p.z > max.z + 0.001f)
+				return false;
+		}
+		return true;
+	};
+
+	bool correct = true;
+	std::string ss;
+	auto report = [&](const std::string& name, const RigidBodyPhysicsComponent& physicscomponent, bool result) {
+		ss += name + ": " + std::to_string(physicscomponent.convex_hull_vertex_counts.size()) + " hulls, " + std::to_string(physicscomponent.convex_hull_vertices.size()) + " vertices";
+		if (!result)
+		{
+			ss += " (INCORRECT RESULT!)";
+			correct = false;
+		}
+		ss += "\n";
+	};
+
+	// A mesh without geometry has no hulls:
+	{
+		MeshComponent mesh;
+		RigidBodyPhysicsComponent physicscomponent;
+		physicscomponent.convex_hull.max_hulls = 4;
+		wi::physics::CreateConvexHulls(physicscomponent, mesh);
+		report("Empty mesh", physicscomponent, physicscomponent.convex_hull_vertex_counts.empty());
+	}
+
+	// A box can't be decomposed further, even with a negative concavity threshold:
+	{
+		MeshComponent mesh;
+		add_box(mesh, XMFLOAT3(-1, -1, -1), XMFLOAT3(1, 1, 1));
+		finish(mesh);
+		RigidBodyPhysicsComponent physicscomponent;
+		physicscomponent.convex_hull.max_hulls = 8;
+		physicscomponent.convex_hull.concavity = -1;
+		wi::physics::CreateConvexHulls(physicscomponent, mesh);
+		const bool result =
+			physicscomponent.convex_hull_vertex_counts.size() == 1 &&
+			physicscomponent.convex_hull_vertex_counts[0] == 8 &&
+			hull_inside(physicscomponent, 0, 8, XMFLOAT3(-1, -1, -1), XMFLOAT3(1, 1, 1))
+			;
+		report("Box with negative concavity", physicscomponent, result);
+	}
+
+	// Hull reduction of a sphere to the vertex limit, the remaining vertices must be from the sphere surface:
+	{
+		MeshComponent mesh;
+		const uint32_t slices = 32;
+		const uint32_t stacks = 16;
+		for (uint32_t y = 0; y <= stacks; ++y)
+		{
+			const float theta = XM_PI * y / stacks;
+			for (uint32_t x = 0; x <= slices; ++x)
+			{
+				const float phi = XM_2PI * x / slices;
+				mesh.vertex_positions.push_back(XMFLOAT3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+			}
+		}
+		for (uint32_t y = 0; y < stacks; ++y)
+		{
+			for (uint32_t x = 0; x < slices; ++x)
+			{
+				const uint32_t i0 = x + y * (slices + 1);
+				const uint32_t i1 = i0 + slices + 1;
+				const uint32_t quad[] = { i0, i1, i0 + 1, i0 + 1, i1, i1 + 1 };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+		finish(mesh);
+		RigidBodyPhysicsComponent physicscomponent;
+		physicscomponent.convex_hull.vertex_limit = 16;
+		wi::physics::CreateConvexHulls(physicscomponent, mesh);
+		bool result =
+			physicscomponent.convex_hull_vertex_counts.size() == 1 &&
+			physicscomponent.convex_hull_vertex_counts[0] >= 4 &&
+			physicscomponent.convex_hull_vertex_counts[0] <= 16
+			;
+		for (const XMFLOAT3& p : physicscomponent.convex_hull_vertices)
+		{
+			result = result && std::abs(XMVectorGetX(XMVector3Length(XMLoadFloat3(&p))) - 1) < 0.001f;
+		}
+		report("Sphere of " + std::to_string(mesh.vertex_positions.size()) + " vertices reduced to 16", physicscomponent, result);
+	}
+
+	// Two boxes placed diagonally are decomposed into one hull per box:
+	{
+		MeshComponent mesh;
+		add_box(mesh, XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+		add_box(mesh, XMFLOAT3(2, 2, 0), XMFLOAT3(3, 3, 1));
+		finish(mesh);
+		RigidBodyPhysicsComponent physicscomponent;
+		physicscomponent.convex_hull.max_hulls = 4;
+		wi::physics::CreateConvexHulls(physicscomponent, mesh);
+		bool result = physicscomponent.convex_hull_vertex_counts.size() == 2;
+		if (result)
+		{
+			const uint32_t count0 = physicscomponent.convex_hull_vertex_counts[0];
+			const uint32_t count1 = physicscomponent.convex_hull_vertex_counts[1];
+			const bool first_is_A = hull_inside(physicscomponent, 0, count0, XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 1));
+			result = count0 == 8 && count1 == 8;
+			result = result && hull_inside(physicscomponent, 0, count0, first_is_A ? XMFLOAT3(0, 0, 0) : XMFLOAT3(2, 2, 0), first_is_A ? XMFLOAT3(1, 1, 1) : XMFLOAT3(3, 3, 1));
+			result = result && hull_inside(physicscomponent, count0, count1, first_is_A ? XMFLOAT3(2, 2, 0) : XMFLOAT3(0, 0, 0), first_is_A ? XMFLOAT3(3, 3, 1) : XMFLOAT3(1, 1, 1));
+		}
+		report("Two boxes decomposed", physicscomponent, result);
+	}
+	ss += correct ? "All results are correct" : "Some results are INCORRECT!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::PhysicsQueryTest()
+{
+	// Three static unit boxes along the X axis at x = 10, 20 and 30, the queries have known results:
+	static wi::scene::Scene scene;
+	scene.Clear();
+	Entity boxes[3];
+	for (uint32_t i = 0; i < arraysize(boxes); ++i)
+	{
+		boxes[i] = CreateEntity();
+		scene.transforms.Create(boxes[i]).Translate(XMFLOAT3(10.0f + i * 10.0f, 0, 0));
+		RigidBodyPhysicsComponent& rigidbody = scene.rigidbodies.Create(boxes[i]);
+		rigidbody.shape = RigidBodyPhysicsComponent::CollisionShape::BOX;
+		rigidbody.box.halfextents = XMFLOAT3(1, 1, 1);
+		rigidbody.mass = 0;
+	}
+
+	// The bodies are created by the physics update, without simulating anything:
+	const bool simulation_enabled = wi::physics::IsSimulationEnabled();
+	wi::jobsystem::context ctx;
+	wi::physics::SetSimulationEnabled(false);
+	wi::physics::RunPhysicsUpdateSystem(ctx, scene, 1.0f / 60.0f);
+	wi::jobsystem::Wait(ctx);
+	wi::physics::SetSimulationEnabled(simulation_enabled);
+
+	auto equal = [](float a, float b, float epsilon) {
+		return std::abs(a - b) <= epsilon;
+	};
+	auto facing_negative_x = [&](const wi::physics::RayHit& hit) {
+		return equal(hit.normal.x, -1, 0.01f) && equal(hit.normal.y, 0, 0.01f) && equal(hit.normal.z, 0, 0.01f);
+	};
+
+	bool correct = true;
+	std::string ss = "Physics queries against 3 boxes:\n";
+	auto report = [&](const std::string& name, bool result) {
+		ss += name + (result ? ": ok\n" : ": (INCORRECT RESULT!)\n");
+		correct = correct && result;
+	};
+
+	// Rays, repeated so that they span multiple job groups: (expected box index, expected distance), -1 for miss
+	{
+		struct RayQuery
+		{
+			XMFLOAT3 origin;
+			XMFLOAT3 direction;
+			float tmax;
+			int box;
+			float distance;
+		};
+		const RayQuery queries[] = {
+			{ XMFLOAT3(0, 0, 0), XMFLOAT3(1, 0, 0), 100, 0, 9 },
+			{ XMFLOAT3(15, 0.5f, 0), XMFLOAT3(1, 0, 0), 100, 1, 4 },
+			{ XMFLOAT3(0, 0, 0), XMFLOAT3(1, 0, 0), 5, -1, 0 },
+			{ XMFLOAT3(0, 0, 0), XMFLOAT3(0, 1, 0), 100, -1, 0 },
+			{ XMFLOAT3(25, 0, 0.5f), XMFLOAT3(1, 0, 0), 100, 2, 4 },
+		};
+		const uint32_t rayCount = 200;
+		wi::vector<wi::primitive::Ray> rays(rayCount);
+		wi::vector<wi::physics::RayHit> hits(rayCount);
+		for (uint32_t i = 0; i < rayCount; ++i)
+		{
+			const RayQuery& query = queries[i % arraysize(queries)];
+			rays[i] = wi::primitive::Ray(XMLoadFloat3(&query.origin), XMLoadFloat3(&query.direction), 0, query.tmax);
+		}
+
+		wi::physics::RayCast(scene, rays.data(), hits.data(), rays.size());
+		bool result = true;
+		for (uint32_t i = 0; i < rayCount; ++i)
+		{
+			const RayQuery& query = queries[i % arraysize(queries)];
+			const wi::physics::RayHit& hit = hits[i];
+			if (query.box < 0)
+			{
+				result = result && hit.entity == INVALID_ENTITY;
+				continue;
+			}
+			result = result && hit.entity == boxes[query.box];
+			result = result && equal(hit.distance, query.distance, 0.001f);
+			result = result && facing_negative_x(hit);
+			result = result && equal(hit.position.x, query.origin.x + query.distance, 0.001f);
+		}
+		report("Closest ray hits", result);
+
+		// Any hit can report any of the boxes along the ray, but the hit itself must be exact:
+		wi::physics::RayCast(scene, rays.data(), hits.data(), rays.size(), true);
+		result = true;
+		for (uint32_t i = 0; i < rayCount; ++i)
+		{
+			const RayQuery& query = queries[i % arraysize(queries)];
+			const wi::physics::RayHit& hit = hits[i];
+			if (query.box < 0)
+			{
+				result = result && hit.entity == INVALID_ENTITY;
+				continue;
+			}
+			int box = -1;
+			for (uint32_t j = uint32_t(query.box); j < arraysize(boxes); ++j)
+			{
+				if (hit.entity == boxes[j])
+				{
+					box = int(j);
+				}
+			}
+			result = result && box >= 0;
+			result = result && equal(hit.distance, query.distance + (box - query.box) * 10.0f, 0.001f);
+			result = result && facing_negative_x(hit);
+		}
+		report("Any ray hits", result);
+	}
+
+	// Sphere sweeps: a center hit, a hit on the top edge of the box and a miss above it
+	{
+		wi::physics::SphereSweep sweeps[3];
+		for (auto& sweep : sweeps)
+		{
+			sweep.sphere.radius = 0.5f;
+			sweep.direction = XMFLOAT3(1, 0, 0);
+			sweep.distance = 100;
+		}
+		sweeps[0].sphere.center = XMFLOAT3(0, 0, 0);
+		sweeps[1].sphere.center = XMFLOAT3(0, 1.4f, 0);
+		sweeps[2].sphere.center = XMFLOAT3(0, 1.6f, 0);
+		wi::physics::RayHit hits[arraysize(sweeps)];
+		wi::physics::SphereCast(scene, sweeps, hits, arraysize(sweeps));
+
+		bool result = true;
+		result = result && hits[0].entity == boxes[0] && equal(hits[0].distance, 8.5f, 0.02f) && facing_negative_x(hits[0]);
+		result = result && hits[1].entity == boxes[0] && equal(hits[1].distance, 8.7f, 0.02f); // touches the edge at (9, 1)
+		result = result && hits[2].entity == INVALID_ENTITY;
+		report("Sphere casts", result);
+	}
+
+	// Overlaps, spanning multiple job groups: every fifth query has no overlap, every fifth overlaps the first two boxes
+	{
+		const uint32_t sphereCount = 200;
+		wi::vector<wi::primitive::Sphere> spheres(sphereCount);
+		wi::vector<wi::physics::OverlapRange> ranges(sphereCount);
+		wi::vector<Entity> entities;
+		for (uint32_t i = 0; i < sphereCount; ++i)
+		{
+			switch (i % 5)
+			{
+			case 3:
+				spheres[i] = wi::primitive::Sphere(XMFLOAT3(15, 0, 0), 0.5f);
+				break;
+			case 4:
+				spheres[i] = wi::primitive::Sphere(XMFLOAT3(15, 0, 0), 6);
+				break;
+			default:
+				spheres[i] = wi::primitive::Sphere(XMFLOAT3(10.0f + (i % 5) * 10.0f, 0, 0), 0.5f);
+				break;
+			}
+		}
+		wi::physics::Overlap(scene, spheres.data(), ranges.data(), spheres.size(), entities);
+
+		bool result = true;
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < sphereCount; ++i)
+		{
+			const wi::physics::OverlapRange& range = ranges[i];
+			result = result && range.offset == offset;
+			offset += range.count;
+			if (!result || range.offset + range.count > entities.size())
+			{
+				result = false;
+				break;
+			}
+			const Entity* found = entities.data() + range.offset;
+			switch (i % 5)
+			{
+			case 3:
+				result = result && range.count == 0;
+				break;
+			case 4:
+				result = result && range.count == 2;
+				result = result && std::count(found, found + range.count, boxes[0]) == 1 && std::count(found, found + range.count, boxes[1]) == 1;
+				break;
+			default:
+				result = result && range.count == 1 && found[0] == boxes[i % 5];
+				break;
+			}
+		}
+		result = result && offset == entities.size();
+		report("Overlaps (" + std::to_string(entities.size()) + " results)", result);
+	}
+
+	scene.Clear();
+	ss += correct ? "All results are correct" : "Some results are INCORRECT!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::MeshNormalsBenchmarkTest()
+{
+	wi::Timer timer;
+
+	// Smooth normals of UV spheres with a texture seam, the seam vertices have the same positions but different UVs:
+	//	Vertices with the same position and attributes are welded, normals are accumulated from all faces around a position
+	auto create_sphere = [](MeshComponent& mesh, uint32_t n) {
+		for (uint32_t y = 0; y <= n; ++y)
+		{
+			for (uint32_t x = 0; x <= n; ++x)
+			{
+				const float u = float(x) / float(n);
+				const float v = float(y) / float(n);
+				const float theta = u * XM_2PI;
+				const float phi = v * XM_PI;
+				mesh.vertex_positions.push_back(XMFLOAT3(std::sin(phi) * std::cos(theta) * 10, std::cos(phi) * 10, std::sin(phi) * std::sin(theta) * 10));
+				mesh.vertex_uvset_0.push_back(XMFLOAT2(u, v));
+				mesh.vertex_normals.push_back(XMFLOAT3(0, 1, 0));
+			}
+		}
+		for (uint32_t y = 0; y < n; ++y)
+		{
+			for (uint32_t x = 0; x < n; ++x)
+			{
+				const uint32_t a = y * (n + 1) + x;
+				const uint32_t b = a + 1;
+				const uint32_t c = a + n + 1;
+				const uint32_t d = c + 1;
+				const uint32_t quad[] = { a, c, b, b, c, d };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+		MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+		subset.indexOffset = 0;
+		subset.indexCount = (uint32_t)mesh.indices.size();
+	};
+
+	std::string ss = "Smooth normal computation with vertex welding (ComputeNormals(COMPUTE_NORMALS_SMOOTH)):\n";
+	for (uint32_t n : { 40u, 100u, 316u, 707u })
+	{
+		MeshComponent mesh;
+		create_sphere(mesh, n);
+		const size_t triangles = mesh.indices.size() / 3;
+		const size_t vertices = mesh.vertex_positions.size();
+
+		timer.record();
+		mesh.ComputeNormals(MeshComponent::COMPUTE_NORMALS_SMOOTH);
+		const double milliseconds = timer.elapsed_milliseconds();
+
+		ss += std::to_string(triangles) + " triangles: " + std::to_string(milliseconds) + " ms, vertices: " + std::to_string(vertices) + " -> " + std::to_string(mesh.vertex_positions.size());
+
+		// The normals of a sphere must point outwards from the center:
+		bool correct = true;
+		for (size_t i = 0; i < mesh.vertex_positions.size() && correct; ++i)
+		{
+			const XMVECTOR P = XMVector3Normalize(XMLoadFloat3(&mesh.vertex_positions[i]));
+			const XMVECTOR N = XMLoadFloat3(&mesh.vertex_normals[i]);
+			correct = std::abs(XMVectorGetX(XMVector3Dot(P, N))) > 0.99f;
+		}
+		if (!correct)
+		{
+			ss += " (INCORRECT RESULT!)";
+		}
+		ss += "\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 20;
+	this->AddFont(&font);
+}
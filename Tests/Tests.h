@@ -17,6 +17,18 @@ public:
 	void RunSpriteTest();
 	void RunNetworkTest();
 	void ContainerTest();
+	void RadixSortTest();
+	void ForwardEntityCullingTest();
+	void AnimationCrowdTest();
+	void PhysicsBenchmarkTest();
+	void ParticleBenchmarkTest();
+	void OceanBenchmarkTest();
+	void MeshNormalsBenchmarkTest();
+	void DrawMergeTest();
+	void OcclusionBufferTest();
+	void ClusterCullingTest();
+	void ConvexHullTest();
+	void PhysicsQueryTest();
 };
 
 class Tests : public wi::Application
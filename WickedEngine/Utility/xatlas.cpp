@@ -63,7 +63,7 @@ Copyright (c) 2012 Brandon Pelfrey
 #endif
 
 #ifndef XA_MULTITHREADED
-#define XA_MULTITHREADED 1
+#define XA_MULTITHREADED 0 // Wicked Engine: multiple atlases are generated in parallel with wi::jobsystem, instead of every atlas starting its own worker threads
 #endif
 
 #define XA_STR(x) #x
@@ -56,6 +56,7 @@
 #include "wiRectPacker.h"
 #include "wiProfiler.h"
 #include "wiOcean.h"
+#include "wiTerrain.h"
 #include "wiFFTGenerator.h"
 #include "wiArguments.h"
 #include "wiGPUBVH.h"
@@ -69,6 +70,8 @@
 #include "wiUnorderedSet.h"
 #include "wiVector.h"
 #include "wiNoise.h"
+#include "wiOcclusionBuffer.h"
+#include "wiSort.h"
 
 #ifdef _WIN32
 #ifdef PLATFORM_UWP
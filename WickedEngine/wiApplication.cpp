@@ -368,6 +368,10 @@ namespace wi
 			if (infoDisplay.pipeline_count)
 			{
 				infodisplay_str += "Graphics pipelines active: " + std::to_string(graphicsDevice->GetActivePipelineCount()) + "\n";
+				const PipelineCompileStatistics pipeline_statistics = graphicsDevice->GetPipelineCompileStatistics();
+				infodisplay_str += "Pipeline hitches: " + std::to_string(pipeline_statistics.compiled_at_draw);
+				infodisplay_str += " (total: " + std::to_string(int(std::round(pipeline_statistics.hitch_milliseconds_total))) + " ms, max: " + std::to_string(int(std::round(pipeline_statistics.hitch_milliseconds_max))) + " ms)\n";
+				infodisplay_str += "Pipelines precompiled: " + std::to_string(pipeline_statistics.precompiled) + ", async: " + std::to_string(pipeline_statistics.compiled_async) + ", skipped draws: " + std::to_string(pipeline_statistics.skipped_draws) + "\n";
 			}
 
 			wi::font::Params params = wi::font::Params(4, 4, infoDisplay.size, wi::font::WIFALIGN_LEFT, wi::font::WIFALIGN_TOP, wi::Color(255, 255, 255, 255), wi::Color(0, 0, 0, 255));
@@ -491,6 +495,11 @@ namespace wi
 				graphicsDevice = std::make_unique<GraphicsDevice_DX12>(validationMode);
 #endif
 			}
+
+			if (wi::arguments::HasArgument("asyncpipelines"))
+			{
+				graphicsDevice->SetAsyncPipelineCompilationEnabled(true);
+			}
 		}
 		wi::graphics::GetDevice() = graphicsDevice.get();
 
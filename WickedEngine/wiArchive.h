@@ -84,6 +84,11 @@ namespace wi
 			_write((uint8_t)data);
 			return *this;
 		}
+		inline Archive& operator<<(unsigned short data)
+		{
+			_write((uint16_t)data);
+			return *this;
+		}
 		inline Archive& operator<<(int data)
 		{
 			_write((int64_t)data);
@@ -212,6 +217,13 @@ namespace wi
 			data = (unsigned char)temp;
 			return *this;
 		}
+		inline Archive& operator>>(unsigned short& data)
+		{
+			uint16_t temp;
+			_read(temp);
+			data = (unsigned short)temp;
+			return *this;
+		}
 		inline Archive& operator>>(int& data)
 		{
 			int64_t temp;
@@ -8,4 +8,6 @@ namespace wi::arguments
 	void Parse(const wchar_t* args);
     void Parse(int argc, char *argv[]);
 	bool HasArgument(const std::string& value);
+	// Returns the value of an argument given in the form of name=value, or empty string if it was not specified
+	std::string GetArgumentValue(const std::string& name);
 }
@@ -12,6 +12,7 @@
 #include "wiEventHandler.h"
 #include "wiTimer.h"
 #include "wiVector.h"
+#include "wiJobSystem.h"
 
 #include <algorithm>
 
@@ -307,9 +308,14 @@ namespace wi
 		return retVal;
 	}
 
-	void EmittedParticleSystem::UpdateCPU(const TransformComponent& transform, float dt)
+	void EmittedParticleSystem::UpdateCPU(const TransformComponent& transform, float dt, const MeshComponent* mesh)
 	{
-		CreateSelfBuffers();
+		// Without a graphics device (headless), only the CPU simulation can run:
+		const bool gpu = wi::graphics::GetDevice() != nullptr;
+		if (gpu)
+		{
+			CreateSelfBuffers();
+		}
 
 		if (IsPaused())
 			return;
@@ -323,6 +329,14 @@ namespace wi
 		emit += burst;
 		burst = 0;
 
+		if (IsCPUSimulationEnabled())
+		{
+			SimulateCPU(transform, mesh, dt);
+		}
+
+		if (!gpu)
+			return;
+
 		// Swap CURRENT alivelist with NEW alivelist
 		std::swap(aliveList[0], aliveList[1]);
 
@@ -345,6 +359,457 @@ namespace wi
 	{
 		SetPaused(false);
 		counterBuffer = {}; // will be recreated
+		cpu_particles.alive_count = 0;
+	}
+
+	namespace cpu_simulation
+	{
+		// The same hashing as SPH_GridHash() in the shaders, but into a power of two bucket count:
+		inline uint32_t GridHash(int x, int y, int z, uint32_t bucket_mask)
+		{
+			const uint32_t p1 = 73856093;
+			const uint32_t p2 = 19349663;
+			const uint32_t p3 = 83492791;
+			return ((p1 * uint32_t(x)) ^ (p2 * uint32_t(y)) ^ (p3 * uint32_t(z))) & bucket_mask;
+		}
+
+		// Collects the hashed cells that can contain particles within smoothing radius of a position
+		//	Different cells can hash into the same bucket, so duplicates are removed to not count the same particles twice
+		inline uint32_t GatherNeighborCells(float x, float y, float z, float h_rcp, uint32_t bucket_mask, uint32_t cells[27])
+		{
+			const int cx = (int)std::floor(x * h_rcp);
+			const int cy = (int)std::floor(y * h_rcp);
+			const int cz = (int)std::floor(z * h_rcp);
+			uint32_t count = 0;
+			for (int i = -1; i <= 1; ++i)
+			{
+				for (int j = -1; j <= 1; ++j)
+				{
+					for (int k = -1; k <= 1; ++k)
+					{
+						cells[count++] = GridHash(cx + i, cy + j, cz + k, bucket_mask);
+					}
+				}
+			}
+			std::sort(cells, cells + count);
+			return uint32_t(std::unique(cells, cells + count) - cells);
+		}
+
+		// Per particle random generator, so the emission doesn't depend on which thread emits which particle:
+		struct RNG
+		{
+			uint32_t state;
+			RNG(uint32_t seed, uint32_t index)
+			{
+				state = seed ^ (index * 2654435761u);
+				state = (state ^ 61u) ^ (state >> 16u);
+				state *= 9u;
+				state = state ^ (state >> 4u);
+				state *= 0x27d4eb2du;
+				state = state ^ (state >> 15u);
+				state = std::max(1u, state);
+			}
+			float next_float()
+			{
+				state ^= state << 13u;
+				state ^= state >> 17u;
+				state ^= state << 5u;
+				return float(state >> 8u) * (1.0f / 16777216.0f);
+			}
+		};
+	}
+
+	void EmittedParticleSystem::SimulateCPU(const TransformComponent& transform, const MeshComponent* mesh, float dt)
+	{
+		CPUParticles& particles = cpu_particles;
+		wi::vector<float>* streams[] = {
+			&particles.position_x,
+			&particles.position_y,
+			&particles.position_z,
+			&particles.velocity_x,
+			&particles.velocity_y,
+			&particles.velocity_z,
+			&particles.life,
+			&particles.max_life,
+			&particles.size_begin,
+			&particles.size_end,
+		};
+
+		// Capacity is padded, so that 4-wide loads starting at any alive particle stay in bounds:
+		const size_t capacity = size_t((MAX_PARTICLES + 3u) & ~3u) + 4;
+		if (particles.position_x.size() != capacity)
+		{
+			for (auto& stream : streams)
+			{
+				stream->resize(capacity);
+			}
+			particles.force_x.resize(capacity);
+			particles.force_y.resize(capacity);
+			particles.force_z.resize(capacity);
+			particles.density.resize(capacity);
+			particles.cell.resize(capacity);
+			particles.sort_indices.resize(capacity);
+			particles.sort_scratch.resize(capacity);
+		}
+		particles.alive_count = std::min(particles.alive_count, MAX_PARTICLES);
+
+		// simulation can be either fixed or variable timestep:
+		dt = FIXED_TIMESTEP >= 0 ? FIXED_TIMESTEP : dt;
+
+		wi::jobsystem::context ctx;
+
+		// Emit, the same way as emittedparticle_emitCS:
+		const uint32_t emit_count = std::min((uint32_t)emit, MAX_PARTICLES - particles.alive_count);
+		if (emit_count > 0)
+		{
+			const XMMATRIX W = XMLoadFloat4x4(&transform.world);
+			XMFLOAT3 emitter_velocity;
+			XMStoreFloat3(&emitter_velocity, XMVector3TransformNormal(XMLoadFloat3(&velocity), W));
+			const bool from_mesh = mesh != nullptr && mesh->indices.size() >= 3 && !mesh->vertex_positions.empty();
+			const bool mesh_normals = from_mesh && mesh->vertex_normals.size() == mesh->vertex_positions.size();
+			const bool volume = IsVolumeEnabled();
+			const uint32_t seed = wi::random::GetRandom(0u, ~0u);
+			const uint32_t first = particles.alive_count;
+
+			wi::jobsystem::Dispatch(ctx, emit_count, 256, [&](wi::jobsystem::JobArgs args) {
+				cpu_simulation::RNG rng(seed, args.jobIndex);
+
+				XMVECTOR P;
+				XMVECTOR N = XMVectorZero();
+				if (from_mesh)
+				{
+					// random triangle on emitter surface:
+					const uint32_t triangle_count = uint32_t(mesh->indices.size() / 3);
+					const uint32_t tri = std::min(uint32_t(rng.next_float() * triangle_count), triangle_count - 1);
+					const uint32_t i0 = mesh->indices[tri * 3 + 0];
+					const uint32_t i1 = mesh->indices[tri * 3 + 1];
+					const uint32_t i2 = mesh->indices[tri * 3 + 2];
+
+					// random barycentric coords:
+					float f = rng.next_float();
+					float g = rng.next_float();
+					if (f + g > 1)
+					{
+						f = 1 - f;
+						g = 1 - g;
+					}
+
+					const XMVECTOR P0 = XMLoadFloat3(&mesh->vertex_positions[i0]);
+					const XMVECTOR P1 = XMLoadFloat3(&mesh->vertex_positions[i1]);
+					const XMVECTOR P2 = XMLoadFloat3(&mesh->vertex_positions[i2]);
+					P = XMVector3Transform(P0 + f * (P1 - P0) + g * (P2 - P0), W);
+
+					if (mesh_normals)
+					{
+						const XMVECTOR N0 = XMLoadFloat3(&mesh->vertex_normals[i0]);
+						const XMVECTOR N1 = XMLoadFloat3(&mesh->vertex_normals[i1]);
+						const XMVECTOR N2 = XMLoadFloat3(&mesh->vertex_normals[i2]);
+						N = XMVector3Normalize(XMVector3TransformNormal(N0 + f * (N1 - N0) + g * (N2 - N0), W));
+					}
+				}
+				else if (volume)
+				{
+					// Emit inside volume:
+					const float x = rng.next_float() * 2 - 1;
+					const float y = rng.next_float() * 2 - 1;
+					const float z = rng.next_float() * 2 - 1;
+					P = XMVector3Transform(XMVectorSet(x, y, z, 1), W);
+				}
+				else
+				{
+					// Just emit from center point:
+					P = W.r[3];
+				}
+
+				const float particleStartingSize = size + size * (rng.next_float() - 0.5f) * random_factor;
+				const float rx = rng.next_float() - 0.5f;
+				const float ry = rng.next_float() - 0.5f;
+				const float rz = rng.next_float() - 0.5f;
+				const XMVECTOR V = XMLoadFloat3(&emitter_velocity) + (N + XMVectorSet(rx, ry, rz, 0) * random_factor) * normal_factor;
+				const float maxLife = life + life * (rng.next_float() - 0.5f) * random_life;
+
+				const uint32_t i = first + args.jobIndex;
+				particles.position_x[i] = XMVectorGetX(P);
+				particles.position_y[i] = XMVectorGetY(P);
+				particles.position_z[i] = XMVectorGetZ(P);
+				particles.velocity_x[i] = XMVectorGetX(V);
+				particles.velocity_y[i] = XMVectorGetY(V);
+				particles.velocity_z[i] = XMVectorGetZ(V);
+				particles.life[i] = maxLife;
+				particles.max_life[i] = maxLife;
+				particles.size_begin[i] = particleStartingSize;
+				particles.size_end[i] = particleStartingSize * scaleX;
+			});
+			wi::jobsystem::Wait(ctx);
+			particles.alive_count += emit_count;
+		}
+
+		const uint32_t alive_count = particles.alive_count;
+		if (alive_count == 0)
+			return;
+
+		const XMVECTOR lanes = XMVectorSet(0, 1, 2, 3);
+		const bool sph = IsSPHEnabled();
+
+		if (sph)
+		{
+			// SPH params, the same as the GPU simulation:
+			const float h = SPH_h;
+			const float h_rcp = 1.0f / SPH_h;
+			const float h2 = h * h;
+			const float h3 = h2 * h;
+			const float h6 = h2 * h2 * h2;
+			const float h9 = h6 * h3;
+			const float poly6_constant = (315.0f / (64.0f * XM_PI * h9));
+			const float spiky_constant = (-45.0f / (XM_PI * h6));
+			const float visc_constant = (45.0f / (XM_PI * h6));
+			const float K = SPH_K;
+			const float p0 = SPH_p0;
+			const float e = SPH_e;
+
+			// Hash every particle into a grid cell of [SPH smoothing radius] size:
+			const uint32_t bucket_count = wi::math::GetNextPowerOfTwo(std::max(64u, alive_count * 2));
+			const uint32_t bucket_mask = bucket_count - 1;
+			wi::jobsystem::Dispatch(ctx, alive_count, 1024, [&](wi::jobsystem::JobArgs args) {
+				const uint32_t i = args.jobIndex;
+				particles.cell[i] = cpu_simulation::GridHash(
+					(int)std::floor(particles.position_x[i] * h_rcp),
+					(int)std::floor(particles.position_y[i] * h_rcp),
+					(int)std::floor(particles.position_z[i] * h_rcp),
+					bucket_mask
+				);
+			});
+			wi::jobsystem::Wait(ctx);
+
+			// Counting sort by cell, after this every cell is a contiguous range of particles that can be loaded 4 at a time:
+			particles.cell_end.clear();
+			particles.cell_end.resize(bucket_count);
+			for (uint32_t i = 0; i < alive_count; ++i)
+			{
+				particles.cell_end[particles.cell[i]]++;
+			}
+			uint32_t offset = 0;
+			for (auto& x : particles.cell_end)
+			{
+				const uint32_t cell_count = x;
+				x = offset;
+				offset += cell_count;
+			}
+			for (uint32_t i = 0; i < alive_count; ++i)
+			{
+				particles.sort_indices[particles.cell_end[particles.cell[i]]++] = i;
+			}
+			for (auto& stream : streams)
+			{
+				wi::jobsystem::Dispatch(ctx, alive_count, 4096, [&](wi::jobsystem::JobArgs args) {
+					particles.sort_scratch[args.jobIndex] = (*stream)[particles.sort_indices[args.jobIndex]];
+				});
+				wi::jobsystem::Wait(ctx);
+				std::swap(*stream, particles.sort_scratch);
+			}
+
+			// Density evaluation, neighbors are processed 4 at a time:
+			wi::jobsystem::Dispatch(ctx, alive_count, 64, [&](wi::jobsystem::JobArgs args) {
+				const uint32_t i = args.jobIndex;
+				const float ax = particles.position_x[i];
+				const float ay = particles.position_y[i];
+				const float az = particles.position_z[i];
+				const XMVECTOR AX = XMVectorReplicate(ax);
+				const XMVECTOR AY = XMVectorReplicate(ay);
+				const XMVECTOR AZ = XMVectorReplicate(az);
+				const XMVECTOR H2 = XMVectorReplicate(h2);
+
+				uint32_t cells[27];
+				const uint32_t cell_count = cpu_simulation::GatherNeighborCells(ax, ay, az, h_rcp, bucket_mask, cells);
+
+				XMVECTOR density = XMVectorZero();
+				for (uint32_t c = 0; c < cell_count; ++c)
+				{
+					const uint32_t begin = cells[c] == 0 ? 0 : particles.cell_end[cells[c] - 1];
+					const uint32_t end = particles.cell_end[cells[c]];
+					const XMVECTOR END = XMVectorReplicate(float(end));
+					for (uint32_t j = begin; j < end; j += 4)
+					{
+						const XMVECTOR DX = AX - XMLoadFloat4((const XMFLOAT4*)&particles.position_x[j]);
+						const XMVECTOR DY = AY - XMLoadFloat4((const XMFLOAT4*)&particles.position_y[j]);
+						const XMVECTOR DZ = AZ - XMLoadFloat4((const XMFLOAT4*)&particles.position_z[j]);
+						const XMVECTOR R2 = DX * DX + DY * DY + DZ * DZ; // distance squared
+						const XMVECTOR valid = XMVectorAndInt(XMVectorLess(R2, H2), XMVectorLess(XMVectorReplicate(float(j)) + lanes, END));
+						const XMVECTOR T = H2 - R2;
+						density += XMVectorSelect(XMVectorZero(), T * T * T, valid); // poly6 smoothing kernel
+					}
+				}
+
+				// Can't be lower than reference density to avoid negative pressure!
+				particles.density[i] = std::max(p0, XMVectorGetX(XMVectorSum(density)) * poly6_constant * mass);
+			});
+			wi::jobsystem::Wait(ctx);
+
+			// Force evaluation:
+			wi::jobsystem::Dispatch(ctx, alive_count, 64, [&](wi::jobsystem::JobArgs args) {
+				const uint32_t i = args.jobIndex;
+				const float ax = particles.position_x[i];
+				const float ay = particles.position_y[i];
+				const float az = particles.position_z[i];
+				const float densityA = particles.density[i];
+				const float pressureA = K * (densityA - p0);
+				const XMVECTOR AX = XMVectorReplicate(ax);
+				const XMVECTOR AY = XMVectorReplicate(ay);
+				const XMVECTOR AZ = XMVectorReplicate(az);
+				const XMVECTOR VAX = XMVectorReplicate(particles.velocity_x[i]);
+				const XMVECTOR VAY = XMVectorReplicate(particles.velocity_y[i]);
+				const XMVECTOR VAZ = XMVectorReplicate(particles.velocity_z[i]);
+				const XMVECTOR DA2 = XMVectorReplicate(2 * densityA);
+				const XMVECTOR PA = XMVectorReplicate(pressureA);
+				const XMVECTOR H = XMVectorReplicate(h);
+				const XMVECTOR ONE = XMVectorSplatOne();
+
+				uint32_t cells[27];
+				const uint32_t cell_count = cpu_simulation::GatherNeighborCells(ax, ay, az, h_rcp, bucket_mask, cells);
+
+				XMVECTOR FAX = XMVectorZero(); // pressure force
+				XMVECTOR FAY = XMVectorZero();
+				XMVECTOR FAZ = XMVectorZero();
+				XMVECTOR FVX = XMVectorZero(); // viscosity force
+				XMVECTOR FVY = XMVectorZero();
+				XMVECTOR FVZ = XMVectorZero();
+				for (uint32_t c = 0; c < cell_count; ++c)
+				{
+					const uint32_t begin = cells[c] == 0 ? 0 : particles.cell_end[cells[c] - 1];
+					const uint32_t end = particles.cell_end[cells[c]];
+					const XMVECTOR END = XMVectorReplicate(float(end));
+					for (uint32_t j = begin; j < end; j += 4)
+					{
+						const XMVECTOR DX = AX - XMLoadFloat4((const XMFLOAT4*)&particles.position_x[j]);
+						const XMVECTOR DY = AY - XMLoadFloat4((const XMFLOAT4*)&particles.position_y[j]);
+						const XMVECTOR DZ = AZ - XMLoadFloat4((const XMFLOAT4*)&particles.position_z[j]);
+						const XMVECTOR R = XMVectorSqrt(DX * DX + DY * DY + DZ * DZ);
+
+						// avoid division by zero, this also skips the particle itself:
+						XMVECTOR valid = XMVectorLess(XMVectorReplicate(float(j)) + lanes, END);
+						valid = XMVectorAndInt(valid, XMVectorGreater(R, XMVectorZero()));
+						valid = XMVectorAndInt(valid, XMVectorLess(R, H));
+
+						const XMVECTOR R_rcp = XMVectorReciprocal(XMVectorSelect(ONE, R, valid));
+						const XMVECTOR densityB = XMVectorSelect(ONE, XMLoadFloat4((const XMFLOAT4*)&particles.density[j]), valid);
+						const XMVECTOR pressureB = (densityB - XMVectorReplicate(p0)) * K;
+						const XMVECTOR HR = H - R;
+
+						// spiky kernel smoothing function:
+						const XMVECTOR pressure = XMVectorSelect(XMVectorZero(), (PA + pressureB) / (DA2 * densityB) * spiky_constant * HR * HR * R_rcp, valid);
+						FAX += pressure * DX;
+						FAY += pressure * DY;
+						FAZ += pressure * DZ;
+
+						const XMVECTOR viscosity = XMVectorSelect(XMVectorZero(), visc_constant * HR * R_rcp / densityB, valid);
+						FVX += viscosity * (XMLoadFloat4((const XMFLOAT4*)&particles.velocity_x[j]) - VAX) * DX;
+						FVY += viscosity * (XMLoadFloat4((const XMFLOAT4*)&particles.velocity_y[j]) - VAY) * DY;
+						FVZ += viscosity * (XMLoadFloat4((const XMFLOAT4*)&particles.velocity_z[j]) - VAZ) * DZ;
+					}
+				}
+
+				// apply all forces:
+				const float densityA_rcp = 1.0f / densityA;
+				particles.force_x[i] = (-XMVectorGetX(XMVectorSum(FAX)) + e * XMVectorGetX(XMVectorSum(FVX))) * densityA_rcp;
+				particles.force_y[i] = (-XMVectorGetX(XMVectorSum(FAY)) + e * XMVectorGetX(XMVectorSum(FVY))) * densityA_rcp;
+				particles.force_z[i] = (-XMVectorGetX(XMVectorSum(FAZ)) + e * XMVectorGetX(XMVectorSum(FVZ))) * densityA_rcp;
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+
+		// Integrate 4 particles at a time, the same way as emittedparticle_simulateCS:
+		const uint32_t pack_count = (alive_count + 3) / 4;
+		wi::jobsystem::Dispatch(ctx, pack_count, 64, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t i = args.jobIndex * 4;
+			XMVECTOR PX = XMLoadFloat4((const XMFLOAT4*)&particles.position_x[i]);
+			XMVECTOR PY = XMLoadFloat4((const XMFLOAT4*)&particles.position_y[i]);
+			XMVECTOR PZ = XMLoadFloat4((const XMFLOAT4*)&particles.position_z[i]);
+			XMVECTOR VX = XMLoadFloat4((const XMFLOAT4*)&particles.velocity_x[i]);
+			XMVECTOR VY = XMLoadFloat4((const XMFLOAT4*)&particles.velocity_y[i]);
+			XMVECTOR VZ = XMLoadFloat4((const XMFLOAT4*)&particles.velocity_z[i]);
+			XMVECTOR LIFE = XMLoadFloat4((const XMFLOAT4*)&particles.life[i]);
+
+			XMVECTOR FX = XMVectorReplicate(gravity.x);
+			XMVECTOR FY = XMVectorReplicate(gravity.y);
+			XMVECTOR FZ = XMVectorReplicate(gravity.z);
+			if (sph)
+			{
+				FX += XMLoadFloat4((const XMFLOAT4*)&particles.force_x[i]);
+				FY += XMLoadFloat4((const XMFLOAT4*)&particles.force_y[i]);
+				FZ += XMLoadFloat4((const XMFLOAT4*)&particles.force_z[i]);
+			}
+
+			VX += FX * dt;
+			VY += FY * dt;
+			VZ += FZ * dt;
+			PX += VX * dt;
+			PY += VY * dt;
+			PZ += VZ * dt;
+
+			// drag:
+			VX *= drag;
+			VY *= drag;
+			VZ *= drag;
+
+			if (sph)
+			{
+				// The same debug floor and box collisions as the GPU SPH simulation:
+				const XMVECTOR MAXLIFE = XMLoadFloat4((const XMFLOAT4*)&particles.max_life[i]);
+				const XMVECTOR SIZEBEGIN = XMLoadFloat4((const XMFLOAT4*)&particles.size_begin[i]);
+				const XMVECTOR SIZEEND = XMLoadFloat4((const XMFLOAT4*)&particles.size_end[i]);
+				const XMVECTOR lifeLerp = XMVectorSplatOne() - LIFE / MAXLIFE;
+				const XMVECTOR particleSize = XMVectorLerpV(SIZEBEGIN, SIZEEND, lifeLerp);
+				const XMVECTOR elastic = XMVectorReplicate(-0.6f);
+				const XMVECTOR extentX = XMVectorReplicate(40);
+				const XMVECTOR extentZ = XMVectorReplicate(22);
+
+				XMVECTOR collision = XMVectorLess(PY - particleSize, XMVectorZero());
+				PY = XMVectorSelect(PY, particleSize, collision);
+				VY = XMVectorSelect(VY, VY * elastic, collision);
+
+				collision = XMVectorGreater(PX + particleSize, extentX);
+				PX = XMVectorSelect(PX, extentX - particleSize, collision);
+				VX = XMVectorSelect(VX, VX * elastic, collision);
+				collision = XMVectorLess(PX - particleSize, -extentX);
+				PX = XMVectorSelect(PX, particleSize - extentX, collision);
+				VX = XMVectorSelect(VX, VX * elastic, collision);
+
+				collision = XMVectorGreater(PZ + particleSize, extentZ);
+				PZ = XMVectorSelect(PZ, extentZ - particleSize, collision);
+				VZ = XMVectorSelect(VZ, VZ * elastic, collision);
+				collision = XMVectorLess(PZ - particleSize, -extentZ);
+				PZ = XMVectorSelect(PZ, particleSize - extentZ, collision);
+				VZ = XMVectorSelect(VZ, VZ * elastic, collision);
+			}
+
+			LIFE -= XMVectorReplicate(dt);
+
+			XMStoreFloat4((XMFLOAT4*)&particles.position_x[i], PX);
+			XMStoreFloat4((XMFLOAT4*)&particles.position_y[i], PY);
+			XMStoreFloat4((XMFLOAT4*)&particles.position_z[i], PZ);
+			XMStoreFloat4((XMFLOAT4*)&particles.velocity_x[i], VX);
+			XMStoreFloat4((XMFLOAT4*)&particles.velocity_y[i], VY);
+			XMStoreFloat4((XMFLOAT4*)&particles.velocity_z[i], VZ);
+			XMStoreFloat4((XMFLOAT4*)&particles.life[i], LIFE);
+		});
+		wi::jobsystem::Wait(ctx);
+
+		// Remove dead particles by moving the last alive particle into their place:
+		uint32_t count = alive_count;
+		for (uint32_t i = 0; i < count;)
+		{
+			if (particles.life[i] > 0)
+			{
+				i++;
+				continue;
+			}
+			count--;
+			for (auto& stream : streams)
+			{
+				(*stream)[i] = (*stream)[count];
+			}
+		}
+		particles.alive_count = count;
 	}
 
 	void EmittedParticleSystem::UpdateGPU(uint32_t instanceIndex, const TransformComponent& transform, const MeshComponent* mesh, CommandList cmd) const
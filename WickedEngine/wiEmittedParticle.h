@@ -7,6 +7,7 @@
 #include "wiMath.h"
 #include "wiECS.h"
 #include "wiScene_Decl.h"
+#include "wiVector.h"
 
 namespace wi
 {
@@ -54,6 +55,7 @@ namespace wi
 
 	private:
 		void CreateSelfBuffers();
+		void SimulateCPU(const wi::scene::TransformComponent& transform, const wi::scene::MeshComponent* mesh, float dt);
 
 		float emit = 0.0f;
 		int burst = 0;
@@ -61,7 +63,38 @@ namespace wi
 		uint32_t MAX_PARTICLES = 1000;
 
 	public:
-		void UpdateCPU(const wi::scene::TransformComponent& transform, float dt);
+		// CPU simulation state, particles are stored as structure of arrays so that 4 of them can be processed at once
+		//	Only the first alive_count entries are valid, the arrays are padded so that vector loads can read past the end
+		//	The order of particles is not persistent, they are reordered by dying and by the SPH grid sort
+		struct CPUParticles
+		{
+			uint32_t alive_count = 0;
+			wi::vector<float> position_x;
+			wi::vector<float> position_y;
+			wi::vector<float> position_z;
+			wi::vector<float> velocity_x;
+			wi::vector<float> velocity_y;
+			wi::vector<float> velocity_z;
+			wi::vector<float> life;
+			wi::vector<float> max_life;
+			wi::vector<float> size_begin;
+			wi::vector<float> size_end;
+
+			// SPH temporaries:
+			wi::vector<float> force_x;
+			wi::vector<float> force_y;
+			wi::vector<float> force_z;
+			wi::vector<float> density;
+			wi::vector<uint32_t> cell; // hashed grid cell of every particle
+			wi::vector<uint32_t> cell_end; // end of every hashed grid cell in the sorted particle arrays, a cell starts where the previous one ends
+			wi::vector<uint32_t> sort_indices;
+			wi::vector<float> sort_scratch;
+		};
+		CPUParticles cpu_particles;
+
+		// When FLAG_CPU_SIMULATION is set, this also simulates the particles on the CPU into cpu_particles, which doesn't need a graphics device
+		//	The GPU simulation still runs independently for rendering. mesh is optional, it is used for CPU emission from the mesh surface
+		void UpdateCPU(const wi::scene::TransformComponent& transform, float dt, const wi::scene::MeshComponent* mesh = nullptr);
 		void Burst(int num);
 		void Restart();
 
@@ -81,6 +114,7 @@ namespace wi
 			FLAG_SPH_FLUIDSIMULATION = 1 << 4,
 			FLAG_HAS_VOLUME = 1 << 5,
 			FLAG_FRAME_BLENDING = 1 << 6,
+			FLAG_CPU_SIMULATION = 1 << 7,
 		};
 		uint32_t _flags = FLAG_EMPTY;
 
@@ -136,6 +170,7 @@ namespace wi
 		inline bool IsSPHEnabled() const { return _flags & FLAG_SPH_FLUIDSIMULATION; }
 		inline bool IsVolumeEnabled() const { return _flags & FLAG_HAS_VOLUME; }
 		inline bool IsFrameBlendingEnabled() const { return _flags & FLAG_FRAME_BLENDING; }
+		inline bool IsCPUSimulationEnabled() const { return _flags & FLAG_CPU_SIMULATION; }
 
 		inline void SetDebug(bool value) { if (value) { _flags |= FLAG_DEBUG; } else { _flags &= ~FLAG_DEBUG; } }
 		inline void SetPaused(bool value) { if (value) { _flags |= FLAG_PAUSED; } else { _flags &= ~FLAG_PAUSED; } }
@@ -144,6 +179,7 @@ namespace wi
 		inline void SetSPHEnabled(bool value) { if (value) { _flags |= FLAG_SPH_FLUIDSIMULATION; } else { _flags &= ~FLAG_SPH_FLUIDSIMULATION; } }
 		inline void SetVolumeEnabled(bool value) { if (value) { _flags |= FLAG_HAS_VOLUME; } else { _flags &= ~FLAG_HAS_VOLUME; } }
 		inline void SetFrameBlendingEnabled(bool value) { if (value) { _flags |= FLAG_FRAME_BLENDING; } else { _flags &= ~FLAG_FRAME_BLENDING; } }
+		inline void SetCPUSimulationEnabled(bool value) { if (value) { _flags |= FLAG_CPU_SIMULATION; } else { _flags &= ~FLAG_CPU_SIMULATION; } }
 
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 
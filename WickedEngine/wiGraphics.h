@@ -733,6 +733,7 @@ namespace wi::graphics
 		{
 			EMPTY = 0,
 			ALLOW_UAV_WRITES = 1 << 0,
+			SYNCHRONOUS_PIPELINE_COMPILATION = 1 << 1, // pipelines are compiled at draw even if async pipeline compilation is enabled, for rendering that can't skip draws
 		};
 		Flags flags = Flags::EMPTY;
 		wi::vector<RenderPassAttachment> attachments;
@@ -45,6 +45,17 @@ namespace wi::graphics
 		QUEUE_COUNT,
 	};
 
+	// Graphics pipeline compilation statistics, these can be used to measure hitches caused by pipelines that are compiled on first use
+	struct PipelineCompileStatistics
+	{
+		uint64_t precompiled = 0; // pipelines that were compiled in the background from the pipeline warm-up list
+		uint64_t compiled_async = 0; // pipelines that were compiled in the background because async compilation is enabled
+		uint64_t compiled_at_draw = 0; // pipelines that were compiled on the command list recording thread, each of these is a hitch
+		uint64_t skipped_draws = 0; // draws that were skipped because their pipeline was still compiling in the background
+		float hitch_milliseconds_total = 0; // time spent compiling pipelines on command list recording threads
+		float hitch_milliseconds_max = 0; // the longest pipeline compilation on a command list recording thread
+	};
+
 	class GraphicsDevice
 	{
 	protected:
@@ -102,6 +113,16 @@ namespace wi::graphics
 		//	One PipelineState object can be compiled internally for multiple render target or depth-stencil formats, or sample counts
 		virtual size_t GetActivePipelineCount() const = 0;
 
+		// Returns the graphics pipeline compilation statistics since the device was created
+		virtual PipelineCompileStatistics GetPipelineCompileStatistics() const { return {}; }
+
+		// Asynchronous pipeline compilation: if enabled, draws that would compile a pipeline will instead start compiling it in the background
+		//	and be skipped until the pipeline is ready, this avoids hitches at the cost of objects missing for a few frames
+		//	Rendering that happens only once (captures, bakes) would lose the skipped draws permanently,
+		//	its render passes should be created with RenderPassDesc::Flags::SYNCHRONOUS_PIPELINE_COMPILATION
+		virtual void SetAsyncPipelineCompilationEnabled(bool value) {}
+		virtual bool IsAsyncPipelineCompilationEnabled() const { return false; }
+
 		// Returns the number of elapsed frames (submits)
 		//	It is incremented when calling SubmitCommandLists()
 		constexpr uint64_t GetFrameCount() const { return FRAMECOUNT; }
@@ -795,6 +795,7 @@ namespace vulkan_internal
 		wi::vector<uint32_t> uniform_buffer_dynamic_slots;
 
 		size_t binding_hash = 0;
+		size_t code_hash = 0; // hash of the shader binary, stable between runs
 
 		~Shader_Vulkan()
 		{
@@ -825,6 +826,7 @@ namespace vulkan_internal
 		wi::vector<uint32_t> uniform_buffer_dynamic_slots;
 
 		size_t binding_hash = 0;
+		size_t content_hash = 0; // hash of the pipeline description using shader binary hashes instead of pointers, stable between runs
 
 		VkGraphicsPipelineCreateInfo pipelineInfo = {};
 		VkPipelineShaderStageCreateInfo shaderStages[static_cast<size_t>(ShaderStage::Count)] = {};
@@ -998,6 +1000,88 @@ namespace vulkan_internal
 	{
 		return wi::helper::GetTempDirectoryPath() + "WickedVkPipelineCache.data";
 	}
+	inline const std::string GetPipelineManifestPath()
+	{
+		return wi::helper::GetTempDirectoryPath() + "WickedVkPipelineManifest.data";
+	}
+	static constexpr uint32_t pipeline_manifest_version = 1;
+
+	// Hashes the contents of a pipeline description, so it can be matched with the same pipeline state in a different run:
+	size_t ComputePipelineContentHash(const PipelineStateDesc& desc)
+	{
+		size_t hash = 0;
+		const Shader* shaders[] = { desc.ms, desc.as, desc.vs, desc.ps, desc.hs, desc.ds, desc.gs };
+		for (const Shader* shader : shaders)
+		{
+			wi::helper::hash_combine(hash, shader == nullptr ? size_t(0) : to_internal(shader)->code_hash);
+		}
+		if (desc.il != nullptr)
+		{
+			for (auto& x : desc.il->elements)
+			{
+				wi::helper::hash_combine(hash, x.semantic_name);
+				wi::helper::hash_combine(hash, x.semantic_index);
+				wi::helper::hash_combine(hash, x.format);
+				wi::helper::hash_combine(hash, x.input_slot);
+				wi::helper::hash_combine(hash, x.aligned_byte_offset);
+				wi::helper::hash_combine(hash, x.input_slot_class);
+			}
+		}
+		if (desc.rs != nullptr)
+		{
+			const RasterizerState& rs = *desc.rs;
+			wi::helper::hash_combine(hash, rs.fill_mode);
+			wi::helper::hash_combine(hash, rs.cull_mode);
+			wi::helper::hash_combine(hash, rs.front_counter_clockwise);
+			wi::helper::hash_combine(hash, rs.depth_bias);
+			wi::helper::hash_combine(hash, rs.depth_bias_clamp);
+			wi::helper::hash_combine(hash, rs.slope_scaled_depth_bias);
+			wi::helper::hash_combine(hash, rs.depth_clip_enable);
+			wi::helper::hash_combine(hash, rs.multisample_enable);
+			wi::helper::hash_combine(hash, rs.antialiased_line_enable);
+			wi::helper::hash_combine(hash, rs.conservative_rasterization_enable);
+			wi::helper::hash_combine(hash, rs.forced_sample_count);
+		}
+		if (desc.bs != nullptr)
+		{
+			const BlendState& bs = *desc.bs;
+			wi::helper::hash_combine(hash, bs.alpha_to_coverage_enable);
+			wi::helper::hash_combine(hash, bs.independent_blend_enable);
+			for (auto& x : bs.render_target)
+			{
+				wi::helper::hash_combine(hash, x.blend_enable);
+				wi::helper::hash_combine(hash, x.src_blend);
+				wi::helper::hash_combine(hash, x.dest_blend);
+				wi::helper::hash_combine(hash, x.blend_op);
+				wi::helper::hash_combine(hash, x.src_blend_alpha);
+				wi::helper::hash_combine(hash, x.dest_blend_alpha);
+				wi::helper::hash_combine(hash, x.blend_op_alpha);
+				wi::helper::hash_combine(hash, x.render_target_write_mask);
+			}
+		}
+		if (desc.dss != nullptr)
+		{
+			const DepthStencilState& dss = *desc.dss;
+			wi::helper::hash_combine(hash, dss.depth_enable);
+			wi::helper::hash_combine(hash, dss.depth_write_mask);
+			wi::helper::hash_combine(hash, dss.depth_func);
+			wi::helper::hash_combine(hash, dss.stencil_enable);
+			wi::helper::hash_combine(hash, dss.stencil_read_mask);
+			wi::helper::hash_combine(hash, dss.stencil_write_mask);
+			for (auto& x : { dss.front_face, dss.back_face })
+			{
+				wi::helper::hash_combine(hash, x.stencil_fail_op);
+				wi::helper::hash_combine(hash, x.stencil_depth_fail_op);
+				wi::helper::hash_combine(hash, x.stencil_pass_op);
+				wi::helper::hash_combine(hash, x.stencil_func);
+			}
+			wi::helper::hash_combine(hash, dss.depth_bounds_test_enable);
+		}
+		wi::helper::hash_combine(hash, desc.pt);
+		wi::helper::hash_combine(hash, desc.patch_control_points);
+		wi::helper::hash_combine(hash, desc.sample_mask);
+		return hash;
+	}
 
 	bool CreateSwapChainInternal(
 		SwapChain_Vulkan* internal_state,
@@ -2052,11 +2136,339 @@ using namespace vulkan_internal;
 		dirty = DIRTY_NONE;
 	}
 
-	void GraphicsDevice_Vulkan::pso_validate(CommandList cmd)
+	VkPipeline GraphicsDevice_Vulkan::pso_compile(const PipelineState* pso, const PipelineManifestEntry& layout, VkRenderPass renderpass) const
+	{
+		auto internal_state = to_internal(pso);
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = internal_state->pipelineInfo; // make a copy here
+		pipelineInfo.renderPass = renderpass;
+		pipelineInfo.subpass = 0;
+
+		// MSAA:
+		VkPipelineMultisampleStateCreateInfo multisampling = {};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		if (layout.attachment_count > 0)
+		{
+			multisampling.rasterizationSamples = (VkSampleCountFlagBits)layout.attachments[0].sample_count;
+		}
+		if (pso->desc.rs != nullptr)
+		{
+			const RasterizerState& desc = *pso->desc.rs;
+			if (desc.forced_sample_count > 1)
+			{
+				multisampling.rasterizationSamples = (VkSampleCountFlagBits)desc.forced_sample_count;
+			}
+		}
+		multisampling.minSampleShading = 1.0f;
+		VkSampleMask samplemask = internal_state->samplemask;
+		samplemask = pso->desc.sample_mask;
+		multisampling.pSampleMask = &samplemask;
+		if (pso->desc.bs != nullptr)
+		{
+			multisampling.alphaToCoverageEnable = pso->desc.bs->alpha_to_coverage_enable ? VK_TRUE : VK_FALSE;
+		}
+		else
+		{
+			multisampling.alphaToCoverageEnable = VK_FALSE;
+		}
+		multisampling.alphaToOneEnable = VK_FALSE;
+
+		pipelineInfo.pMultisampleState = &multisampling;
+
+
+		// Blending:
+		uint32_t numBlendAttachments = 0;
+		VkPipelineColorBlendAttachmentState colorBlendAttachments[8] = {};
+		for (uint32_t i = 0; i < layout.attachment_count; ++i)
+		{
+			if ((RenderPassAttachment::Type)layout.attachments[i].type != RenderPassAttachment::Type::RENDERTARGET)
+			{
+				continue;
+			}
+
+			size_t attachmentIndex = 0;
+			if (pso->desc.bs->independent_blend_enable)
+				attachmentIndex = i;
+
+			const auto& desc = pso->desc.bs->render_target[attachmentIndex];
+			VkPipelineColorBlendAttachmentState& attachment = colorBlendAttachments[numBlendAttachments];
+			numBlendAttachments++;
+
+			attachment.blendEnable = desc.blend_enable ? VK_TRUE : VK_FALSE;
+
+			attachment.colorWriteMask = 0;
+			if (has_flag(desc.render_target_write_mask, ColorWrite::ENABLE_RED))
+			{
+				attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
+			}
+			if (has_flag(desc.render_target_write_mask, ColorWrite::ENABLE_GREEN))
+			{
+				attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
+			}
+			if (has_flag(desc.render_target_write_mask, ColorWrite::ENABLE_BLUE))
+			{
+				attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
+			}
+			if (has_flag(desc.render_target_write_mask, ColorWrite::ENABLE_ALPHA))
+			{
+				attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
+			}
+
+			attachment.srcColorBlendFactor = _ConvertBlend(desc.src_blend);
+			attachment.dstColorBlendFactor = _ConvertBlend(desc.dest_blend);
+			attachment.colorBlendOp = _ConvertBlendOp(desc.blend_op);
+			attachment.srcAlphaBlendFactor = _ConvertBlend(desc.src_blend_alpha);
+			attachment.dstAlphaBlendFactor = _ConvertBlend(desc.dest_blend_alpha);
+			attachment.alphaBlendOp = _ConvertBlendOp(desc.blend_op_alpha);
+		}
+
+		VkPipelineColorBlendStateCreateInfo colorBlending = {};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		colorBlending.attachmentCount = numBlendAttachments;
+		colorBlending.pAttachments = colorBlendAttachments;
+		colorBlending.blendConstants[0] = 1.0f;
+		colorBlending.blendConstants[1] = 1.0f;
+		colorBlending.blendConstants[2] = 1.0f;
+		colorBlending.blendConstants[3] = 1.0f;
+
+		pipelineInfo.pColorBlendState = &colorBlending;
+
+		// Input layout:
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		wi::vector<VkVertexInputBindingDescription> bindings;
+		wi::vector<VkVertexInputAttributeDescription> attributes;
+		if (pso->desc.il != nullptr)
+		{
+			uint32_t lastBinding = 0xFFFFFFFF;
+			for (auto& x : pso->desc.il->elements)
+			{
+				if (x.input_slot == lastBinding)
+					continue;
+				lastBinding = x.input_slot;
+				VkVertexInputBindingDescription& bind = bindings.emplace_back();
+				bind.binding = x.input_slot;
+				bind.inputRate = x.input_slot_class == InputClassification::PER_VERTEX_DATA ? VK_VERTEX_INPUT_RATE_VERTEX : VK_VERTEX_INPUT_RATE_INSTANCE;
+				bind.stride = layout.vb_strides[x.input_slot];
+			}
+
+			uint32_t offset = 0;
+			uint32_t i = 0;
+			lastBinding = 0xFFFFFFFF;
+			for (auto& x : pso->desc.il->elements)
+			{
+				VkVertexInputAttributeDescription attr = {};
+				attr.binding = x.input_slot;
+				if (attr.binding != lastBinding)
+				{
+					lastBinding = attr.binding;
+					offset = 0;
+				}
+				attr.format = _ConvertFormat(x.format);
+				attr.location = i;
+				attr.offset = x.aligned_byte_offset;
+				if (attr.offset == InputLayout::APPEND_ALIGNED_ELEMENT)
+				{
+					// need to manually resolve this from the format spec.
+					attr.offset = offset;
+					offset += GetFormatStride(x.format);
+				}
+
+				attributes.push_back(attr);
+
+				i++;
+			}
+
+			vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+			vertexInputInfo.pVertexBindingDescriptions = bindings.data();
+			vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+			vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+		}
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkResult res = vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+		assert(res == VK_SUCCESS);
+
+		return pipeline;
+	}
+	VkRenderPass GraphicsDevice_Vulkan::pso_compile_renderpass(const PipelineManifestEntry& layout) const
+	{
+		// Pipelines only need a compatible render pass, which must match the attachment formats, sample counts and references of CreateRenderPass(),
+		//	but load/store operations and layouts don't matter
+		VkAttachmentDescription2 attachmentDescriptions[18] = {};
+		VkAttachmentReference2 colorAttachmentRefs[8] = {};
+		VkAttachmentReference2 resolveAttachmentRefs[8] = {};
+		VkAttachmentReference2 shadingRateAttachmentRef = {};
+		VkAttachmentReference2 depthAttachmentRef = {};
+
+		VkFragmentShadingRateAttachmentInfoKHR shading_rate_attachment = {};
+		shading_rate_attachment.sType = VK_STRUCTURE_TYPE_FRAGMENT_SHADING_RATE_ATTACHMENT_INFO_KHR;
+		shading_rate_attachment.pFragmentShadingRateAttachment = &shadingRateAttachmentRef;
+		shading_rate_attachment.shadingRateAttachmentTexelSize.width = VARIABLE_RATE_SHADING_TILE_SIZE;
+		shading_rate_attachment.shadingRateAttachmentTexelSize.height = VARIABLE_RATE_SHADING_TILE_SIZE;
+
+		int resolvecount = 0;
+
+		VkSubpassDescription2 subpass = {};
+		subpass.sType = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_2;
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+		for (uint32_t i = 0; i < layout.attachment_count; ++i)
+		{
+			const RenderPassAttachment::Type type = (RenderPassAttachment::Type)layout.attachments[i].type;
+			const Format format = (Format)layout.attachments[i].format;
+
+			attachmentDescriptions[i].sType = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2;
+			attachmentDescriptions[i].format = _ConvertFormat(format);
+			attachmentDescriptions[i].samples = (VkSampleCountFlagBits)layout.attachments[i].sample_count;
+			attachmentDescriptions[i].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachmentDescriptions[i].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachmentDescriptions[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachmentDescriptions[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachmentDescriptions[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachmentDescriptions[i].finalLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			if (type == RenderPassAttachment::Type::RENDERTARGET)
+			{
+				colorAttachmentRefs[subpass.colorAttachmentCount].sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+				colorAttachmentRefs[subpass.colorAttachmentCount].attachment = i;
+				colorAttachmentRefs[subpass.colorAttachmentCount].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				colorAttachmentRefs[subpass.colorAttachmentCount].aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				subpass.colorAttachmentCount++;
+				subpass.pColorAttachments = colorAttachmentRefs;
+			}
+			else if (type == RenderPassAttachment::Type::DEPTH_STENCIL)
+			{
+				depthAttachmentRef.sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+				depthAttachmentRef.attachment = i;
+				depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				depthAttachmentRef.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+				if (IsFormatStencilSupport(format))
+				{
+					depthAttachmentRef.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+				}
+				subpass.pDepthStencilAttachment = &depthAttachmentRef;
+			}
+			else if (type == RenderPassAttachment::Type::RESOLVE)
+			{
+				resolveAttachmentRefs[resolvecount].sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+				resolveAttachmentRefs[resolvecount].attachment = i;
+				resolveAttachmentRefs[resolvecount].layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				resolveAttachmentRefs[resolvecount].aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				resolvecount++;
+				subpass.pResolveAttachments = resolveAttachmentRefs;
+			}
+			else if (type == RenderPassAttachment::Type::SHADING_RATE_SOURCE && CheckCapability(GraphicsDeviceCapability::VARIABLE_RATE_SHADING_TIER2))
+			{
+				shadingRateAttachmentRef.sType = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+				shadingRateAttachmentRef.attachment = i;
+				shadingRateAttachmentRef.layout = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR;
+				shadingRateAttachmentRef.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				subpass.pNext = &shading_rate_attachment;
+			}
+		}
+
+		VkRenderPassCreateInfo2 renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO_2;
+		renderPassInfo.attachmentCount = layout.attachment_count;
+		renderPassInfo.pAttachments = attachmentDescriptions;
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+
+		VkRenderPass renderpass = VK_NULL_HANDLE;
+		VkResult res = vkCreateRenderPass2(device, &renderPassInfo, nullptr, &renderpass);
+		assert(res == VK_SUCCESS);
+
+		return renderpass;
+	}
+	void GraphicsDevice_Vulkan::pso_compile_async(size_t pipeline_hash, const PipelineState* pso, const PipelineManifestEntry& layout, const RenderPass* renderpass) const
+	{
+		pipelines_compiled_mutex.lock();
+		const bool already_compiling = !pipelines_compiling.insert(pipeline_hash).second;
+		pipelines_compiled_mutex.unlock();
+		if (already_compiling)
+			return;
+
+		// The job holds references to the pipeline and shader objects, and copies of the states that the description points to,
+		//	so those can be destroyed by the application while the pipeline is compiling:
+		PipelineState pso_ref = *pso;
+		const BlendState bs_copy = pso->desc.bs == nullptr ? BlendState() : *pso->desc.bs;
+		const InputLayout il_copy = pso->desc.il == nullptr ? InputLayout() : *pso->desc.il;
+		const RasterizerState rs_copy = pso->desc.rs == nullptr ? RasterizerState() : *pso->desc.rs;
+		const bool has_bs = pso->desc.bs != nullptr;
+		const bool has_il = pso->desc.il != nullptr;
+		const bool has_rs = pso->desc.rs != nullptr;
+		Shader shader_refs[] = {
+			pso->desc.ms == nullptr ? Shader() : *pso->desc.ms,
+			pso->desc.as == nullptr ? Shader() : *pso->desc.as,
+			pso->desc.vs == nullptr ? Shader() : *pso->desc.vs,
+			pso->desc.ps == nullptr ? Shader() : *pso->desc.ps,
+			pso->desc.hs == nullptr ? Shader() : *pso->desc.hs,
+			pso->desc.ds == nullptr ? Shader() : *pso->desc.ds,
+			pso->desc.gs == nullptr ? Shader() : *pso->desc.gs,
+		};
+		RenderPass renderpass_ref;
+		if (renderpass != nullptr)
+		{
+			renderpass_ref = *renderpass;
+		}
+		const bool precompile = renderpass == nullptr;
+
+		std::scoped_lock lock(pipeline_compile_queue.locker);
+		pipeline_compile_queue.jobs.push_back([this, pipeline_hash, pso_ref, shader_refs, bs_copy, il_copy, rs_copy, has_bs, has_il, has_rs, renderpass_ref, layout, precompile]() {
+			PipelineState pso_local = pso_ref;
+			pso_local.desc.bs = has_bs ? &bs_copy : nullptr;
+			pso_local.desc.il = has_il ? &il_copy : nullptr;
+			pso_local.desc.rs = has_rs ? &rs_copy : nullptr;
+			VkRenderPass vk_renderpass = precompile ? pso_compile_renderpass(layout) : to_internal(&renderpass_ref)->renderpass;
+			VkPipeline pipeline = pso_compile(&pso_local, layout, vk_renderpass);
+			if (precompile)
+			{
+				vkDestroyRenderPass(device, vk_renderpass, nullptr);
+			}
+
+			pipelines_compiled_mutex.lock();
+			pipelines_compiled.push_back(std::make_pair(pipeline_hash, pipeline));
+			pipelines_compiling.erase(pipeline_hash);
+			if (precompile)
+			{
+				pipeline_statistics.precompiled++;
+			}
+			else
+			{
+				pipeline_statistics.compiled_async++;
+			}
+			pipelines_compiled_mutex.unlock();
+		});
+		pipeline_compile_queue.wake.notify_one();
+	}
+	void GraphicsDevice_Vulkan::pso_compile_wait() const
+	{
+		std::unique_lock lock(pipeline_compile_queue.locker);
+		pipeline_compile_queue.idle.wait(lock, [this] { return pipeline_compile_queue.jobs.empty() && pipeline_compile_queue.running == 0; });
+	}
+	void GraphicsDevice_Vulkan::pso_manifest_record(const PipelineManifestEntry& layout) const
+	{
+		std::scoped_lock lock(pipeline_manifest_mutex);
+		pipeline_manifest_used.insert(layout.pso_hash);
+		wi::vector<PipelineManifestEntry>& entries = pipeline_manifest[layout.pso_hash];
+		for (auto& x : entries)
+		{
+			if (x.renderpass_hash == layout.renderpass_hash && x.vb_hash == layout.vb_hash)
+				return;
+		}
+		entries.push_back(layout);
+	}
+	bool GraphicsDevice_Vulkan::pso_validate(CommandList cmd)
 	{
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		if (!commandlist.dirty_pso)
-			return;
+			return true;
 
 		const PipelineState* pso = commandlist.active_pso;
 		size_t pipeline_hash = commandlist.prev_pipeline_hash;
@@ -2076,161 +2488,71 @@ using namespace vulkan_internal;
 				}
 			}
 
+			bool compiling = false;
 			if (pipeline == VK_NULL_HANDLE)
 			{
-				VkGraphicsPipelineCreateInfo pipelineInfo = internal_state->pipelineInfo; // make a copy here
-				pipelineInfo.renderPass = to_internal(commandlist.active_renderpass)->renderpass;
-				pipelineInfo.subpass = 0;
-
-				// MSAA:
-				VkPipelineMultisampleStateCreateInfo multisampling = {};
-				multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-				multisampling.sampleShadingEnable = VK_FALSE;
-				multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-				if (commandlist.active_renderpass->desc.attachments.size() > 0 && commandlist.active_renderpass->desc.attachments[0].texture != nullptr)
+				// Pipelines compiled in the background that are not yet merged into pipelines_global:
+				std::scoped_lock lock(pipelines_compiled_mutex);
+				for (auto& x : pipelines_compiled)
 				{
-					multisampling.rasterizationSamples = (VkSampleCountFlagBits)commandlist.active_renderpass->desc.attachments[0].texture->desc.sample_count;
-				}
-				if (pso->desc.rs != nullptr)
-				{
-					const RasterizerState& desc = *pso->desc.rs;
-					if (desc.forced_sample_count > 1)
+					if (pipeline_hash == x.first)
 					{
-						multisampling.rasterizationSamples = (VkSampleCountFlagBits)desc.forced_sample_count;
+						pipeline = x.second;
+						break;
 					}
 				}
-				multisampling.minSampleShading = 1.0f;
-				VkSampleMask samplemask = internal_state->samplemask;
-				samplemask = pso->desc.sample_mask;
-				multisampling.pSampleMask = &samplemask;
-				if (pso->desc.bs != nullptr)
-				{
-					multisampling.alphaToCoverageEnable = pso->desc.bs->alpha_to_coverage_enable ? VK_TRUE : VK_FALSE;
-				}
-				else
-				{
-					multisampling.alphaToCoverageEnable = VK_FALSE;
-				}
-				multisampling.alphaToOneEnable = VK_FALSE;
-
-				pipelineInfo.pMultisampleState = &multisampling;
-
+				compiling = pipelines_compiling.count(pipeline_hash) > 0;
+			}
 
-				// Blending:
-				uint32_t numBlendAttachments = 0;
-				VkPipelineColorBlendAttachmentState colorBlendAttachments[8] = {};
-				const size_t blend_loopCount = commandlist.active_renderpass->desc.attachments.size();
-				for (size_t i = 0; i < blend_loopCount; ++i)
-				{
-					if (commandlist.active_renderpass->desc.attachments[i].type != RenderPassAttachment::Type::RENDERTARGET)
+			if (pipeline == VK_NULL_HANDLE)
+			{
+				PipelineManifestEntry layout;
+				layout.pso_hash = internal_state->content_hash;
+				layout.renderpass_hash = commandlist.active_renderpass->hash;
+				layout.vb_hash = commandlist.vb_hash;
+				std::memcpy(layout.vb_strides, commandlist.vb_strides, sizeof(layout.vb_strides));
+
+				// The swapchain render pass is not created by CreateRenderPass(), so those pipelines are not recorded into the warm-up list:
+				bool recordable = commandlist.prev_swapchains.empty() || commandlist.active_renderpass != &to_internal(&commandlist.prev_swapchains.back())->renderpass;
+				const auto& attachments = commandlist.active_renderpass->desc.attachments;
+				assert(attachments.size() <= arraysize(layout.attachments));
+				layout.attachment_count = std::min(uint32_t(attachments.size()), uint32_t(arraysize(layout.attachments)));
+				for (uint32_t i = 0; i < layout.attachment_count; ++i)
+				{
+					layout.attachments[i].type = (uint8_t)attachments[i].type;
+					if (attachments[i].texture == nullptr)
 					{
+						recordable = false;
 						continue;
 					}
+					layout.attachments[i].format = (uint32_t)attachments[i].texture->desc.format;
+					layout.attachments[i].sample_count = (uint8_t)attachments[i].texture->desc.sample_count;
+				}
+				if (recordable)
+				{
+					pso_manifest_record(layout);
+				}
 
-					size_t attachmentIndex = 0;
-					if (pso->desc.bs->independent_blend_enable)
-						attachmentIndex = i;
-
-					const auto& desc = pso->desc.bs->render_target[attachmentIndex];
-					VkPipelineColorBlendAttachmentState& attachment = colorBlendAttachments[numBlendAttachments];
-					numBlendAttachments++;
-
-					attachment.blendEnable = desc.blend_enable ? VK_TRUE : VK_FALSE;
-
-					attachment.colorWriteMask = 0;
-					if (has_flag(desc.render_target_write_mask, ColorWrite::ENABLE_RED))
-					{
-						attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
-					}
-					if (has_flag(desc.render_target_write_mask, ColorWrite::ENABLE_GREEN))
-					{
-						attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT;
-					}
-					if (has_flag(desc.render_target_write_mask, ColorWrite::ENABLE_BLUE))
-					{
-						attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT;
-					}
-					if (has_flag(desc.render_target_write_mask, ColorWrite::ENABLE_ALPHA))
-					{
-						attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT;
-					}
-
-					attachment.srcColorBlendFactor = _ConvertBlend(desc.src_blend);
-					attachment.dstColorBlendFactor = _ConvertBlend(desc.dest_blend);
-					attachment.colorBlendOp = _ConvertBlendOp(desc.blend_op);
-					attachment.srcAlphaBlendFactor = _ConvertBlend(desc.src_blend_alpha);
-					attachment.dstAlphaBlendFactor = _ConvertBlend(desc.dest_blend_alpha);
-					attachment.alphaBlendOp = _ConvertBlendOp(desc.blend_op_alpha);
-				}
-
-				VkPipelineColorBlendStateCreateInfo colorBlending = {};
-				colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-				colorBlending.logicOpEnable = VK_FALSE;
-				colorBlending.logicOp = VK_LOGIC_OP_COPY;
-				colorBlending.attachmentCount = numBlendAttachments;
-				colorBlending.pAttachments = colorBlendAttachments;
-				colorBlending.blendConstants[0] = 1.0f;
-				colorBlending.blendConstants[1] = 1.0f;
-				colorBlending.blendConstants[2] = 1.0f;
-				colorBlending.blendConstants[3] = 1.0f;
-
-				pipelineInfo.pColorBlendState = &colorBlending;
-
-				// Input layout:
-				VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-				vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-				wi::vector<VkVertexInputBindingDescription> bindings;
-				wi::vector<VkVertexInputAttributeDescription> attributes;
-				if (pso->desc.il != nullptr)
-				{
-					uint32_t lastBinding = 0xFFFFFFFF;
-					for (auto& x : pso->desc.il->elements)
+				if (async_pipeline_compilation.load() && !has_flag(commandlist.active_renderpass->desc.flags, RenderPassDesc::Flags::SYNCHRONOUS_PIPELINE_COMPILATION))
+				{
+					if (!compiling)
 					{
-						if (x.input_slot == lastBinding)
-							continue;
-						lastBinding = x.input_slot;
-						VkVertexInputBindingDescription& bind = bindings.emplace_back();
-						bind.binding = x.input_slot;
-						bind.inputRate = x.input_slot_class == InputClassification::PER_VERTEX_DATA ? VK_VERTEX_INPUT_RATE_VERTEX : VK_VERTEX_INPUT_RATE_INSTANCE;
-						bind.stride = commandlist.vb_strides[x.input_slot];
+						pso_compile_async(pipeline_hash, pso, layout, commandlist.active_renderpass);
 					}
-
-					uint32_t offset = 0;
-					uint32_t i = 0;
-					lastBinding = 0xFFFFFFFF;
-					for (auto& x : pso->desc.il->elements)
-					{
-						VkVertexInputAttributeDescription attr = {};
-						attr.binding = x.input_slot;
-						if (attr.binding != lastBinding)
-						{
-							lastBinding = attr.binding;
-							offset = 0;
-						}
-						attr.format = _ConvertFormat(x.format);
-						attr.location = i;
-						attr.offset = x.aligned_byte_offset;
-						if (attr.offset == InputLayout::APPEND_ALIGNED_ELEMENT)
-						{
-							// need to manually resolve this from the format spec.
-							attr.offset = offset;
-							offset += GetFormatStride(x.format);
-						}
-
-						attributes.push_back(attr);
-
-						i++;
-					}
-
-					vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
-					vertexInputInfo.pVertexBindingDescriptions = bindings.data();
-					vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
-					vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+					std::scoped_lock lock(pipelines_compiled_mutex);
+					pipeline_statistics.skipped_draws++;
+					return false;
 				}
-				pipelineInfo.pVertexInputState = &vertexInputInfo;
 
-				VkResult res = vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
-				assert(res == VK_SUCCESS);
+				wi::Timer timer;
+				pipeline = pso_compile(pso, layout, to_internal(commandlist.active_renderpass)->renderpass);
+				const float elapsed = (float)timer.elapsed_milliseconds();
+
+				pipelines_compiled_mutex.lock();
+				pipeline_statistics.compiled_at_draw++;
+				pipeline_statistics.hitch_milliseconds_total += elapsed;
+				pipeline_statistics.hitch_milliseconds_max = std::max(pipeline_statistics.hitch_milliseconds_max, elapsed);
+				pipelines_compiled_mutex.unlock();
 
 				commandlist.pipelines_worker.push_back(std::make_pair(pipeline_hash, pipeline));
 			}
@@ -2243,14 +2565,17 @@ using namespace vulkan_internal;
 
 		vkCmdBindPipeline(commandlist.GetCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 		commandlist.dirty_pso = false;
+		return true;
 	}
 
-	void GraphicsDevice_Vulkan::predraw(CommandList cmd)
+	bool GraphicsDevice_Vulkan::predraw(CommandList cmd)
 	{
-		pso_validate(cmd);
+		if (!pso_validate(cmd))
+			return false; // pipeline is still compiling asynchronously, the draw is skipped
 
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		commandlist.binder.flush(true, cmd);
+		return true;
 	}
 	void GraphicsDevice_Vulkan::predispatch(CommandList cmd)
 	{
@@ -3178,6 +3503,33 @@ using namespace vulkan_internal;
 			assert(res == VK_SUCCESS);
 		}
 
+		// Pipeline warm-up list:
+		{
+			wi::vector<uint8_t> manifestData;
+			if (wi::helper::FileRead(GetPipelineManifestPath(), manifestData) && manifestData.size() >= sizeof(uint32_t) * 2)
+			{
+				uint32_t version = 0;
+				uint32_t entrySize = 0;
+				std::memcpy(&version, manifestData.data() + 0, sizeof(uint32_t));
+				std::memcpy(&entrySize, manifestData.data() + 4, sizeof(uint32_t));
+				const size_t entryCount = (manifestData.size() - sizeof(uint32_t) * 2) / sizeof(PipelineManifestEntry);
+
+				if (version == pipeline_manifest_version && entrySize == sizeof(PipelineManifestEntry))
+				{
+					for (size_t i = 0; i < entryCount; ++i)
+					{
+						PipelineManifestEntry entry;
+						std::memcpy(&entry, manifestData.data() + sizeof(uint32_t) * 2 + i * sizeof(PipelineManifestEntry), sizeof(PipelineManifestEntry));
+						if (entry.attachment_count <= arraysize(entry.attachments))
+						{
+							pipeline_manifest[entry.pso_hash].push_back(entry);
+						}
+					}
+					wi::backlog::post("Vulkan pipeline warm-up list loaded: " + std::to_string(entryCount) + " pipelines");
+				}
+			}
+		}
+
 		// Static samplers:
 		{
 			VkSamplerCreateInfo createInfo = {};
@@ -3305,10 +3657,50 @@ using namespace vulkan_internal;
 			assert(res == VK_SUCCESS);
 		}
 
+		// Background pipeline compiler threads:
+		{
+			const uint32_t thread_count = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+			for (uint32_t i = 0; i < thread_count; ++i)
+			{
+				pipeline_compile_queue.threads.emplace_back([this] {
+					PipelineCompileQueue& queue = pipeline_compile_queue;
+					std::unique_lock lock(queue.locker);
+					while (true)
+					{
+						queue.wake.wait(lock, [&] { return !queue.alive || !queue.jobs.empty(); });
+						if (!queue.alive)
+							break;
+						std::function<void()> job = std::move(queue.jobs.front());
+						queue.jobs.pop_front();
+						queue.running++;
+						lock.unlock();
+						job();
+						lock.lock();
+						queue.running--;
+						if (queue.jobs.empty() && queue.running == 0)
+						{
+							queue.idle.notify_all();
+						}
+					}
+				});
+			}
+		}
+
 		wi::backlog::post("Created GraphicsDevice_Vulkan (" + std::to_string((int)std::round(timer.elapsed())) + " ms)");
 	}
 	GraphicsDevice_Vulkan::~GraphicsDevice_Vulkan()
 	{
+		// Pipelines that didn't start compiling yet are abandoned, the running ones are finished:
+		pipeline_compile_queue.locker.lock();
+		pipeline_compile_queue.jobs.clear();
+		pipeline_compile_queue.alive = false;
+		pipeline_compile_queue.locker.unlock();
+		pipeline_compile_queue.wake.notify_all();
+		for (auto& x : pipeline_compile_queue.threads)
+		{
+			x.join();
+		}
+
 		VkResult res = vkDeviceWaitIdle(device);
 		assert(res == VK_SUCCESS);
 
@@ -3356,6 +3748,27 @@ using namespace vulkan_internal;
 		{
 			vkDestroyPipeline(device, x.second, nullptr);
 		}
+		for (auto& x : pipelines_compiled)
+		{
+			vkDestroyPipeline(device, x.second, nullptr);
+		}
+
+		// Write the pipeline warm-up list for the next run, entries of pipeline states that were not created in this run are dropped:
+		{
+			wi::vector<uint8_t> manifestData(sizeof(uint32_t) * 2);
+			const uint32_t entrySize = sizeof(PipelineManifestEntry);
+			std::memcpy(manifestData.data() + 0, &pipeline_manifest_version, sizeof(uint32_t));
+			std::memcpy(manifestData.data() + 4, &entrySize, sizeof(uint32_t));
+			for (auto& x : pipeline_manifest)
+			{
+				if (pipeline_manifest_used.count(x.first) == 0)
+					continue;
+				const size_t offset = manifestData.size();
+				manifestData.resize(offset + x.second.size() * sizeof(PipelineManifestEntry));
+				std::memcpy(manifestData.data() + offset, x.second.data(), x.second.size() * sizeof(PipelineManifestEntry));
+			}
+			wi::helper::FileWrite(GetPipelineManifestPath(), manifestData.data(), manifestData.size());
+		}
 
 		vmaDestroyBuffer(allocationhandler->allocator, nullBuffer, nullBufferAllocation);
 		vkDestroyBufferView(device, nullBufferView, nullptr);
@@ -4041,6 +4454,12 @@ using namespace vulkan_internal;
 		res = vkCreateShaderModule(device, &moduleInfo, nullptr, &internal_state->shaderModule);
 		assert(res == VK_SUCCESS);
 
+		wi::helper::hash_combine(internal_state->code_hash, shadercode_size);
+		for (size_t i = 0; i < shadercode_size / sizeof(uint32_t); ++i)
+		{
+			wi::helper::hash_combine(internal_state->code_hash, ((const uint32_t*)shadercode)[i]);
+		}
+
 		internal_state->stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		internal_state->stageInfo.module = internal_state->shaderModule;
 		internal_state->stageInfo.pName = "main";
@@ -5052,6 +5471,30 @@ using namespace vulkan_internal;
 
 		pipelineInfo.pDynamicState = &dynamicStateInfo;
 
+		// Pipelines of this state that were used in a previous run are compiled in the background from the warm-up list:
+		internal_state->content_hash = ComputePipelineContentHash(*desc);
+		{
+			wi::vector<PipelineManifestEntry> entries;
+			pipeline_manifest_mutex.lock();
+			auto it = pipeline_manifest.find(internal_state->content_hash);
+			if (it != pipeline_manifest.end())
+			{
+				entries = it->second;
+				pipeline_manifest_used.insert(internal_state->content_hash);
+			}
+			pipeline_manifest_mutex.unlock();
+
+			for (auto& entry : entries)
+			{
+				// Same as the pipeline hash that pso_validate() will look for:
+				size_t pipeline_hash = 0;
+				wi::helper::hash_combine(pipeline_hash, pso->hash);
+				wi::helper::hash_combine(pipeline_hash, size_t(entry.renderpass_hash));
+				wi::helper::hash_combine(pipeline_hash, size_t(entry.vb_hash));
+				pso_compile_async(pipeline_hash, pso, entry, nullptr);
+			}
+		}
+
 		return res == VK_SUCCESS;
 	}
 	bool GraphicsDevice_Vulkan::CreateRenderPass(const RenderPassDesc* desc, RenderPass* renderpass) const
@@ -6388,6 +6831,24 @@ using namespace vulkan_internal;
 				commandlist.pipelines_worker.clear();
 			}
 
+			// Pipelines that were compiled in the background:
+			pipelines_compiled_mutex.lock();
+			for (auto& x : pipelines_compiled)
+			{
+				if (pipelines_global.count(x.first) == 0)
+				{
+					pipelines_global[x.first] = x.second;
+				}
+				else
+				{
+					allocationhandler->destroylocker.lock();
+					allocationhandler->destroyer_pipelines.push_back(std::make_pair(x.second, FRAMECOUNT));
+					allocationhandler->destroylocker.unlock();
+				}
+			}
+			pipelines_compiled.clear();
+			pipelines_compiled_mutex.unlock();
+
 			// final submits with fences:
 			for (int queue = 0; queue < QUEUE_COUNT; ++queue)
 			{
@@ -6443,6 +6904,8 @@ using namespace vulkan_internal;
 	}
 	void GraphicsDevice_Vulkan::ClearPipelineStateCache()
 	{
+		pso_compile_wait();
+
 		allocationhandler->destroylocker.lock();
 
 		pso_layout_cache_mutex.lock();
@@ -6468,6 +6931,12 @@ using namespace vulkan_internal;
 			}
 			x->pipelines_worker.clear();
 		}
+
+		for (auto& x : pipelines_compiled)
+		{
+			allocationhandler->destroyer_pipelines.push_back(std::make_pair(x.second, FRAMECOUNT));
+		}
+		pipelines_compiled.clear();
 		allocationhandler->destroylocker.unlock();
 
 		// Destroy Vulkan pipeline cache 
@@ -6483,6 +6952,12 @@ using namespace vulkan_internal;
 		assert(res == VK_SUCCESS);
 	}
 
+	PipelineCompileStatistics GraphicsDevice_Vulkan::GetPipelineCompileStatistics() const
+	{
+		std::scoped_lock lock(pipelines_compiled_mutex);
+		return pipeline_statistics;
+	}
+
 	Texture GraphicsDevice_Vulkan::GetBackBuffer(const SwapChain* swapchain) const
 	{
 		auto swapchain_internal = to_internal(swapchain);
@@ -6972,45 +7447,52 @@ using namespace vulkan_internal;
 	}
 	void GraphicsDevice_Vulkan::Draw(uint32_t vertexCount, uint32_t startVertexLocation, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		vkCmdDraw(commandlist.GetCommandBuffer(), vertexCount, 1, startVertexLocation, 0);
 	}
 	void GraphicsDevice_Vulkan::DrawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int32_t baseVertexLocation, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		vkCmdDrawIndexed(commandlist.GetCommandBuffer(), indexCount, 1, startIndexLocation, baseVertexLocation, 0);
 	}
 	void GraphicsDevice_Vulkan::DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		vkCmdDraw(commandlist.GetCommandBuffer(), vertexCount, instanceCount, startVertexLocation, startInstanceLocation);
 	}
 	void GraphicsDevice_Vulkan::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		vkCmdDrawIndexed(commandlist.GetCommandBuffer(), indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
 	}
 	void GraphicsDevice_Vulkan::DrawInstancedIndirect(const GPUBuffer* args, uint64_t args_offset, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		auto internal_state = to_internal(args);
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		vkCmdDrawIndirect(commandlist.GetCommandBuffer(), internal_state->resource, args_offset, 1, (uint32_t)sizeof(IndirectDrawArgsInstanced));
 	}
 	void GraphicsDevice_Vulkan::DrawIndexedInstancedIndirect(const GPUBuffer* args, uint64_t args_offset, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		auto internal_state = to_internal(args);
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		vkCmdDrawIndexedIndirect(commandlist.GetCommandBuffer(), internal_state->resource, args_offset, 1, sizeof(IndirectDrawArgsIndexedInstanced));
 	}
 	void GraphicsDevice_Vulkan::DrawInstancedIndirectCount(const GPUBuffer* args, uint64_t args_offset, const GPUBuffer* count, uint64_t count_offset, uint32_t max_count, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		auto args_internal = to_internal(args);
 		auto count_internal = to_internal(count);
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
@@ -7018,7 +7500,8 @@ using namespace vulkan_internal;
 	}
 	void GraphicsDevice_Vulkan::DrawIndexedInstancedIndirectCount(const GPUBuffer* args, uint64_t args_offset, const GPUBuffer* count, uint64_t count_offset, uint32_t max_count, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		auto args_internal = to_internal(args);
 		auto count_internal = to_internal(count);
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
@@ -7039,13 +7522,15 @@ using namespace vulkan_internal;
 	}
 	void GraphicsDevice_Vulkan::DispatchMesh(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		vkCmdDrawMeshTasksNV(commandlist.GetCommandBuffer(), threadGroupCountX * threadGroupCountY * threadGroupCountZ, 0);
 	}
 	void GraphicsDevice_Vulkan::DispatchMeshIndirect(const GPUBuffer* args, uint64_t args_offset, CommandList cmd)
 	{
-		predraw(cmd);
+		if (!predraw(cmd))
+			return;
 		auto internal_state = to_internal(args);
 		CommandList_Vulkan& commandlist = GetCommandList(cmd);
 		vkCmdDrawMeshTasksIndirectNV(commandlist.GetCommandBuffer(), internal_state->resource, args_offset, 1, sizeof(IndirectDispatchArgs));
@@ -11,6 +11,7 @@
 #include "wiUnorderedMap.h"
 #include "wiVector.h"
 #include "wiSpinLock.h"
+#include "wiUnorderedSet.h"
 
 #ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
@@ -25,6 +26,9 @@
 #include <atomic>
 #include <mutex>
 #include <algorithm>
+#include <functional>
+#include <thread>
+#include <condition_variable>
 
 namespace wi::graphics
 {
@@ -274,9 +278,58 @@ namespace wi::graphics
 		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 		wi::unordered_map<size_t, VkPipeline> pipelines_global;
 
-		void pso_validate(CommandList cmd);
+		// Pipeline warm-up list:
+		//	Every compiled graphics pipeline is recorded with the content hash of its PipelineState and the layout of the render pass it was compiled for
+		//	The list is saved when the device is destroyed, and in the next run its pipelines are compiled on the background compiler threads as soon as their PipelineState is created
+		struct PipelineManifestEntry
+		{
+			uint64_t pso_hash = 0; // content hash of the PipelineState, unlike PipelineState::hash this is stable between runs
+			uint64_t renderpass_hash = 0; // RenderPass::hash
+			uint64_t vb_hash = 0;
+			uint32_t vb_strides[8] = {};
+			uint32_t attachment_count = 0;
+			uint32_t padding = 0;
+			struct Attachment
+			{
+				uint32_t format = 0;
+				uint8_t type = 0;
+				uint8_t sample_count = 1;
+				uint8_t padding[2] = {};
+			} attachments[18] = {}; // 8 render targets, 8 resolves, depth stencil, shading rate source
+		};
+		mutable wi::unordered_map<size_t, wi::vector<PipelineManifestEntry>> pipeline_manifest; // key: PipelineManifestEntry::pso_hash
+		mutable wi::unordered_set<size_t> pipeline_manifest_used; // pso_hash of the entries that were created or recorded in this run, only these are saved
+		mutable std::mutex pipeline_manifest_mutex;
 
-		void predraw(CommandList cmd);
+		// Background pipeline compilation runs on dedicated threads instead of the job system,
+		//	because wi::jobsystem::Wait() executes queued jobs on the waiting thread, which can be the command list recording thread
+		struct PipelineCompileQueue
+		{
+			std::deque<std::function<void()>> jobs;
+			uint32_t running = 0;
+			bool alive = true;
+			std::mutex locker;
+			std::condition_variable wake;
+			std::condition_variable idle;
+			wi::vector<std::thread> threads;
+		};
+		mutable PipelineCompileQueue pipeline_compile_queue;
+
+		// Pipelines compiled in the background are collected here until they are merged into pipelines_global in SubmitCommandLists():
+		mutable wi::vector<std::pair<size_t, VkPipeline>> pipelines_compiled;
+		mutable wi::unordered_set<size_t> pipelines_compiling;
+		mutable PipelineCompileStatistics pipeline_statistics;
+		mutable std::mutex pipelines_compiled_mutex;
+		std::atomic_bool async_pipeline_compilation{ false };
+
+		VkPipeline pso_compile(const PipelineState* pso, const PipelineManifestEntry& layout, VkRenderPass renderpass) const;
+		VkRenderPass pso_compile_renderpass(const PipelineManifestEntry& layout) const;
+		void pso_compile_async(size_t pipeline_hash, const PipelineState* pso, const PipelineManifestEntry& layout, const RenderPass* renderpass) const;
+		void pso_manifest_record(const PipelineManifestEntry& layout) const;
+		void pso_compile_wait() const;
+		bool pso_validate(CommandList cmd);
+
+		bool predraw(CommandList cmd);
 		void predispatch(CommandList cmd);
 
 		static constexpr uint32_t immutable_sampler_slot_begin = 100;
@@ -315,6 +368,9 @@ namespace wi::graphics
 		void WaitForGPU() const override;
 		void ClearPipelineStateCache() override;
 		size_t GetActivePipelineCount() const override { return pipelines_global.size(); }
+		PipelineCompileStatistics GetPipelineCompileStatistics() const override;
+		void SetAsyncPipelineCompilationEnabled(bool value) override { async_pipeline_compilation.store(value); }
+		bool IsAsyncPipelineCompilationEnabled() const override { return async_pipeline_compilation.load(); }
 
 		ShaderFormat GetShaderFormat() const override { return ShaderFormat::SPIRV; }
 
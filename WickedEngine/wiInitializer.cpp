@@ -73,4 +73,9 @@ namespace wi::initializer
 			return systems[system].load();
 		}
 	}
+
+	void WaitForInitializationsToFinish()
+	{
+		wi::jobsystem::Wait(ctx);
+	}
 }
@@ -28,4 +28,6 @@ namespace wi::initializer
 	// Check if systems have been initialized or not
 	//	system : specify to check a specific system, or leave default to check all systems
 	bool IsInitializeFinished(INITIALIZED_SYSTEM system = INITIALIZED_SYSTEM_COUNT);
+	// Blocks CPU until all initializations are finished
+	void WaitForInitializationsToFinish();
 }
@@ -97,6 +97,122 @@ namespace wi::noise
 			}
 			return result;
 		}
+
+		// Gradient of grad() as x, y, z coefficients for every hash value
+		static constexpr float gradient_coefficients[16][3] = {
+			{ 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 },
+			{ 1, 0, 1 }, { -1, 0, 1 }, { 1, 0, -1 }, { -1, 0, -1 },
+			{ 0, 1, 1 }, { 0, -1, 1 }, { 0, 1, -1 }, { 0, -1, -1 },
+			{ 1, 1, 0 }, { 0, -1, 1 }, { -1, 1, 0 }, { 0, -1, -1 },
+		};
+		inline XMVECTOR grad(const uint8_t hash[4], XMVECTOR x, XMVECTOR y, XMVECTOR z) const
+		{
+			const float* g0 = gradient_coefficients[hash[0] & 15];
+			const float* g1 = gradient_coefficients[hash[1] & 15];
+			const float* g2 = gradient_coefficients[hash[2] & 15];
+			const float* g3 = gradient_coefficients[hash[3] & 15];
+			const XMVECTOR gx = XMVectorSet(g0[0], g1[0], g2[0], g3[0]);
+			const XMVECTOR gy = XMVectorSet(g0[1], g1[1], g2[1], g3[1]);
+			const XMVECTOR gz = XMVectorSet(g0[2], g1[2], g2[2], g3[2]);
+			return XMVectorAdd(XMVectorAdd(XMVectorMultiply(gx, x), XMVectorMultiply(gy, y)), XMVectorMultiply(gz, z));
+		}
+		inline XMVECTOR fade(XMVECTOR t) const
+		{
+			return t * t * t * (t * (t * 6 - XMVectorReplicate(15)) + XMVectorReplicate(10));
+		}
+		inline XMVECTOR lerp(XMVECTOR a, XMVECTOR b, XMVECTOR t) const
+		{
+			return XMVectorAdd(a, XMVectorMultiply(XMVectorSubtract(b, a), t));
+		}
+		// Computes noise for 4 points at once, the lattice lookups are done per lane, everything else is SIMD
+		//	returns noise in range [-1, 1]
+		inline XMVECTOR compute(XMVECTOR x, XMVECTOR y, XMVECTOR z) const
+		{
+			const XMVECTOR _x = XMVectorFloor(x);
+			const XMVECTOR _y = XMVectorFloor(y);
+			const XMVECTOR _z = XMVectorFloor(z);
+
+			XMFLOAT4 cx, cy, cz;
+			XMStoreFloat4(&cx, _x);
+			XMStoreFloat4(&cy, _y);
+			XMStoreFloat4(&cz, _z);
+			const float* lx = &cx.x;
+			const float* ly = &cy.x;
+			const float* lz = &cz.x;
+
+			uint8_t hAA[4], hBA[4], hAB[4], hBB[4], hAA1[4], hBA1[4], hAB1[4], hBB1[4];
+			for (int i = 0; i < 4; ++i)
+			{
+				const int ix = int(lx[i]) & 255;
+				const int iy = int(ly[i]) & 255;
+				const int iz = int(lz[i]) & 255;
+
+				const uint8_t A = (state[ix & 255] + iy) & 255;
+				const uint8_t B = (state[(ix + 1) & 255] + iy) & 255;
+
+				const uint8_t AA = (state[A] + iz) & 255;
+				const uint8_t AB = (state[(A + 1) & 255] + iz) & 255;
+
+				const uint8_t BA = (state[B] + iz) & 255;
+				const uint8_t BB = (state[(B + 1) & 255] + iz) & 255;
+
+				hAA[i] = state[AA];
+				hBA[i] = state[BA];
+				hAB[i] = state[AB];
+				hBB[i] = state[BB];
+				hAA1[i] = state[(AA + 1) & 255];
+				hBA1[i] = state[(BA + 1) & 255];
+				hAB1[i] = state[(AB + 1) & 255];
+				hBB1[i] = state[(BB + 1) & 255];
+			}
+
+			const XMVECTOR one = XMVectorReplicate(1);
+			const XMVECTOR fx = XMVectorSubtract(x, _x);
+			const XMVECTOR fy = XMVectorSubtract(y, _y);
+			const XMVECTOR fz = XMVectorSubtract(z, _z);
+			const XMVECTOR fx1 = XMVectorSubtract(fx, one);
+			const XMVECTOR fy1 = XMVectorSubtract(fy, one);
+			const XMVECTOR fz1 = XMVectorSubtract(fz, one);
+
+			const XMVECTOR u = fade(fx);
+			const XMVECTOR v = fade(fy);
+			const XMVECTOR w = fade(fz);
+
+			const XMVECTOR p0 = grad(hAA, fx, fy, fz);
+			const XMVECTOR p1 = grad(hBA, fx1, fy, fz);
+			const XMVECTOR p2 = grad(hAB, fx, fy1, fz);
+			const XMVECTOR p3 = grad(hBB, fx1, fy1, fz);
+			const XMVECTOR p4 = grad(hAA1, fx, fy, fz1);
+			const XMVECTOR p5 = grad(hBA1, fx1, fy, fz1);
+			const XMVECTOR p6 = grad(hAB1, fx, fy1, fz1);
+			const XMVECTOR p7 = grad(hBB1, fx1, fy1, fz1);
+
+			const XMVECTOR q0 = lerp(p0, p1, u);
+			const XMVECTOR q1 = lerp(p2, p3, u);
+			const XMVECTOR q2 = lerp(p4, p5, u);
+			const XMVECTOR q3 = lerp(p6, p7, u);
+
+			const XMVECTOR r0 = lerp(q0, q1, v);
+			const XMVECTOR r1 = lerp(q2, q3, v);
+
+			return lerp(r0, r1, w);
+		}
+		// Computes noise for 4 points at once
+		//	returns noise in range [-1, 1]
+		inline XMVECTOR compute(XMVECTOR x, XMVECTOR y, XMVECTOR z, int octaves, float persistence = 0.5f) const
+		{
+			XMVECTOR result = XMVectorZero();
+			float amplitude = 1;
+			for (int i = 0; i < octaves; ++i)
+			{
+				result = XMVectorAdd(result, XMVectorScale(compute(x, y, z), amplitude));
+				x = XMVectorAdd(x, x);
+				y = XMVectorAdd(y, y);
+				z = XMVectorAdd(z, z);
+				amplitude *= persistence;
+			}
+			return result;
+		}
 	};
 
 	// Based on: https://www.shadertoy.com/view/MslGD8
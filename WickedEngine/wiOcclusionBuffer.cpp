@@ -0,0 +1,317 @@
+#include "wiOcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace wi::primitive;
+
+namespace wi
+{
+	static constexpr float NEAR_W = 0.01f; // vertices closer than this view depth are not rasterized (no clipping is performed)
+	static constexpr float GUARD_BAND = 4096.0f; // triangles reaching farther than this outside the screen (in pixels) are not rasterized to keep edge functions precise
+	static constexpr uint32_t STRIP_HEIGHT = 8; // rows rasterized by one job
+	static constexpr uint32_t SIMD_WIDTH = 4; // pixels processed at once
+
+	void OcclusionBuffer::Begin(const XMMATRIX& VP, uint32_t width, uint32_t height)
+	{
+		XMStoreFloat4x4(&viewProjection, VP);
+		occluders.clear();
+		vertexCount = 0;
+		triangleCount = 0;
+
+		width = std::max(SIMD_WIDTH, (width + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH);
+		height = std::max(1u, height);
+		if (levels.empty() || levels[0].width != width || levels[0].height != height)
+		{
+			levels.clear();
+			while (true)
+			{
+				Level& level = levels.emplace_back();
+				level.width = width;
+				level.height = height;
+				level.mindepth.resize(width * height);
+				level.maxdepth.resize(width * height);
+				if (width == 1 && height == 1)
+					break;
+				width = std::max(1u, (width + 1) / 2);
+				height = std::max(1u, (height + 1) / 2);
+			}
+		}
+		std::fill(levels[0].maxdepth.begin(), levels[0].maxdepth.end(), 0.0f);
+	}
+
+	void OcclusionBuffer::AddOccluder(const XMFLOAT3* positions, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const XMMATRIX& world)
+	{
+		if (positions == nullptr || indices == nullptr || vertexCount == 0 || indexCount < 3)
+			return;
+		Occluder& occluder = occluders.emplace_back();
+		occluder.positions = positions;
+		occluder.vertexCount = vertexCount;
+		occluder.indices = indices;
+		occluder.indexCount = indexCount - indexCount % 3;
+		XMStoreFloat4x4(&occluder.world, world);
+		occluder.vertexOffset = this->vertexCount;
+		occluder.triangleOffset = triangleCount;
+		this->vertexCount += vertexCount;
+		triangleCount += occluder.indexCount / 3;
+	}
+
+	void OcclusionBuffer::Rasterize()
+	{
+		if (levels.empty())
+			return;
+		Level& level0 = levels[0];
+		const uint32_t width = level0.width;
+		const uint32_t height = level0.height;
+		const float fwidth = float(width);
+		const float fheight = float(height);
+
+		vertices.resize(vertexCount);
+		triangles.resize(triangleCount);
+		Triangle* triangle_data = triangles.data();
+
+		wi::jobsystem::context ctx;
+
+		// Transform vertices into screen space and set up triangles, one job per occluder:
+		wi::jobsystem::Dispatch(ctx, (uint32_t)occluders.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			const Occluder& occluder = occluders[args.jobIndex];
+			const XMMATRIX M = XMLoadFloat4x4(&occluder.world) * XMLoadFloat4x4(&viewProjection);
+
+			XMFLOAT4* transformed = vertices.data() + occluder.vertexOffset;
+			for (uint32_t i = 0; i < occluder.vertexCount; ++i)
+			{
+				XMFLOAT4 clip;
+				XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(occluder.positions + i), M));
+				if (clip.w < NEAR_W)
+				{
+					transformed[i] = XMFLOAT4(0, 0, 0, 0);
+					continue;
+				}
+				const float iw = 1.0f / clip.w;
+				transformed[i] = XMFLOAT4(
+					(clip.x * iw * 0.5f + 0.5f) * fwidth,
+					(0.5f - clip.y * iw * 0.5f) * fheight,
+					iw,
+					1
+				);
+			}
+
+			for (uint32_t i = 0; i < occluder.indexCount; i += 3)
+			{
+				Triangle& tri = triangle_data[occluder.triangleOffset + i / 3];
+				tri.minx = tri.miny = 0;
+				tri.maxx = tri.maxy = -1;
+
+				const uint32_t i0 = occluder.indices[i + 0];
+				const uint32_t i1 = occluder.indices[i + 1];
+				const uint32_t i2 = occluder.indices[i + 2];
+				if (i0 >= occluder.vertexCount || i1 >= occluder.vertexCount || i2 >= occluder.vertexCount)
+					continue;
+				XMFLOAT4 v0 = transformed[i0];
+				XMFLOAT4 v1 = transformed[i1];
+				XMFLOAT4 v2 = transformed[i2];
+
+				// Triangles touching the near plane are skipped instead of clipped, this only loses occlusion:
+				if (v0.w == 0 || v1.w == 0 || v2.w == 0)
+					continue;
+
+				const float bminx = std::min(v0.x, std::min(v1.x, v2.x));
+				const float bminy = std::min(v0.y, std::min(v1.y, v2.y));
+				const float bmaxx = std::max(v0.x, std::max(v1.x, v2.x));
+				const float bmaxy = std::max(v0.y, std::max(v1.y, v2.y));
+				if (bmaxx < 0 || bmaxy < 0 || bminx >= fwidth || bminy >= fheight)
+					continue;
+				if (bminx < -GUARD_BAND || bminy < -GUARD_BAND || bmaxx > fwidth + GUARD_BAND || bmaxy > fheight + GUARD_BAND)
+					continue;
+
+				float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+				if (std::abs(area) < 1e-6f)
+					continue;
+				if (area < 0)
+				{
+					// Both facings are rasterized, but edge functions are always set up to be positive inside:
+					std::swap(v1, v2);
+					area = -area;
+				}
+
+				const XMFLOAT4* v[] = { &v0, &v1, &v2 };
+				const float inv_area = 1.0f / area;
+				tri.depth = XMFLOAT3(0, 0, 0);
+				for (int e = 0; e < 3; ++e)
+				{
+					// The edge opposite of vertex e, its function equals the area at vertex e:
+					const XMFLOAT4& a = *v[(e + 1) % 3];
+					const XMFLOAT4& b = *v[(e + 2) % 3];
+					tri.edge[e] = XMFLOAT3(a.y - b.y, b.x - a.x, a.x * b.y - a.y * b.x);
+					tri.depth.x += tri.edge[e].x * v[e]->z * inv_area;
+					tri.depth.y += tri.edge[e].y * v[e]->z * inv_area;
+					tri.depth.z += tri.edge[e].z * v[e]->z * inv_area;
+				}
+
+				tri.minx = std::max(0, (int)std::floor(bminx));
+				tri.miny = std::max(0, (int)std::floor(bminy));
+				tri.maxx = std::min(int(width) - 1, (int)std::ceil(bmaxx));
+				tri.maxy = std::min(int(height) - 1, (int)std::ceil(bmaxy));
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		// Rasterize horizontal strips of the depth buffer in parallel, SIMD_WIDTH pixels at a time:
+		float* depth_data = level0.maxdepth.data();
+		const uint32_t stripCount = (height + STRIP_HEIGHT - 1) / STRIP_HEIGHT;
+		wi::jobsystem::Dispatch(ctx, stripCount, 1, [&](wi::jobsystem::JobArgs args) {
+			const int strip_begin = int(args.jobIndex * STRIP_HEIGHT);
+			const int strip_end = std::min(int(height), strip_begin + int(STRIP_HEIGHT));
+			const XMVECTOR zero = XMVectorZero();
+			const XMVECTOR step = XMVectorReplicate(float(SIMD_WIDTH));
+			const XMVECTOR pixel_offsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+
+			for (uint32_t t = 0; t < triangleCount; ++t)
+			{
+				const Triangle& tri = triangle_data[t];
+				const int row_begin = std::max(tri.miny, strip_begin);
+				const int row_end = std::min(tri.maxy + 1, strip_end);
+				if (row_begin >= row_end || tri.minx > tri.maxx)
+					continue;
+
+				const XMVECTOR e0x = XMVectorReplicate(tri.edge[0].x);
+				const XMVECTOR e1x = XMVectorReplicate(tri.edge[1].x);
+				const XMVECTOR e2x = XMVectorReplicate(tri.edge[2].x);
+				const XMVECTOR dx = XMVectorReplicate(tri.depth.x);
+				const int column_begin = tri.minx & ~int(SIMD_WIDTH - 1);
+
+				for (int y = row_begin; y < row_end; ++y)
+				{
+					const float py = float(y) + 0.5f;
+					const XMVECTOR e0c = XMVectorReplicate(tri.edge[0].y * py + tri.edge[0].z);
+					const XMVECTOR e1c = XMVectorReplicate(tri.edge[1].y * py + tri.edge[1].z);
+					const XMVECTOR e2c = XMVectorReplicate(tri.edge[2].y * py + tri.edge[2].z);
+					const XMVECTOR dc = XMVectorReplicate(tri.depth.y * py + tri.depth.z);
+
+					float* row = depth_data + y * width;
+					XMVECTOR px = XMVectorAdd(XMVectorReplicate(float(column_begin)), pixel_offsets);
+					for (int x = column_begin; x <= tri.maxx; x += SIMD_WIDTH)
+					{
+						XMVECTOR mask = XMVectorGreaterOrEqual(XMVectorMultiplyAdd(px, e0x, e0c), zero);
+						mask = XMVectorAndInt(mask, XMVectorGreaterOrEqual(XMVectorMultiplyAdd(px, e1x, e1c), zero));
+						mask = XMVectorAndInt(mask, XMVectorGreaterOrEqual(XMVectorMultiplyAdd(px, e2x, e2c), zero));
+						if (XMVector4EqualInt(mask, XMVectorFalseInt()))
+						{
+							px = XMVectorAdd(px, step);
+							continue;
+						}
+						const XMVECTOR depth = XMVectorMultiplyAdd(px, dx, dc);
+						XMFLOAT4* dst = (XMFLOAT4*)(row + x);
+						const XMVECTOR current = XMLoadFloat4(dst);
+						XMStoreFloat4(dst, XMVectorSelect(current, XMVectorMax(current, depth), mask));
+						px = XMVectorAdd(px, step);
+					}
+				}
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		// Build the min/max hierarchy:
+		std::copy(level0.maxdepth.begin(), level0.maxdepth.end(), level0.mindepth.begin());
+		for (size_t i = 1; i < levels.size(); ++i)
+		{
+			const Level& src = levels[i - 1];
+			Level& dst = levels[i];
+			for (uint32_t y = 0; y < dst.height; ++y)
+			{
+				const uint32_t y0 = std::min(y * 2, src.height - 1);
+				const uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+				for (uint32_t x = 0; x < dst.width; ++x)
+				{
+					const uint32_t x0 = std::min(x * 2, src.width - 1);
+					const uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+					const uint32_t i00 = x0 + y0 * src.width;
+					const uint32_t i10 = x1 + y0 * src.width;
+					const uint32_t i01 = x0 + y1 * src.width;
+					const uint32_t i11 = x1 + y1 * src.width;
+					dst.mindepth[x + y * dst.width] = std::min(std::min(src.mindepth[i00], src.mindepth[i10]), std::min(src.mindepth[i01], src.mindepth[i11]));
+					dst.maxdepth[x + y * dst.width] = std::max(std::max(src.maxdepth[i00], src.maxdepth[i10]), std::max(src.maxdepth[i01], src.maxdepth[i11]));
+				}
+			}
+		}
+	}
+
+	// Tests one texel of a level against the closest depth of the tested box (rect is the box footprint at level 0)
+	//	Ambiguous texels (the box is between the farthest and closest occluder) are refined in the next finer level
+	static bool IsTexelOccluded(const wi::vector<OcclusionBuffer::Level>& levels, uint32_t L, uint32_t tx, uint32_t ty, const uint32_t rect[4], float closest)
+	{
+		const OcclusionBuffer::Level& level = levels[L];
+		const uint32_t idx = tx + ty * level.width;
+		if (closest < level.mindepth[idx])
+			return true;
+		if (L == 0 || closest >= level.maxdepth[idx])
+			return false;
+		const uint32_t C = L - 1;
+		const uint32_t cx0 = std::max(tx * 2, rect[0] >> C);
+		const uint32_t cy0 = std::max(ty * 2, rect[1] >> C);
+		const uint32_t cx1 = std::min(tx * 2 + 1, rect[2] >> C);
+		const uint32_t cy1 = std::min(ty * 2 + 1, rect[3] >> C);
+		for (uint32_t cy = cy0; cy <= cy1; ++cy)
+		{
+			for (uint32_t cx = cx0; cx <= cx1; ++cx)
+			{
+				if (!IsTexelOccluded(levels, C, cx, cy, rect, closest))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool OcclusionBuffer::IsOccluded(const AABB& aabb) const
+	{
+		if (levels.empty() || triangleCount == 0)
+			return false;
+
+		const XMMATRIX VP = XMLoadFloat4x4(&viewProjection);
+		const float fwidth = float(levels[0].width);
+		const float fheight = float(levels[0].height);
+		float minx = FLT_MAX, miny = FLT_MAX, maxx = -FLT_MAX, maxy = -FLT_MAX;
+		float closest = 0;
+		for (int i = 0; i < 8; ++i)
+		{
+			const XMFLOAT3 corner = aabb.corner(i);
+			XMFLOAT4 clip;
+			XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corner), VP));
+			if (clip.w < NEAR_W)
+				return false; // intersects the camera near area, consider it visible
+			const float iw = 1.0f / clip.w;
+			const float x = (clip.x * iw * 0.5f + 0.5f) * fwidth;
+			const float y = (0.5f - clip.y * iw * 0.5f) * fheight;
+			minx = std::min(minx, x);
+			miny = std::min(miny, y);
+			maxx = std::max(maxx, x);
+			maxy = std::max(maxy, y);
+			closest = std::max(closest, iw);
+		}
+		if (maxx < 0 || maxy < 0 || minx >= fwidth || miny >= fheight)
+			return false; // off screen, it is not the occlusion test's job to cull it
+
+		const uint32_t rect[4] = {
+			(uint32_t)std::max(0.0f, minx),
+			(uint32_t)std::max(0.0f, miny),
+			(uint32_t)std::min(fwidth - 1, maxx),
+			(uint32_t)std::min(fheight - 1, maxy),
+		};
+
+		// Start from the level where the box covers at most 2x2 texels:
+		uint32_t L = 0;
+		while (L + 1 < (uint32_t)levels.size() && ((rect[2] >> L) - (rect[0] >> L) > 1 || (rect[3] >> L) - (rect[1] >> L) > 1))
+		{
+			L++;
+		}
+		for (uint32_t ty = rect[1] >> L; ty <= (rect[3] >> L); ++ty)
+		{
+			for (uint32_t tx = rect[0] >> L; tx <= (rect[2] >> L); ++tx)
+			{
+				if (!IsTexelOccluded(levels, L, tx, ty, rect, closest))
+					return false;
+			}
+		}
+		return true;
+	}
+}
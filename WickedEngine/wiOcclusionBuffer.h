@@ -0,0 +1,70 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiPrimitive.h"
+#include "wiVector.h"
+#include "wiMath.h"
+#include "wiJobSystem.h"
+
+namespace wi
+{
+	// Low resolution software rasterized depth buffer for CPU occlusion culling
+	//	Occluder triangle meshes are rasterized on wi::jobsystem workers with SIMD, then a min/max depth hierarchy is built
+	//	Bounding boxes can be tested against the occluders in the same frame, before anything is sent to the GPU
+	//	Depth is stored as inverse view depth (1 / w), a bigger value means closer, 0 means nothing was rasterized
+	struct OcclusionBuffer
+	{
+		static constexpr uint32_t DEFAULT_WIDTH = 256;
+		static constexpr uint32_t DEFAULT_HEIGHT = 128;
+
+		struct Level
+		{
+			uint32_t width = 0;
+			uint32_t height = 0;
+			wi::vector<float> mindepth; // farthest occluder depth in the texel footprint
+			wi::vector<float> maxdepth; // closest occluder depth in the texel footprint
+		};
+		wi::vector<Level> levels; // level 0 is the rasterized depth buffer, every further level halves the resolution
+
+		XMFLOAT4X4 viewProjection = wi::math::IDENTITY_MATRIX;
+
+		struct Occluder
+		{
+			const XMFLOAT3* positions = nullptr;
+			uint32_t vertexCount = 0;
+			const uint32_t* indices = nullptr;
+			uint32_t indexCount = 0;
+			XMFLOAT4X4 world;
+			uint32_t vertexOffset = 0;
+			uint32_t triangleOffset = 0;
+		};
+		wi::vector<Occluder> occluders;
+		struct Triangle
+		{
+			XMFLOAT3 edge[3]; // edge functions: x * edge.x + y * edge.y + edge.z >= 0 for pixels inside
+			XMFLOAT3 depth; // inverse depth plane: x * depth.x + y * depth.y + depth.z
+			int minx, miny, maxx, maxy; // clamped screen bounds, empty if the triangle is not rasterized
+		};
+		wi::vector<XMFLOAT4> vertices; // transformed occluder vertices (x, y: screen pixel, z: inverse depth, w: valid)
+		wi::vector<Triangle> triangles; // rasterizer setup of occluder triangles
+		uint32_t vertexCount = 0;
+		uint32_t triangleCount = 0;
+
+		// Start a new frame, this removes all occluders and clears the depth
+		void Begin(const XMMATRIX& viewProjection, uint32_t width = DEFAULT_WIDTH, uint32_t height = DEFAULT_HEIGHT);
+
+		// Add an occluder triangle mesh, the memory must be kept alive until Rasterize() finishes
+		//	Occluders should be conservative: they must not be bigger than the geometry that is actually rendered
+		void AddOccluder(const XMFLOAT3* positions, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const XMMATRIX& world);
+
+		// Transform and rasterize all occluders, then build the depth hierarchy. This waits for completion.
+		void Rasterize();
+
+		// Returns true if the bounding box is completely hidden behind occluders
+		bool IsOccluded(const wi::primitive::AABB& aabb) const;
+
+		uint32_t GetWidth() const { return levels.empty() ? 0 : levels[0].width; }
+		uint32_t GetHeight() const { return levels.empty() ? 0 : levels[0].height; }
+		// Returns the rasterized depth buffer with GetWidth() * GetHeight() inverse depth values
+		const float* GetDepth() const { return levels.empty() ? nullptr : levels[0].maxdepth.data(); }
+	};
+}
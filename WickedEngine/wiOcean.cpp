@@ -7,6 +7,7 @@
 #include "wiEventHandler.h"
 #include "wiTimer.h"
 #include "wiVector.h"
+#include "wiJobSystem.h"
 
 #include <algorithm>
 
@@ -62,6 +63,72 @@ namespace wi
 				device->CreatePipelineState(&desc, &PSO_wire);
 			}
 		}
+
+		// CPU FFT helpers, complex matrices are stored as separate real and imaginary dim x dim float arrays:
+
+		// Reorders the rows of a matrix into bit reversed order, for the in place radix-2 FFT
+		void BitReverseRows(float* real, float* imag, int dim)
+		{
+			const int bits = (int)std::log2(dim);
+			for (int i = 0; i < dim; ++i)
+			{
+				int j = 0;
+				for (int b = 0; b < bits; ++b)
+				{
+					j |= ((i >> b) & 1) << (bits - 1 - b);
+				}
+				if (j > i)
+				{
+					std::swap_ranges(real + i * dim, real + (i + 1) * dim, real + j * dim);
+					std::swap_ranges(imag + i * dim, imag + (i + 1) * dim, imag + j * dim);
+				}
+			}
+		}
+
+		void Transpose(float* real, float* imag, int dim)
+		{
+			for (int i = 0; i < dim; ++i)
+			{
+				for (int j = i + 1; j < dim; ++j)
+				{
+					std::swap(real[i * dim + j], real[j * dim + i]);
+					std::swap(imag[i * dim + j], imag[j * dim + i]);
+				}
+			}
+		}
+
+		// Radix-2 FFT along 4 neighbouring columns at once, the rows must be in bit reversed order
+		//	twiddles[k] = exp(-2 * PI * i * k / dim), the same forward transform as the GPU FFT
+		void FFTColumns4(float* real, float* imag, int dim, int column, const XMFLOAT2* twiddles)
+		{
+			for (int len = 2; len <= dim; len <<= 1)
+			{
+				const int half = len >> 1;
+				const int twiddle_stride = dim / len;
+				for (int i = 0; i < dim; i += len)
+				{
+					for (int j = 0; j < half; ++j)
+					{
+						const XMVECTOR WR = XMVectorReplicate(twiddles[j * twiddle_stride].x);
+						const XMVECTOR WI = XMVectorReplicate(twiddles[j * twiddle_stride].y);
+						XMFLOAT4* ar = (XMFLOAT4*)(real + (i + j) * dim + column);
+						XMFLOAT4* ai = (XMFLOAT4*)(imag + (i + j) * dim + column);
+						XMFLOAT4* br = (XMFLOAT4*)(real + (i + j + half) * dim + column);
+						XMFLOAT4* bi = (XMFLOAT4*)(imag + (i + j + half) * dim + column);
+						const XMVECTOR AR = XMLoadFloat4(ar);
+						const XMVECTOR AI = XMLoadFloat4(ai);
+						const XMVECTOR BR = XMLoadFloat4(br);
+						const XMVECTOR BI = XMLoadFloat4(bi);
+						const XMVECTOR VR = BR * WR - BI * WI;
+						const XMVECTOR VI = BR * WI + BI * WR;
+						XMStoreFloat4(ar, AR + VR);
+						XMStoreFloat4(ai, AI + VI);
+						XMStoreFloat4(br, AR - VR);
+						XMStoreFloat4(bi, AI - VI);
+					}
+				}
+			}
+		}
 	}
 	using namespace ocean_internal;
 
@@ -113,9 +180,16 @@ namespace wi
 
 		// Height map H(0)
 		int height_map_size = (params.dmap_dim + 4) * (params.dmap_dim + 1);
-		wi::vector<XMFLOAT2> h0_data(height_map_size);
-		wi::vector<float> omega_data(height_map_size);
+		h0_data.resize(height_map_size);
+		omega_data.resize(height_map_size);
+		h0_dim = params.dmap_dim;
 		initHeightMap(params, h0_data.data(), omega_data.data());
+		std::atomic_store(&cpu_front, std::shared_ptr<CPUDisplacement>());
+		cpu_back.reset();
+
+		// Without a graphics device (headless), only the CPU evaluation can be used:
+		if (device == nullptr)
+			return;
 
 		int hmap_dim = params.dmap_dim;
 		int input_full_size = (hmap_dim + 4) * (hmap_dim + 1);
@@ -371,6 +445,214 @@ namespace wi
 	}
 
 
+	void Ocean::UpdateDisplacementMapCPU(const OceanParameters& params, float time)
+	{
+		const int N = h0_dim;
+		const int dim = std::min((int)wi::math::GetNextPowerOfTwo((uint32_t)std::max(4, cpu_dim)), N);
+
+		// The back buffer was the front buffer before the last swap, a query that started before that can still be reading it:
+		if (cpu_back == nullptr || cpu_back.use_count() > 1)
+		{
+			cpu_back = std::make_shared<CPUDisplacement>();
+		}
+		CPUDisplacement& cpu = *cpu_back;
+		cpu.params = params;
+		cpu.gpu_dim = N;
+
+		if (cpu_dim <= 0 || dim < 4 || h0_data.empty())
+		{
+			// Only the water plane is kept, queries return undisplaced positions:
+			cpu.displacement.clear();
+			cpu.dim = 0;
+			cpu_back = std::atomic_exchange(&cpu_front, cpu_back);
+			return;
+		}
+
+		const size_t field_size = size_t(dim) * size_t(dim);
+		cpu.dim = dim;
+		cpu.displacement.resize(field_size);
+		if (cpu_fft_real.size() != field_size * 3)
+		{
+			cpu_fft_real.resize(field_size * 3);
+			cpu_fft_imag.resize(field_size * 3);
+			cpu_fft_twiddles.resize(dim / 2);
+			for (int k = 0; k < dim / 2; ++k)
+			{
+				const float phase = -2 * XM_PI * k / dim;
+				cpu_fft_twiddles[k] = XMFLOAT2(std::cos(phase), std::sin(phase));
+			}
+		}
+
+		wi::jobsystem::context ctx;
+
+		// H(0) -> H(t), the same as oceanSimulatorCS, but only for the lowest dim x dim frequencies:
+		//	the frequency index (x - dim/2) of the CPU grid is (x + offset - N/2) in the GPU grid
+		const int offset = (N - dim) / 2;
+		const int in_width = N + 4;
+		const float phase = time * params.time_scale;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)dim, 1, [&](wi::jobsystem::JobArgs args) {
+			const int y = (int)args.jobIndex;
+			for (int x = 0; x < dim; ++x)
+			{
+				const int in_index = (y + offset) * in_width + (x + offset);
+				const int in_mindex = (N - y - offset) * in_width + (N - x - offset);
+				const int out_index = y * dim + x;
+
+				const XMFLOAT2 h0_k = h0_data[in_index];
+				const XMFLOAT2 h0_mk = h0_data[in_mindex];
+				const float sin_v = std::sin(omega_data[in_index] * phase);
+				const float cos_v = std::cos(omega_data[in_index] * phase);
+				const float ht_x = (h0_k.x + h0_mk.x) * cos_v - (h0_k.y + h0_mk.y) * sin_v;
+				const float ht_y = (h0_k.x - h0_mk.x) * sin_v + (h0_k.y - h0_mk.y) * cos_v;
+
+				// H(t) -> Dx(t), Dy(t)
+				float kx = x - dim * 0.5f;
+				float ky = y - dim * 0.5f;
+				const float sqr_k = kx * kx + ky * ky;
+				const float rsqr_k = sqr_k > 1e-12f ? 1 / std::sqrt(sqr_k) : 0;
+				kx *= rsqr_k;
+				ky *= rsqr_k;
+
+				cpu_fft_real[out_index] = ht_x;
+				cpu_fft_imag[out_index] = ht_y;
+				cpu_fft_real[out_index + field_size] = ht_y * kx;
+				cpu_fft_imag[out_index + field_size] = -ht_x * kx;
+				cpu_fft_real[out_index + field_size * 2] = ht_y * ky;
+				cpu_fft_imag[out_index + field_size * 2] = -ht_x * ky;
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		// 2D FFT of the 3 fields: columns, then transposed columns (rows), 4 columns at a time:
+		const uint32_t column_groups = uint32_t(dim / 4);
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			wi::jobsystem::Dispatch(ctx, 3, 1, [&](wi::jobsystem::JobArgs args) {
+				float* real = cpu_fft_real.data() + field_size * args.jobIndex;
+				float* imag = cpu_fft_imag.data() + field_size * args.jobIndex;
+				if (pass > 0)
+				{
+					Transpose(real, imag, dim);
+				}
+				BitReverseRows(real, imag, dim);
+			});
+			wi::jobsystem::Wait(ctx);
+
+			wi::jobsystem::Dispatch(ctx, column_groups * 3, 1, [&](wi::jobsystem::JobArgs args) {
+				const uint32_t field = args.jobIndex / column_groups;
+				const int column = int(args.jobIndex % column_groups) * 4;
+				FFTColumns4(cpu_fft_real.data() + field_size * field, cpu_fft_imag.data() + field_size * field, dim, column, cpu_fft_twiddles.data());
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+
+		// Update displacement map, the same as oceanUpdateDisplacementMapCS, but the fields are still transposed and the result is in world space (xzy):
+		wi::jobsystem::Dispatch(ctx, (uint32_t)dim, 1, [&](wi::jobsystem::JobArgs args) {
+			const int y = (int)args.jobIndex;
+			for (int x = 0; x < dim; ++x)
+			{
+				const size_t addr = size_t(x) * dim + y;
+				// cos(pi * (m1 + m2))
+				const float sign_correction = ((x + y) & 1) ? -1.0f : 1.0f;
+				XMFLOAT4& displacement = cpu.displacement[size_t(y) * dim + x];
+				displacement.x = cpu_fft_real[addr + field_size] * sign_correction * params.choppy_scale;
+				displacement.y = cpu_fft_real[addr] * sign_correction;
+				displacement.z = cpu_fft_real[addr + field_size * 2] * sign_correction * params.choppy_scale;
+				displacement.w = 0;
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		cpu_back = std::atomic_exchange(&cpu_front, cpu_back);
+	}
+
+	bool Ocean::IsValidCPU() const
+	{
+		const std::shared_ptr<CPUDisplacement> cpu = std::atomic_load(&cpu_front);
+		return cpu != nullptr && !cpu->displacement.empty();
+	}
+
+	XMVECTOR Ocean::SampleDisplacementCPU(const CPUDisplacement& cpu, float x, float z)
+	{
+		// Bilinear wrapped sampling, the same as the displacement map sampling of oceanSurfaceVS
+		//	The GPU texel centers are half of a GPU texel away from the grid positions, that's a fraction of a CPU texel
+		const int dim = cpu.dim;
+		const float half_texel = 0.5f * dim / cpu.gpu_dim;
+		const float u = x / cpu.params.patch_length * dim - half_texel;
+		const float v = z / cpu.params.patch_length * dim - half_texel;
+		const float u_floor = std::floor(u);
+		const float v_floor = std::floor(v);
+		const float fu = u - u_floor;
+		const float fv = v - v_floor;
+		const int mask = dim - 1;
+		const int x0 = int(int64_t(u_floor) & mask);
+		const int y0 = int(int64_t(v_floor) & mask);
+		const int x1 = (x0 + 1) & mask;
+		const int y1 = (y0 + 1) & mask;
+		const XMVECTOR D00 = XMLoadFloat4(&cpu.displacement[y0 * dim + x0]);
+		const XMVECTOR D10 = XMLoadFloat4(&cpu.displacement[y0 * dim + x1]);
+		const XMVECTOR D01 = XMLoadFloat4(&cpu.displacement[y1 * dim + x0]);
+		const XMVECTOR D11 = XMLoadFloat4(&cpu.displacement[y1 * dim + x1]);
+		return XMVectorLerp(XMVectorLerp(D00, D10, fu), XMVectorLerp(D01, D11, fu), fv);
+	}
+
+	XMFLOAT3 Ocean::GetDisplacedPosition(const XMFLOAT3& worldPosition) const
+	{
+		XMFLOAT3 result;
+		GetDisplacedPositions(&worldPosition, &result, 1);
+		return result;
+	}
+
+	void Ocean::GetDisplacedPositions(const XMFLOAT3* worldPositions, XMFLOAT3* results, size_t count) const
+	{
+		const std::shared_ptr<CPUDisplacement> cpu = std::atomic_load(&cpu_front);
+		const bool valid = cpu != nullptr && !cpu->displacement.empty();
+		const float waterHeight = cpu == nullptr ? OceanParameters().waterHeight : cpu->params.waterHeight;
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMVECTOR P = XMVectorSet(worldPositions[i].x, waterHeight, worldPositions[i].z, 0);
+			if (valid)
+			{
+				P += SampleDisplacementCPU(*cpu, worldPositions[i].x, worldPositions[i].z);
+			}
+			XMStoreFloat3(&results[i], P);
+		}
+	}
+
+	float Ocean::GetHeight(const XMFLOAT3& worldPosition) const
+	{
+		float result;
+		GetHeights(&worldPosition, &result, 1);
+		return result;
+	}
+
+	void Ocean::GetHeights(const XMFLOAT3* worldPositions, float* results, size_t count) const
+	{
+		const std::shared_ptr<CPUDisplacement> cpu = std::atomic_load(&cpu_front);
+		if (cpu == nullptr || cpu->displacement.empty())
+		{
+			std::fill(results, results + count, cpu == nullptr ? OceanParameters().waterHeight : cpu->params.waterHeight);
+			return;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Find the point of the water plane that is displaced horizontally onto the query position:
+			const float x = worldPositions[i].x;
+			const float z = worldPositions[i].z;
+			XMFLOAT4 displacement;
+			XMStoreFloat4(&displacement, SampleDisplacementCPU(*cpu, x, z));
+			for (int iteration = 0; iteration < 16; ++iteration)
+			{
+				const XMFLOAT4 previous = displacement;
+				XMStoreFloat4(&displacement, SampleDisplacementCPU(*cpu, x - displacement.x, z - displacement.z));
+				if (std::abs(displacement.x - previous.x) + std::abs(displacement.z - previous.z) < 0.001f)
+					break;
+			}
+			results[i] = cpu->params.waterHeight + displacement.y;
+		}
+	}
+
+
 	void Ocean::Render(const CameraComponent& camera, const OceanParameters& params, CommandList cmd) const
 	{
 		GraphicsDevice* device = wi::graphics::GetDevice();
@@ -4,6 +4,9 @@
 #include "wiFFTGenerator.h"
 #include "wiScene_Decl.h"
 #include "wiMath.h"
+#include "wiVector.h"
+
+#include <memory>
 
 namespace wi
 {
@@ -49,6 +52,25 @@ namespace wi
 
 		bool IsValid() const { return displacementMap.IsValid(); }
 
+		// Resolution of the CPU evaluation (power of 2, not larger than dmap_dim), 0: disabled
+		//	When enabled, the renderer updates the CPU evaluation every frame with the time of the GPU simulation
+		int cpu_dim = 0;
+
+		// CPU evaluation of the same wave spectrum, for buoyancy and gameplay queries without GPU readback
+		//	The lowest cpu_dim x cpu_dim frequencies of the spectrum are transformed with a CPU FFT, higher frequencies are left out
+		//	time must be the same as the GPU simulation time (FrameCB::time) for the results to match the rendered surface
+		//	The result is written into a back buffer and swapped in at the end, so the queries below can run on other threads while this is updating
+		//	Only one thread can update it at a time (the renderer updates it every frame)
+		void UpdateDisplacementMapCPU(const OceanParameters& params, float time);
+		bool IsValidCPU() const;
+
+		// Returns the displaced water surface position of a point on the water plane, only the XZ of the input are used
+		XMFLOAT3 GetDisplacedPosition(const XMFLOAT3& worldPosition) const;
+		void GetDisplacedPositions(const XMFLOAT3* worldPositions, XMFLOAT3* results, size_t count) const;
+		// Returns the water surface height at XZ world positions, the horizontal (choppy) displacement is taken into account
+		float GetHeight(const XMFLOAT3& worldPosition) const;
+		void GetHeights(const XMFLOAT3* worldPositions, float* results, size_t count) const;
+
 		// occlusion result history bitfield (32 bit->32 frame history)
 		mutable uint32_t occlusionHistory = ~0u;
 		mutable int occlusionQueries[wi::graphics::GraphicsDevice::GetBufferCount() + 1];
@@ -68,6 +90,31 @@ namespace wi
 
 		void initHeightMap(const OceanParameters& params, XMFLOAT2* out_h0, float* out_omega);
 
+		// The initial height field and angular frequencies are kept for the CPU evaluation:
+		wi::vector<XMFLOAT2> h0_data;
+		wi::vector<float> omega_data;
+		int h0_dim = 0;
+
+		// CPU evaluation results, world space displacement in xyz:
+		struct CPUDisplacement
+		{
+			wi::vector<XMFLOAT4> displacement;
+			int dim = 0;
+			int gpu_dim = 0;
+			OceanParameters params;
+		};
+		// Queries read the front buffer through an atomic copy of the pointer, the update writes the back buffer then swaps them
+		//	The back buffer is replaced by a new allocation if a query still references it
+		std::shared_ptr<CPUDisplacement> cpu_front;
+		std::shared_ptr<CPUDisplacement> cpu_back;
+
+		// CPU FFT work buffers, H(t), Dx(t) and Dy(t) one after the other:
+		wi::vector<float> cpu_fft_real;
+		wi::vector<float> cpu_fft_imag;
+		wi::vector<XMFLOAT2> cpu_fft_twiddles;
+
+		static XMVECTOR SampleDisplacementCPU(const CPUDisplacement& cpu, float x, float z);
+
 
 		// Initial height field H(0) generated by Phillips spectrum & Gauss distribution.
 		wi::graphics::GPUBuffer buffer_Float2_H0;
@@ -21,14 +21,67 @@ namespace wi::physics
 	void SetDebugDrawEnabled(bool value);
 	bool IsDebugDrawEnabled();
 
+	// Enable/disable the multithreaded simulation
+	//	The collision detection, rigid body integration and constraint solving of independent simulation islands
+	//	will be executed on wi::jobsystem. When there are soft bodies, the simulation falls back to single threaded.
+	//	Default is enabled
+	void SetMultithreadingEnabled(bool value);
+	bool IsMultithreadingEnabled();
+
 	// Set the accuracy of the simulation
-	//	This value corresponds to maximum simulation step count
+	//	This value corresponds to maximum simulation step count per update (the substep budget)
+	//	Frame time that would need more steps than this is dropped, so the simulation slows down instead of spiraling
 	//	Higher values will be slower but more accurate
 	//	Default is 10
 	void SetAccuracy(int value);
 	int GetAccuracy();
 
+	// Set the fixed simulation frequency in steps per second
+	//	The frame delta time is accumulated, and the simulation is advanced in steps of 1 / frequency
+	//	Default is 60
+	void SetFrameRate(float value);
+	float GetFrameRate();
+
+	// Enable/disable interpolation of rigid body transforms between the last two simulation steps
+	//	This removes jitter when the frame rate differs from the simulation frequency, but the rendered state lags one step behind
+	//	Default is enabled
+	void SetInterpolationEnabled(bool value);
+	bool IsInterpolationEnabled();
+
+	// Enable/disable deterministic mode, for server side simulation or replays
+	//	Every update advances the simulation by exactly one fixed step regardless of dt, without interpolation
+	//	Starting from the same scene with the same inputs, the simulation results are bit-identical across runs
+	//	Default is disabled
+	void SetDeterministicEnabled(bool value);
+	bool IsDeterministicEnabled();
+
+	// Returns the interpolation factor that was used in the last update of the scene in range [0, 1]
+	float GetInterpolationAlpha(const wi::scene::Scene& scene = wi::scene::GetScene());
+	// Returns the number of simulation steps that were performed in the last update of the scene
+	int GetLastStepCount(const wi::scene::Scene& scene = wi::scene::GetScene());
+
+	// Collision shapes are shared between rigid bodies with the same shape type, parameters and mesh
+	//	Triangle mesh BVHs are built once per mesh and shared by all instances regardless of their scale
+	struct ShapeCacheStatistics
+	{
+		uint32_t shape_count = 0; // number of unique collision shapes alive
+		uint32_t reference_count = 0; // number of rigid bodies referencing the unique shapes
+		size_t memory = 0; // estimated memory of unique shapes in bytes
+		size_t memory_saved = 0; // estimated memory in bytes that would be used by duplicated shapes without sharing
+		double build_milliseconds = 0; // total time spent building unique shapes
+		double saved_milliseconds = 0; // total build time avoided by reusing shapes
+	};
+	ShapeCacheStatistics GetShapeCacheStatistics();
+
+	// Generates the convex hulls of a CONVEX_HULL rigid body from the mesh into physicscomponent.convex_hull_vertices
+	//	Each hull is reduced to at most convex_hull.vertex_limit vertices. If convex_hull.max_hulls > 1, the mesh
+	//	is approximately decomposed into convex parts that will be simulated as a compound shape
+	//	This is called automatically when a rigid body is created without generated hulls
+	void CreateConvexHulls(wi::scene::RigidBodyPhysicsComponent& physicscomponent, const wi::scene::MeshComponent& mesh);
+
 	// Update the physics state, run simulation, etc.
+	//	Every scene has its own physics world, it is created on the first update and destroyed by Scene::Clear()
+	//	Different scenes can be updated at the same time from multiple threads
 	void RunPhysicsUpdateSystem(
 		wi::jobsystem::context& ctx,
 		wi::scene::Scene& scene,
@@ -63,4 +116,35 @@ namespace wi::physics
 		const wi::scene::RigidBodyPhysicsComponent& physicscomponent,
 		const XMFLOAT3& torque
 	);
+
+	// Batched queries against the rigid bodies of the scene's physics world, executed in parallel on wi::jobsystem
+	//	The results are written to the same index as their queries
+	//	These must not be called while RunPhysicsUpdateSystem() is running on the same scene
+	struct RayHit
+	{
+		wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY; // INVALID_ENTITY if nothing was hit
+		XMFLOAT3 position = XMFLOAT3(0, 0, 0);
+		XMFLOAT3 normal = XMFLOAT3(0, 0, 0);
+		float distance = std::numeric_limits<float>::max();
+	};
+	// Finds the closest hits of rays within their [TMin, TMax] range
+	//	any_hit: report the first hit that is found instead of the closest, which is faster for line of sight tests
+	void RayCast(const wi::scene::Scene& scene, const wi::primitive::Ray* rays, RayHit* hits, size_t count, bool any_hit = false);
+
+	struct SphereSweep
+	{
+		wi::primitive::Sphere sphere; // starting position and radius
+		XMFLOAT3 direction = XMFLOAT3(0, 0, 1);
+		float distance = 0;
+	};
+	// Finds the closest hits of spheres moving along their directions
+	void SphereCast(const wi::scene::Scene& scene, const SphereSweep* sweeps, RayHit* hits, size_t count);
+
+	struct OverlapRange
+	{
+		uint32_t offset = 0; // first overlapping entity in the entities array
+		uint32_t count = 0; // number of overlapping entities
+	};
+	// Finds the rigid bodies overlapping spheres, the entities of all queries are written into one array
+	void Overlap(const wi::scene::Scene& scene, const wi::primitive::Sphere* spheres, OverlapRange* ranges, size_t count, wi::vector<wi::ecs::Entity>& entities);
 }
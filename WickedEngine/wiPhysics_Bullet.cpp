@@ -5,15 +5,24 @@
 #include "wiJobSystem.h"
 #include "wiRenderer.h"
 #include "wiTimer.h"
+#include "wiSpinLock.h"
+#include "wiHelper.h"
 
 #include "btBulletDynamicsCommon.h"
 #include "BulletSoftBody/btSoftBodyHelpers.h"
 #include "BulletSoftBody/btDefaultSoftBodySolver.h"
 #include "BulletSoftBody/btSoftRigidDynamicsWorld.h"
 #include "BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h"
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "LinearMath/btConvexHullComputer.h"
+#include "BulletCollision/CollisionShapes/btTriangleShape.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkPairDetector.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h"
+#include "BulletCollision/NarrowPhaseCollision/btPointCollector.h"
 
 #include <mutex>
 #include <memory>
+#include <algorithm>
 
 using namespace wi::ecs;
 using namespace wi::scene;
@@ -23,16 +32,464 @@ namespace wi::physics
 	bool ENABLED = true;
 	bool SIMULATION_ENABLED = true;
 	bool DEBUGDRAW_ENABLED = false;
+	bool MULTITHREADING_ENABLED = true;
+	bool INTERPOLATION_ENABLED = true;
+	bool DETERMINISTIC_ENABLED = false;
 	int ACCURACY = 10;
-	std::mutex physicsLock;
+	float FRAMERATE = 60;
+
+	// Component pointers of the registered bodies, gathered by the registration jobs for the feedback phase:
+	struct RigidBodyFeedback
+	{
+		btRigidBody* rigidbody = nullptr;
+		RigidBodyPhysicsComponent* physicscomponent = nullptr;
+		TransformComponent* transform = nullptr;
+	};
+	struct SoftBodyFeedback
+	{
+		btSoftBody* softbody = nullptr;
+		SoftBodyPhysicsComponent* physicscomponent = nullptr;
+		MeshComponent* mesh = nullptr;
+	};
+
+	// Runs the task count times on wi::jobsystem and waits for completion, small workloads run on the calling thread
+	//	This is the task scheduler of the parallel simulation paths below
+	template<typename T>
+	void ParallelFor(uint32_t count, uint32_t groupSize, const T& task)
+	{
+		if (count <= groupSize || wi::jobsystem::GetThreadCount() <= 1)
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				task(i);
+			}
+			return;
+		}
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, count, groupSize, [&](wi::jobsystem::JobArgs args) {
+			task(args.jobIndex);
+		});
+		wi::jobsystem::Wait(ctx);
+	}
+
+	// Collision dispatcher that can run the narrow phase of the overlapping pairs in parallel
+	//	While the pairs are processed, manifold and collision algorithm allocations are locked, new manifolds are
+	//	collected and released manifolds are deferred. After the batch, they are applied to the manifold array in
+	//	a fixed order, so the solver sees the same contact order regardless of thread timing
+	class CollisionDispatcherMt : public btCollisionDispatcher
+	{
+		wi::SpinLock locker;
+		bool batch_updating = false;
+		struct CreatedManifold
+		{
+			uint64_t sort_key = 0; // pair index in the upper 32 bits, allocation order within the pair in the lower bits
+			btPersistentManifold* manifold = nullptr;
+		};
+		wi::vector<CreatedManifold> created_manifolds;
+		wi::vector<btPersistentManifold*> released_manifolds;
+		inline static thread_local uint64_t pair_sort_key = 0;
+
+	public:
+		bool parallel = false;
+		uint32_t pair_group_size = 64;
+
+		CollisionDispatcherMt(btCollisionConfiguration* collisionConfiguration) : btCollisionDispatcher(collisionConfiguration) {}
+
+		btPersistentManifold* getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1) override
+		{
+			if (!batch_updating)
+				return btCollisionDispatcher::getNewManifold(body0, body1);
+
+			std::scoped_lock lck(locker);
+			btPersistentManifold* manifold = btCollisionDispatcher::getNewManifold(body0, body1);
+			m_manifoldsPtr.pop_back(); // it will be added to the array after the batch
+			created_manifolds.push_back({ pair_sort_key++, manifold });
+			return manifold;
+		}
+		void releaseManifold(btPersistentManifold* manifold) override
+		{
+			if (!batch_updating)
+			{
+				btCollisionDispatcher::releaseManifold(manifold);
+				return;
+			}
+
+			std::scoped_lock lck(locker);
+			released_manifolds.push_back(manifold);
+		}
+		void* allocateCollisionAlgorithm(int size) override
+		{
+			if (!batch_updating)
+				return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+
+			std::scoped_lock lck(locker);
+			return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+		}
+		void freeCollisionAlgorithm(void* ptr) override
+		{
+			if (!batch_updating)
+			{
+				btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+				return;
+			}
+
+			std::scoped_lock lck(locker);
+			btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+		}
+
+		void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher) override
+		{
+			const uint32_t pairCount = (uint32_t)pairCache->getNumOverlappingPairs();
+			if (!parallel || pairCount <= pair_group_size)
+			{
+				btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+				return;
+			}
+
+			btBroadphasePair* pairs = &pairCache->getOverlappingPairArray()[0];
+			btNearCallback nearCallback = getNearCallback();
+
+			batch_updating = true;
+			ParallelFor(pairCount, pair_group_size, [&](uint32_t i) {
+				pair_sort_key = uint64_t(i) << 32ull;
+				nearCallback(pairs[i], *this, dispatchInfo);
+			});
+			batch_updating = false;
+
+			// Manifolds that were created and released within the batch are not in the array yet:
+			for (btPersistentManifold* manifold : released_manifolds)
+			{
+				for (size_t i = 0; i < created_manifolds.size(); ++i)
+				{
+					if (created_manifolds[i].manifold == manifold)
+					{
+						created_manifolds.erase(created_manifolds.begin() + i);
+						manifold->m_index1a = m_manifoldsPtr.size();
+						m_manifoldsPtr.push_back(manifold);
+						break;
+					}
+				}
+			}
+			// The array was not modified during the batch, so the manifold indices give a deterministic release order:
+			std::sort(released_manifolds.begin(), released_manifolds.end(), [](const btPersistentManifold* a, const btPersistentManifold* b) {
+				return a->m_index1a > b->m_index1a;
+			});
+			for (btPersistentManifold* manifold : released_manifolds)
+			{
+				btCollisionDispatcher::releaseManifold(manifold);
+			}
+			released_manifolds.clear();
+
+			std::sort(created_manifolds.begin(), created_manifolds.end(), [](const CreatedManifold& a, const CreatedManifold& b) {
+				return a.sort_key < b.sort_key;
+			});
+			for (const CreatedManifold& x : created_manifolds)
+			{
+				x.manifold->m_index1a = m_manifoldsPtr.size();
+				m_manifoldsPtr.push_back(x.manifold);
+			}
+			created_manifolds.clear();
+		}
+	};
+
+	// Dynamics world that integrates rigid bodies and solves the simulation islands in parallel
+	//	Islands are batched like in the serial solver and every batch is solved by a separate solver from a pool.
+	//	Islands that contain kinematic bodies are solved serially, because a kinematic body can be part of
+	//	multiple islands and the solver writes per body temporary data into it.
+	//	The parallel paths are only used without soft bodies, those are simulated with the serial Bullet implementation
+	class DynamicsWorldMt : public btSoftRigidDynamicsWorld
+	{
+		struct IslandCollector : public btSimulationIslandManager::IslandCallback
+		{
+			struct Island
+			{
+				int id = -1;
+				uint32_t bodyOffset = 0;
+				uint32_t bodyCount = 0;
+				uint32_t manifoldOffset = 0;
+				uint32_t manifoldCount = 0;
+			};
+			wi::vector<Island> islands;
+			wi::vector<btCollisionObject*> bodies;
+			wi::vector<btPersistentManifold*> manifolds;
+
+			void processIsland(btCollisionObject** islandBodies, int numBodies, btPersistentManifold** islandManifolds, int numManifolds, int islandId) override
+			{
+				Island& island = islands.emplace_back();
+				island.id = islandId;
+				island.bodyOffset = (uint32_t)bodies.size();
+				island.bodyCount = (uint32_t)numBodies;
+				island.manifoldOffset = (uint32_t)manifolds.size();
+				island.manifoldCount = (uint32_t)numManifolds;
+				bodies.insert(bodies.end(), islandBodies, islandBodies + numBodies);
+				manifolds.insert(manifolds.end(), islandManifolds, islandManifolds + numManifolds);
+			}
+			void clear()
+			{
+				islands.clear();
+				bodies.clear();
+				manifolds.clear();
+			}
+		};
+		IslandCollector collector;
+
+		// Islands are regrouped into solver batches, the last group is the serial one:
+		struct SolverGroup
+		{
+			wi::vector<btCollisionObject*> bodies;
+			wi::vector<btPersistentManifold*> manifolds;
+			wi::vector<btTypedConstraint*> constraints;
+			struct Batch
+			{
+				uint32_t bodyOffset = 0;
+				uint32_t bodyCount = 0;
+				uint32_t manifoldOffset = 0;
+				uint32_t manifoldCount = 0;
+				uint32_t constraintOffset = 0;
+				uint32_t constraintCount = 0;
+			};
+			wi::vector<Batch> batches;
+			uint32_t batch_size = 0; // manifold and constraint count of the current batch
+
+			void clear()
+			{
+				bodies.clear();
+				manifolds.clear();
+				constraints.clear();
+				batches.clear();
+				batch_size = 0;
+			}
+			void add_island(const IslandCollector& collector, const IslandCollector::Island& island, btTypedConstraint** islandConstraints, uint32_t constraintCount)
+			{
+				bodies.insert(bodies.end(), collector.bodies.begin() + island.bodyOffset, collector.bodies.begin() + island.bodyOffset + island.bodyCount);
+				manifolds.insert(manifolds.end(), collector.manifolds.begin() + island.manifoldOffset, collector.manifolds.begin() + island.manifoldOffset + island.manifoldCount);
+				constraints.insert(constraints.end(), islandConstraints, islandConstraints + constraintCount);
+				batch_size += island.manifoldCount + constraintCount;
+			}
+			void end_batch()
+			{
+				Batch batch;
+				if (!batches.empty())
+				{
+					const Batch& prev = batches.back();
+					batch.bodyOffset = prev.bodyOffset + prev.bodyCount;
+					batch.manifoldOffset = prev.manifoldOffset + prev.manifoldCount;
+					batch.constraintOffset = prev.constraintOffset + prev.constraintCount;
+				}
+				batch.bodyCount = (uint32_t)bodies.size() - batch.bodyOffset;
+				batch.manifoldCount = (uint32_t)manifolds.size() - batch.manifoldOffset;
+				batch.constraintCount = (uint32_t)constraints.size() - batch.constraintOffset;
+				if (batch.bodyCount > 0)
+				{
+					batches.push_back(batch);
+				}
+				batch_size = 0;
+			}
+			void solve(btConstraintSolver* solver, uint32_t batchIndex, const btContactSolverInfo& solverInfo, btIDebugDraw* debugDrawer, btDispatcher* dispatcher)
+			{
+				const Batch& batch = batches[batchIndex];
+				solver->solveGroup(
+					bodies.data() + batch.bodyOffset, (int)batch.bodyCount,
+					manifolds.data() + batch.manifoldOffset, (int)batch.manifoldCount,
+					constraints.data() + batch.constraintOffset, (int)batch.constraintCount,
+					solverInfo, debugDrawer, dispatcher
+				);
+			}
+		};
+		SolverGroup parallel_group;
+		SolverGroup serial_group;
+
+		wi::SpinLock solver_pool_locker;
+		wi::vector<std::unique_ptr<btSequentialImpulseConstraintSolver>> solver_pool;
+		uint32_t solve_index = 0;
+
+		btSequentialImpulseConstraintSolver* AcquireSolver()
+		{
+			std::scoped_lock lck(solver_pool_locker);
+			if (solver_pool.empty())
+			{
+				return new btSequentialImpulseConstraintSolver;
+			}
+			btSequentialImpulseConstraintSolver* solver = solver_pool.back().release();
+			solver_pool.pop_back();
+			return solver;
+		}
+		void ReleaseSolver(btSequentialImpulseConstraintSolver* solver)
+		{
+			std::scoped_lock lck(solver_pool_locker);
+			solver_pool.emplace_back(solver);
+		}
+
+		static int GetConstraintIslandId(const btTypedConstraint* constraint)
+		{
+			const btCollisionObject& a = constraint->getRigidBodyA();
+			const btCollisionObject& b = constraint->getRigidBodyB();
+			return a.getIslandTag() >= 0 ? a.getIslandTag() : b.getIslandTag();
+		}
+
+	public:
+		bool parallel = false;
+		uint32_t body_group_size = 256;
+
+		DynamicsWorldMt(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration)
+			: btSoftRigidDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration)
+		{
+		}
+
+		// Advances the simulation by steps * timeStep like stepSimulation(), but the time accumulation is done by the caller
+		//	beforeLastStep is called before the last step, so the state of the previous step can be saved for interpolation
+		template<typename T>
+		void StepFixed(int steps, btScalar timeStep, const T& beforeLastStep)
+		{
+			saveKinematicState(timeStep * steps);
+			applyGravity();
+			for (int i = 0; i < steps; ++i)
+			{
+				if (i == steps - 1)
+				{
+					beforeLastStep();
+				}
+				internalSingleStepSimulation(timeStep);
+			}
+			synchronizeMotionStates();
+			clearForces();
+		}
+
+		// Resets the random constraint order of the solvers, so that a new simulation starts from the same state
+		void ResetSolverState()
+		{
+			solve_index = 0;
+			m_constraintSolver->reset();
+		}
+
+		void predictUnconstraintMotion(btScalar timeStep) override
+		{
+			if (!parallel)
+			{
+				btSoftRigidDynamicsWorld::predictUnconstraintMotion(timeStep);
+				return;
+			}
+
+			ParallelFor((uint32_t)m_nonStaticRigidBodies.size(), body_group_size, [&](uint32_t i) {
+				btRigidBody* body = m_nonStaticRigidBodies[i];
+				if (!body->isStaticOrKinematicObject())
+				{
+					body->applyDamping(timeStep);
+					body->predictIntegratedTransform(timeStep, body->getInterpolationWorldTransform());
+				}
+			});
+		}
+
+		void integrateTransforms(btScalar timeStep) override
+		{
+			bool serial = !parallel || getApplySpeculativeContactRestitution();
+			if (!serial && getDispatchInfo().m_useContinuous)
+			{
+				// Continuous collision clamping performs sweep tests against the broadphase, that is not thread safe:
+				for (int i = 0; i < m_nonStaticRigidBodies.size(); ++i)
+				{
+					if (m_nonStaticRigidBodies[i]->getCcdSquareMotionThreshold() > 0)
+					{
+						serial = true;
+						break;
+					}
+				}
+			}
+			if (serial)
+			{
+				btSoftRigidDynamicsWorld::integrateTransforms(timeStep);
+				return;
+			}
+
+			ParallelFor((uint32_t)m_nonStaticRigidBodies.size(), body_group_size, [&](uint32_t i) {
+				btRigidBody* body = m_nonStaticRigidBodies[i];
+				body->setHitFraction(1);
+				if (body->isActive() && !body->isStaticOrKinematicObject())
+				{
+					btTransform predictedTransform;
+					body->predictIntegratedTransform(timeStep, predictedTransform);
+					body->proceedToTransform(predictedTransform);
+				}
+			});
+		}
+
+		void solveConstraints(btContactSolverInfo& solverInfo) override
+		{
+			if (!parallel || !m_islandManager->getSplitIslands())
+			{
+				btSoftRigidDynamicsWorld::solveConstraints(solverInfo);
+				return;
+			}
+
+			m_sortedConstraints.resize(m_constraints.size());
+			for (int i = 0; i < m_constraints.size(); ++i)
+			{
+				m_sortedConstraints[i] = m_constraints[i];
+			}
+			m_sortedConstraints.quickSort([](const btTypedConstraint* a, const btTypedConstraint* b) {
+				return GetConstraintIslandId(a) < GetConstraintIslandId(b);
+			});
+
+			collector.clear();
+			m_islandManager->buildAndProcessIslands(getDispatcher(), getCollisionWorld(), &collector);
+
+			// Islands are visited in increasing id order, the same as the sorted constraints:
+			parallel_group.clear();
+			serial_group.clear();
+			int constraintIndex = 0;
+			for (const IslandCollector::Island& island : collector.islands)
+			{
+				while (constraintIndex < m_sortedConstraints.size() && GetConstraintIslandId(m_sortedConstraints[constraintIndex]) < island.id)
+				{
+					constraintIndex++;
+				}
+				btTypedConstraint** islandConstraints = m_sortedConstraints.size() > 0 ? &m_sortedConstraints[0] + constraintIndex : nullptr;
+				uint32_t constraintCount = 0;
+				bool kinematic = false;
+				while (constraintIndex < m_sortedConstraints.size() && GetConstraintIslandId(m_sortedConstraints[constraintIndex]) == island.id)
+				{
+					const btTypedConstraint* constraint = m_sortedConstraints[constraintIndex];
+					kinematic |= constraint->getRigidBodyA().isKinematicObject() || constraint->getRigidBodyB().isKinematicObject();
+					constraintCount++;
+					constraintIndex++;
+				}
+				for (uint32_t i = 0; i < island.manifoldCount && !kinematic; ++i)
+				{
+					const btPersistentManifold* manifold = collector.manifolds[island.manifoldOffset + i];
+					kinematic |= manifold->getBody0()->isKinematicObject() || manifold->getBody1()->isKinematicObject();
+				}
+
+				SolverGroup& group = kinematic ? serial_group : parallel_group;
+				group.add_island(collector, island, islandConstraints, constraintCount);
+
+				// Small islands are combined to reduce solver overhead:
+				if (!kinematic && group.batch_size > (uint32_t)solverInfo.m_minimumSolverBatchSize)
+				{
+					group.end_batch();
+				}
+			}
+			parallel_group.end_batch();
+			serial_group.end_batch();
+
+			solve_index++;
+			ParallelFor((uint32_t)parallel_group.batches.size(), 1, [&](uint32_t i) {
+				btSequentialImpulseConstraintSolver* solver = AcquireSolver();
+				solver->setRandSeed(solve_index * 7919u + i); // random constraint order must not depend on which solver gets the batch
+				parallel_group.solve(solver, i, solverInfo, m_debugDrawer, getDispatcher());
+				ReleaseSolver(solver);
+			});
+
+			m_constraintSolver->prepareSolve(getNumCollisionObjects(), getDispatcher()->getNumManifolds());
+			for (uint32_t i = 0; i < (uint32_t)serial_group.batches.size(); ++i)
+			{
+				serial_group.solve(m_constraintSolver, i, solverInfo, m_debugDrawer, getDispatcher());
+			}
+			m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
+		}
+	};
 
 	btVector3 gravity(0, -10, 0);
 	int softbodyIterationCount = 5;
-	btSoftBodyRigidBodyCollisionConfiguration collisionConfiguration;
-	btDbvtBroadphase overlappingPairCache;
-	btSequentialImpulseConstraintSolver solver;
-	btCollisionDispatcher dispatcher(&collisionConfiguration);
-	btSoftRigidDynamicsWorld dynamicsWorld(&dispatcher, &overlappingPairCache, &solver, &collisionConfiguration);
 
 	class DebugDraw : public btIDebugDraw
 	{
@@ -68,20 +525,6 @@ namespace wi::physics
 	{
 		wi::Timer timer;
 
-		dynamicsWorld.getSolverInfo().m_solverMode |= SOLVER_RANDMIZE_ORDER;
-		dynamicsWorld.getDispatchInfo().m_enableSatConvex = true;
-		dynamicsWorld.getSolverInfo().m_splitImpulse = true;
-		dynamicsWorld.setGravity(gravity);
-		dynamicsWorld.setDebugDrawer(&debugDraw);
-
-		btSoftBodyWorldInfo& softWorldInfo = dynamicsWorld.getWorldInfo();
-		softWorldInfo.air_density = btScalar(1.2f);
-		softWorldInfo.water_density = 0;
-		softWorldInfo.water_offset = 0;
-		softWorldInfo.water_normal = btVector3(0, 0, 0);
-		softWorldInfo.m_gravity.setValue(gravity.x(), gravity.y(), gravity.z());
-		softWorldInfo.m_sparsesdf.Initialize();
-
 		wi::backlog::post("wi::physics Initialized [Bullet] (" + std::to_string((int)std::round(timer.elapsed())) + " ms)");
 	}
 
@@ -94,85 +537,723 @@ namespace wi::physics
 	bool IsDebugDrawEnabled() { return DEBUGDRAW_ENABLED; }
 	void SetDebugDrawEnabled(bool value) { DEBUGDRAW_ENABLED = value; }
 
+	bool IsInterpolationEnabled() { return INTERPOLATION_ENABLED; }
+	void SetInterpolationEnabled(bool value) { INTERPOLATION_ENABLED = value; }
+
+	bool IsDeterministicEnabled() { return DETERMINISTIC_ENABLED; }
+	void SetDeterministicEnabled(bool value) { DETERMINISTIC_ENABLED = value; }
+
+	bool IsMultithreadingEnabled() { return MULTITHREADING_ENABLED; }
+	void SetMultithreadingEnabled(bool value) { MULTITHREADING_ENABLED = value; }
+
 	int GetAccuracy() { return ACCURACY; }
 	void SetAccuracy(int value) { ACCURACY = value; }
 
-	void AddRigidBody(Entity entity, wi::scene::RigidBodyPhysicsComponent& physicscomponent, const wi::scene::TransformComponent& transform, const wi::scene::MeshComponent* mesh)
+	float GetFrameRate() { return FRAMERATE; }
+	void SetFrameRate(float value) { FRAMERATE = value; }
+
+
+	// Convex hull with outward facing planes, used by convex hull generation
+	struct ConvexHull
 	{
-		btCollisionShape* shape = nullptr;
+		btAlignedObjectArray<btVector3> vertices;
+		btAlignedObjectArray<btVector4> planes; // xyz: normal, w: distance from origin
+	};
+	// Computes the convex hull of points, reduced to at most vertex_limit vertices
+	//	The reduced hull is the hull of the support vertices of the full hull in evenly distributed directions,
+	//	the direction count is increased while the support vertices fit into the limit
+	void ComputeConvexHull(const btVector3* points, int count, uint32_t vertex_limit, ConvexHull& hull)
+	{
+		hull.vertices.clear();
+		hull.planes.clear();
+		if (count <= 0)
+			return;
 
-		switch (physicscomponent.shape)
+		btConvexHullComputer computer;
+		computer.compute(&points[0].x(), sizeof(btVector3), count, 0, 0);
+
+		vertex_limit = std::max(4u, vertex_limit);
+		if ((uint32_t)computer.vertices.size() > vertex_limit)
 		{
-		case RigidBodyPhysicsComponent::CollisionShape::BOX:
+			btAlignedObjectArray<btVector3> reduced;
+			wi::vector<uint8_t> selected(computer.vertices.size());
+			for (uint32_t direction_count = vertex_limit; direction_count <= vertex_limit * 8; direction_count *= 2)
+			{
+				// Fibonacci sphere directions:
+				std::fill(selected.begin(), selected.end(), 0);
+				btAlignedObjectArray<btVector3> candidates;
+				for (uint32_t i = 0; i < direction_count; ++i)
+				{
+					const float y = 1 - 2 * (i + 0.5f) / direction_count;
+					const float r = std::sqrt(std::max(0.0f, 1 - y * y));
+					const float phi = i * 2.39996323f;
+					const btVector3 direction(std::cos(phi) * r, y, std::sin(phi) * r);
+					int support = 0;
+					btScalar support_distance = computer.vertices[0].dot(direction);
+					for (int j = 1; j < computer.vertices.size(); ++j)
+					{
+						const btScalar distance = computer.vertices[j].dot(direction);
+						if (distance > support_distance)
+						{
+							support_distance = distance;
+							support = j;
+						}
+					}
+					if (selected[support] == 0)
+					{
+						selected[support] = 1;
+						candidates.push_back(computer.vertices[support]);
+					}
+				}
+				if ((uint32_t)candidates.size() > vertex_limit)
+					break;
+				reduced = candidates;
+			}
+			computer.compute(&reduced[0].x(), sizeof(btVector3), reduced.size(), 0, 0);
+		}
+
+		hull.vertices = computer.vertices;
+
+		btVector3 center(0, 0, 0);
+		for (int i = 0; i < hull.vertices.size(); ++i)
 		{
-			shape = new btBoxShape(btVector3(physicscomponent.box.halfextents.x, physicscomponent.box.halfextents.y, physicscomponent.box.halfextents.z));
+			center += hull.vertices[i];
 		}
-		break;
+		center /= btScalar(std::max(1, hull.vertices.size()));
+		for (int i = 0; i < computer.faces.size(); ++i)
+		{
+			const btConvexHullComputer::Edge* edge = &computer.edges[computer.faces[i]];
+			const btVector3& a = computer.vertices[edge->getSourceVertex()];
+			edge = edge->getNextEdgeOfFace();
+			const btVector3& b = computer.vertices[edge->getSourceVertex()];
+			edge = edge->getNextEdgeOfFace();
+			const btVector3& c = computer.vertices[edge->getSourceVertex()];
+			btVector3 normal = (b - a).cross(c - a);
+			if (normal.length2() < SIMD_EPSILON)
+				continue;
+			normal.normalize();
+			if (normal.dot(center - a) > 0)
+			{
+				normal = -normal;
+			}
+			hull.planes.push_back(btVector4(normal.x(), normal.y(), normal.z(), normal.dot(a)));
+		}
+	}
+
+	void CreateConvexHulls(wi::scene::RigidBodyPhysicsComponent& physicscomponent, const wi::scene::MeshComponent& mesh)
+	{
+		physicscomponent.convex_hull_vertices.clear();
+		physicscomponent.convex_hull_vertex_counts.clear();
+		if (mesh.vertex_positions.empty())
+			return;
 
-		case RigidBodyPhysicsComponent::CollisionShape::SPHERE:
+		auto append = [&](const ConvexHull& hull) {
+			if (hull.vertices.size() == 0)
+				return;
+			for (int i = 0; i < hull.vertices.size(); ++i)
+			{
+				physicscomponent.convex_hull_vertices.push_back(XMFLOAT3(hull.vertices[i].x(), hull.vertices[i].y(), hull.vertices[i].z()));
+			}
+			physicscomponent.convex_hull_vertex_counts.push_back((uint32_t)hull.vertices.size());
+		};
+
+		const uint32_t vertex_limit = physicscomponent.convex_hull.vertex_limit;
+		btAlignedObjectArray<btVector3> points;
+		ConvexHull hull;
+
+		// Triangles of the first LOD, without decomposition only their vertices matter:
+		wi::vector<uint32_t> triangles;
+		uint32_t first_subset = 0;
+		uint32_t last_subset = 0;
+		mesh.GetLODSubsetRange(0, first_subset, last_subset);
+		for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
 		{
-			shape = new btSphereShape(btScalar(physicscomponent.sphere.radius));
+			const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
+			for (uint32_t i = 0; i + 2 < subset.indexCount; i += 3)
+			{
+				triangles.push_back(subset.indexOffset + i);
+			}
 		}
-		break;
 
-		case RigidBodyPhysicsComponent::CollisionShape::CAPSULE:
-			shape = new btCapsuleShape(btScalar(physicscomponent.capsule.radius), btScalar(physicscomponent.capsule.height));
-			break;
+		if (physicscomponent.convex_hull.max_hulls <= 1 || triangles.empty())
+		{
+			points.resize((int)mesh.vertex_positions.size());
+			for (int i = 0; i < points.size(); ++i)
+			{
+				const XMFLOAT3& pos = mesh.vertex_positions[i];
+				points[i] = btVector3(pos.x, pos.y, pos.z);
+			}
+			ComputeConvexHull(&points[0], points.size(), vertex_limit, hull);
+			append(hull);
+			return;
+		}
 
-		case RigidBodyPhysicsComponent::CollisionShape::CONVEX_HULL:
-			if(mesh != nullptr)
+		// Approximate convex decomposition:
+		//	The part with the highest concavity is split in two along the longest axis of its bounds until
+		//	the hull count limit is reached, or all parts are below the concavity threshold.
+		//	Concavity is the deepest distance of the part's surface vertices inside its hull, relative to the part size
+		struct Part
+		{
+			wi::vector<uint32_t> triangles;
+			btVector3 aabb_min;
+			btVector3 aabb_max;
+			float concavity = 0;
+		};
+		auto compute_part = [&](Part& part) {
+			points.clear();
+			part.aabb_min = btVector3(FLT_MAX, FLT_MAX, FLT_MAX);
+			part.aabb_max = btVector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			for (uint32_t triangle : part.triangles)
 			{
-				shape = new btConvexHullShape();
-				for (auto& pos : mesh->vertex_positions)
+				for (uint32_t i = 0; i < 3; ++i)
 				{
-					((btConvexHullShape*)shape)->addPoint(btVector3(pos.x, pos.y, pos.z));
+					const XMFLOAT3& pos = mesh.vertex_positions[mesh.indices[triangle + i]];
+					const btVector3 point(pos.x, pos.y, pos.z);
+					points.push_back(point);
+					part.aabb_min.setMin(point);
+					part.aabb_max.setMax(point);
 				}
-				btVector3 S(transform.scale_local.x, transform.scale_local.y, transform.scale_local.z);
-				shape->setLocalScaling(S);
 			}
-			else
+			ComputeConvexHull(&points[0], points.size(), vertex_limit, hull);
+
+			// At most 4096 vertices are sampled:
+			const int sample_step = std::max(1, points.size() / 4096);
+			btScalar depth = 0;
+			for (int i = 0; i < points.size(); i += sample_step)
 			{
-				wi::backlog::post("Convex Hull physics requested, but no MeshComponent provided!");
-				assert(0);
+				btScalar distance = FLT_MAX;
+				for (int j = 0; j < hull.planes.size(); ++j)
+				{
+					const btVector4& plane = hull.planes[j];
+					distance = std::min(distance, plane.w() - btVector3(plane.x(), plane.y(), plane.z()).dot(points[i]));
+				}
+				depth = std::max(depth, distance);
 			}
-			break;
+			const btScalar size = (part.aabb_max - part.aabb_min).length();
+			part.concavity = size > 0 ? float(depth / size) : 0;
+		};
+
+		// Unsplittable parts are marked with zero concavity, so the threshold can't be negative, otherwise they would be selected forever:
+		const float concavity_threshold = std::max(0.0f, physicscomponent.convex_hull.concavity);
+		wi::vector<Part> parts(1);
+		parts[0].triangles = std::move(triangles);
+		compute_part(parts[0]);
+		while (parts.size() < physicscomponent.convex_hull.max_hulls)
+		{
+			size_t split = 0;
+			for (size_t i = 1; i < parts.size(); ++i)
+			{
+				if (parts[i].concavity > parts[split].concavity)
+				{
+					split = i;
+				}
+			}
+			if (parts[split].concavity <= concavity_threshold)
+				break;
+
+			Part& part = parts[split];
+			const int axis = (part.aabb_max - part.aabb_min).maxAxis();
+			auto centroid = [&](uint32_t triangle) {
+				return (
+					(&mesh.vertex_positions[mesh.indices[triangle + 0]].x)[axis] +
+					(&mesh.vertex_positions[mesh.indices[triangle + 1]].x)[axis] +
+					(&mesh.vertex_positions[mesh.indices[triangle + 2]].x)[axis]
+				) / 3.0f;
+			};
+			float split_position = 0;
+			for (uint32_t triangle : part.triangles)
+			{
+				split_position += centroid(triangle);
+			}
+			split_position /= part.triangles.size();
 
-		case RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH:
-			if(mesh != nullptr)
+			Part front;
+			Part back;
+			for (uint32_t triangle : part.triangles)
 			{
-				int totalVerts = (int)mesh->vertex_positions.size();
-				int totalTriangles = 0;
-				uint32_t first_subset = 0;
-				uint32_t last_subset = 0;
-				mesh->GetLODSubsetRange(0, first_subset, last_subset);
-				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+				(centroid(triangle) < split_position ? back : front).triangles.push_back(triangle);
+			}
+			if (front.triangles.empty() || back.triangles.empty())
+			{
+				part.concavity = 0; // can't be split further
+				continue;
+			}
+			compute_part(front);
+			compute_part(back);
+			part = std::move(front);
+			parts.push_back(std::move(back));
+		}
+
+		for (Part& part : parts)
+		{
+			points.clear();
+			for (uint32_t triangle : part.triangles)
+			{
+				for (uint32_t i = 0; i < 3; ++i)
 				{
-					const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
-					totalTriangles += int(subset.indexCount / 3);
+					const XMFLOAT3& pos = mesh.vertex_positions[mesh.indices[triangle + i]];
+					points.push_back(btVector3(pos.x, pos.y, pos.z));
 				}
+			}
+			ComputeConvexHull(&points[0], points.size(), vertex_limit, hull);
+			append(hull);
+		}
+	}
 
-				btTriangleIndexVertexArray* indexVertexArrays = new btTriangleIndexVertexArray(
-					totalTriangles,
-					(int*)mesh->indices.data(),
-					3 * sizeof(int),
-					totalVerts,
-					(btScalar*)mesh->vertex_positions.data(),
-					sizeof(XMFLOAT3)
-				);
+	// Collision shapes are shared between rigid bodies that would create identical shapes
+	//	Convex shapes are keyed by their parameters and scale. Triangle meshes are keyed by the mesh only, the
+	//	BVH is built once per mesh and every instance references it with its own btScaledBvhTriangleMeshShape
+	//	Mesh based shapes also include the geometry version of the mesh, so an edited mesh doesn't reuse a shape of its old geometry
+	namespace shapecache
+	{
+		struct Key
+		{
+			Entity meshID = INVALID_ENTITY;
+			RigidBodyPhysicsComponent::CollisionShape shape = RigidBodyPhysicsComponent::CollisionShape::BOX;
+			XMFLOAT3 params = XMFLOAT3(0, 0, 0);
+			XMFLOAT3 scale = XMFLOAT3(1, 1, 1);
+			uint64_t geometry = 0;
+
+			bool operator==(const Key& other) const
+			{
+				return meshID == other.meshID && shape == other.shape && geometry == other.geometry &&
+					params.x == other.params.x && params.y == other.params.y && params.z == other.params.z &&
+					scale.x == other.scale.x && scale.y == other.scale.y && scale.z == other.scale.z;
+			}
+		};
+		struct KeyHasher
+		{
+			size_t operator()(const Key& key) const
+			{
+				size_t hash = 0;
+				wi::helper::hash_combine(hash, key.meshID);
+				wi::helper::hash_combine(hash, key.geometry);
+				wi::helper::hash_combine(hash, (uint32_t)key.shape);
+				wi::helper::hash_combine(hash, key.params.x);
+				wi::helper::hash_combine(hash, key.params.y);
+				wi::helper::hash_combine(hash, key.params.z);
+				wi::helper::hash_combine(hash, key.scale.x);
+				wi::helper::hash_combine(hash, key.scale.y);
+				wi::helper::hash_combine(hash, key.scale.z);
+				return hash;
+			}
+		};
+		struct Entry
+		{
+			btCollisionShape* shape = nullptr;
+			btTriangleIndexVertexArray* triangles = nullptr;
+			uint32_t refcount = 0;
+			size_t memory = 0;
+			double build_milliseconds = 0;
+		};
+		// These are never destroyed, because scenes that are destroyed at exit can still release their shapes:
+		wi::unordered_map<Key, Entry, KeyHasher>& entries = *new wi::unordered_map<Key, Entry, KeyHasher>;
+		wi::unordered_map<const btCollisionShape*, Key>& keys = *new wi::unordered_map<const btCollisionShape*, Key>;
+		ShapeCacheStatistics statistics;
+		std::mutex locker;
+
+		// Triangle mesh shapes reference the mesh memory directly, so the location of the arrays is part of their fingerprint too
+		//	The geometry must be recreated with CreateRenderData() after it is edited, so its version identifies it without hashing the vertices
+		//	Only meshes that never had render data created are hashed
+		uint64_t ComputeGeometryHash(const MeshComponent* mesh, bool referenced)
+		{
+			if (mesh == nullptr)
+				return 0;
+			uint64_t hash = mesh->geometry_version > 0 ? mesh->geometry_version : mesh->ComputeClusterHash();
+			if (referenced)
+			{
+				wi::helper::hash_combine(hash, (uint64_t)mesh->vertex_positions.data());
+				wi::helper::hash_combine(hash, (uint64_t)mesh->indices.data());
+			}
+			return hash;
+		}
 
-				bool useQuantizedAabbCompression = true;
-				shape = new btBvhTriangleMeshShape(indexVertexArrays, useQuantizedAabbCompression);
-				btVector3 S(transform.scale_local.x, transform.scale_local.y, transform.scale_local.z);
-				shape->setLocalScaling(S);
-				shape->setUserPointer(indexVertexArrays);
+		// This doesn't access the cache, it can be called without locking
+		Key MakeKey(const RigidBodyPhysicsComponent& physicscomponent, const MeshComponent* mesh, Entity meshID, const XMFLOAT3& scale)
+		{
+			Key key;
+			key.shape = physicscomponent.shape;
+			switch (physicscomponent.shape)
+			{
+			case RigidBodyPhysicsComponent::CollisionShape::BOX:
+				key.params = physicscomponent.box.halfextents;
+				key.scale = scale;
+				break;
+			case RigidBodyPhysicsComponent::CollisionShape::SPHERE:
+				key.params.x = physicscomponent.sphere.radius;
+				key.scale = scale;
+				break;
+			case RigidBodyPhysicsComponent::CollisionShape::CAPSULE:
+				key.params.x = physicscomponent.capsule.radius;
+				key.params.y = physicscomponent.capsule.height;
+				key.scale = scale;
+				break;
+			case RigidBodyPhysicsComponent::CollisionShape::CONVEX_HULL:
+				key.meshID = meshID;
+				key.params.x = float(physicscomponent.convex_hull.vertex_limit);
+				key.params.y = float(physicscomponent.convex_hull.max_hulls);
+				key.params.z = physicscomponent.convex_hull.concavity;
+				key.scale = scale;
+				key.geometry = ComputeGeometryHash(mesh, false);
+				break;
+			case RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH:
+				key.meshID = meshID; // scale is applied per instance
+				key.geometry = ComputeGeometryHash(mesh, true);
+				break;
+			default:
+				break;
+			}
+			return key;
+		}
+
+		// Fills the convex hulls of a rigid body from an existing convex hull or compound shape
+		void ReadConvexHulls(const btCollisionShape* shape, RigidBodyPhysicsComponent& physicscomponent)
+		{
+			auto read = [&](const btConvexHullShape* hull) {
+				for (int i = 0; i < hull->getNumPoints(); ++i)
+				{
+					const btVector3& point = hull->getUnscaledPoints()[i];
+					physicscomponent.convex_hull_vertices.push_back(XMFLOAT3(point.x(), point.y(), point.z()));
+				}
+				physicscomponent.convex_hull_vertex_counts.push_back((uint32_t)hull->getNumPoints());
+			};
+			physicscomponent.convex_hull_vertices.clear();
+			physicscomponent.convex_hull_vertex_counts.clear();
+			if (shape->isCompound())
+			{
+				const btCompoundShape* compound = (const btCompoundShape*)shape;
+				for (int i = 0; i < compound->getNumChildShapes(); ++i)
+				{
+					read((const btConvexHullShape*)compound->getChildShape(i));
+				}
 			}
 			else
 			{
-				wi::backlog::post("Triangle Mesh physics requested, but no MeshComponent provided!");
+				read((const btConvexHullShape*)shape);
+			}
+		}
+
+		// Returns a shared shape with increased reference count, or nullptr if the shape couldn't be created
+		btCollisionShape* Acquire(const Key& key, RigidBodyPhysicsComponent& physicscomponent, const MeshComponent* mesh)
+		{
+			auto it = entries.find(key);
+			if (it != entries.end())
+			{
+				Entry& entry = it->second;
+				if (key.shape == RigidBodyPhysicsComponent::CollisionShape::CONVEX_HULL && physicscomponent.convex_hull_vertex_counts.empty())
+				{
+					ReadConvexHulls(entry.shape, physicscomponent);
+				}
+				entry.refcount++;
+				statistics.reference_count++;
+				statistics.memory_saved += entry.memory;
+				statistics.saved_milliseconds += entry.build_milliseconds;
+				return entry.shape;
+			}
+
+			wi::Timer timer;
+			Entry entry;
+			switch (key.shape)
+			{
+			case RigidBodyPhysicsComponent::CollisionShape::BOX:
+				entry.shape = new btBoxShape(btVector3(key.params.x, key.params.y, key.params.z));
+				entry.memory = sizeof(btBoxShape);
+				break;
+
+			case RigidBodyPhysicsComponent::CollisionShape::SPHERE:
+				entry.shape = new btSphereShape(btScalar(key.params.x));
+				entry.memory = sizeof(btSphereShape);
+				break;
+
+			case RigidBodyPhysicsComponent::CollisionShape::CAPSULE:
+				entry.shape = new btCapsuleShape(btScalar(key.params.x), btScalar(key.params.y));
+				entry.memory = sizeof(btCapsuleShape);
+				break;
+
+			case RigidBodyPhysicsComponent::CollisionShape::CONVEX_HULL:
+				if (physicscomponent.convex_hull_vertex_counts.empty() && mesh != nullptr)
+				{
+					CreateConvexHulls(physicscomponent, *mesh);
+				}
+				if (!physicscomponent.convex_hull_vertex_counts.empty())
+				{
+					// Multiple hulls of a decomposed mesh are children of a compound shape:
+					btCompoundShape* compound = nullptr;
+					if (physicscomponent.convex_hull_vertex_counts.size() > 1)
+					{
+						compound = new btCompoundShape();
+						entry.shape = compound;
+						entry.memory = sizeof(btCompoundShape);
+					}
+					size_t offset = 0;
+					for (uint32_t count : physicscomponent.convex_hull_vertex_counts)
+					{
+						btConvexHullShape* hull = new btConvexHullShape();
+						for (uint32_t i = 0; i < count && offset + i < physicscomponent.convex_hull_vertices.size(); ++i)
+						{
+							const XMFLOAT3& pos = physicscomponent.convex_hull_vertices[offset + i];
+							hull->addPoint(btVector3(pos.x, pos.y, pos.z), false);
+						}
+						offset += count;
+						hull->recalcLocalAabb();
+						entry.memory += sizeof(btConvexHullShape) + hull->getNumPoints() * sizeof(btVector3);
+						if (compound == nullptr)
+						{
+							entry.shape = hull;
+						}
+						else
+						{
+							btTransform identity;
+							identity.setIdentity();
+							compound->addChildShape(identity, hull);
+						}
+					}
+				}
+				else
+				{
+					wi::backlog::post("Convex Hull physics requested, but no MeshComponent provided!");
+					assert(0);
+				}
+				break;
+
+			case RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH:
+				if (mesh != nullptr)
+				{
+					int totalVerts = (int)mesh->vertex_positions.size();
+					int totalTriangles = 0;
+					uint32_t first_subset = 0;
+					uint32_t last_subset = 0;
+					mesh->GetLODSubsetRange(0, first_subset, last_subset);
+					for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+					{
+						const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
+						totalTriangles += int(subset.indexCount / 3);
+					}
+
+					entry.triangles = new btTriangleIndexVertexArray(
+						totalTriangles,
+						(int*)mesh->indices.data(),
+						3 * sizeof(int),
+						totalVerts,
+						(btScalar*)mesh->vertex_positions.data(),
+						sizeof(XMFLOAT3)
+					);
+
+					bool useQuantizedAabbCompression = true;
+					btBvhTriangleMeshShape* trimesh = new btBvhTriangleMeshShape(entry.triangles, useQuantizedAabbCompression);
+					entry.shape = trimesh;
+					entry.memory = sizeof(btBvhTriangleMeshShape) + sizeof(btTriangleIndexVertexArray);
+					if (trimesh->getOptimizedBvh() != nullptr)
+					{
+						entry.memory += trimesh->getOptimizedBvh()->calculateSerializeBufferSize();
+					}
+				}
+				else
+				{
+					wi::backlog::post("Triangle Mesh physics requested, but no MeshComponent provided!");
+					assert(0);
+				}
+				break;
+
+			default:
+				break;
+			}
+
+			if (entry.shape == nullptr)
+				return nullptr;
+
+			if (key.shape != RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH)
+			{
+				entry.shape->setLocalScaling(btVector3(key.scale.x, key.scale.y, key.scale.z));
+			}
+			entry.build_milliseconds = timer.elapsed_milliseconds();
+			entry.refcount = 1;
+			statistics.shape_count++;
+			statistics.reference_count++;
+			statistics.memory += entry.memory;
+			statistics.build_milliseconds += entry.build_milliseconds;
+			keys[entry.shape] = key;
+			entries[key] = entry;
+			return entry.shape;
+		}
+
+		// Decreases the reference count of a shared shape and destroys it when it's no longer used
+		void Release(const btCollisionShape* shape)
+		{
+			auto it_key = keys.find(shape);
+			if (it_key == keys.end())
+			{
 				assert(0);
+				return;
+			}
+			auto it = entries.find(it_key->second);
+			Entry& entry = it->second;
+			statistics.reference_count--;
+			entry.refcount--;
+			if (entry.refcount > 0)
+			{
+				statistics.memory_saved -= entry.memory;
+				return;
+			}
+			statistics.shape_count--;
+			statistics.memory -= entry.memory;
+			if (entry.shape->isCompound())
+			{
+				btCompoundShape* compound = (btCompoundShape*)entry.shape;
+				for (int i = 0; i < compound->getNumChildShapes(); ++i)
+				{
+					delete compound->getChildShape(i);
+				}
+			}
+			delete entry.shape;
+			delete entry.triangles;
+			keys.erase(it_key);
+			entries.erase(it);
+		}
+
+		// Creates the collision shape of one rigid body, triangle meshes get a per instance scaling shape
+		btCollisionShape* CreateInstance(RigidBodyPhysicsComponent& physicscomponent, const MeshComponent* mesh, Entity meshID, const XMFLOAT3& scale)
+		{
+			const Key key = MakeKey(physicscomponent, mesh, meshID, scale);
+			std::scoped_lock lck(locker);
+			btCollisionShape* shape = Acquire(key, physicscomponent, mesh);
+			if (shape != nullptr && shape->getShapeType() == TRIANGLE_MESH_SHAPE_PROXYTYPE)
+			{
+				shape = new btScaledBvhTriangleMeshShape((btBvhTriangleMeshShape*)shape, btVector3(scale.x, scale.y, scale.z));
+			}
+			return shape;
+		}
+		void DestroyInstance(btCollisionShape* shape)
+		{
+			std::scoped_lock lck(locker);
+			if (shape->getShapeType() == SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE)
+			{
+				btScaledBvhTriangleMeshShape* scaled = (btScaledBvhTriangleMeshShape*)shape;
+				Release(scaled->getChildShape());
+				delete scaled;
+				return;
+			}
+			Release(shape);
+		}
+
+		// Changes the scale of a rigid body, shared convex shapes are replaced by a shape with the new scale
+		void SetInstanceScale(btRigidBody* rigidbody, RigidBodyPhysicsComponent& physicscomponent, const MeshComponent* mesh, Entity meshID, const XMFLOAT3& scale)
+		{
+			btCollisionShape* shape = rigidbody->getCollisionShape();
+			if (shape->getShapeType() == SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE)
+			{
+				std::scoped_lock lck(locker);
+				shape->setLocalScaling(btVector3(scale.x, scale.y, scale.z));
+				return;
+			}
+			const Key key = MakeKey(physicscomponent, mesh, meshID, scale);
+			std::scoped_lock lck(locker);
+			btCollisionShape* scaled = Acquire(key, physicscomponent, mesh);
+			if (scaled != nullptr)
+			{
+				rigidbody->setCollisionShape(scaled);
+				Release(shape);
+			}
+		}
+	}
+
+	ShapeCacheStatistics GetShapeCacheStatistics()
+	{
+		std::scoped_lock lck(shapecache::locker);
+		return shapecache::statistics;
+	}
+
+	// The physics world of a scene, it is created on demand and destroyed with the scene (Scene::physics_scene)
+	//	Separate scenes don't share state, so they can be updated on different threads at the same time
+	struct PhysicsScene
+	{
+		btSoftBodyRigidBodyCollisionConfiguration collisionConfiguration;
+		btDbvtBroadphase broadphase;
+		btSequentialImpulseConstraintSolver solver;
+		CollisionDispatcherMt dispatcher;
+		DynamicsWorldMt dynamicsWorld;
+		std::mutex locker;
+
+		float accumulator = 0;
+		bool world_reset = true;
+		float interpolation_alpha = 0;
+		int last_step_count = 0;
+
+		wi::vector<RigidBodyFeedback> rigidbody_feedback;
+		wi::vector<SoftBodyFeedback> softbody_feedback;
+
+		PhysicsScene() :
+			dispatcher(&collisionConfiguration),
+			dynamicsWorld(&dispatcher, &broadphase, &solver, &collisionConfiguration)
+		{
+			dynamicsWorld.getSolverInfo().m_solverMode |= SOLVER_RANDMIZE_ORDER;
+			dynamicsWorld.getDispatchInfo().m_enableSatConvex = true;
+			dynamicsWorld.getSolverInfo().m_splitImpulse = true;
+			dynamicsWorld.setGravity(gravity);
+			dynamicsWorld.setDebugDrawer(&debugDraw);
+
+			btSoftBodyWorldInfo& softWorldInfo = dynamicsWorld.getWorldInfo();
+			softWorldInfo.air_density = btScalar(1.2f);
+			softWorldInfo.water_density = 0;
+			softWorldInfo.water_offset = 0;
+			softWorldInfo.water_normal = btVector3(0, 0, 0);
+			softWorldInfo.m_gravity.setValue(gravity.x(), gravity.y(), gravity.z());
+			softWorldInfo.m_sparsesdf.Initialize();
+		}
+		~PhysicsScene()
+		{
+			for (int i = dynamicsWorld.getNumCollisionObjects() - 1; i >= 0; --i)
+			{
+				btCollisionObject* collisionobject = dynamicsWorld.getCollisionObjectArray()[i];
+				btRigidBody* rigidbody = btRigidBody::upcast(collisionobject);
+				if (rigidbody != nullptr)
+				{
+					shapecache::DestroyInstance(rigidbody->getCollisionShape());
+					delete rigidbody->getMotionState();
+					dynamicsWorld.removeRigidBody(rigidbody);
+					delete rigidbody;
+					continue;
+				}
+				btSoftBody* softbody = btSoftBody::upcast(collisionobject);
+				if (softbody != nullptr)
+				{
+					dynamicsWorld.removeSoftBody(softbody);
+					delete softbody;
+				}
 			}
-			break;
 		}
+	};
+	PhysicsScene& GetPhysicsScene(Scene& scene)
+	{
+		if (scene.physics_scene == nullptr)
+		{
+			scene.physics_scene = std::make_shared<PhysicsScene>();
+		}
+		return *(PhysicsScene*)scene.physics_scene.get();
+	}
+	const PhysicsScene* GetPhysicsScene(const Scene& scene)
+	{
+		return (const PhysicsScene*)scene.physics_scene.get();
+	}
+
+	float GetInterpolationAlpha(const wi::scene::Scene& scene)
+	{
+		const PhysicsScene* physics_scene = GetPhysicsScene(scene);
+		return physics_scene == nullptr ? 0 : physics_scene->interpolation_alpha;
+	}
+	int GetLastStepCount(const wi::scene::Scene& scene)
+	{
+		const PhysicsScene* physics_scene = GetPhysicsScene(scene);
+		return physics_scene == nullptr ? 0 : physics_scene->last_step_count;
+	}
+
+	void AddRigidBody(Entity entity, wi::scene::RigidBodyPhysicsComponent& physicscomponent, const wi::scene::TransformComponent& transform, const wi::scene::MeshComponent* mesh, Entity meshID)
+	{
+		// Primitive shapes are created unscaled, kinematic bodies will be scaled by the system later:
+		const bool mesh_shape =
+			physicscomponent.shape == RigidBodyPhysicsComponent::CollisionShape::CONVEX_HULL ||
+			physicscomponent.shape == RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH;
+		btCollisionShape* shape = shapecache::CreateInstance(physicscomponent, mesh, meshID, mesh_shape ? transform.scale_local : XMFLOAT3(1, 1, 1));
 
 		if (shape != nullptr)
 		{
@@ -227,11 +1308,13 @@ namespace wi::physics
 				rigidbody->setActivationState(DISABLE_DEACTIVATION);
 			}
 
-			dynamicsWorld.addRigidBody(rigidbody);
+			// It will be added to the world after the parallel registration, in component order
 			physicscomponent.physicsobject = rigidbody;
+			physicscomponent.previous_position = physicscomponent.current_position = transform.translation_local;
+			physicscomponent.previous_rotation = physicscomponent.current_rotation = transform.rotation_local;
 		}
 	}
-	void AddSoftBody(Entity entity, wi::scene::SoftBodyPhysicsComponent& physicscomponent, const wi::scene::MeshComponent& mesh)
+	void AddSoftBody(PhysicsScene& physics_scene, Entity entity, wi::scene::SoftBodyPhysicsComponent& physicscomponent, const wi::scene::MeshComponent& mesh)
 	{
 		physicscomponent.CreateFromMesh(mesh);
 
@@ -264,7 +1347,7 @@ namespace wi::physics
 		}
 
 		btSoftBody* softbody = btSoftBodyHelpers::CreateFromTriMesh(
-			dynamicsWorld.getWorldInfo()
+			physics_scene.dynamicsWorld.getWorldInfo()
 			, btVerts.data()
 			, btInd.data()
 			, tCount
@@ -321,7 +1404,7 @@ namespace wi::physics
 
 			softbody->setPose(true, true);
 
-			dynamicsWorld.addSoftBody(softbody);
+			physics_scene.dynamicsWorld.addSoftBody(softbody);
 			physicscomponent.physicsobject = softbody;
 		}
 	}
@@ -337,31 +1420,51 @@ namespace wi::physics
 
 		auto range = wi::profiler::BeginRangeCPU("Physics");
 
+		PhysicsScene& physics_scene = GetPhysicsScene(scene);
+		DynamicsWorldMt& dynamicsWorld = physics_scene.dynamicsWorld;
+		CollisionDispatcherMt& dispatcher = physics_scene.dispatcher;
+		wi::vector<RigidBodyFeedback>& rigidbody_feedback = physics_scene.rigidbody_feedback;
+		wi::vector<SoftBodyFeedback>& softbody_feedback = physics_scene.softbody_feedback;
+
 		btVector3 wind = btVector3(scene.weather.windDirection.x, scene.weather.windDirection.y, scene.weather.windDirection.z);
 
+		// Collision objects that are not claimed by a component in the registration below will be removed:
+		for (int i = 0; i < dynamicsWorld.getNumCollisionObjects(); ++i)
+		{
+			dynamicsWorld.getCollisionObjectArray()[i]->setUserPointer(nullptr);
+		}
+		rigidbody_feedback.resize(scene.rigidbodies.GetCount());
+		softbody_feedback.resize(scene.softbodies.GetCount());
+
 		// System will register rigidbodies to objects, and update physics engine state for kinematics:
 		wi::jobsystem::Dispatch(ctx, (uint32_t)scene.rigidbodies.GetCount(), 256, [&](wi::jobsystem::JobArgs args) {
 
 			RigidBodyPhysicsComponent& physicscomponent = scene.rigidbodies[args.jobIndex];
 			Entity entity = scene.rigidbodies.GetEntity(args.jobIndex);
+			RigidBodyFeedback& feedback = rigidbody_feedback[args.jobIndex];
+			feedback = {};
 
 			if (physicscomponent.physicsobject == nullptr)
 			{
 				TransformComponent& transform = *scene.transforms.GetComponent(entity);
 				const ObjectComponent* object = scene.objects.GetComponent(entity);
 				const MeshComponent* mesh = nullptr;
+				Entity meshID = INVALID_ENTITY;
 				if (object != nullptr)
 				{
 					mesh = scene.meshes.GetComponent(object->meshID);
+					meshID = object->meshID;
 				}
-				physicsLock.lock();
-				AddRigidBody(entity, physicscomponent, transform, mesh);
-				physicsLock.unlock();
+				AddRigidBody(entity, physicscomponent, transform, mesh, meshID);
 			}
 
 			if (physicscomponent.physicsobject != nullptr)
 			{
 				btRigidBody* rigidbody = (btRigidBody*)physicscomponent.physicsobject;
+				rigidbody->setUserPointer(&physicscomponent);
+				feedback.rigidbody = rigidbody;
+				feedback.physicscomponent = &physicscomponent;
+				feedback.transform = scene.transforms.GetComponent(entity);
 
 				int activationState = rigidbody->getActivationState();
 				if (physicscomponent.IsDisableDeactivation())
@@ -384,7 +1487,7 @@ namespace wi::physics
 				// For kinematic object, system updates physics state, else the physics updates system state:
 				if (physicscomponent.IsKinematic() || !IsSimulationEnabled())
 				{
-					TransformComponent& transform = *scene.transforms.GetComponent(entity);
+					TransformComponent& transform = *feedback.transform;
 
 					btMotionState* motionState = rigidbody->getMotionState();
 					btTransform physicsTransform;
@@ -396,6 +1499,8 @@ namespace wi::physics
 					physicsTransform.setOrigin(T);
 					physicsTransform.setRotation(R);
 					motionState->setWorldTransform(physicsTransform);
+					physicscomponent.previous_position = physicscomponent.current_position = position;
+					physicscomponent.previous_rotation = physicscomponent.current_rotation = rotation;
 
 					if (!IsSimulationEnabled())
 					{
@@ -403,10 +1508,14 @@ namespace wi::physics
 						rigidbody->setWorldTransform(physicsTransform);
 					}
 
-					btCollisionShape* shape = rigidbody->getCollisionShape();
 					XMFLOAT3 scale = transform.GetScale();
-					btVector3 S(scale.x, scale.y, scale.z);
-					shape->setLocalScaling(S);
+					const btVector3& S = rigidbody->getCollisionShape()->getLocalScaling();
+					if (S.x() != scale.x || S.y() != scale.y || S.z() != scale.z)
+					{
+						const ObjectComponent* object = scene.objects.GetComponent(entity);
+						Entity meshID = object == nullptr ? INVALID_ENTITY : object->meshID;
+						shapecache::SetInstanceScale(rigidbody, physicscomponent, scene.meshes.GetComponent(meshID), meshID, scale);
+					}
 				}
 			}
 		});
@@ -417,6 +1526,8 @@ namespace wi::physics
 			SoftBodyPhysicsComponent& physicscomponent = scene.softbodies[args.jobIndex];
 			Entity entity = scene.softbodies.GetEntity(args.jobIndex);
 			MeshComponent& mesh = *scene.meshes.GetComponent(entity);
+			SoftBodyFeedback& feedback = softbody_feedback[args.jobIndex];
+			feedback = {};
 			const ArmatureComponent* armature = mesh.IsSkinned() ? scene.armatures.GetComponent(mesh.armatureID) : nullptr;
 			mesh.SetDynamic(true);
 
@@ -426,21 +1537,27 @@ namespace wi::physics
 				if (physicscomponent.physicsobject != nullptr)
 				{
 					btSoftBody* softbody = (btSoftBody*)physicscomponent.physicsobject;
-					delete softbody;
+					physics_scene.locker.lock();
 					dynamicsWorld.removeSoftBody(softbody);
+					physics_scene.locker.unlock();
+					delete softbody;
 					physicscomponent.physicsobject = nullptr;
 				}
 			}
 			if (physicscomponent._flags & SoftBodyPhysicsComponent::SAFE_TO_REGISTER && physicscomponent.physicsobject == nullptr)
 			{
-				physicsLock.lock();
-				AddSoftBody(entity, physicscomponent, mesh);
-				physicsLock.unlock();
+				physics_scene.locker.lock();
+				AddSoftBody(physics_scene, entity, physicscomponent, mesh);
+				physics_scene.locker.unlock();
 			}
 
 			if (physicscomponent.physicsobject != nullptr)
 			{
 				btSoftBody* softbody = (btSoftBody*)physicscomponent.physicsobject;
+				softbody->setUserPointer(&physicscomponent);
+				feedback.softbody = softbody;
+				feedback.physicscomponent = &physicscomponent;
+				feedback.mesh = &mesh;
 				softbody->m_cfg.kDF = physicscomponent.friction;
 				softbody->setWindVelocity(wind);
 
@@ -451,6 +1568,7 @@ namespace wi::physics
 				XMMATRIX worldMatrix = XMLoadFloat4x4(&physicscomponent.worldMatrix);
 
 				// System controls zero weight soft body nodes:
+				const XMFLOAT3* skinned_positions = nullptr;
 				for (size_t ind = 0; ind < physicscomponent.weights.size(); ++ind)
 				{
 					float weight = physicscomponent.weights[ind];
@@ -459,8 +1577,12 @@ namespace wi::physics
 					{
 						btSoftBody::Node& node = softbody->m_nodes[(uint32_t)ind];
 						uint32_t graphicsInd = physicscomponent.physicsToGraphicsVertexMapping[ind];
-						XMFLOAT3 position = mesh.vertex_positions[graphicsInd];
-						XMVECTOR P = armature == nullptr ? XMLoadFloat3(&position) : wi::scene::SkinVertex(mesh, *armature, graphicsInd);
+						if (armature != nullptr && skinned_positions == nullptr)
+						{
+							skinned_positions = scene.GetSkinnedVertexPositions(entity, mesh, *armature);
+						}
+						XMFLOAT3 position = armature == nullptr ? mesh.vertex_positions[graphicsInd] : skinned_positions[graphicsInd];
+						XMVECTOR P = XMLoadFloat3(&position);
 						P = XMVector3Transform(P, worldMatrix);
 						XMStoreFloat3(&position, P);
 						node.m_x = btVector3(position.x, position.y, position.z);
@@ -471,172 +1593,263 @@ namespace wi::physics
 
 		wi::jobsystem::Wait(ctx);
 
-		// Perform internal simulation step:
+		// New rigid bodies are added in a fixed order, because the order of collision objects affects the simulation result:
+		for (size_t i = 0; i < scene.rigidbodies.GetCount(); ++i)
+		{
+			btRigidBody* rigidbody = (btRigidBody*)scene.rigidbodies[i].physicsobject;
+			if (rigidbody != nullptr && !rigidbody->isInWorld())
+			{
+				dynamicsWorld.addRigidBody(rigidbody);
+			}
+		}
+
+		// Perform internal simulation steps:
+		//	The frame time is accumulated and consumed in fixed steps, at most ACCURACY steps per frame.
+		//	Time that doesn't fit into the step budget is dropped, so a slow frame can't make the following frames even slower.
+		//	In deterministic mode, every update is exactly one fixed step.
+		physics_scene.last_step_count = 0;
 		if (IsSimulationEnabled())
 		{
-			dynamicsWorld.stepSimulation(dt, ACCURACY);
+			const float timestep = 1.0f / std::max(1.0f, FRAMERATE);
+			if (IsDeterministicEnabled())
+			{
+				physics_scene.accumulator = 0;
+				physics_scene.last_step_count = 1;
+			}
+			else
+			{
+				physics_scene.accumulator += dt;
+				physics_scene.last_step_count = std::min((int)(physics_scene.accumulator / timestep), std::max(1, ACCURACY));
+				physics_scene.accumulator -= physics_scene.last_step_count * timestep;
+				if (physics_scene.accumulator >= timestep)
+				{
+					physics_scene.accumulator = std::fmod(physics_scene.accumulator, timestep);
+				}
+				physics_scene.accumulator = std::max(0.0f, physics_scene.accumulator);
+			}
+			physics_scene.interpolation_alpha = IsInterpolationEnabled() && !IsDeterministicEnabled() ? physics_scene.accumulator / timestep : 1;
+
+			if (physics_scene.last_step_count > 0)
+			{
+				// Soft bodies write into each other's contact lists from the narrow phase, so they are only simulated serially:
+				const bool parallel = IsMultithreadingEnabled() && dynamicsWorld.getSoftBodyArray().size() == 0 && wi::jobsystem::GetThreadCount() > 1;
+				dispatcher.parallel = parallel;
+				dynamicsWorld.parallel = parallel;
+				dynamicsWorld.StepFixed(physics_scene.last_step_count, timestep, [&]() {
+					// The state before the last step is the start of interpolation:
+					ParallelFor((uint32_t)rigidbody_feedback.size(), 256, [&](uint32_t i) {
+						const RigidBodyFeedback& feedback = rigidbody_feedback[i];
+						if (feedback.rigidbody == nullptr || feedback.rigidbody->isStaticOrKinematicObject())
+							return;
+						const btTransform& physicsTransform = feedback.rigidbody->getWorldTransform();
+						const btVector3& T = physicsTransform.getOrigin();
+						const btQuaternion R = physicsTransform.getRotation();
+						feedback.physicscomponent->previous_position = XMFLOAT3(T.x(), T.y(), T.z());
+						feedback.physicscomponent->previous_rotation = XMFLOAT4(R.x(), R.y(), R.z(), R.w());
+					});
+				});
+			}
 		}
 
-		// Feedback physics engine state to system:
+		auto range_feedback = wi::profiler::BeginRangeCPU("Physics - Feedback");
+
+		// Remove collision objects that were not claimed by any component:
 		for (int i = 0; i < dynamicsWorld.getCollisionObjectArray().size(); ++i)
 		{
 			btCollisionObject* collisionobject = dynamicsWorld.getCollisionObjectArray()[i];
-			Entity entity = (Entity)collisionobject->getUserIndex();
+			if (collisionobject->getUserPointer() != nullptr)
+				continue;
 
 			btRigidBody* rigidbody = btRigidBody::upcast(collisionobject);
 			if (rigidbody != nullptr)
 			{
-				RigidBodyPhysicsComponent* physicscomponent = scene.rigidbodies.GetComponent(entity);
-				if (physicscomponent == nullptr || physicscomponent->physicsobject != rigidbody)
+				shapecache::DestroyInstance(rigidbody->getCollisionShape());
+				btMotionState* motionstate = rigidbody->getMotionState();
+				delete motionstate;
+				dynamicsWorld.removeRigidBody(rigidbody);
+				delete rigidbody;
+				i--;
+				continue;
+			}
+			btSoftBody* softbody = btSoftBody::upcast(collisionobject);
+			if (softbody != nullptr)
+			{
+				dynamicsWorld.removeSoftBody(softbody);
+				delete softbody;
+				i--;
+				continue;
+			}
+		}
+
+		// Feedback non-kinematic rigid bodies to system:
+		if (IsSimulationEnabled())
+		{
+			ParallelFor((uint32_t)rigidbody_feedback.size(), 256, [&](uint32_t i) {
+				const RigidBodyFeedback& feedback = rigidbody_feedback[i];
+				if (feedback.rigidbody == nullptr || feedback.physicscomponent->IsKinematic())
+					return;
+				RigidBodyPhysicsComponent* physicscomponent = feedback.physicscomponent;
+				TransformComponent& transform = *feedback.transform;
+
+				if (physics_scene.last_step_count > 0)
 				{
-					btCollisionShape* shape = rigidbody->getCollisionShape();
-					btTriangleIndexVertexArray* triangleinfo = (btTriangleIndexVertexArray*)shape->getUserPointer();
-					delete triangleinfo;
-					delete shape;
-					btMotionState* motionstate = rigidbody->getMotionState();
-					delete motionstate;
-					dynamicsWorld.removeRigidBody(rigidbody);
-					delete rigidbody;
-					i--;
-					continue;
+					const btTransform& physicsTransform = feedback.rigidbody->getWorldTransform();
+					const btVector3& T = physicsTransform.getOrigin();
+					const btQuaternion R = physicsTransform.getRotation();
+					physicscomponent->current_position = XMFLOAT3(T.x(), T.y(), T.z());
+					physicscomponent->current_rotation = XMFLOAT4(R.x(), R.y(), R.z(), R.w());
 				}
 
-				// Feedback non-kinematic objects to system:
-				if (IsSimulationEnabled() && !physicscomponent->IsKinematic())
+				// The rendered transform is interpolated between the last two simulation steps:
+				if (physics_scene.interpolation_alpha < 1)
 				{
-					TransformComponent& transform = *scene.transforms.GetComponent(entity);
-	
-					btTransform physicsTransform = rigidbody->getWorldTransform();
-					btVector3 T = physicsTransform.getOrigin();
-					btQuaternion R = physicsTransform.getRotation();
-
-					transform.translation_local = XMFLOAT3(T.x(), T.y(), T.z());
-					transform.rotation_local = XMFLOAT4(R.x(), R.y(), R.z(), R.w());
-					transform.SetDirty();
+					const XMVECTOR P0 = XMLoadFloat3(&physicscomponent->previous_position);
+					const XMVECTOR P1 = XMLoadFloat3(&physicscomponent->current_position);
+					const XMVECTOR Q0 = XMLoadFloat4(&physicscomponent->previous_rotation);
+					const XMVECTOR Q1 = XMLoadFloat4(&physicscomponent->current_rotation);
+					XMStoreFloat3(&transform.translation_local, XMVectorLerp(P0, P1, physics_scene.interpolation_alpha));
+					XMStoreFloat4(&transform.rotation_local, XMQuaternionNormalize(XMQuaternionSlerp(Q0, Q1, physics_scene.interpolation_alpha)));
 				}
-			}
-			else
-			{
-				btSoftBody* softbody = btSoftBody::upcast(collisionobject);
-
-				if (softbody != nullptr)
+				else
 				{
-					SoftBodyPhysicsComponent* physicscomponent = scene.softbodies.GetComponent(entity);
-					if (physicscomponent == nullptr || physicscomponent->physicsobject != softbody)
-					{
-						dynamicsWorld.removeSoftBody(softbody);
-						delete softbody;
-						i--;
-						continue;
-					}
-
-					MeshComponent& mesh = *scene.meshes.GetComponent(entity);
-
-					// System mesh aabb will be queried from physics engine soft body:
-					btVector3 aabb_min;
-					btVector3 aabb_max;
-					softbody->getAabb(aabb_min, aabb_max);
-					physicscomponent->aabb = wi::primitive::AABB(XMFLOAT3(aabb_min.x(), aabb_min.y(), aabb_min.z()), XMFLOAT3(aabb_max.x(), aabb_max.y(), aabb_max.z()));
-
-					// Soft body simulation nodes will update graphics mesh:
-					for (size_t ind = 0; ind < physicscomponent->vertex_positions_simulation.size(); ++ind)
-					{
-						uint32_t physicsInd = physicscomponent->graphicsToPhysicsVertexMapping[ind];
-						float weight = physicscomponent->weights[physicsInd];
-
-						btSoftBody::Node& node = softbody->m_nodes[physicsInd];
+					transform.translation_local = physicscomponent->current_position;
+					transform.rotation_local = physicscomponent->current_rotation;
+				}
+				transform.SetDirty();
+			});
+		}
 
-						MeshComponent::Vertex_POS& vertex = physicscomponent->vertex_positions_simulation[ind];
-						vertex.pos.x = node.m_x.getX();
-						vertex.pos.y = node.m_x.getY();
-						vertex.pos.z = node.m_x.getZ();
+		// Soft body simulation nodes will update graphics mesh, in vertex ranges:
+		for (const SoftBodyFeedback& feedback : softbody_feedback)
+		{
+			if (feedback.softbody == nullptr)
+				continue;
+			SoftBodyPhysicsComponent* physicscomponent = feedback.physicscomponent;
+			btSoftBody* softbody = feedback.softbody;
+
+			// System mesh aabb will be queried from physics engine soft body:
+			btVector3 aabb_min;
+			btVector3 aabb_max;
+			softbody->getAabb(aabb_min, aabb_max);
+			physicscomponent->aabb = wi::primitive::AABB(XMFLOAT3(aabb_min.x(), aabb_min.y(), aabb_min.z()), XMFLOAT3(aabb_max.x(), aabb_max.y(), aabb_max.z()));
+
+			ParallelFor((uint32_t)physicscomponent->vertex_positions_simulation.size(), 1024, [&](uint32_t ind) {
+				const uint32_t physicsInd = physicscomponent->graphicsToPhysicsVertexMapping[ind];
+				const btSoftBody::Node& node = softbody->m_nodes[physicsInd];
+
+				MeshComponent::Vertex_POS& vertex = physicscomponent->vertex_positions_simulation[ind];
+				vertex.pos.x = node.m_x.getX();
+				vertex.pos.y = node.m_x.getY();
+				vertex.pos.z = node.m_x.getZ();
+
+				XMFLOAT3 normal;
+				normal.x = -node.m_n.getX();
+				normal.y = -node.m_n.getY();
+				normal.z = -node.m_n.getZ();
+				vertex.MakeFromParams(normal);
+			});
+		}
 
-						XMFLOAT3 normal;
-						normal.x = -node.m_n.getX();
-						normal.y = -node.m_n.getY();
-						normal.z = -node.m_n.getZ();
-						vertex.MakeFromParams(normal);
-					}
+		// Update tangent vectors, one soft body per job because triangles accumulate into shared vertices:
+		ParallelFor((uint32_t)softbody_feedback.size(), 1, [&](uint32_t index) {
+			const SoftBodyFeedback& feedback = softbody_feedback[index];
+			if (feedback.softbody == nullptr)
+				return;
+			SoftBodyPhysicsComponent* physicscomponent = feedback.physicscomponent;
+			const MeshComponent& mesh = *feedback.mesh;
+			if (mesh.vertex_uvset_0.empty() || mesh.vertex_normals.empty())
+				return;
+
+			std::fill(physicscomponent->vertex_tangents_tmp.begin(), physicscomponent->vertex_tangents_tmp.end(), XMFLOAT4(0, 0, 0, 0));
+
+			uint32_t first_subset = 0;
+			uint32_t last_subset = 0;
+			mesh.GetLODSubsetRange(0, first_subset, last_subset);
+			for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+			{
+				const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
+				for (size_t i = 0; i < subset.indexCount; i += 3)
+				{
+					const uint32_t i0 = mesh.indices[subset.indexOffset + i + 0];
+					const uint32_t i1 = mesh.indices[subset.indexOffset + i + 1];
+					const uint32_t i2 = mesh.indices[subset.indexOffset + i + 2];
+
+					const XMFLOAT3 v0 = physicscomponent->vertex_positions_simulation[i0].pos;
+					const XMFLOAT3 v1 = physicscomponent->vertex_positions_simulation[i1].pos;
+					const XMFLOAT3 v2 = physicscomponent->vertex_positions_simulation[i2].pos;
+
+					const XMFLOAT2 u0 = mesh.vertex_uvset_0[i0];
+					const XMFLOAT2 u1 = mesh.vertex_uvset_0[i1];
+					const XMFLOAT2 u2 = mesh.vertex_uvset_0[i2];
+
+					const XMVECTOR nor0 = physicscomponent->vertex_positions_simulation[i0].LoadNOR();
+					const XMVECTOR nor1 = physicscomponent->vertex_positions_simulation[i1].LoadNOR();
+					const XMVECTOR nor2 = physicscomponent->vertex_positions_simulation[i2].LoadNOR();
+
+					const XMVECTOR facenormal = XMVector3Normalize(XMVectorAdd(XMVectorAdd(nor0, nor1), nor2));
+
+					const float x1 = v1.x - v0.x;
+					const float x2 = v2.x - v0.x;
+					const float y1 = v1.y - v0.y;
+					const float y2 = v2.y - v0.y;
+					const float z1 = v1.z - v0.z;
+					const float z2 = v2.z - v0.z;
+
+					const float s1 = u1.x - u0.x;
+					const float s2 = u2.x - u0.x;
+					const float t1 = u1.y - u0.y;
+					const float t2 = u2.y - u0.y;
+
+					const float r = 1.0f / (s1 * t2 - s2 * t1);
+					const XMVECTOR sdir = XMVectorSet((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
+						(t2 * z1 - t1 * z2) * r, 0);
+					const XMVECTOR tdir = XMVectorSet((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
+						(s1 * z2 - s2 * z1) * r, 0);
+
+					XMVECTOR tangent;
+					tangent = XMVector3Normalize(XMVectorSubtract(sdir, XMVectorMultiply(facenormal, XMVector3Dot(facenormal, sdir))));
+					float sign = XMVectorGetX(XMVector3Dot(XMVector3Cross(tangent, facenormal), tdir)) < 0.0f ? -1.0f : 1.0f;
+
+					XMFLOAT3 t;
+					XMStoreFloat3(&t, tangent);
+
+					physicscomponent->vertex_tangents_tmp[i0].x += t.x;
+					physicscomponent->vertex_tangents_tmp[i0].y += t.y;
+					physicscomponent->vertex_tangents_tmp[i0].z += t.z;
+					physicscomponent->vertex_tangents_tmp[i0].w = sign;
+
+					physicscomponent->vertex_tangents_tmp[i1].x += t.x;
+					physicscomponent->vertex_tangents_tmp[i1].y += t.y;
+					physicscomponent->vertex_tangents_tmp[i1].z += t.z;
+					physicscomponent->vertex_tangents_tmp[i1].w = sign;
+
+					physicscomponent->vertex_tangents_tmp[i2].x += t.x;
+					physicscomponent->vertex_tangents_tmp[i2].y += t.y;
+					physicscomponent->vertex_tangents_tmp[i2].z += t.z;
+					physicscomponent->vertex_tangents_tmp[i2].w = sign;
+				}
+			}
 
-					// Update tangent vectors:
-					if (!mesh.vertex_uvset_0.empty() && !mesh.vertex_normals.empty())
-					{
-						uint32_t first_subset = 0;
-						uint32_t last_subset = 0;
-						mesh.GetLODSubsetRange(0, first_subset, last_subset);
-						for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
-						{
-							const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
-							for (size_t i = 0; i < subset.indexCount; i += 3)
-							{
-								const uint32_t i0 = mesh.indices[i + 0];
-								const uint32_t i1 = mesh.indices[i + 1];
-								const uint32_t i2 = mesh.indices[i + 2];
-
-								const XMFLOAT3 v0 = physicscomponent->vertex_positions_simulation[i0].pos;
-								const XMFLOAT3 v1 = physicscomponent->vertex_positions_simulation[i1].pos;
-								const XMFLOAT3 v2 = physicscomponent->vertex_positions_simulation[i2].pos;
-
-								const XMFLOAT2 u0 = mesh.vertex_uvset_0[i0];
-								const XMFLOAT2 u1 = mesh.vertex_uvset_0[i1];
-								const XMFLOAT2 u2 = mesh.vertex_uvset_0[i2];
-
-								const XMVECTOR nor0 = physicscomponent->vertex_positions_simulation[i0].LoadNOR();
-								const XMVECTOR nor1 = physicscomponent->vertex_positions_simulation[i1].LoadNOR();
-								const XMVECTOR nor2 = physicscomponent->vertex_positions_simulation[i2].LoadNOR();
-
-								const XMVECTOR facenormal = XMVector3Normalize(XMVectorAdd(XMVectorAdd(nor0, nor1), nor2));
-
-								const float x1 = v1.x - v0.x;
-								const float x2 = v2.x - v0.x;
-								const float y1 = v1.y - v0.y;
-								const float y2 = v2.y - v0.y;
-								const float z1 = v1.z - v0.z;
-								const float z2 = v2.z - v0.z;
-
-								const float s1 = u1.x - u0.x;
-								const float s2 = u2.x - u0.x;
-								const float t1 = u1.y - u0.y;
-								const float t2 = u2.y - u0.y;
-
-								const float r = 1.0f / (s1 * t2 - s2 * t1);
-								const XMVECTOR sdir = XMVectorSet((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r,
-									(t2 * z1 - t1 * z2) * r, 0);
-								const XMVECTOR tdir = XMVectorSet((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r,
-									(s1 * z2 - s2 * z1) * r, 0);
-
-								XMVECTOR tangent;
-								tangent = XMVector3Normalize(XMVectorSubtract(sdir, XMVectorMultiply(facenormal, XMVector3Dot(facenormal, sdir))));
-								float sign = XMVectorGetX(XMVector3Dot(XMVector3Cross(tangent, facenormal), tdir)) < 0.0f ? -1.0f : 1.0f;
-
-								XMFLOAT3 t;
-								XMStoreFloat3(&t, tangent);
-
-								physicscomponent->vertex_tangents_tmp[i0].x += t.x;
-								physicscomponent->vertex_tangents_tmp[i0].y += t.y;
-								physicscomponent->vertex_tangents_tmp[i0].z += t.z;
-								physicscomponent->vertex_tangents_tmp[i0].w = sign;
-
-								physicscomponent->vertex_tangents_tmp[i1].x += t.x;
-								physicscomponent->vertex_tangents_tmp[i1].y += t.y;
-								physicscomponent->vertex_tangents_tmp[i1].z += t.z;
-								physicscomponent->vertex_tangents_tmp[i1].w = sign;
-
-								physicscomponent->vertex_tangents_tmp[i2].x += t.x;
-								physicscomponent->vertex_tangents_tmp[i2].y += t.y;
-								physicscomponent->vertex_tangents_tmp[i2].z += t.z;
-								physicscomponent->vertex_tangents_tmp[i2].w = sign;
-							}
-						}
+			for (size_t i = 0; i < physicscomponent->vertex_tangents_simulation.size(); ++i)
+			{
+				physicscomponent->vertex_tangents_simulation[i].FromFULL(physicscomponent->vertex_tangents_tmp[i]);
+			}
+		});
 
-						for (size_t i = 0; i < physicscomponent->vertex_tangents_simulation.size(); ++i)
-						{
-							physicscomponent->vertex_tangents_simulation[i].FromFULL(physicscomponent->vertex_tangents_tmp[i]);
-						}
-					}
+		wi::profiler::EndRange(range_feedback); // Physics - Feedback
 
-				}
-			}
+		// When the world becomes empty, the broadphase ids and solver random state are reset,
+		//	so a new simulation of the same scene will produce the same results as the first one:
+		if (!physics_scene.world_reset && dynamicsWorld.getNumCollisionObjects() == 0)
+		{
+			physics_scene.broadphase.resetPool(&dispatcher);
+			dynamicsWorld.ResetSolverState();
+			physics_scene.accumulator = 0;
+			physics_scene.world_reset = true;
+		}
+		else if (dynamicsWorld.getNumCollisionObjects() > 0)
+		{
+			physics_scene.world_reset = false;
 		}
 
 		if (IsDebugDrawEnabled())
@@ -708,4 +1921,285 @@ namespace wi::physics
 			rigidbody->applyTorque(btVector3(torque.x, torque.y, torque.z));
 		}
 	}
+
+
+	// The queries traverse the broadphase trees with btDbvt::rayTest() and btDbvt::collideTV(), because these use local stacks,
+	//	while btDbvtBroadphase::rayTest() uses a persistent stack that can't be shared between threads
+	namespace query
+	{
+		// Calls callback(btRigidBody*) for rigid bodies whose bounds are intersected by the ray segment
+		template<typename T>
+		void RayBroadphase(const btDbvtBroadphase& broadphase, const btVector3& from, const btVector3& to, const T& callback)
+		{
+			struct Policy : btDbvt::ICollide
+			{
+				const T& callback;
+				Policy(const T& callback) : callback(callback) {}
+				void Process(const btDbvtNode* leaf) override
+				{
+					btCollisionObject* collisionobject = (btCollisionObject*)((btDbvtProxy*)leaf->data)->m_clientObject;
+					btRigidBody* rigidbody = btRigidBody::upcast(collisionobject);
+					if (rigidbody != nullptr)
+					{
+						callback(rigidbody);
+					}
+				}
+			} policy(callback);
+			btDbvt::rayTest(broadphase.m_sets[0].m_root, from, to, policy);
+			btDbvt::rayTest(broadphase.m_sets[1].m_root, from, to, policy);
+		}
+		// Calls callback(btRigidBody*) for rigid bodies whose bounds overlap the bounds
+		template<typename T>
+		void AABBBroadphase(const btDbvtBroadphase& broadphase, const btVector3& aabb_min, const btVector3& aabb_max, const T& callback)
+		{
+			struct Policy : btDbvt::ICollide
+			{
+				const T& callback;
+				Policy(const T& callback) : callback(callback) {}
+				void Process(const btDbvtNode* leaf) override
+				{
+					btCollisionObject* collisionobject = (btCollisionObject*)((btDbvtProxy*)leaf->data)->m_clientObject;
+					btRigidBody* rigidbody = btRigidBody::upcast(collisionobject);
+					if (rigidbody != nullptr)
+					{
+						callback(rigidbody);
+					}
+				}
+			} policy(callback);
+			const ATTRIBUTE_ALIGNED16(btDbvtVolume) bounds = btDbvtVolume::FromMM(aabb_min, aabb_max);
+			broadphase.m_sets[0].collideTV(broadphase.m_sets[0].m_root, bounds, policy);
+			broadphase.m_sets[1].collideTV(broadphase.m_sets[1].m_root, bounds, policy);
+		}
+
+		// Clips the parametric range of a ray to the bounds of the physics world, returns false if it misses the world
+		bool ClipToWorld(const btDbvtBroadphase& broadphase, const btVector3& origin, const btVector3& direction, float& tmin, float& tmax)
+		{
+			btVector3 world_min(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+			btVector3 world_max(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+			for (const btDbvt& set : broadphase.m_sets)
+			{
+				if (set.m_root != nullptr)
+				{
+					world_min.setMin(set.m_root->volume.Mins());
+					world_max.setMax(set.m_root->volume.Maxs());
+				}
+			}
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (std::abs(direction[axis]) < SIMD_EPSILON)
+				{
+					if (origin[axis] < world_min[axis] || origin[axis] > world_max[axis])
+						return false;
+					continue;
+				}
+				float t0 = (world_min[axis] - origin[axis]) / direction[axis];
+				float t1 = (world_max[axis] - origin[axis]) / direction[axis];
+				if (t0 > t1)
+				{
+					std::swap(t0, t1);
+				}
+				tmin = std::max(tmin, t0);
+				tmax = std::min(tmax, t1);
+			}
+			return tmin <= tmax;
+		}
+
+		// Reports whether a sphere overlaps a collision shape, concave and compound shapes are tested per convex part
+		bool SphereOverlap(const btSphereShape& sphere, const btTransform& sphereTransform, const btCollisionShape* shape, const btTransform& shapeTransform)
+		{
+			if (shape->isConvex())
+			{
+				btVoronoiSimplexSolver simplexSolver;
+				btGjkEpaPenetrationDepthSolver penetrationSolver;
+				btGjkPairDetector detector(&sphere, (const btConvexShape*)shape, &simplexSolver, &penetrationSolver);
+				btGjkPairDetector::ClosestPointInput input;
+				input.m_transformA = sphereTransform;
+				input.m_transformB = shapeTransform;
+				btPointCollector output;
+				detector.getClosestPoints(input, output, nullptr);
+				return output.m_hasResult && output.m_distance <= 0;
+			}
+			if (shape->isCompound())
+			{
+				const btCompoundShape* compound = (const btCompoundShape*)shape;
+				for (int i = 0; i < compound->getNumChildShapes(); ++i)
+				{
+					if (SphereOverlap(sphere, sphereTransform, compound->getChildShape(i), shapeTransform * compound->getChildTransform(i)))
+						return true;
+				}
+				return false;
+			}
+			if (shape->isConcave())
+			{
+				struct Callback : btTriangleCallback
+				{
+					const btSphereShape& sphere;
+					btTransform sphereTransform;
+					bool overlap = false;
+					Callback(const btSphereShape& sphere, const btTransform& sphereTransform) : sphere(sphere), sphereTransform(sphereTransform) {}
+					void processTriangle(btVector3* triangle, int partId, int triangleIndex) override
+					{
+						if (overlap)
+							return;
+						btTriangleShape triangleShape(triangle[0], triangle[1], triangle[2]);
+						btTransform identity;
+						identity.setIdentity();
+						overlap = SphereOverlap(sphere, sphereTransform, &triangleShape, identity);
+					}
+				};
+				// The triangles are tested in the local space of the shape:
+				const btTransform local = shapeTransform.inverse() * sphereTransform;
+				const btVector3 extent(sphere.getRadius(), sphere.getRadius(), sphere.getRadius());
+				Callback callback(sphere, local);
+				((const btConcaveShape*)shape)->processAllTriangles(&callback, local.getOrigin() - extent, local.getOrigin() + extent);
+				return callback.overlap;
+			}
+			return false;
+		}
+	}
+
+	void RayCast(const wi::scene::Scene& scene, const wi::primitive::Ray* rays, RayHit* hits, size_t count, bool any_hit)
+	{
+		const PhysicsScene* physics_scene = GetPhysicsScene(scene);
+		if (physics_scene == nullptr)
+		{
+			std::fill(hits, hits + count, RayHit());
+			return;
+		}
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)count, 64, [&](wi::jobsystem::JobArgs args) {
+			const wi::primitive::Ray& ray = rays[args.jobIndex];
+			RayHit& hit = hits[args.jobIndex];
+			hit = {};
+
+			const btVector3 origin(ray.origin.x, ray.origin.y, ray.origin.z);
+			const btVector3 direction(ray.direction.x, ray.direction.y, ray.direction.z);
+			float tmin = ray.TMin;
+			float tmax = ray.TMax;
+			if (!query::ClipToWorld(physics_scene->broadphase, origin, direction, tmin, tmax))
+				return;
+
+			btTransform rayFrom;
+			rayFrom.setIdentity();
+			rayFrom.setOrigin(origin + direction * tmin);
+			btTransform rayTo;
+			rayTo.setIdentity();
+			rayTo.setOrigin(origin + direction * tmax);
+
+			btCollisionWorld::ClosestRayResultCallback result(rayFrom.getOrigin(), rayTo.getOrigin());
+			query::RayBroadphase(physics_scene->broadphase, rayFrom.getOrigin(), rayTo.getOrigin(), [&](btRigidBody* rigidbody) {
+				if (any_hit && result.hasHit())
+					return;
+				btCollisionWorld::rayTestSingle(rayFrom, rayTo, rigidbody, rigidbody->getCollisionShape(), rigidbody->getWorldTransform(), result);
+			});
+
+			if (result.hasHit())
+			{
+				hit.entity = (Entity)result.m_collisionObject->getUserIndex();
+				hit.position = XMFLOAT3(result.m_hitPointWorld.x(), result.m_hitPointWorld.y(), result.m_hitPointWorld.z());
+				const btVector3 normal = result.m_hitNormalWorld.normalized();
+				hit.normal = XMFLOAT3(normal.x(), normal.y(), normal.z());
+				hit.distance = origin.distance(result.m_hitPointWorld);
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+	}
+
+	void SphereCast(const wi::scene::Scene& scene, const SphereSweep* sweeps, RayHit* hits, size_t count)
+	{
+		const PhysicsScene* physics_scene = GetPhysicsScene(scene);
+		if (physics_scene == nullptr)
+		{
+			std::fill(hits, hits + count, RayHit());
+			return;
+		}
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)count, 64, [&](wi::jobsystem::JobArgs args) {
+			const SphereSweep& sweep = sweeps[args.jobIndex];
+			RayHit& hit = hits[args.jobIndex];
+			hit = {};
+
+			const btVector3 origin(sweep.sphere.center.x, sweep.sphere.center.y, sweep.sphere.center.z);
+			const btVector3 direction = btVector3(sweep.direction.x, sweep.direction.y, sweep.direction.z).normalized();
+			const btVector3 target = origin + direction * sweep.distance;
+			const btVector3 extent(sweep.sphere.radius, sweep.sphere.radius, sweep.sphere.radius);
+
+			btSphereShape sphere(sweep.sphere.radius);
+			btTransform castFrom;
+			castFrom.setIdentity();
+			castFrom.setOrigin(origin);
+			btTransform castTo;
+			castTo.setIdentity();
+			castTo.setOrigin(target);
+
+			btVector3 aabb_min = origin;
+			btVector3 aabb_max = origin;
+			aabb_min.setMin(target);
+			aabb_max.setMax(target);
+
+			btCollisionWorld::ClosestConvexResultCallback result(origin, target);
+			query::AABBBroadphase(physics_scene->broadphase, aabb_min - extent, aabb_max + extent, [&](btRigidBody* rigidbody) {
+				btCollisionWorld::objectQuerySingle(&sphere, castFrom, castTo, rigidbody, rigidbody->getCollisionShape(), rigidbody->getWorldTransform(), result, 0);
+			});
+
+			if (result.hasHit())
+			{
+				hit.entity = (Entity)result.m_hitCollisionObject->getUserIndex();
+				hit.position = XMFLOAT3(result.m_hitPointWorld.x(), result.m_hitPointWorld.y(), result.m_hitPointWorld.z());
+				const btVector3 normal = result.m_hitNormalWorld.normalized();
+				hit.normal = XMFLOAT3(normal.x(), normal.y(), normal.z());
+				hit.distance = sweep.distance * result.m_closestHitFraction;
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+	}
+
+	void Overlap(const wi::scene::Scene& scene, const wi::primitive::Sphere* spheres, OverlapRange* ranges, size_t count, wi::vector<wi::ecs::Entity>& entities)
+	{
+		entities.clear();
+		const PhysicsScene* physics_scene = GetPhysicsScene(scene);
+		if (physics_scene == nullptr)
+		{
+			std::fill(ranges, ranges + count, OverlapRange());
+			return;
+		}
+
+		// Every job group collects its results separately, then they are concatenated in query order:
+		const uint32_t groupSize = 64;
+		const uint32_t groupCount = ((uint32_t)count + groupSize - 1) / groupSize;
+		wi::vector<wi::vector<Entity>> group_entities(groupCount);
+
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)count, groupSize, [&](wi::jobsystem::JobArgs args) {
+			const wi::primitive::Sphere& query = spheres[args.jobIndex];
+			wi::vector<Entity>& results = group_entities[args.groupID];
+			OverlapRange& range = ranges[args.jobIndex];
+			range.offset = (uint32_t)results.size();
+
+			btSphereShape sphere(query.radius);
+			btTransform sphereTransform;
+			sphereTransform.setIdentity();
+			sphereTransform.setOrigin(btVector3(query.center.x, query.center.y, query.center.z));
+			const btVector3 extent(query.radius, query.radius, query.radius);
+
+			query::AABBBroadphase(physics_scene->broadphase, sphereTransform.getOrigin() - extent, sphereTransform.getOrigin() + extent, [&](btRigidBody* rigidbody) {
+				if (query::SphereOverlap(sphere, sphereTransform, rigidbody->getCollisionShape(), rigidbody->getWorldTransform()))
+				{
+					results.push_back((Entity)rigidbody->getUserIndex());
+				}
+			});
+			range.count = (uint32_t)results.size() - range.offset;
+		});
+		wi::jobsystem::Wait(ctx);
+
+		for (uint32_t groupID = 0; groupID < groupCount; ++groupID)
+		{
+			const uint32_t group_offset = (uint32_t)entities.size();
+			for (uint32_t i = groupID * groupSize; i < std::min((uint32_t)count, (groupID + 1) * groupSize); ++i)
+			{
+				ranges[i].offset += group_offset;
+			}
+			entities.insert(entities.end(), group_entities[groupID].begin(), group_entities[groupID].end());
+		}
+	}
 }
@@ -56,12 +56,14 @@ namespace wi::profiler
 		bool IsCPURange() const { return !cmd.IsValid(); }
 	};
 	wi::unordered_map<size_t, Range> ranges;
+	wi::unordered_map<std::string, uint64_t> counters;
 
 	void BeginFrame()
 	{
 		if (ENABLED_REQUEST != ENABLED)
 		{
 			ranges.clear();
+			counters.clear();
 			ENABLED = ENABLED_REQUEST;
 		}
 
@@ -268,6 +270,16 @@ namespace wi::profiler
 		lock.unlock();
 	}
 
+	void SetCounter(const char* name, uint64_t value)
+	{
+		if (!ENABLED || !initialized)
+			return;
+
+		lock.lock();
+		counters[name] = value;
+		lock.unlock();
+	}
+
 	struct Hits
 	{
 		uint32_t num_hits = 0;
@@ -344,6 +356,18 @@ namespace wi::profiler
 			x.second.total_time = 0;
 		}
 
+		// Print counters:
+		if (!counters.empty())
+		{
+			ss << std::endl << "Counters:" << std::endl;
+			lock.lock();
+			for (auto& x : counters)
+			{
+				ss << "\t" << x.first << ": " << x.second << std::endl;
+			}
+			lock.unlock();
+		}
+
 		wi::font::Params params = wi::font::Params(x, y, wi::font::WIFONTSIZE_DEFAULT - 4, wi::font::WIFALIGN_LEFT, wi::font::WIFALIGN_TOP, wi::Color(255, 255, 255, 255), wi::Color(0, 0, 0, 255));
 
 		wi::image::Params fx;
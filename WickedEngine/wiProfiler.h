@@ -21,6 +21,9 @@ namespace wi::profiler
 	// End a profiling range
 	void EndRange(range_id id);
 
+	// Set the value of a named counter (for example uploaded bytes or draw call counts), it will be displayed with the ranges
+	void SetCounter(const char* name, uint64_t value);
+
 	// Renders a basic text of the Profiling results to the (x,y) screen coordinate
 	void DrawData(
 		const wi::Canvas& canvas,
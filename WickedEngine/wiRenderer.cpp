@@ -19,6 +19,7 @@
 #include "wiSheenLUT.h"
 #include "wiShaderCompiler.h"
 #include "wiTimer.h"
+#include "wiSort.h"
 #include "wiUnorderedMap.h" // leave it here for shader dump!
 
 #include "shaders/ShaderInterop_Postprocess.h"
@@ -84,6 +85,7 @@ bool variableRateShadingClassificationDebug = false;
 float GameSpeed = 1;
 bool debugLightCulling = false;
 bool occlusionCulling = false;
+bool occlusionCullingCPU = false;
 bool temporalAA = false;
 bool temporalAADEBUG = false;
 uint32_t raytraceBounceCount = 3;
@@ -145,81 +147,65 @@ Texture texture_detailNoise;
 Texture texture_curlNoise;
 Texture texture_weatherMap;
 
-// Direct reference to a renderable instance:
-struct RenderBatch
-{
-	uint64_t data;
-
-	inline void Create(uint32_t meshIndex, uint32_t instanceIndex, float distance)
-	{
-		// These asserts are a indicating if render queue limits are reached:
-		assert(meshIndex < 0x00FFFFFF);
-		assert(instanceIndex < 0x00FFFFFF);
-
-		data = 0;
-		data |= uint64_t(meshIndex & 0x00FFFFFF) << 40ull;
-		data |= uint64_t(XMConvertFloatToHalf(distance) & 0xFFFF) << 24ull;
-		data |= uint64_t(instanceIndex & 0x00FFFFFF) << 0ull;
-	}
 
-	inline float GetDistance() const
-	{
-		return XMConvertHalfToFloat(HALF((data >> 24ull) & 0xFFFF));
-	}
-	inline uint32_t GetMeshIndex() const
-	{
-		return (data >> 40ull) & 0x00FFFFFF;
-	}
-	inline uint32_t GetInstanceIndex() const
-	{
-		return (data >> 0ull) & 0x00FFFFFF;
-	}
-
-	// opaque sorting
-	//	Priority is set to mesh index to have more instancing
-	//	distance is second priority (front to back Z-buffering)
-	bool operator<(const RenderBatch& other) const
-	{
-		return data < other.data;
-	}
-	// transparent sorting
-	//	Priority is distance for correct alpha blending (back to front rendering)
-	//	mesh index is second priority for instancing
-	bool operator>(const RenderBatch& other) const
+// Returns a 6-bit key of the pipeline states that a mesh will likely use, so render queues can be sorted to reduce state changes
+//	The material of the first subset is used, because a render batch always refers to a whole mesh
+inline uint8_t GetMeshPipelineKey(const Scene& scene, uint32_t meshIndex)
+{
+	const MeshComponent& mesh = scene.meshes[meshIndex];
+	if (mesh.subsets.empty() || mesh.subsets[0].materialIndex >= scene.materials.GetCount())
+		return 0;
+	const MaterialComponent& material = scene.materials[mesh.subsets[0].materialIndex];
+	static constexpr uint32_t builtin_count = MaterialComponent::SHADERTYPE_COUNT * BLENDMODE_COUNT;
+	static_assert(builtin_count < 0x40, "Pipeline key of built-in shaders must fit into 6 bits!");
+	if (material.IsCustomShader())
 	{
-		// Swap bits of meshIndex and distance to prioritize distance more
-		uint64_t a_data = 0ull;
-		a_data |= ((data >> 24ull) & 0xFFFF) << 48ull; // distance repack
-		a_data |= ((data >> 40ull) & 0x00FFFFFF) << 24ull; // meshIndex repack
-		a_data |= data & 0x00FFFFFF; // instanceIndex repack
-		uint64_t b_data = 0ull;
-		b_data |= ((other.data >> 24ull) & 0xFFFF) << 48ull; // distance repack
-		b_data |= ((other.data >> 40ull) & 0x00FFFFFF) << 24ull; // meshIndex repack
-		b_data |= other.data & 0x00FFFFFF; // instanceIndex repack
-		return a_data > b_data;
+		return uint8_t(builtin_count + uint32_t(material.GetCustomShaderID()) % (0x40 - builtin_count));
 	}
-};
+	return uint8_t(material.shaderType * BLENDMODE_COUNT + material.GetBlendMode());
+}
 
 // This is a utility that points to a linear array of render batches:
 struct RenderQueue
 {
 	wi::vector<RenderBatch> batches;
+	wi::vector<uint64_t> sort_scratch; // render queues are thread_local, so this memory is reused per thread
+	mutable MeshDrawGrouping grouping; // scratch memory of RenderMeshes(), reused with the render queue
 
 	inline void init()
 	{
 		batches.clear();
 	}
-	inline void add(uint32_t meshIndex, uint32_t instanceIndex, float distance)
+	inline void add(uint32_t meshIndex, uint32_t instanceIndex, float distance, uint8_t pipelineKey)
 	{
-		batches.emplace_back().Create(meshIndex, instanceIndex, distance);
+		batches.emplace_back().Create(meshIndex, instanceIndex, distance, pipelineKey);
 	}
 	inline void sort_transparent()
 	{
-		std::sort(batches.begin(), batches.end(), std::greater<RenderBatch>());
+		// Keys are inverted, so that ascending radix sort results in back to front order:
+		for (auto& batch : batches)
+		{
+			batch.data = ~batch.GetTransparentSortKey();
+		}
+		sort_keys();
+		for (auto& batch : batches)
+		{
+			batch.SetFromTransparentSortKey(~batch.data);
+		}
 	}
 	inline void sort_opaque()
 	{
-		std::sort(batches.begin(), batches.end(), std::less<RenderBatch>());
+		sort_keys();
+	}
+	inline void sort_keys()
+	{
+		if (sort_scratch.size() < batches.size())
+		{
+			sort_scratch.resize(batches.size());
+		}
+		// Render queues are thread_local and sorted inside render jobs, so the sort must not wait for other jobs:
+		//	a job picked up by this thread while waiting could use the same render queue
+		wi::sort::RadixSort((uint64_t*)batches.data(), sort_scratch.data(), batches.size());
 	}
 	inline bool empty() const
 	{
@@ -2385,67 +2371,261 @@ ForwardEntityMaskCB ForwardEntityCullingCPU(const Visibility& vis, const AABB& b
 	return cb;
 }
 
-void RenderMeshes(
-	const Visibility& vis,
-	const RenderQueue& renderQueue,
-	RENDERPASS renderPass,
-	uint32_t renderTypeFlags,
-	CommandList cmd,
-	bool tessellation = false,
-	const Frustum* frusta = nullptr,
-	uint32_t frustum_count = 1
-)
+// Computes the range of clusters that an AABB overlaps, returns false if it is outside the clustered bounds
+static bool GetForwardEntityClusterRange(const ForwardEntityClusters& clusters, const AABB& aabb, uint32_t range_min[3], uint32_t range_max[3])
 {
-	if (renderQueue.empty())
-		return;
+	if (!aabb.intersects(clusters.bounds))
+		return false;
+	const float aabb_min[] = { aabb._min.x, aabb._min.y, aabb._min.z };
+	const float aabb_max[] = { aabb._max.x, aabb._max.y, aabb._max.z };
+	const float bounds_min[] = { clusters.bounds._min.x, clusters.bounds._min.y, clusters.bounds._min.z };
+	const float scale[] = { clusters.cell_scale.x, clusters.cell_scale.y, clusters.cell_scale.z };
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		// The same monotonic mapping is used for entities and batches, so overlapping boxes always share a cluster:
+		const float lo = std::floor((aabb_min[axis] - bounds_min[axis]) * scale[axis]);
+		const float hi = std::floor((aabb_max[axis] - bounds_min[axis]) * scale[axis]);
+		range_min[axis] = (uint32_t)wi::math::Clamp(lo, 0.0f, float(ForwardEntityClusters::GRID_DIM - 1));
+		range_max[axis] = (uint32_t)wi::math::Clamp(hi, 0.0f, float(ForwardEntityClusters::GRID_DIM - 1));
+	}
+	return true;
+}
+inline uint32_t GetForwardEntityClusterIndex(uint32_t x, uint32_t y, uint32_t z)
+{
+	return x + y * ForwardEntityClusters::GRID_DIM + z * ForwardEntityClusters::GRID_DIM * ForwardEntityClusters::GRID_DIM;
+}
 
-	device->EventBegin("RenderMeshes", cmd);
+void ForwardEntityClusters::Build(const Visibility& vis, const AABB& bounds, RENDERPASS renderPass)
+{
+	this->vis = &vis;
+	this->bounds = bounds;
+	this->renderPass = renderPass;
+	const XMFLOAT3 size = bounds.getHalfWidth();
+	cell_scale.x = size.x > 0 ? float(GRID_DIM) / (size.x * 2) : 0;
+	cell_scale.y = size.y > 0 ? float(GRID_DIM) / (size.y * 2) : 0;
+	cell_scale.z = size.z > 0 ? float(GRID_DIM) / (size.z * 2) : 0;
+	std::memset(clusters, 0, sizeof(clusters));
 
-	tessellation = tessellation && device->CheckCapability(GraphicsDeviceCapability::TESSELLATION);
-	
-	// Do we need to compute a light mask for this pass on the CPU?
-	const bool forwardLightmaskRequest =
-		renderPass == RENDERPASS_ENVMAPCAPTURE ||
-		renderPass == RENDERPASS_VOXELIZE;
+	// Bit indices are assigned the same way as in ForwardEntityCullingCPU():
+	uint32_t range_min[3];
+	uint32_t range_max[3];
+	for (size_t i = 0; i < std::min(size_t(64), vis.visibleLights.size()); ++i)
+	{
+		const uint32_t lightIndex = vis.visibleLights[i];
+		if (!GetForwardEntityClusterRange(*this, vis.scene->aabb_lights[lightIndex], range_min, range_max))
+			continue;
+		for (uint32_t z = range_min[2]; z <= range_max[2]; ++z)
+			for (uint32_t y = range_min[1]; y <= range_max[1]; ++y)
+				for (uint32_t x = range_min[0]; x <= range_max[0]; ++x)
+					clusters[GetForwardEntityClusterIndex(x, y, z)].lightMask |= 1ull << i;
+	}
+	for (size_t i = 0; i < std::min(size_t(32), vis.visibleDecals.size()); ++i)
+	{
+		const uint32_t decalIndex = vis.visibleDecals[vis.visibleDecals.size() - 1 - i]; // note: reverse order, for correct blending!
+		if (!GetForwardEntityClusterRange(*this, vis.scene->aabb_decals[decalIndex], range_min, range_max))
+			continue;
+		for (uint32_t z = range_min[2]; z <= range_max[2]; ++z)
+			for (uint32_t y = range_min[1]; y <= range_max[1]; ++y)
+				for (uint32_t x = range_min[0]; x <= range_max[0]; ++x)
+					clusters[GetForwardEntityClusterIndex(x, y, z)].decalMask |= 1u << i;
+	}
+	if (renderPass != RENDERPASS_ENVMAPCAPTURE)
+	{
+		for (size_t i = 0; i < std::min(size_t(32), vis.visibleEnvProbes.size()); ++i)
+		{
+			const uint32_t probeIndex = vis.visibleEnvProbes[vis.visibleEnvProbes.size() - 1 - i]; // note: reverse order, for correct blending!
+			if (!GetForwardEntityClusterRange(*this, vis.scene->aabb_probes[probeIndex], range_min, range_max))
+				continue;
+			for (uint32_t z = range_min[2]; z <= range_max[2]; ++z)
+				for (uint32_t y = range_min[1]; y <= range_max[1]; ++y)
+					for (uint32_t x = range_min[0]; x <= range_max[0]; ++x)
+						clusters[GetForwardEntityClusterIndex(x, y, z)].envprobeMask |= 1u << i;
+		}
+	}
+}
 
-	// Pre-allocate space for all the instances in GPU-buffer:
-	const size_t alloc_size = renderQueue.size() * frustum_count * sizeof(ShaderMeshInstancePointer);
-	const GraphicsDevice::GPUAllocation instances = device->AllocateGPU(alloc_size, cmd);
-	const int instanceBufferDescriptorIndex = device->GetDescriptorIndex(&instances.buffer, SubresourceType::SRV);
+ForwardEntityMaskCB ForwardEntityClusters::Cull(const AABB& batch_aabb) const
+{
+	ForwardEntityMaskCB cb;
+	cb.xForwardLightMask.x = 0;
+	cb.xForwardLightMask.y = 0;
+	cb.xForwardDecalMask = 0;
+	cb.xForwardEnvProbeMask = 0;
+	if (vis == nullptr)
+		return cb;
 
-	// This will correspond to a single draw call
-	//	It's used to render multiple instances of a single mesh
-	struct InstancedBatch
+	uint32_t range_min[3];
+	uint32_t range_max[3];
+	if (!GetForwardEntityClusterRange(*this, batch_aabb, range_min, range_max))
 	{
-		uint32_t meshIndex = ~0u;
-		uint32_t instanceCount = 0;
-		uint32_t dataOffset = 0;
-		uint8_t userStencilRefOverride = 0;
-		bool forceAlphatestForDithering = false;
-		AABB aabb;
-		uint32_t lod = 0;
-	} instancedBatch = {};
+		// Outside of the clustered bounds, this shouldn't happen but the result will still be correct:
+		return ForwardEntityCullingCPU(*vis, batch_aabb, renderPass);
+	}
 
+	// Gather the candidates from the overlapped clusters:
+	uint64_t lightMask = 0;
+	uint32_t decalMask = 0;
+	uint32_t envprobeMask = 0;
+	for (uint32_t z = range_min[2]; z <= range_max[2]; ++z)
+	{
+		for (uint32_t y = range_min[1]; y <= range_max[1]; ++y)
+		{
+			for (uint32_t x = range_min[0]; x <= range_max[0]; ++x)
+			{
+				const Cluster& cluster = clusters[GetForwardEntityClusterIndex(x, y, z)];
+				lightMask |= cluster.lightMask;
+				decalMask |= cluster.decalMask;
+				envprobeMask |= cluster.envprobeMask;
+			}
+		}
+	}
 
-	// This will be called every time we start a new draw call:
-	auto batch_flush = [&]()
+	// Only the candidates are tested precisely:
+	uint64_t lightResult = 0;
+	for (size_t i = 0; lightMask != 0; ++i, lightMask >>= 1)
 	{
-		if (instancedBatch.instanceCount == 0)
-			return;
-		const MeshComponent& mesh = vis.scene->meshes[instancedBatch.meshIndex];
-		const bool forceAlphaTestForDithering = instancedBatch.forceAlphatestForDithering != 0;
-		const uint8_t userStencilRefOverride = instancedBatch.userStencilRefOverride;
+		if ((lightMask & 1) && vis->scene->aabb_lights[vis->visibleLights[i]].intersects(batch_aabb))
+		{
+			lightResult |= 1ull << i;
+		}
+	}
+	cb.xForwardLightMask.x = uint32_t(lightResult);
+	cb.xForwardLightMask.y = uint32_t(lightResult >> 32ull);
 
-		const float tessF = mesh.GetTessellationFactor();
-		const bool tessellatorRequested = tessF > 0 && tessellation;
+	for (size_t i = 0; decalMask != 0; ++i, decalMask >>= 1)
+	{
+		if ((decalMask & 1) && vis->scene->aabb_decals[vis->visibleDecals[vis->visibleDecals.size() - 1 - i]].intersects(batch_aabb))
+		{
+			cb.xForwardDecalMask |= 1u << i;
+		}
+	}
 
-		if (forwardLightmaskRequest)
+	for (size_t i = 0; envprobeMask != 0; ++i, envprobeMask >>= 1)
+	{
+		if ((envprobeMask & 1) && vis->scene->aabb_probes[vis->visibleEnvProbes[vis->visibleEnvProbes.size() - 1 - i]].intersects(batch_aabb))
 		{
-			ForwardEntityMaskCB cb = ForwardEntityCullingCPU(vis, instancedBatch.aabb, renderPass);
-			device->BindDynamicConstantBuffer(cb, CB_GETBINDSLOT(ForwardEntityMaskCB), cmd);
+			cb.xForwardEnvProbeMask |= 1u << i;
 		}
+	}
 
-		device->BindIndexBuffer(&mesh.generalBuffer, mesh.GetIndexFormat(), mesh.ib.offset, cmd);
+	return cb;
+}
+
+void MeshDrawGrouping::GroupInstances(
+	const Scene& scene,
+	const RenderBatch* batches,
+	size_t count,
+	bool orderIndependent,
+	bool mergeAABBs,
+	const Frustum* frusta,
+	uint32_t frustum_count
+)
+{
+	assert(frustum_count <= 8); // frustum mask must fit in 8 bits
+	instancedBatches.clear();
+	batchLookup.clear();
+	subsetDraws.clear();
+	queueBatchIndices.resize(count);
+	queueFrustumMasks.resize(count);
+	consecutiveBatchCount = 0;
+	instanceCount = 0;
+
+	uint64_t prevKey = ~0ull;
+	uint32_t prevBatchIndex = ~0u;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const RenderBatch& batch = batches[i];
+		const uint32_t meshIndex = batch.GetMeshIndex();
+		const uint32_t instanceIndex = batch.GetInstanceIndex();
+		const ObjectComponent& instance = scene.objects[instanceIndex];
+		const AABB& instanceAABB = scene.aabb_objects[instanceIndex];
+		const uint8_t userStencilRefOverride = instance.userStencilRef;
+
+		const uint64_t key = (uint64_t(meshIndex) << 32ull) | (uint64_t(instance.lod & 0x00FFFFFF) << 8ull) | uint64_t(userStencilRefOverride);
+		uint32_t batchIndex = prevBatchIndex;
+		if (key != prevKey)
+		{
+			consecutiveBatchCount++;
+			batchIndex = ~0u;
+			if (orderIndependent)
+			{
+				auto it = batchLookup.find(key);
+				if (it != batchLookup.end())
+				{
+					batchIndex = it->second;
+				}
+			}
+			if (batchIndex == ~0u)
+			{
+				// When we encounter a new mesh inside the global instance array, we begin a new InstancedBatch:
+				batchIndex = (uint32_t)instancedBatches.size();
+				InstancedBatch& instancedBatch = instancedBatches.emplace_back();
+				instancedBatch.meshIndex = meshIndex;
+				instancedBatch.userStencilRefOverride = userStencilRefOverride;
+				instancedBatch.lod = instance.lod;
+				if (orderIndependent)
+				{
+					batchLookup[key] = batchIndex;
+				}
+			}
+			prevKey = key;
+			prevBatchIndex = batchIndex;
+		}
+		InstancedBatch& instancedBatch = instancedBatches[batchIndex];
+
+		const float dither = std::max(instance.GetTransparency(), std::max(0.0f, batch.GetDistance() - instance.fadeDistance) / instance.radius);
+		if (dither > 0)
+		{
+			instancedBatch.forceAlphatestForDithering = true;
+		}
+
+		if (mergeAABBs)
+		{
+			instancedBatch.aabb = AABB::Merge(instancedBatch.aabb, instanceAABB);
+		}
+
+		uint8_t frustumMask = 0;
+		for (uint32_t frustum_index = 0; frustum_index < frustum_count; ++frustum_index)
+		{
+			if (frusta != nullptr && !frusta[frustum_index].CheckBoxFast(instanceAABB))
+			{
+				// In case multiple cameras were provided and no intersection detected with frustum, we don't add the instance for the face:
+				continue;
+			}
+			frustumMask |= 1u << frustum_index;
+			instancedBatch.instanceCount++;
+		}
+		queueBatchIndices[i] = batchIndex;
+		queueFrustumMasks[i] = frustumMask;
+	}
+
+	// Allocate contiguous instance ranges for batches:
+	for (auto& instancedBatch : instancedBatches)
+	{
+		instancedBatch.instanceOffset = instanceCount;
+		instanceCount += instancedBatch.instanceCount;
+	}
+}
+
+void MeshDrawGrouping::GatherSubsetDraws(
+	const Scene& scene,
+	RENDERPASS renderPass,
+	uint32_t renderTypeFlags,
+	bool tessellation,
+	bool sortByPipeline
+)
+{
+	subsetDraws.clear();
+	for (uint32_t batchIndex = 0; batchIndex < (uint32_t)instancedBatches.size(); ++batchIndex)
+	{
+		const InstancedBatch& instancedBatch = instancedBatches[batchIndex];
+		if (instancedBatch.instanceCount == 0)
+			continue;
+		const MeshComponent& mesh = scene.meshes[instancedBatch.meshIndex];
+		const bool forceAlphaTestForDithering = instancedBatch.forceAlphatestForDithering;
+
+		const float tessF = mesh.GetTessellationFactor();
+		const bool tessellatorRequested = tessF > 0 && tessellation;
 
 		uint32_t first_subset = 0;
 		uint32_t last_subset = 0;
@@ -2457,7 +2637,7 @@ void RenderMeshes(
 			{
 				continue;
 			}
-			const MaterialComponent& material = vis.scene->materials[subset.materialIndex];
+			const MaterialComponent& material = scene.materials[subset.materialIndex];
 
 			bool subsetRenderable = renderTypeFlags & material.GetRenderTypes();
 
@@ -2472,7 +2652,7 @@ void RenderMeshes(
 			}
 
 			const PipelineState* pso = nullptr;
-			const PipelineState* pso_backside = nullptr; // only when separate backside rendering is required (transparent doublesided)
+			const PipelineState* pso_backside = nullptr;
 			{
 				if (IsWireRender())
 				{
@@ -2512,99 +2692,180 @@ void RenderMeshes(
 				continue;
 			}
 
-			STENCILREF engineStencilRef = material.engineStencilRef;
-			uint8_t userStencilRef = userStencilRefOverride > 0 ? userStencilRefOverride : material.userStencilRef;
-			uint32_t stencilRef = CombineStencilrefs(engineStencilRef, userStencilRef);
-			device->BindStencilRef(stencilRef, cmd);
+			assert(subsetIndex < 256u); // subsets must be represented as 8-bit
 
-			if (renderPass != RENDERPASS_PREPASS && renderPass != RENDERPASS_VOXELIZE) // depth only alpha test will be full res
-			{
-				device->BindShadingRate(material.shadingRate, cmd);
-			}
+			SubsetDraw& draw = subsetDraws.emplace_back();
+			draw.pso = pso;
+			draw.pso_backside = pso_backside;
+			draw.batchIndex = batchIndex;
+			draw.subsetIndex = subsetIndex;
+		}
+	}
 
-			assert(subsetIndex < 256u); // subsets must be represented as 8-bit
+	if (sortByPipeline)
+	{
+		std::sort(subsetDraws.begin(), subsetDraws.end(), [](const SubsetDraw& a, const SubsetDraw& b) {
+			if (a.pso != b.pso)
+				return a.pso < b.pso;
+			if (a.batchIndex != b.batchIndex)
+				return a.batchIndex < b.batchIndex;
+			return a.subsetIndex < b.subsetIndex;
+		});
+	}
+}
 
-			ObjectPushConstants push;
-			push.geometryIndex = mesh.geometryOffset + subsetIndex;
-			push.materialIndex = subset.materialIndex;
-			push.instances = instanceBufferDescriptorIndex;
-			push.instance_offset = (uint)instancedBatch.dataOffset;
+// Instancing statistics of RenderMeshes(), these are reported to the profiler once per frame:
+struct RenderMeshesStats
+{
+	std::atomic<uint32_t> consecutiveBatches{ 0 }; // instanced batches if only neighbouring render queue entries were merged
+	std::atomic<uint32_t> mergedBatches{ 0 }; // instanced batches after merging
+	std::atomic<uint32_t> drawCalls{ 0 };
+} renderMeshesStats;
 
-			if (pso_backside != nullptr)
-			{
-				device->BindPipelineState(pso_backside, cmd);
-				device->PushConstants(&push, sizeof(push), cmd);
-				device->DrawIndexedInstanced(subset.indexCount, instancedBatch.instanceCount, subset.indexOffset, 0, 0, cmd);
-			}
+void RenderMeshes(
+	const Visibility& vis,
+	const RenderQueue& renderQueue,
+	RENDERPASS renderPass,
+	uint32_t renderTypeFlags,
+	CommandList cmd,
+	bool tessellation = false,
+	const Frustum* frusta = nullptr,
+	uint32_t frustum_count = 1
+)
+{
+	if (renderQueue.empty())
+		return;
 
-			device->BindPipelineState(pso, cmd);
-			device->PushConstants(&push, sizeof(push), cmd);
-			device->DrawIndexedInstanced(subset.indexCount, instancedBatch.instanceCount, subset.indexOffset, 0, 0, cmd);
+	device->EventBegin("RenderMeshes", cmd);
 
-		}
-	};
+	tessellation = tessellation && device->CheckCapability(GraphicsDeviceCapability::TESSELLATION);
+	
+	// Do we need to compute a light mask for this pass on the CPU?
+	const bool forwardLightmaskRequest =
+		renderPass == RENDERPASS_ENVMAPCAPTURE ||
+		renderPass == RENDERPASS_VOXELIZE;
 
-	// The following loop is writing the instancing batches to a GPUBuffer:
-	//	RenderQueue is sorted based on mesh index, so when a new mesh or stencil request is encountered, we need to flush the batch
-	uint32_t instanceCount = 0;
-	for (const RenderBatch& batch : renderQueue.batches) // Do not break out of this loop!
-	{
-		const uint32_t meshIndex = batch.GetMeshIndex();
-		const uint32_t instanceIndex = batch.GetInstanceIndex();
-		const ObjectComponent& instance = vis.scene->objects[instanceIndex];
-		const AABB& instanceAABB = vis.scene->aabb_objects[instanceIndex];
-		const uint8_t userStencilRefOverride = instance.userStencilRef;
+	// Pre-allocate space for all the instances in GPU-buffer:
+	const size_t alloc_size = renderQueue.size() * frustum_count * sizeof(ShaderMeshInstancePointer);
+	const GraphicsDevice::GPUAllocation instances = device->AllocateGPU(alloc_size, cmd);
+	const int instanceBufferDescriptorIndex = device->GetDescriptorIndex(&instances.buffer, SubresourceType::SRV);
 
-		// When we encounter a new mesh inside the global instance array, we begin a new RenderBatch:
-		if (meshIndex != instancedBatch.meshIndex ||
-			userStencilRefOverride != instancedBatch.userStencilRefOverride ||
-			instance.lod != instancedBatch.lod
-			)
-		{
-			batch_flush();
+	// When the draw order doesn't matter, instances of the same mesh can be merged into the same batch
+	//	even if they are not next to each other in the render queue (for example when stencil or LOD is interleaved)
+	const bool orderIndependent =
+		!(renderTypeFlags & (RENDERTYPE_TRANSPARENT | RENDERTYPE_WATER)) ||
+		renderPass == RENDERPASS_SHADOW ||
+		renderPass == RENDERPASS_SHADOWCUBE;
 
-			instancedBatch = {};
-			instancedBatch.meshIndex = meshIndex;
-			instancedBatch.instanceCount = 0;
-			instancedBatch.dataOffset = (uint32_t)(instances.offset + instanceCount * sizeof(ShaderMeshInstancePointer));
-			instancedBatch.userStencilRefOverride = userStencilRefOverride;
-			instancedBatch.forceAlphatestForDithering = 0;
-			instancedBatch.aabb = AABB();
-			instancedBatch.lod = instance.lod;
-		}
+	// 1.) Assign render queue entries to instanced batches and allocate instance ranges:
+	MeshDrawGrouping& grouping = renderQueue.grouping;
+	grouping.GroupInstances(*vis.scene, renderQueue.batches.data(), renderQueue.batches.size(), orderIndependent, forwardLightmaskRequest, frusta, frustum_count);
+	auto& instancedBatches = grouping.instancedBatches;
 
-		const float dither = std::max(instance.GetTransparency(), std::max(0.0f, batch.GetDistance() - instance.fadeDistance) / instance.radius);
-		if (dither > 0)
+	// Forward entity masks are computed once per batch, using a cluster grid that is built once for this pass:
+	wi::vector<ForwardEntityMaskCB> batchEntityMasks;
+	if (forwardLightmaskRequest)
+	{
+		ForwardEntityClusters forwardEntityClusters;
+		AABB bounds;
+		for (const auto& instancedBatch : instancedBatches)
 		{
-			instancedBatch.forceAlphatestForDithering = 1;
+			bounds = AABB::Merge(bounds, instancedBatch.aabb);
 		}
-
-		if (forwardLightmaskRequest)
+		forwardEntityClusters.Build(vis, bounds, renderPass);
+		batchEntityMasks.resize(instancedBatches.size());
+		for (size_t i = 0; i < instancedBatches.size(); ++i)
 		{
-			instancedBatch.aabb = AABB::Merge(instancedBatch.aabb, instanceAABB);
+			batchEntityMasks[i] = forwardEntityClusters.Cull(instancedBatches[i].aabb);
 		}
+	}
+
+	// 2.) Write the instances into the GPU buffer:
+	for (size_t i = 0; i < renderQueue.batches.size(); ++i)
+	{
+		const RenderBatch& batch = renderQueue.batches[i];
+		const uint32_t instanceIndex = batch.GetInstanceIndex();
+		const ObjectComponent& instance = vis.scene->objects[instanceIndex];
+		MeshDrawGrouping::InstancedBatch& instancedBatch = instancedBatches[grouping.queueBatchIndices[i]];
+		const uint8_t frustumMask = grouping.queueFrustumMasks[i];
+
+		const float dither = std::max(instance.GetTransparency(), std::max(0.0f, batch.GetDistance() - instance.fadeDistance) / instance.radius);
 
 		for (uint32_t frustum_index = 0; frustum_index < frustum_count; ++frustum_index)
 		{
-			if (frusta != nullptr && !frusta[frustum_index].CheckBoxFast(instanceAABB))
-			{
-				// In case multiple cameras were provided and no intersection detected with frustum, we don't add the instance for the face:
+			if ((frustumMask & (1u << frustum_index)) == 0)
 				continue;
-			}
 
 			ShaderMeshInstancePointer poi;
 			poi.Create(instanceIndex, frustum_index, dither);
 
 			// Write into actual GPU-buffer:
-			std::memcpy((ShaderMeshInstancePointer*)instances.data + instanceCount, &poi, sizeof(poi)); // memcpy whole structure into mapped pointer to avoid read from uncached memory
+			std::memcpy((ShaderMeshInstancePointer*)instances.data + instancedBatch.instanceOffset + instancedBatch.instanceWritten, &poi, sizeof(poi)); // memcpy whole structure into mapped pointer to avoid read from uncached memory
+			instancedBatch.instanceWritten++;
+		}
+	}
+
+	// 3.) Gather subset draws of all batches:
+	//	When order doesn't matter, draws are grouped by pipeline state to reduce state changes
+	//	Forward light masks are bound per batch, so in that case the batch order is kept
+	grouping.GatherSubsetDraws(*vis.scene, renderPass, renderTypeFlags, tessellation, orderIndependent && !forwardLightmaskRequest);
+
+	// 4.) Record the draw calls:
+	uint32_t boundBatchIndex = ~0u;
+	uint32_t drawCount = 0;
+	for (const MeshDrawGrouping::SubsetDraw& draw : grouping.subsetDraws)
+	{
+		const MeshDrawGrouping::InstancedBatch& instancedBatch = instancedBatches[draw.batchIndex];
+		const MeshComponent& mesh = vis.scene->meshes[instancedBatch.meshIndex];
+		const MeshComponent::MeshSubset& subset = mesh.subsets[draw.subsetIndex];
+		const MaterialComponent& material = vis.scene->materials[subset.materialIndex];
 
-			instancedBatch.instanceCount++; // next instance in current InstancedBatch
-			instanceCount++;
+		if (draw.batchIndex != boundBatchIndex)
+		{
+			if (forwardLightmaskRequest)
+			{
+				device->BindDynamicConstantBuffer(batchEntityMasks[draw.batchIndex], CB_GETBINDSLOT(ForwardEntityMaskCB), cmd);
+			}
+			if (boundBatchIndex == ~0u || instancedBatches[boundBatchIndex].meshIndex != instancedBatch.meshIndex)
+			{
+				device->BindIndexBuffer(&mesh.generalBuffer, mesh.GetIndexFormat(), mesh.ib.offset, cmd);
+			}
+			boundBatchIndex = draw.batchIndex;
 		}
 
+		STENCILREF engineStencilRef = material.engineStencilRef;
+		uint8_t userStencilRef = instancedBatch.userStencilRefOverride > 0 ? instancedBatch.userStencilRefOverride : material.userStencilRef;
+		uint32_t stencilRef = CombineStencilrefs(engineStencilRef, userStencilRef);
+		device->BindStencilRef(stencilRef, cmd);
+
+		if (renderPass != RENDERPASS_PREPASS && renderPass != RENDERPASS_VOXELIZE) // depth only alpha test will be full res
+		{
+			device->BindShadingRate(material.shadingRate, cmd);
+		}
+
+		ObjectPushConstants push;
+		push.geometryIndex = mesh.geometryOffset + draw.subsetIndex;
+		push.materialIndex = subset.materialIndex;
+		push.instances = instanceBufferDescriptorIndex;
+		push.instance_offset = (uint)(instances.offset + instancedBatch.instanceOffset * sizeof(ShaderMeshInstancePointer));
+
+		if (draw.pso_backside != nullptr)
+		{
+			device->BindPipelineState(draw.pso_backside, cmd);
+			device->PushConstants(&push, sizeof(push), cmd);
+			device->DrawIndexedInstanced(subset.indexCount, instancedBatch.instanceCount, subset.indexOffset, 0, 0, cmd);
+			drawCount++;
+		}
+
+		device->BindPipelineState(draw.pso, cmd);
+		device->PushConstants(&push, sizeof(push), cmd);
+		device->DrawIndexedInstanced(subset.indexCount, instancedBatch.instanceCount, subset.indexOffset, 0, 0, cmd);
+		drawCount++;
 	}
 
-	batch_flush();
+	renderMeshesStats.consecutiveBatches.fetch_add(grouping.consecutiveBatchCount);
+	renderMeshesStats.mergedBatches.fetch_add((uint32_t)instancedBatches.size());
+	renderMeshesStats.drawCalls.fetch_add(drawCount);
 
 	device->EventEnd(cmd);
 }
@@ -2688,6 +2949,8 @@ void UpdateVisibility(Visibility& vis)
 		vis.frustum = vis.camera->frustum;
 	}
 
+	const bool occlusion_cpu = (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING) && (vis.flags & Visibility::ALLOW_OBJECTS) && GetOcclusionCullingCPUEnabled() && !GetFreezeCullingCameraEnabled();
+
 	if (!GetOcclusionCullingEnabled() || GetFreezeCullingCameraEnabled())
 	{
 		vis.flags &= ~Visibility::ALLOW_OCCLUSION_CULLING;
@@ -2920,6 +3183,60 @@ void UpdateVisibility(Visibility& vis)
 	vis.visibleDecals.resize((size_t)vis.decal_counter.load());
 	vis.visibleLights.resize((size_t)vis.light_counter.load());
 
+	if (occlusion_cpu && !vis.visibleObjects.empty())
+	{
+		auto range_occlusion = wi::profiler::BeginRangeCPU("Occlusion Culling (CPU)");
+
+		// Visible occluders are rasterized with their first LOD:
+		vis.occlusionBuffer.Begin(vis.camera->GetViewProjection());
+		for (uint32_t instanceIndex : vis.visibleObjects)
+		{
+			const ObjectComponent& object = vis.scene->objects[instanceIndex];
+			if (!object.IsOccluder() || object.mesh_index >= vis.scene->meshes.GetCount())
+				continue;
+			const MeshComponent& mesh = vis.scene->meshes[object.mesh_index];
+			if (mesh.IsSkinned() || vis.scene->softbodies.Contains(object.meshID))
+				continue; // deformed geometry doesn't match the vertex positions on the CPU
+			const XMMATRIX W = XMLoadFloat4x4(&object.worldMatrix);
+			uint32_t first_subset = 0;
+			uint32_t last_subset = 0;
+			mesh.GetLODSubsetRange(0, first_subset, last_subset);
+			for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+			{
+				const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
+				if (subset.indexCount == 0 || subset.indexOffset + subset.indexCount > (uint32_t)mesh.indices.size())
+					continue;
+				vis.occlusionBuffer.AddOccluder(
+					mesh.vertex_positions.data(),
+					(uint32_t)mesh.vertex_positions.size(),
+					mesh.indices.data() + subset.indexOffset,
+					subset.indexCount,
+					W
+				);
+			}
+		}
+		vis.occlusionBuffer.Rasterize();
+
+		// Test the bounding boxes of every visible object against the occluders:
+		vis.occludedObjectsCPU.resize(vis.visibleObjects.size());
+		std::atomic<uint32_t> occluded_count{ 0 };
+		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.visibleObjects.size(), groupSize, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t instanceIndex = vis.visibleObjects[args.jobIndex];
+			const ObjectComponent& object = vis.scene->objects[instanceIndex];
+			// Occluders are not tested, they would be occluded by themselves:
+			const bool occluded = !object.IsOccluder() && vis.occlusionBuffer.IsOccluded(vis.scene->aabb_objects[instanceIndex]);
+			vis.occludedObjectsCPU[args.jobIndex] = occluded ? 1 : 0;
+			if (occluded)
+			{
+				occluded_count.fetch_add(1);
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		wi::profiler::SetCounter("CPU occlusion culled objects", occluded_count.load());
+		wi::profiler::EndRange(range_occlusion);
+	}
+
 	if (vis.scene->weather.IsOceanEnabled())
 	{
 		bool occluded = false;
@@ -2950,6 +3267,11 @@ void UpdatePerFrameData(
 	float dt
 )
 {
+	// Report instancing statistics of the previous frame:
+	wi::profiler::SetCounter("RenderMeshes instanced batches (consecutive)", renderMeshesStats.consecutiveBatches.exchange(0));
+	wi::profiler::SetCounter("RenderMeshes instanced batches (merged)", renderMeshesStats.mergedBatches.exchange(0));
+	wi::profiler::SetCounter("RenderMeshes draw calls", renderMeshesStats.drawCalls.exchange(0));
+
 	// Update Voxelization parameters:
 	if (scene.objects.GetCount() > 0)
 	{
@@ -3130,6 +3452,12 @@ void UpdatePerFrameData(
 	frameCB.time_previous = frameCB.time;
 	frameCB.time += frameCB.delta_time;
 	frameCB.frame_count = (uint)device->GetFrameCount();
+
+	// The CPU ocean evaluation uses the time of the GPU simulation, so that the queries match the rendered surface:
+	if (scene.weather.IsOceanEnabled() && scene.ocean.cpu_dim > 0)
+	{
+		scene.ocean.UpdateDisplacementMapCPU(scene.weather.oceanParameters, frameCB.time);
+	}
 	frameCB.blue_noise_phase = (frameCB.frame_count & 0xFF) * 1.6180339887f;
 
 	frameCB.voxelradiance_max_distance = voxelSceneData.maxDistance;
@@ -3349,44 +3677,21 @@ void UpdateRenderData(
 	device->UpdateBuffer(&constantBuffers[CBTYPE_FRAME], &frameCB, cmd);
 	barrier_stack.push_back(GPUBarrier::Buffer(&constantBuffers[CBTYPE_FRAME], ResourceState::COPY_DST, ResourceState::CONSTANT_BUFFER));
 
-	if (vis.scene->instanceBuffer.IsValid() && vis.scene->instanceArraySize > 0)
-	{
-		device->CopyBuffer(
-			&vis.scene->instanceBuffer,
-			0,
-			&vis.scene->instanceUploadBuffer[device->GetBufferIndex()],
-			0,
-			vis.scene->instanceArraySize * sizeof(ShaderMeshInstance),
-			cmd
-		);
-		barrier_stack.push_back(GPUBarrier::Buffer(&vis.scene->instanceBuffer, ResourceState::COPY_DST, ResourceState::SHADER_RESOURCE));
-	}
-
-	if (vis.scene->geometryBuffer.IsValid() && vis.scene->geometryArraySize > 0)
-	{
-		device->CopyBuffer(
-			&vis.scene->geometryBuffer,
-			0,
-			&vis.scene->geometryUploadBuffer[device->GetBufferIndex()],
-			0,
-			vis.scene->geometryArraySize * sizeof(ShaderGeometry),
-			cmd
-		);
-		barrier_stack.push_back(GPUBarrier::Buffer(&vis.scene->geometryBuffer, ResourceState::COPY_DST, ResourceState::SHADER_RESOURCE));
-	}
-
-	if (vis.scene->materialBuffer.IsValid() && vis.scene->materialArraySize > 0)
-	{
-		device->CopyBuffer(
-			&vis.scene->materialBuffer,
-			0,
-			&vis.scene->materialUploadBuffer[device->GetBufferIndex()],
-			0,
-			vis.scene->materialArraySize * sizeof(ShaderMaterial),
-			cmd
-		);
-		barrier_stack.push_back(GPUBarrier::Buffer(&vis.scene->materialBuffer, ResourceState::COPY_DST, ResourceState::SHADER_RESOURCE));
-	}
+	// Only the changed ranges of scene data are copied, see GPUArrayTracker:
+	auto copy_tracked_ranges = [&](const GPUBuffer& dst, const GPUBuffer& src, const GPUArrayTracker& tracker) {
+		if (!dst.IsValid() || tracker.copy_ranges.empty())
+			return;
+		for (auto& range : tracker.copy_ranges)
+		{
+			device->CopyBuffer(&dst, range.offset, &src, range.offset, range.size, cmd);
+		}
+		tracker.SetConsumed();
+		barrier_stack.push_back(GPUBarrier::Buffer(&dst, ResourceState::COPY_DST, ResourceState::SHADER_RESOURCE));
+	};
+	copy_tracked_ranges(vis.scene->instanceBuffer, vis.scene->instanceUploadBuffer[device->GetBufferIndex()], vis.scene->instanceTracker);
+	copy_tracked_ranges(vis.scene->geometryBuffer, vis.scene->geometryUploadBuffer[device->GetBufferIndex()], vis.scene->geometryTracker);
+	copy_tracked_ranges(vis.scene->materialBuffer, vis.scene->materialUploadBuffer[device->GetBufferIndex()], vis.scene->materialTracker);
+	wi::profiler::SetCounter("Scene data upload (bytes)", vis.scene->instanceTracker.upload_size + vis.scene->geometryTracker.upload_size + vis.scene->materialTracker.upload_size);
 
 	// Fill Entity Array with decals + envprobes + lights in the frustum:
 	{
@@ -4709,7 +5014,7 @@ void DrawShadowmaps(
 							{
 								Entity cullable_entity = vis.scene->aabb_objects.GetEntity(i);
 
-								renderQueue.add(object.mesh_index, uint32_t(i), 0);
+								renderQueue.add(object.mesh_index, uint32_t(i), 0, GetMeshPipelineKey(*vis.scene, object.mesh_index));
 
 								if (object.GetRenderTypes() & RENDERTYPE_TRANSPARENT || object.GetRenderTypes() & RENDERTYPE_WATER)
 								{
@@ -4721,6 +5026,9 @@ void DrawShadowmaps(
 
 					if (!renderQueue.empty())
 					{
+						// Sorting by mesh index groups instances of the same mesh together for instancing:
+						renderQueue.sort_opaque();
+
 						CameraCB cb;
 						XMStoreFloat4x4(&cb.view_projection, shcams[cascade].view_projection);
 						device->BindDynamicConstantBuffer(cb, CBSLOT_RENDERER_CAMERA, cmd);
@@ -4763,7 +5071,7 @@ void DrawShadowmaps(
 						{
 							Entity cullable_entity = vis.scene->aabb_objects.GetEntity(i);
 
-							renderQueue.add(object.mesh_index, uint32_t(i), 0);
+							renderQueue.add(object.mesh_index, uint32_t(i), 0, GetMeshPipelineKey(*vis.scene, object.mesh_index));
 
 							if (object.GetRenderTypes() & RENDERTYPE_TRANSPARENT || object.GetRenderTypes() & RENDERTYPE_WATER)
 							{
@@ -4774,6 +5082,9 @@ void DrawShadowmaps(
 				}
 				if (!renderQueue.empty())
 				{
+					// Sorting by mesh index groups instances of the same mesh together for instancing:
+					renderQueue.sort_opaque();
+
 					if (predicationRequest && light.occlusionquery >= 0)
 						device->PredicationBegin(
 							&vis.scene->queryPredicationBuffer,
@@ -4823,7 +5134,7 @@ void DrawShadowmaps(
 						{
 							Entity cullable_entity = vis.scene->aabb_objects.GetEntity(i);
 
-							renderQueue.add(object.mesh_index, uint32_t(i), 0);
+							renderQueue.add(object.mesh_index, uint32_t(i), 0, GetMeshPipelineKey(*vis.scene, object.mesh_index));
 
 							if (object.GetRenderTypes() & RENDERTYPE_TRANSPARENT || object.GetRenderTypes() & RENDERTYPE_WATER)
 							{
@@ -4834,6 +5145,9 @@ void DrawShadowmaps(
 				}
 				if (!renderQueue.empty())
 				{
+					// Sorting by mesh index groups instances of the same mesh together for instancing:
+					renderQueue.sort_opaque();
+
 					if (predicationRequest && light.occlusionquery >= 0)
 						device->PredicationBegin(
 							&vis.scene->queryPredicationBuffer,
@@ -4912,6 +5226,7 @@ void DrawScene(
 	const bool hairparticle = flags & DRAWSCENE_HAIRPARTICLE;
 	const bool impostor = flags & DRAWSCENE_IMPOSTOR;
 	const bool occlusion = (flags & DRAWSCENE_OCCLUSIONCULLING) && GetOcclusionCullingEnabled();
+	const bool occlusion_cpu = (flags & DRAWSCENE_OCCLUSIONCULLING) && !vis.occludedObjectsCPU.empty();
 
 	device->EventBegin("DrawScene", cmd);
 	device->BindShadingRate(ShadingRate::RATE_1X1, cmd);
@@ -4959,13 +5274,17 @@ void DrawScene(
 
 	static thread_local RenderQueue renderQueue;
 	renderQueue.init();
-	for (uint32_t instanceIndex : vis.visibleObjects)
+	for (size_t visibleIndex = 0; visibleIndex < vis.visibleObjects.size(); ++visibleIndex)
 	{
+		const uint32_t instanceIndex = vis.visibleObjects[visibleIndex];
 		const ObjectComponent& object = vis.scene->objects[instanceIndex];
 
 		if (occlusion && object.IsOccluded())
 			continue;
 
+		if (occlusion_cpu && vis.IsOccludedCPU(visibleIndex))
+			continue;
+
 		if (object.IsRenderable() && (object.GetRenderTypes() & renderTypeFlags))
 		{
 			const float distance = wi::math::Distance(vis.camera->Eye, object.center);
@@ -4973,7 +5292,7 @@ void DrawScene(
 			{
 				continue;
 			}
-			renderQueue.add(object.mesh_index, instanceIndex, distance);
+			renderQueue.add(object.mesh_index, instanceIndex, distance, GetMeshPipelineKey(*vis.scene, object.mesh_index));
 		}
 	}
 	if (!renderQueue.empty())
@@ -6311,7 +6630,7 @@ void RefreshEnvProbes(const Visibility& vis, CommandList cmd)
 					const ObjectComponent& object = vis.scene->objects[i];
 					if (object.IsRenderable())
 					{
-						renderQueue.add(object.mesh_index, uint32_t(i), 0);
+						renderQueue.add(object.mesh_index, uint32_t(i), 0, GetMeshPipelineKey(*vis.scene, object.mesh_index));
 					}
 				}
 			}
@@ -6560,7 +6879,7 @@ void VoxelRadiance(const Visibility& vis, CommandList cmd)
 			const ObjectComponent& object = vis.scene->objects[i];
 			if (object.IsRenderable())
 			{
-				renderQueue.add(object.mesh_index, uint32_t(i), 0);
+				renderQueue.add(object.mesh_index, uint32_t(i), 0, GetMeshPipelineKey(*vis.scene, object.mesh_index));
 			}
 		}
 	}
@@ -12836,6 +13155,8 @@ void SetOcclusionCullingEnabled(bool value)
 	occlusionCulling = value;
 }
 bool GetOcclusionCullingEnabled() { return occlusionCulling; }
+void SetOcclusionCullingCPUEnabled(bool enabled) { occlusionCullingCPU = enabled; }
+bool GetOcclusionCullingCPUEnabled() { return occlusionCullingCPU; }
 void SetTemporalAAEnabled(bool enabled) { temporalAA = enabled; }
 bool GetTemporalAAEnabled() { return temporalAA; }
 void SetTemporalAADebugEnabled(bool enabled) { temporalAADEBUG = enabled; }
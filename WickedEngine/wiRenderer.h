@@ -10,6 +10,8 @@
 #include "shaders/ShaderInterop_Renderer.h"
 #include "shaders/ShaderInterop_SurfelGI.h"
 #include "wiVector.h"
+#include "wiUnorderedMap.h"
+#include "wiOcclusionBuffer.h"
 
 #include <memory>
 #include <limits>
@@ -119,9 +121,14 @@ namespace wi::renderer
 		XMFLOAT4 reflectionPlane = XMFLOAT4(0, 1, 0, 0);
 		std::atomic_bool volumetriclight_request{ false };
 
+		// CPU occlusion culling (when wi::renderer::GetOcclusionCullingCPUEnabled() is true):
+		wi::OcclusionBuffer occlusionBuffer;
+		wi::vector<uint8_t> occludedObjectsCPU; // parallel to visibleObjects, nonzero if the object was found occluded
+
 		void Clear()
 		{
 			visibleObjects.clear();
+			occludedObjectsCPU.clear();
 			visibleLights.clear();
 			visibleDecals.clear();
 			visibleEnvProbes.clear();
@@ -145,6 +152,165 @@ namespace wi::renderer
 		{
 			return volumetriclight_request.load();
 		}
+		bool IsOccludedCPU(size_t visibleObjectIndex) const
+		{
+			return visibleObjectIndex < occludedObjectsCPU.size() && occludedObjectsCPU[visibleObjectIndex] != 0;
+		}
+	};
+
+	// Computes which visible lights, decals and env probes affect a batch with the given bounds
+	//	This is the brute force CPU light culling used for simple forward passes (drawcall-granularity)
+	ForwardEntityMaskCB ForwardEntityCullingCPU(const Visibility& vis, const wi::primitive::AABB& batch_aabb, wi::enums::RENDERPASS renderPass);
+
+	// Clustered version of ForwardEntityCullingCPU() for computing the masks of many batches in the same pass:
+	//	Visible lights, decals and env probes are binned once into a world space grid that covers the bounds of all batches,
+	//	then a batch only tests the entities that were binned into the clusters that it overlaps. The results are the same.
+	struct ForwardEntityClusters
+	{
+		static constexpr uint32_t GRID_DIM = 8;
+		struct Cluster
+		{
+			uint64_t lightMask;
+			uint32_t decalMask;
+			uint32_t envprobeMask;
+		};
+		Cluster clusters[GRID_DIM * GRID_DIM * GRID_DIM];
+		wi::primitive::AABB bounds;
+		XMFLOAT3 cell_scale = XMFLOAT3(0, 0, 0); // clusters per world unit
+		const Visibility* vis = nullptr;
+		wi::enums::RENDERPASS renderPass = wi::enums::RENDERPASS_MAIN;
+
+		// bounds : every batch that will be culled must be inside this
+		void Build(const Visibility& vis, const wi::primitive::AABB& bounds, wi::enums::RENDERPASS renderPass);
+		ForwardEntityMaskCB Cull(const wi::primitive::AABB& batch_aabb) const;
+	};
+
+	// Direct reference to a renderable instance:
+	//	It is a packed 64-bit sort key: [pipeline: 6 bits][meshIndex: 20 bits][distance: 14 bits][instanceIndex: 24 bits]
+	struct RenderBatch
+	{
+		uint64_t data;
+
+		inline void Create(uint32_t meshIndex, uint32_t instanceIndex, float distance, uint8_t pipelineKey)
+		{
+			// These asserts are a indicating if render queue limits are reached:
+			assert(meshIndex < 0x000FFFFF);
+			assert(instanceIndex < 0x00FFFFFF);
+			assert(pipelineKey < 0x40);
+
+			// distance is positive, so the sign bit of the half float is not stored, and the lowest mantissa bit is dropped
+			const uint64_t distanceBits = (XMConvertFloatToHalf(std::max(0.0f, distance)) >> 1) & 0x3FFF;
+
+			data = 0;
+			data |= uint64_t(pipelineKey & 0x3F) << 58ull;
+			data |= uint64_t(meshIndex & 0x000FFFFF) << 38ull;
+			data |= distanceBits << 24ull;
+			data |= uint64_t(instanceIndex & 0x00FFFFFF) << 0ull;
+		}
+
+		inline float GetDistance() const
+		{
+			return XMConvertHalfToFloat(HALF(((data >> 24ull) & 0x3FFF) << 1));
+		}
+		inline uint32_t GetMeshIndex() const
+		{
+			return (data >> 38ull) & 0x000FFFFF;
+		}
+		inline uint32_t GetInstanceIndex() const
+		{
+			return (data >> 0ull) & 0x00FFFFFF;
+		}
+
+		// opaque sorting
+		//	Priority is set to pipeline and mesh index to have less state changes and more instancing
+		//	distance is next priority (front to back Z-buffering)
+		bool operator<(const RenderBatch& other) const
+		{
+			return data < other.data;
+		}
+		// transparent sorting
+		//	Priority is distance for correct alpha blending (back to front rendering)
+		//	pipeline and mesh index is second priority for instancing
+		bool operator>(const RenderBatch& other) const
+		{
+			return GetTransparentSortKey() > other.GetTransparentSortKey();
+		}
+
+		// Move distance to the top bits to prioritize distance more
+		inline uint64_t GetTransparentSortKey() const
+		{
+			uint64_t key = 0ull;
+			key |= ((data >> 24ull) & 0x3FFF) << 50ull; // distance repack
+			key |= ((data >> 38ull) & 0x03FFFFFF) << 24ull; // pipeline and meshIndex repack
+			key |= data & 0x00FFFFFF; // instanceIndex repack
+			return key;
+		}
+		inline void SetFromTransparentSortKey(uint64_t key)
+		{
+			data = 0ull;
+			data |= ((key >> 24ull) & 0x03FFFFFF) << 38ull; // pipeline and meshIndex unpack
+			data |= ((key >> 50ull) & 0x3FFF) << 24ull; // distance unpack
+			data |= key & 0x00FFFFFF; // instanceIndex unpack
+		}
+	};
+	static_assert(sizeof(RenderBatch) == sizeof(uint64_t), "RenderBatch must be a plain 64-bit key for radix sorting!");
+
+	// Draw merging of mesh rendering, this is the part that runs fully on the CPU before any draw is recorded:
+	//	Render queue entries are grouped into instanced batches of the same mesh, LOD and stencil ref,
+	//	then every renderable subset of the batches becomes a subset draw, which are ordered by pipeline state when possible
+	struct MeshDrawGrouping
+	{
+		// This will correspond to a single draw call per subset
+		//	It's used to render multiple instances of a single mesh
+		struct InstancedBatch
+		{
+			uint32_t meshIndex = ~0u;
+			uint32_t instanceCount = 0;
+			uint32_t instanceOffset = 0; // in ShaderMeshInstancePointer elements
+			uint32_t instanceWritten = 0;
+			uint8_t userStencilRefOverride = 0;
+			bool forceAlphatestForDithering = false;
+			wi::primitive::AABB aabb;
+			uint32_t lod = 0;
+		};
+		struct SubsetDraw
+		{
+			const wi::graphics::PipelineState* pso = nullptr;
+			const wi::graphics::PipelineState* pso_backside = nullptr; // only when separate backside rendering is required (transparent doublesided)
+			uint32_t batchIndex = 0;
+			uint32_t subsetIndex = 0;
+		};
+		wi::vector<InstancedBatch> instancedBatches;
+		wi::vector<uint32_t> queueBatchIndices; // instanced batch index for every render queue entry
+		wi::vector<uint8_t> queueFrustumMasks; // visible frusta for every render queue entry
+		wi::vector<SubsetDraw> subsetDraws;
+		wi::unordered_map<uint64_t, uint32_t> batchLookup;
+		uint32_t consecutiveBatchCount = 0; // how many batches would be created by only merging neighbouring entries, for statistics
+		uint32_t instanceCount = 0; // instances of all batches, including every frustum that an instance is visible in
+
+		// Assigns render queue entries to instanced batches, then allocates contiguous instance ranges for the batches
+		//	orderIndependent	:	when the draw order doesn't matter, entries that are not next to each other can be merged too
+		//	mergeAABBs			:	compute the bounds of every batch from its instances
+		//	frusta				:	if not nullptr, instances are only counted for the frusta that they intersect (max 8)
+		void GroupInstances(
+			const wi::scene::Scene& scene,
+			const RenderBatch* batches,
+			size_t count,
+			bool orderIndependent,
+			bool mergeAABBs,
+			const wi::primitive::Frustum* frusta = nullptr,
+			uint32_t frustum_count = 1
+		);
+
+		// Gathers the renderable subsets of every instanced batch with their pipeline states
+		//	sortByPipeline	:	order the draws by pipeline state, then by batch and subset (otherwise batch order is kept)
+		void GatherSubsetDraws(
+			const wi::scene::Scene& scene,
+			wi::enums::RENDERPASS renderPass,
+			uint32_t renderTypeFlags,
+			bool tessellation,
+			bool sortByPipeline
+		);
 	};
 
 	// Performs frustum culling.
@@ -792,6 +958,10 @@ namespace wi::renderer
 	bool GetVariableRateShadingClassificationDebug();
 	void SetOcclusionCullingEnabled(bool enabled);
 	bool GetOcclusionCullingEnabled();
+	// CPU occlusion culling rasterizes objects marked with ObjectComponent::SetOccluder() into a software depth buffer
+	//	and culls objects behind them in the same frame, before render queues are built
+	void SetOcclusionCullingCPUEnabled(bool enabled);
+	bool GetOcclusionCullingCPUEnabled();
 	void SetTemporalAAEnabled(bool enabled);
 	bool GetTemporalAAEnabled();
 	void SetTemporalAADebugEnabled(bool enabled);
@@ -11,6 +11,11 @@
 #include "wiBacklog.h"
 #include "wiTimer.h"
 #include "wiUnorderedMap.h"
+#include "wiUnorderedSet.h"
+#include "wiSort.h"
+#include "wiProfiler.h"
+#include "Utility/meshoptimizer/meshoptimizer.h"
+#include "Utility/xatlas.h"
 
 #include "shaders/ShaderInterop_SurfelGI.h"
 #include "shaders/ShaderInterop_DDGI.h"
@@ -383,9 +388,11 @@ namespace wi::scene
 		return wi::renderer::CombineStencilrefs(engineStencilRef, userStencilRef);
 	}
 
+	static std::atomic<uint64_t> next_geometry_version{ 0 };
 	void MeshComponent::CreateRenderData()
 	{
 		GraphicsDevice* device = wi::graphics::GetDevice();
+		geometry_version = next_geometry_version.fetch_add(1) + 1;
 
 		generalBuffer = {};
 		streamoutBuffer = {};
@@ -734,6 +741,21 @@ namespace wi::scene
 			assert(success);
 			device->SetName(&BLAS, "MeshComponent::BLAS");
 		}
+
+		if (IsSkinned() || !targets.empty())
+		{
+			clusters.clear();
+			cluster_vertices.clear();
+			cluster_triangles.clear();
+			cluster_hash = 0;
+		}
+		else if (!cluster_hash_check || clusters.empty() || ComputeClusterHash() != cluster_hash)
+		{
+			// The render data is recreated because the geometry changed, so the clusters are rebuilt without comparing fingerprints
+			//	Only the clusters that were serialized with the mesh are checked, once after loading
+			BuildClusters();
+		}
+		cluster_hash_check = false;
 	}
 	void MeshComponent::CreateStreamoutRenderData()
 	{
@@ -786,6 +808,111 @@ namespace wi::scene
 		so_pre.descriptor_srv = device->GetDescriptorIndex(&streamoutBuffer, SubresourceType::SRV, so_pre.subresource_srv);
 		so_pre.descriptor_uav = device->GetDescriptorIndex(&streamoutBuffer, SubresourceType::UAV, so_pre.subresource_uav);
 	}
+	// Comparisons of ComputeNormals(), vertices are considered the same when they are closer than FLT_EPSILON on every axis
+	inline bool IsPositionMatching(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return
+			std::abs(a.x - b.x) < FLT_EPSILON &&
+			std::abs(a.y - b.y) < FLT_EPSILON &&
+			std::abs(a.z - b.z) < FLT_EPSILON;
+	}
+	inline bool IsTexcoordMatching(const XMFLOAT2& a, const XMFLOAT2& b)
+	{
+		return
+			std::abs(a.x - b.x) < FLT_EPSILON &&
+			std::abs(a.y - b.y) < FLT_EPSILON;
+	}
+
+	// Spatial hash to find vertex positions that could match with IsPositionMatching()
+	//	Items are sorted by cell, so the items of a cell are next to each other
+	//	The cells are much bigger than the tolerance, so a query only looks into neighbor cells near cell boundaries
+	//	Cells whose hash collides simply share their items
+	struct VertexPositionGrid
+	{
+		double cell_size_rcp = 1;
+		wi::vector<uint64_t> items; // sorted, cell hash (upper 32 bits) | item (lower 32 bits)
+		wi::vector<uint32_t> item_locations; // item -> its location in items
+
+		inline int64_t cell(float value, double offset) const
+		{
+			return (int64_t)std::floor((double(value) + offset) * cell_size_rcp);
+		}
+		static inline uint64_t hash(int64_t x, int64_t y, int64_t z)
+		{
+			return uint64_t(uint32_t(x * 73856093ll ^ y * 19349663ll ^ z * 83492791ll)) << 32ull;
+		}
+
+		void Build(const XMFLOAT3* positions, uint32_t count)
+		{
+			// Cell size that puts a few items into each cell if the positions are distributed evenly on a surface:
+			XMFLOAT3 _min = XMFLOAT3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+			XMFLOAT3 _max = XMFLOAT3(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				_min = wi::math::Min(_min, positions[i]);
+				_max = wi::math::Max(_max, positions[i]);
+			}
+			const float extent = count > 0 ? std::max(_max.x - _min.x, std::max(_max.y - _min.y, _max.z - _min.z)) : 0;
+			cell_size_rcp = 1.0 / std::max(double(extent) / std::max(1.0, std::sqrt(double(count))), 64.0 * FLT_EPSILON);
+
+			items.resize(count);
+			item_locations.resize(count);
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, count, 1024, [&](wi::jobsystem::JobArgs args) {
+				const XMFLOAT3& position = positions[args.jobIndex];
+				items[args.jobIndex] = hash(cell(position.x, 0), cell(position.y, 0), cell(position.z, 0)) | uint64_t(args.jobIndex);
+			});
+			wi::jobsystem::Wait(ctx);
+
+			wi::vector<uint64_t> scratch(count);
+			wi::sort::RadixSortParallel(items.data(), scratch.data(), items.size());
+
+			wi::jobsystem::Dispatch(ctx, count, 1024, [&](wi::jobsystem::JobArgs args) {
+				item_locations[items[args.jobIndex] & 0xFFFFFFFF] = args.jobIndex;
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+
+		// Calls func(item) for every item in the cells that could contain positions matching the position of the queried item (including itself)
+		template<typename F>
+		void Query(uint32_t item, const XMFLOAT3& position, F&& func) const
+		{
+			const double tolerance = 2.0 * FLT_EPSILON;
+			const int64_t x0 = cell(position.x, -tolerance), x1 = cell(position.x, tolerance);
+			const int64_t y0 = cell(position.y, -tolerance), y1 = cell(position.y, tolerance);
+			const int64_t z0 = cell(position.z, -tolerance), z1 = cell(position.z, tolerance);
+			if (x0 == x1 && y0 == y1 && z0 == z1)
+			{
+				// Common case: only the cell of the item itself needs to be visited, which is around the item's location
+				const uint32_t location = item_locations[item];
+				const uint64_t cellhash = items[location] & ~0xFFFFFFFFull;
+				for (size_t i = location; i > 0 && (items[i - 1] & ~0xFFFFFFFFull) == cellhash; --i)
+				{
+					func(uint32_t(items[i - 1]));
+				}
+				for (size_t i = location; i < items.size() && (items[i] & ~0xFFFFFFFFull) == cellhash; ++i)
+				{
+					func(uint32_t(items[i]));
+				}
+				return;
+			}
+			for (int64_t x = x0; x <= x1; ++x)
+			{
+				for (int64_t y = y0; y <= y1; ++y)
+				{
+					for (int64_t z = z0; z <= z1; ++z)
+					{
+						const uint64_t cellhash = hash(x, y, z);
+						for (auto it = std::lower_bound(items.begin(), items.end(), cellhash); it != items.end() && (*it & ~0xFFFFFFFFull) == cellhash; ++it)
+						{
+							func(uint32_t(*it));
+						}
+					}
+				}
+			}
+		}
+	};
+
 	void MeshComponent::ComputeNormals(COMPUTE_NORMALS compute)
 	{
 		// Start recalculating normals:
@@ -805,6 +932,9 @@ namespace wi::scene
 			wi::vector<XMUINT4> newBoneIndicesBuffer;
 			wi::vector<XMFLOAT4> newBoneWeightsBuffer;
 			wi::vector<uint32_t> newColorsBuffer;
+			newIndexBuffer.reserve(indices.size());
+			newPositionsBuffer.reserve(indices.size());
+			newNormalsBuffer.reserve(indices.size());
 
 			for (size_t face = 0; face < indices.size() / 3; face++)
 			{
@@ -906,155 +1036,131 @@ namespace wi::scene
 		case MeshComponent::COMPUTE_NORMALS_SMOOTH:
 		{
 			// Compute smooth surface normals:
+			//	After the hard normals, every vertex belongs to exactly one face (vertex i is a corner of face i / 3)
+			//	Vertices with the same position are found with a spatial hash instead of comparing them with every face
+			const uint32_t vertexCount = (uint32_t)vertex_positions.size();
+			const uint32_t faceCount = uint32_t(indices.size() / 3);
+			wi::jobsystem::context ctx;
+
+			// 1.) Face normals:
+			wi::vector<XMFLOAT3> faceNormals(faceCount);
+			wi::jobsystem::Dispatch(ctx, faceCount, 256, [&](wi::jobsystem::JobArgs args) {
+				const XMFLOAT3& v0 = vertex_positions[indices[args.jobIndex * 3 + 0]];
+				const XMFLOAT3& v1 = vertex_positions[indices[args.jobIndex * 3 + 1]];
+				const XMFLOAT3& v2 = vertex_positions[indices[args.jobIndex * 3 + 2]];
+
+				XMVECTOR U = XMLoadFloat3(&v2) - XMLoadFloat3(&v0);
+				XMVECTOR V = XMLoadFloat3(&v1) - XMLoadFloat3(&v0);
 
-			// 1.) Zero normals, they will be averaged later
-			for (size_t i = 0; i < vertex_normals.size(); i++)
-			{
-				vertex_normals[i] = XMFLOAT3(0, 0, 0);
-			}
-
-			// 2.) Find identical vertices by POSITION, accumulate face normals
-			for (size_t i = 0; i < vertex_positions.size(); i++)
-			{
-				XMFLOAT3& v_search_pos = vertex_positions[i];
+				XMVECTOR N = XMVector3Cross(U, V);
+				N = XMVector3Normalize(N);
 
-				for (size_t ind = 0; ind < indices.size() / 3; ++ind)
-				{
-					uint32_t i0 = indices[ind * 3 + 0];
-					uint32_t i1 = indices[ind * 3 + 1];
-					uint32_t i2 = indices[ind * 3 + 2];
-
-					XMFLOAT3& v0 = vertex_positions[i0];
-					XMFLOAT3& v1 = vertex_positions[i1];
-					XMFLOAT3& v2 = vertex_positions[i2];
-
-					bool match_pos0 =
-						fabs(v_search_pos.x - v0.x) < FLT_EPSILON &&
-						fabs(v_search_pos.y - v0.y) < FLT_EPSILON &&
-						fabs(v_search_pos.z - v0.z) < FLT_EPSILON;
-
-					bool match_pos1 =
-						fabs(v_search_pos.x - v1.x) < FLT_EPSILON &&
-						fabs(v_search_pos.y - v1.y) < FLT_EPSILON &&
-						fabs(v_search_pos.z - v1.z) < FLT_EPSILON;
-
-					bool match_pos2 =
-						fabs(v_search_pos.x - v2.x) < FLT_EPSILON &&
-						fabs(v_search_pos.y - v2.y) < FLT_EPSILON &&
-						fabs(v_search_pos.z - v2.z) < FLT_EPSILON;
-
-					if (match_pos0 || match_pos1 || match_pos2)
-					{
-						XMVECTOR U = XMLoadFloat3(&v2) - XMLoadFloat3(&v0);
-						XMVECTOR V = XMLoadFloat3(&v1) - XMLoadFloat3(&v0);
+				XMStoreFloat3(&faceNormals[args.jobIndex], N);
+			});
 
-						XMVECTOR N = XMVector3Cross(U, V);
-						N = XMVector3Normalize(N);
+			VertexPositionGrid grid;
+			grid.Build(vertex_positions.data(), vertexCount);
+			wi::jobsystem::Wait(ctx);
 
-						XMFLOAT3 normal;
-						XMStoreFloat3(&normal, N);
+			// 2.) Find identical vertices by POSITION, accumulate the normals of their faces (in face order, every face once):
+			wi::jobsystem::Dispatch(ctx, vertexCount, 256, [&](wi::jobsystem::JobArgs args) {
+				const XMFLOAT3& v_search_pos = vertex_positions[args.jobIndex];
 
-						vertex_normals[i].x += normal.x;
-						vertex_normals[i].y += normal.y;
-						vertex_normals[i].z += normal.z;
+				static thread_local wi::vector<uint32_t> faces; // per worker thread
+				faces.clear();
+				grid.Query(args.jobIndex, v_search_pos, [&](uint32_t candidate) {
+					if (IsPositionMatching(v_search_pos, vertex_positions[candidate]))
+					{
+						faces.push_back(candidate / 3);
 					}
+				});
+				std::sort(faces.begin(), faces.end());
+				faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
 
+				XMFLOAT3 normal = XMFLOAT3(0, 0, 0);
+				for (uint32_t face : faces)
+				{
+					normal.x += faceNormals[face].x;
+					normal.y += faceNormals[face].y;
+					normal.z += faceNormals[face].z;
 				}
+				vertex_normals[args.jobIndex] = normal;
+			});
+			wi::jobsystem::Wait(ctx);
+
+			// 3.) Find duplicated vertices by POSITION and UV0 and UV1 and ATLAS and SUBSET:
+			//	A vertex is merged into the first earlier vertex of the subset that is kept and matches it
+			auto is_duplicate = [&](uint32_t ind0, uint32_t ind1) {
+				return
+					IsPositionMatching(vertex_positions[ind0], vertex_positions[ind1]) &&
+					(vertex_uvset_0.empty() || IsTexcoordMatching(vertex_uvset_0[ind0], vertex_uvset_0[ind1])) &&
+					(vertex_uvset_1.empty() || IsTexcoordMatching(vertex_uvset_1[ind0], vertex_uvset_1[ind1])) &&
+					(vertex_atlas.empty() || IsTexcoordMatching(vertex_atlas[ind0], vertex_atlas[ind1]));
+			};
+			wi::vector<uint32_t> remap(vertexCount); // vertex -> the kept vertex that it was merged into
+			wi::vector<uint32_t> vertex_subsets(vertexCount);
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				remap[i] = i;
+				vertex_subsets[i] = ~0u;
 			}
-
-			// 3.) Find duplicated vertices by POSITION and UV0 and UV1 and ATLAS and SUBSET and remove them:
-			for (auto& subset : subsets)
+			for (size_t subsetIndex = 0; subsetIndex < subsets.size(); ++subsetIndex)
 			{
-				for (uint32_t i = 0; i < subset.indexCount - 1; i++)
+				const MeshSubset& subset = subsets[subsetIndex];
+				for (uint32_t i = 0; i < subset.indexCount; ++i)
 				{
-					uint32_t ind0 = indices[subset.indexOffset + (uint32_t)i];
-					const XMFLOAT3& p0 = vertex_positions[ind0];
-					const XMFLOAT2& u00 = vertex_uvset_0.empty() ? XMFLOAT2(0, 0) : vertex_uvset_0[ind0];
-					const XMFLOAT2& u10 = vertex_uvset_1.empty() ? XMFLOAT2(0, 0) : vertex_uvset_1[ind0];
-					const XMFLOAT2& at0 = vertex_atlas.empty() ? XMFLOAT2(0, 0) : vertex_atlas[ind0];
-
-					for (uint32_t j = i + 1; j < subset.indexCount; j++)
-					{
-						uint32_t ind1 = indices[subset.indexOffset + (uint32_t)j];
-
-						if (ind1 == ind0)
+					vertex_subsets[indices[subset.indexOffset + i]] = (uint32_t)subsetIndex;
+				}
+			}
+			wi::jobsystem::Dispatch(ctx, (uint32_t)subsets.size(), 1, [&](wi::jobsystem::JobArgs args) {
+				// Vertex order is the same as index order inside the subset, so earlier vertices of the subset are already decided:
+				const MeshSubset& subset = subsets[args.jobIndex];
+				for (uint32_t i = 0; i < subset.indexCount; ++i)
+				{
+					const uint32_t ind1 = indices[subset.indexOffset + i];
+					uint32_t ind0 = ind1;
+					grid.Query(ind1, vertex_positions[ind1], [&](uint32_t candidate) {
+						if (candidate < ind0 && vertex_subsets[candidate] == args.jobIndex && remap[candidate] == candidate && is_duplicate(candidate, ind1))
 						{
-							continue;
+							ind0 = candidate;
 						}
-
-						const XMFLOAT3& p1 = vertex_positions[ind1];
-						const XMFLOAT2& u01 = vertex_uvset_0.empty() ? XMFLOAT2(0, 0) : vertex_uvset_0[ind1];
-						const XMFLOAT2& u11 = vertex_uvset_1.empty() ? XMFLOAT2(0, 0) : vertex_uvset_1[ind1];
-						const XMFLOAT2& at1 = vertex_atlas.empty() ? XMFLOAT2(0, 0) : vertex_atlas[ind1];
-
-						const bool duplicated_pos =
-							fabs(p0.x - p1.x) < FLT_EPSILON &&
-							fabs(p0.y - p1.y) < FLT_EPSILON &&
-							fabs(p0.z - p1.z) < FLT_EPSILON;
-
-						const bool duplicated_uv0 =
-							fabs(u00.x - u01.x) < FLT_EPSILON &&
-							fabs(u00.y - u01.y) < FLT_EPSILON;
-
-						const bool duplicated_uv1 =
-							fabs(u10.x - u11.x) < FLT_EPSILON &&
-							fabs(u10.y - u11.y) < FLT_EPSILON;
-
-						const bool duplicated_atl =
-							fabs(at0.x - at1.x) < FLT_EPSILON &&
-							fabs(at0.y - at1.y) < FLT_EPSILON;
-
-						if (duplicated_pos && duplicated_uv0 && duplicated_uv1 && duplicated_atl)
-						{
-							// Erase vertices[ind1] because it is a duplicate:
-							if (ind1 < vertex_positions.size())
-							{
-								vertex_positions.erase(vertex_positions.begin() + ind1);
-							}
-							if (ind1 < vertex_normals.size())
-							{
-								vertex_normals.erase(vertex_normals.begin() + ind1);
-							}
-							if (ind1 < vertex_uvset_0.size())
-							{
-								vertex_uvset_0.erase(vertex_uvset_0.begin() + ind1);
-							}
-							if (ind1 < vertex_uvset_1.size())
-							{
-								vertex_uvset_1.erase(vertex_uvset_1.begin() + ind1);
-							}
-							if (ind1 < vertex_atlas.size())
-							{
-								vertex_atlas.erase(vertex_atlas.begin() + ind1);
-							}
-							if (ind1 < vertex_boneindices.size())
-							{
-								vertex_boneindices.erase(vertex_boneindices.begin() + ind1);
-							}
-							if (ind1 < vertex_boneweights.size())
-							{
-								vertex_boneweights.erase(vertex_boneweights.begin() + ind1);
-							}
-
-							// The vertices[ind1] was removed, so each index after that needs to be updated:
-							for (auto& index : indices)
-							{
-								if (index > ind1 && index > 0)
-								{
-									index--;
-								}
-								else if (index == ind1)
-								{
-									index = ind0;
-								}
-							}
-
-						}
-
-					}
+					});
+					remap[ind1] = ind0;
 				}
+			});
+			wi::jobsystem::Wait(ctx);
 
+			// 4.) Remove the duplicates, the remaining vertices keep their order:
+			uint32_t keptCount = 0;
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				remap[i] = remap[i] == i ? keptCount++ : remap[remap[i]]; // duplicates always refer to earlier vertices
 			}
+			wi::jobsystem::Dispatch(ctx, (uint32_t)indices.size(), 1024, [&](wi::jobsystem::JobArgs args) {
+				indices[args.jobIndex] = remap[indices[args.jobIndex]];
+			});
+			auto compact = [&](auto& attribute) {
+				if (attribute.size() != vertexCount)
+					return;
+				uint32_t next = 0;
+				for (uint32_t i = 0; i < vertexCount; ++i)
+				{
+					if (remap[i] == next)
+					{
+						attribute[next++] = attribute[i];
+					}
+				}
+				attribute.resize(keptCount);
+			};
+			compact(vertex_positions);
+			compact(vertex_normals);
+			compact(vertex_uvset_0);
+			compact(vertex_uvset_1);
+			compact(vertex_atlas);
+			compact(vertex_boneindices);
+			compact(vertex_boneweights);
+			compact(vertex_colors);
+			wi::jobsystem::Wait(ctx);
 
 		}
 		break;
@@ -1158,6 +1264,381 @@ namespace wi::scene
 		sphere.radius = aabb.getRadius();
 		return sphere;
 	}
+	void MeshComponent::BuildClusters()
+	{
+		clusters.clear();
+		cluster_vertices.clear();
+		cluster_triangles.clear();
+		if (vertex_positions.empty() || indices.empty())
+			return;
+
+		const float* positions = &vertex_positions[0].x;
+		const size_t vertex_count = vertex_positions.size();
+		wi::vector<meshopt_Meshlet> meshlets;
+		for (uint32_t subsetIndex = 0; subsetIndex < (uint32_t)subsets.size(); ++subsetIndex)
+		{
+			const MeshSubset& subset = subsets[subsetIndex];
+			if (subset.indexCount < 3)
+				continue;
+
+			const size_t max_meshlets = meshopt_buildMeshletsBound(subset.indexCount, CLUSTER_MAX_VERTICES, CLUSTER_MAX_TRIANGLES);
+			meshlets.resize(max_meshlets);
+			const size_t vertex_base = cluster_vertices.size();
+			const size_t triangle_base = cluster_triangles.size();
+			cluster_vertices.resize(vertex_base + max_meshlets * CLUSTER_MAX_VERTICES);
+			cluster_triangles.resize(triangle_base + max_meshlets * CLUSTER_MAX_TRIANGLES * 3);
+
+			const size_t meshlet_count = meshopt_buildMeshlets(
+				meshlets.data(),
+				cluster_vertices.data() + vertex_base,
+				cluster_triangles.data() + triangle_base,
+				indices.data() + subset.indexOffset,
+				subset.indexCount,
+				positions,
+				vertex_count,
+				sizeof(XMFLOAT3),
+				CLUSTER_MAX_VERTICES,
+				CLUSTER_MAX_TRIANGLES,
+				0.25f
+			);
+
+			for (size_t i = 0; i < meshlet_count; ++i)
+			{
+				const meshopt_Meshlet& meshlet = meshlets[i];
+				const meshopt_Bounds bounds = meshopt_computeMeshletBounds(
+					cluster_vertices.data() + vertex_base + meshlet.vertex_offset,
+					cluster_triangles.data() + triangle_base + meshlet.triangle_offset,
+					meshlet.triangle_count,
+					positions,
+					vertex_count,
+					sizeof(XMFLOAT3)
+				);
+
+				MeshCluster& cluster = clusters.emplace_back();
+				cluster.subsetIndex = subsetIndex;
+				cluster.vertexOffset = uint32_t(vertex_base + meshlet.vertex_offset);
+				cluster.vertexCount = meshlet.vertex_count;
+				cluster.triangleOffset = uint32_t(triangle_base + meshlet.triangle_offset);
+				cluster.triangleCount = meshlet.triangle_count;
+				cluster.center = XMFLOAT3(bounds.center[0], bounds.center[1], bounds.center[2]);
+				cluster.radius = bounds.radius;
+				cluster.cone_apex = XMFLOAT3(bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2]);
+				cluster.cone_axis = XMFLOAT3(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]);
+				cluster.cone_cutoff = bounds.cone_cutoff;
+			}
+
+			if (meshlet_count > 0)
+			{
+				const meshopt_Meshlet& last = meshlets[meshlet_count - 1];
+				cluster_vertices.resize(vertex_base + last.vertex_offset + last.vertex_count);
+				cluster_triangles.resize(triangle_base + last.triangle_offset + last.triangle_count * 3);
+			}
+			else
+			{
+				cluster_vertices.resize(vertex_base);
+				cluster_triangles.resize(triangle_base);
+			}
+		}
+		cluster_vertices.shrink_to_fit();
+		cluster_triangles.shrink_to_fit();
+	}
+	uint64_t MeshComponent::ComputeClusterHash() const
+	{
+		// FNV-1a over the positions, indices and subset ranges:
+		uint64_t hash = 14695981039346656037ull;
+		auto combine = [&](uint32_t value) {
+			hash ^= value;
+			hash *= 1099511628211ull;
+		};
+		for (const XMFLOAT3& position : vertex_positions)
+		{
+			combine(*(const uint32_t*)&position.x);
+			combine(*(const uint32_t*)&position.y);
+			combine(*(const uint32_t*)&position.z);
+		}
+		for (uint32_t index : indices)
+		{
+			combine(index);
+		}
+		for (const MeshSubset& subset : subsets)
+		{
+			combine(subset.indexOffset);
+			combine(subset.indexCount);
+		}
+		combine(CLUSTER_MAX_VERTICES);
+		combine(CLUSTER_MAX_TRIANGLES);
+		return hash;
+	}
+	void MeshComponent::CullClusters(const Frustum& frustum, const XMFLOAT4X4& world, uint32_t lod, wi::vector<uint32_t>& visible_clusters, const XMFLOAT3* eye) const
+	{
+		uint32_t first_subset = 0;
+		uint32_t last_subset = 0;
+		GetLODSubsetRange(lod, first_subset, last_subset);
+
+		const XMMATRIX W = XMLoadFloat4x4(&world);
+		const float scale = std::sqrt(std::max(
+			XMVectorGetX(XMVector3LengthSq(W.r[0])), std::max(
+			XMVectorGetX(XMVector3LengthSq(W.r[1])),
+			XMVectorGetX(XMVector3LengthSq(W.r[2])))
+		));
+		const XMVECTOR E = eye == nullptr ? XMVectorZero() : XMLoadFloat3(eye);
+
+		for (uint32_t clusterIndex = 0; clusterIndex < (uint32_t)clusters.size(); ++clusterIndex)
+		{
+			const MeshCluster& cluster = clusters[clusterIndex];
+			if (cluster.subsetIndex < first_subset || cluster.subsetIndex >= last_subset)
+				continue;
+
+			XMFLOAT3 center;
+			XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat3(&cluster.center), W));
+			if (!frustum.CheckSphere(center, cluster.radius * scale))
+				continue;
+
+			if (eye != nullptr && cluster.cone_cutoff < 1)
+			{
+				const XMVECTOR apex = XMVector3Transform(XMLoadFloat3(&cluster.cone_apex), W);
+				const XMVECTOR axis = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&cluster.cone_axis), W));
+				const float facing = XMVectorGetX(XMVector3Dot(XMVector3Normalize(apex - E), axis));
+				if (facing >= cluster.cone_cutoff)
+					continue;
+			}
+
+			visible_clusters.push_back(clusterIndex);
+		}
+	}
+	void MeshComponent::GenerateLODs(const LODGenerationParams& params)
+	{
+		if (vertex_positions.empty() || indices.empty())
+			return;
+
+		uint32_t first_subset = 0;
+		uint32_t last_subset = 0;
+		GetLODSubsetRange(0, first_subset, last_subset);
+		const uint32_t subset_count = last_subset - first_subset;
+		if (subset_count == 0)
+			return;
+
+		const float* positions = &vertex_positions[0].x;
+		const size_t vertex_count = vertex_positions.size();
+		const float scale = meshopt_simplifyScale(positions, vertex_count, sizeof(XMFLOAT3));
+
+		// Index lists of every LOD level and subset: lods[lod * subset_count + subset]
+		wi::vector<wi::vector<uint32_t>> lods(subset_count);
+		for (uint32_t subsetIndex = 0; subsetIndex < subset_count; ++subsetIndex)
+		{
+			const MeshSubset& subset = subsets[first_subset + subsetIndex];
+			lods[subsetIndex].assign(indices.begin() + subset.indexOffset, indices.begin() + subset.indexOffset + subset.indexCount);
+		}
+		wi::vector<float> errors;
+		errors.push_back(0);
+
+		// Every level is simplified from the previous one, which is faster than starting from the original every time
+		//	The error of a level is relative to the previous level, so the errors are accumulated
+		float target_error = params.target_error;
+		for (uint32_t lod = 1; lod < params.lod_count; ++lod)
+		{
+			lods.resize((lod + 1) * subset_count);
+			bool reduced = false;
+			float level_error = 0;
+			for (uint32_t subsetIndex = 0; subsetIndex < subset_count; ++subsetIndex)
+			{
+				const wi::vector<uint32_t>& source = lods[(lod - 1) * subset_count + subsetIndex];
+				wi::vector<uint32_t>& lod_indices = lods[lod * subset_count + subsetIndex];
+				const size_t target_index_count = size_t(source.size() * params.reduction) / 3 * 3;
+				if (target_index_count / 3 < params.min_triangles)
+				{
+					lod_indices = source;
+					continue;
+				}
+
+				lod_indices.resize(source.size());
+				float result_error = 0;
+				if (params.sloppy)
+				{
+					lod_indices.resize(meshopt_simplifySloppy(lod_indices.data(), source.data(), source.size(), positions, vertex_count, sizeof(XMFLOAT3), target_index_count, target_error, &result_error));
+				}
+				else
+				{
+					lod_indices.resize(meshopt_simplify(lod_indices.data(), source.data(), source.size(), positions, vertex_count, sizeof(XMFLOAT3), target_index_count, target_error, &result_error));
+				}
+
+				if (lod_indices.empty())
+				{
+					// Don't let the subset disappear:
+					lod_indices = source;
+					continue;
+				}
+				if (lod_indices.size() < source.size() * 9 / 10)
+				{
+					reduced = true;
+				}
+				level_error = std::max(level_error, result_error * scale);
+			}
+
+			if (!reduced)
+			{
+				// The level would be almost the same as the previous one, the chain ends here:
+				lods.resize(lod * subset_count);
+				break;
+			}
+			errors.push_back(errors.back() + level_error);
+			target_error *= 2;
+		}
+
+		const uint32_t lod_count = (uint32_t)errors.size();
+		if (lod_count < 2)
+			return;
+
+		size_t index_count = 0;
+		for (size_t i = subset_count; i < lods.size(); ++i)
+		{
+			meshopt_optimizeVertexCache(lods[i].data(), lods[i].data(), lods[i].size(), vertex_count);
+			index_count += lods[i].size();
+		}
+		for (uint32_t subsetIndex = 0; subsetIndex < subset_count; ++subsetIndex)
+		{
+			index_count += lods[subsetIndex].size();
+		}
+
+		wi::vector<uint32_t> lod_indices;
+		lod_indices.reserve(index_count);
+		wi::vector<MeshSubset> lod_subsets;
+		lod_subsets.reserve(lods.size());
+		for (size_t i = 0; i < lods.size(); ++i)
+		{
+			MeshSubset subset = subsets[first_subset + i % subset_count];
+			subset.indexOffset = (uint32_t)lod_indices.size();
+			subset.indexCount = (uint32_t)lods[i].size();
+			lod_subsets.push_back(subset);
+			lod_indices.insert(lod_indices.end(), lods[i].begin(), lods[i].end());
+		}
+		indices = std::move(lod_indices);
+		subsets = std::move(lod_subsets);
+		subsets_per_lod = subset_count;
+		lod_errors = std::move(errors);
+	}
+
+	bool MeshComponent::GenerateAtlas(uint32_t resolution)
+	{
+		if (vertex_positions.empty() || indices.empty())
+			return false;
+
+		xatlas::Atlas* atlas = xatlas::Create();
+
+		// Prepare mesh to be processed by xatlas:
+		{
+			xatlas::MeshDecl mesh;
+			mesh.vertexCount = (uint32_t)vertex_positions.size();
+			mesh.vertexPositionData = vertex_positions.data();
+			mesh.vertexPositionStride = sizeof(float) * 3;
+			if (!vertex_normals.empty())
+			{
+				mesh.vertexNormalData = vertex_normals.data();
+				mesh.vertexNormalStride = sizeof(float) * 3;
+			}
+			if (!vertex_uvset_0.empty())
+			{
+				mesh.vertexUvData = vertex_uvset_0.data();
+				mesh.vertexUvStride = sizeof(float) * 2;
+			}
+			mesh.indexCount = (uint32_t)indices.size();
+			mesh.indexData = indices.data();
+			mesh.indexFormat = xatlas::IndexFormat::UInt32;
+			xatlas::AddMeshError::Enum error = xatlas::AddMesh(atlas, mesh);
+			if (error != xatlas::AddMeshError::Success)
+			{
+				wi::backlog::post(std::string("Adding mesh to xatlas failed: ") + xatlas::StringForEnum(error), wi::backlog::LogLevel::Error);
+				xatlas::Destroy(atlas);
+				return false;
+			}
+		}
+
+		xatlas::ChartOptions chartoptions;
+		xatlas::ParameterizeOptions parametrizeoptions;
+		xatlas::PackOptions packoptions;
+		packoptions.resolution = resolution;
+		packoptions.blockAlign = true;
+		xatlas::Generate(atlas, chartoptions, parametrizeoptions, packoptions);
+
+		if (atlas->meshCount == 0 || atlas->width == 0 || atlas->height == 0)
+		{
+			xatlas::Destroy(atlas);
+			return false;
+		}
+
+		const xatlas::Mesh& mesh = atlas->meshes[0];
+		const float width_rcp = 1.0f / float(atlas->width);
+		const float height_rcp = 1.0f / float(atlas->height);
+
+		// All vertex streams are rebuilt, because the atlas can split vertices along chart seams:
+		auto remap = [&](auto& stream) {
+			if (stream.empty())
+				return;
+			std::remove_reference_t<decltype(stream)> remapped(mesh.vertexCount);
+			for (uint32_t i = 0; i < mesh.vertexCount; ++i)
+			{
+				remapped[i] = stream[mesh.vertexArray[i].xref];
+			}
+			stream = std::move(remapped);
+		};
+		remap(vertex_positions);
+		remap(vertex_normals);
+		remap(vertex_tangents);
+		remap(vertex_uvset_0);
+		remap(vertex_uvset_1);
+		remap(vertex_boneindices);
+		remap(vertex_boneweights);
+		remap(vertex_colors);
+		remap(vertex_windweights);
+		for (MeshMorphTarget& target : targets)
+		{
+			remap(target.vertex_positions);
+			remap(target.vertex_normals);
+		}
+
+		vertex_atlas.resize(mesh.vertexCount);
+		for (uint32_t i = 0; i < mesh.vertexCount; ++i)
+		{
+			const xatlas::Vertex& v = mesh.vertexArray[i];
+			vertex_atlas[i].x = v.uv[0] * width_rcp;
+			vertex_atlas[i].y = v.uv[1] * height_rcp;
+		}
+		indices.assign(mesh.indexArray, mesh.indexArray + mesh.indexCount);
+
+		atlas_width = atlas->width;
+		atlas_height = atlas->height;
+		xatlas::Destroy(atlas);
+
+		atlas_hash = ComputeAtlasHash(resolution);
+		return true;
+	}
+	uint64_t MeshComponent::ComputeAtlasHash(uint32_t resolution) const
+	{
+		// FNV-1a over the xatlas inputs and outputs, so modifying any of them invalidates the atlas:
+		uint64_t hash = 14695981039346656037ull;
+		auto combine = [&](uint32_t value) {
+			hash ^= value;
+			hash *= 1099511628211ull;
+		};
+		auto combine_floats = [&](const float* data, size_t count) {
+			for (size_t i = 0; i < count; ++i)
+			{
+				combine(*(const uint32_t*)&data[i]);
+			}
+		};
+		combine_floats((const float*)vertex_positions.data(), vertex_positions.size() * 3);
+		combine_floats((const float*)vertex_normals.data(), vertex_normals.size() * 3);
+		combine_floats((const float*)vertex_uvset_0.data(), vertex_uvset_0.size() * 2);
+		combine_floats((const float*)vertex_atlas.data(), vertex_atlas.size() * 2);
+		for (uint32_t index : indices)
+		{
+			combine(index);
+		}
+		combine(resolution);
+		combine(atlas_width);
+		combine(atlas_height);
+		return hash;
+	}
 
 	void ObjectComponent::ClearLightmap()
 	{
@@ -1465,10 +1946,276 @@ namespace wi::scene
 		UpdateCamera();
 	}
 
+	// Animation compression quantization helpers:
+	static constexpr float ANIMATION_QUATERNION_RANGE = 0.70710678f; // the three smallest components of a unit quaternion are in the [-1/sqrt2, 1/sqrt2] range
+	static inline uint16_t QuantizeAnimationUNORM16(float value)
+	{
+		return uint16_t(wi::math::Clamp(value, 0, 1) * 65535.0f + 0.5f);
+	}
+	static void EncodeAnimationQuaternion(XMFLOAT4 q, uint16_t* dst)
+	{
+		float* v = &q.x;
+		uint32_t largest = 0;
+		for (uint32_t i = 1; i < 4; ++i)
+		{
+			if (std::abs(v[i]) > std::abs(v[largest]))
+				largest = i;
+		}
+		// q and -q are the same rotation, so the largest component is made positive and it can be reconstructed from the others:
+		const float sign = v[largest] < 0 ? -1.0f : 1.0f;
+		uint64_t packed = uint64_t(largest) << 45ull;
+		uint32_t shift = 30;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+			const float unorm = wi::math::Clamp(v[i] * sign / ANIMATION_QUATERNION_RANGE * 0.5f + 0.5f, 0, 1);
+			packed |= uint64_t(unorm * 32767.0f + 0.5f) << uint64_t(shift);
+			shift -= 15;
+		}
+		dst[0] = uint16_t(packed >> 32ull);
+		dst[1] = uint16_t(packed >> 16ull);
+		dst[2] = uint16_t(packed);
+	}
+	static inline XMVECTOR DecodeAnimationQuaternion(const uint16_t* src)
+	{
+		const uint64_t packed = (uint64_t(src[0]) << 32ull) | (uint64_t(src[1]) << 16ull) | uint64_t(src[2]);
+		const uint32_t largest = uint32_t(packed >> 45ull) & 3;
+		float v[4];
+		uint32_t shift = 30;
+		float sum = 0;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+			v[i] = (float((packed >> uint64_t(shift)) & 0x7FFF) / 32767.0f * 2 - 1) * ANIMATION_QUATERNION_RANGE;
+			sum += v[i] * v[i];
+			shift -= 15;
+		}
+		v[largest] = std::sqrt(std::max(0.0f, 1 - sum));
+		return XMVectorSet(v[0], v[1], v[2], v[3]);
+	}
+
+	XMVECTOR AnimationDataComponent::GetCompressedValue(size_t key) const
+	{
+		const uint16_t* data = compressed_data.data() + key * 3;
+		if (_flags & COMPRESSED_QUATERNION)
+		{
+			return DecodeAnimationQuaternion(data);
+		}
+		const XMVECTOR unorm = XMVectorSet(float(data[0]), float(data[1]), float(data[2]), 0) * (1.0f / 65535.0f);
+		return XMVectorMultiplyAdd(unorm, XMLoadFloat3(&range_extent), XMLoadFloat3(&range_min));
+	}
+	bool AnimationDataComponent::Compress(bool quaternion, bool step, float max_error)
+	{
+		const size_t components = quaternion ? 4 : 3;
+		const size_t count = keyframe_times.size();
+		if (IsCompressed() || count == 0 || count > 65536 || keyframe_data.size() != count * components)
+			return false;
+
+		// Quantize every keyframe first, so that key reduction also accounts for the quantization error:
+		const uint32_t flags = quaternion ? COMPRESSED_QUATERNION : COMPRESSED_VECTOR;
+		time_start = keyframe_times.front();
+		time_range = keyframe_times.back() - keyframe_times.front();
+		XMVECTOR vmin = XMVectorReplicate(std::numeric_limits<float>::max());
+		XMVECTOR vmax = XMVectorReplicate(std::numeric_limits<float>::lowest());
+		wi::vector<XMFLOAT4> raw(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (quaternion)
+			{
+				XMStoreFloat4(&raw[i], XMQuaternionNormalize(XMLoadFloat4((const XMFLOAT4*)keyframe_data.data() + i)));
+			}
+			else
+			{
+				raw[i] = XMFLOAT4(keyframe_data[i * 3 + 0], keyframe_data[i * 3 + 1], keyframe_data[i * 3 + 2], 0);
+				vmin = XMVectorMin(vmin, XMLoadFloat4(&raw[i]));
+				vmax = XMVectorMax(vmax, XMLoadFloat4(&raw[i]));
+			}
+		}
+		if (!quaternion)
+		{
+			XMStoreFloat3(&range_min, vmin);
+			XMStoreFloat3(&range_extent, vmax - vmin);
+		}
+
+		wi::vector<uint16_t> quantized_times(count);
+		wi::vector<uint16_t> quantized_data(count * 3);
+		wi::vector<XMFLOAT4> decoded(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			quantized_times[i] = time_range > 0 ? QuantizeAnimationUNORM16((keyframe_times[i] - time_start) / time_range) : 0;
+			uint16_t* dst = quantized_data.data() + i * 3;
+			if (quaternion)
+			{
+				EncodeAnimationQuaternion(raw[i], dst);
+				XMStoreFloat4(&decoded[i], DecodeAnimationQuaternion(dst));
+			}
+			else
+			{
+				dst[0] = range_extent.x > 0 ? QuantizeAnimationUNORM16((raw[i].x - range_min.x) / range_extent.x) : 0;
+				dst[1] = range_extent.y > 0 ? QuantizeAnimationUNORM16((raw[i].y - range_min.y) / range_extent.y) : 0;
+				dst[2] = range_extent.z > 0 ? QuantizeAnimationUNORM16((raw[i].z - range_min.z) / range_extent.z) : 0;
+				const XMVECTOR unorm = XMVectorSet(float(dst[0]), float(dst[1]), float(dst[2]), 0) * (1.0f / 65535.0f);
+				XMStoreFloat4(&decoded[i], XMVectorMultiplyAdd(unorm, XMLoadFloat3(&range_extent), XMLoadFloat3(&range_min)));
+			}
+		}
+
+		// The error of a reduced segment is checked at every original keyframe that it covers:
+		auto get_error = [&](XMVECTOR approximation, size_t key) {
+			if (quaternion)
+			{
+				// Rotation angle between the quaternions, computed from the chord length because acos(dot) is imprecise for small angles:
+				XMVECTOR original = XMLoadFloat4(&raw[key]);
+				if (XMVectorGetX(XMQuaternionDot(approximation, original)) < 0)
+				{
+					original = -original;
+				}
+				const float chord = XMVectorGetX(XMVector4Length(approximation - original));
+				return 4 * std::asin(std::min(1.0f, chord * 0.5f));
+			}
+			return XMVectorGetX(XMVector3Length(approximation - XMLoadFloat4(&raw[key])));
+		};
+		auto get_quantized_time = [&](size_t key) {
+			return time_start + float(quantized_times[key]) * (time_range / 65535.0f);
+		};
+		auto is_segment_valid = [&](size_t left, size_t right) {
+			const XMVECTOR vLeft = XMLoadFloat4(&decoded[left]);
+			const XMVECTOR vRight = XMLoadFloat4(&decoded[right]);
+			const float time_left = get_quantized_time(left);
+			const float time_right = get_quantized_time(right);
+			// The segment end points are also checked, because their times moved by quantization:
+			for (size_t key = left; key <= right; ++key)
+			{
+				XMVECTOR approximation = vLeft;
+				if (!step)
+				{
+					// Interpolated with the quantized keyframe times, because that's what will happen during sampling:
+					const float t = (keyframe_times[key] - time_left) / std::max(std::numeric_limits<float>::epsilon(), time_right - time_left);
+					approximation = quaternion ? XMQuaternionNormalize(XMQuaternionSlerp(vLeft, vRight, t)) : XMVectorLerp(vLeft, vRight, t);
+				}
+				if (get_error(approximation, key) > max_error)
+					return false;
+			}
+			return true;
+		};
+
+		// Greedy key reduction: every segment is extended as long as it stays within the error bound
+		//	Segments are limited in length to keep the worst case compression time linear
+		static constexpr size_t max_segment_length = 256;
+		wi::vector<uint32_t> kept;
+		kept.push_back(0);
+		size_t left = 0;
+		while (left + 1 < count)
+		{
+			size_t right = left + 1;
+			for (size_t candidate = left + 2; candidate < count && candidate - left <= max_segment_length; ++candidate)
+			{
+				if (!is_segment_valid(left, candidate))
+					break;
+				right = candidate;
+			}
+			kept.push_back((uint32_t)right);
+			left = right;
+		}
+
+		// Reduced keyframes must have distinct quantized times to be searchable:
+		for (size_t i = 1; i < kept.size(); ++i)
+		{
+			if (quantized_times[kept[i]] <= quantized_times[kept[i - 1]])
+				return false;
+		}
+
+		compressed_times.resize(kept.size());
+		compressed_data.resize(kept.size() * 3);
+		for (size_t i = 0; i < kept.size(); ++i)
+		{
+			compressed_times[i] = quantized_times[kept[i]];
+			std::memcpy(compressed_data.data() + i * 3, quantized_data.data() + kept[i] * 3, sizeof(uint16_t) * 3);
+		}
+		_flags |= flags;
+		wi::vector<float>().swap(keyframe_times);
+		wi::vector<float>().swap(keyframe_data);
+		return true;
+	}
+	size_t AnimationDataComponent::GetMemorySize() const
+	{
+		return
+			keyframe_times.size() * sizeof(float) +
+			keyframe_data.size() * sizeof(float) +
+			compressed_times.size() * sizeof(uint16_t) +
+			compressed_data.size() * sizeof(uint16_t);
+	}
+
 
 
 	const uint32_t small_subtask_groupsize = 64u;
 
+	void* GPUArrayTracker::Begin(size_t element_stride, size_t element_count, bool gpu_buffer_recreated)
+	{
+		if (gpu_buffer_recreated || element_stride != stride || element_count != count || !consumed)
+		{
+			// The GPU buffer contents can't be trusted, or the renderer didn't copy the previous changes:
+			full_upload = true;
+		}
+		stride = element_stride;
+		count = element_count;
+		current.resize(stride * count);
+		previous.resize(current.size());
+		return current.data();
+	}
+	void GPUArrayTracker::Upload(wi::jobsystem::context& ctx, void* mapped_upload_data)
+	{
+		copy_ranges.clear();
+		upload_size = 0;
+		consumed = false;
+
+		if (current.empty() || mapped_upload_data == nullptr)
+			return;
+
+		const size_t block_size = block_element_count * stride;
+		const size_t block_count = (current.size() + block_size - 1) / block_size;
+		dirty_blocks.resize(block_count);
+		uint8_t* upload_data = (uint8_t*)mapped_upload_data;
+
+		wi::jobsystem::Dispatch(ctx, (uint32_t)block_count, small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+			const size_t offset = args.jobIndex * block_size;
+			const size_t size = std::min(block_size, current.size() - offset);
+			if (full_upload || std::memcmp(current.data() + offset, previous.data() + offset, size) != 0)
+			{
+				std::memcpy(upload_data + offset, current.data() + offset, size);
+				std::memcpy(previous.data() + offset, current.data() + offset, size);
+				dirty_blocks[args.jobIndex] = 1;
+			}
+			else
+			{
+				dirty_blocks[args.jobIndex] = 0;
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		full_upload = false;
+
+		// Merge neighbouring dirty blocks into copy ranges:
+		for (size_t i = 0; i < block_count; ++i)
+		{
+			if (dirty_blocks[i] == 0)
+				continue;
+			const uint64_t offset = i * block_size;
+			const uint64_t size = std::min(block_size, current.size() - offset);
+			if (!copy_ranges.empty() && copy_ranges.back().offset + copy_ranges.back().size == offset)
+			{
+				copy_ranges.back().size += size;
+			}
+			else
+			{
+				copy_ranges.push_back({ offset, size });
+			}
+			upload_size += size;
+		}
+		consumed = copy_ranges.empty();
+	}
+
 	void Scene::Update(float dt)
 	{
 		this->dt = dt;
@@ -1481,7 +2228,8 @@ namespace wi::scene
 			impostorInstanceOffset = uint32_t(instanceArraySize);
 			instanceArraySize += 1;
 		}
-		if (instanceBuffer.desc.size < (instanceArraySize * sizeof(ShaderMeshInstance)))
+		const bool instanceBufferRecreated = instanceBuffer.desc.size < (instanceArraySize * sizeof(ShaderMeshInstance));
+		if (instanceBufferRecreated)
 		{
 			GPUBufferDesc desc;
 			desc.stride = sizeof(ShaderMeshInstance);
@@ -1500,7 +2248,7 @@ namespace wi::scene
 				device->SetName(&instanceUploadBuffer[i], "Scene::instanceUploadBuffer");
 			}
 		}
-		instanceArrayMapped = (ShaderMeshInstance*)instanceUploadBuffer[device->GetBufferIndex()].mapped_data;
+		instanceArrayMapped = (ShaderMeshInstance*)instanceTracker.Begin(sizeof(ShaderMeshInstance), instanceArraySize, instanceBufferRecreated);
 
 		materialArraySize = materials.GetCount();
 		if (impostors.GetCount() > 0)
@@ -1508,7 +2256,8 @@ namespace wi::scene
 			impostorMaterialOffset = uint32_t(materialArraySize);
 			materialArraySize += 1;
 		}
-		if (materialBuffer.desc.size < (materialArraySize * sizeof(ShaderMaterial)))
+		const bool materialBufferRecreated = materialBuffer.desc.size < (materialArraySize * sizeof(ShaderMaterial));
+		if (materialBufferRecreated)
 		{
 			GPUBufferDesc desc;
 			desc.stride = sizeof(ShaderMaterial);
@@ -1527,7 +2276,7 @@ namespace wi::scene
 				device->SetName(&materialUploadBuffer[i], "Scene::materialUploadBuffer");
 			}
 		}
-		materialArrayMapped = (ShaderMaterial*)materialUploadBuffer[device->GetBufferIndex()].mapped_data;
+		materialArrayMapped = (ShaderMaterial*)materialTracker.Begin(sizeof(ShaderMaterial), materialArraySize, materialBufferRecreated);
 
 		TLAS_instancesMapped = nullptr;
 		if (device->CheckCapability(GraphicsDeviceCapability::RAYTRACING))
@@ -1613,6 +2362,24 @@ namespace wi::scene
 
 		wi::physics::RunPhysicsUpdateSystem(ctx, *this, dt);
 
+		// Decide which armatures are updated in this frame, the updates of throttled armatures are staggered by their entity:
+		animation_lod_frame++;
+		animation_lod_statistics = {};
+		for (size_t i = 0; i < armatures.GetCount(); ++i)
+		{
+			ArmatureComponent& armature = armatures[i];
+			const uint32_t interval = animation_lod.enabled ? std::max(1u, armature.lod_update_interval) : 1u;
+			armature.lod_update = interval == 1 || ((animation_lod_frame + armatures.GetEntity(i)) % interval) == 0;
+			if (armature.lod_update)
+			{
+				animation_lod_statistics.armatures_updated++;
+			}
+			else
+			{
+				animation_lod_statistics.armatures_skipped++;
+			}
+		}
+
 		RunAnimationUpdateSystem(ctx);
 
 		RunTransformUpdateSystem(ctx);
@@ -1630,7 +2397,8 @@ namespace wi::scene
 			impostorGeometryOffset = uint32_t(geometryArraySize);
 			geometryArraySize += 1;
 		}
-		if (geometryBuffer.desc.size < (geometryArraySize * sizeof(ShaderGeometry)))
+		const bool geometryBufferRecreated = geometryBuffer.desc.size < (geometryArraySize * sizeof(ShaderGeometry));
+		if (geometryBufferRecreated)
 		{
 			GPUBufferDesc desc;
 			desc.stride = sizeof(ShaderGeometry);
@@ -1649,7 +2417,7 @@ namespace wi::scene
 				device->SetName(&geometryUploadBuffer[i], "Scene::geometryUploadBuffer");
 			}
 		}
-		geometryArrayMapped = (ShaderGeometry*)geometryUploadBuffer[device->GetBufferIndex()].mapped_data;
+		geometryArrayMapped = (ShaderGeometry*)geometryTracker.Begin(sizeof(ShaderGeometry), geometryArraySize, geometryBufferRecreated);
 
 		RunMeshUpdateSystem(ctx);
 
@@ -1667,6 +2435,30 @@ namespace wi::scene
 
 		wi::jobsystem::Wait(ctx); // dependencies
 
+		// The bones were updated, skinned positions will be recomputed when they are requested again:
+		skinning_cache.locker.lock();
+		skinning_cache.generation++;
+		for (auto it = skinning_cache.entries.begin(); it != skinning_cache.entries.end();)
+		{
+			if (skinning_cache.generation - it->second.generation > 60)
+			{
+				it = skinning_cache.entries.erase(it); // not requested for a while
+			}
+			else
+			{
+				++it;
+			}
+		}
+		skinning_cache.locker.unlock();
+
+		if (animation_lod.enabled)
+		{
+			wi::profiler::SetCounter("Animation LOD updated armatures", animation_lod_statistics.armatures_updated);
+			wi::profiler::SetCounter("Animation LOD skipped armatures", animation_lod_statistics.armatures_skipped);
+			wi::profiler::SetCounter("Animation LOD skipped animations", animation_lod_statistics.animations_skipped);
+			wi::profiler::SetCounter("Animation LOD skipped IK and springs", animation_lod_statistics.inverse_kinematics_skipped + animation_lod_statistics.springs_skipped);
+		}
+
 		RunObjectUpdateSystem(ctx);
 
 		RunCameraUpdateSystem(ctx);
@@ -1687,6 +2479,11 @@ namespace wi::scene
 
 		wi::jobsystem::Wait(ctx); // dependencies
 
+		// Only the scene data that changed since the last frame will be written to the upload buffers:
+		instanceTracker.Upload(ctx, instanceUploadBuffer[device->GetBufferIndex()].mapped_data);
+		geometryTracker.Upload(ctx, geometryUploadBuffer[device->GetBufferIndex()].mapped_data);
+		materialTracker.Upload(ctx, materialUploadBuffer[device->GetBufferIndex()].mapped_data);
+
 		// Merge parallel bounds computation (depends on object update system):
 		bounds = AABB();
 		for (auto& group_bound : parallel_bounds)
@@ -2057,6 +2854,8 @@ namespace wi::scene
 		TLAS = RaytracingAccelerationStructure();
 		BVH.Clear();
 		waterRipples.clear();
+		skinning_cache.entries.clear();
+		physics_scene = {};
 
 		surfelBuffer = {};
 		surfelDataBuffer = {};
@@ -2069,6 +2868,16 @@ namespace wi::scene
 	}
 	void Scene::Merge(Scene& other)
 	{
+		// Physics objects belong to the physics world of the other scene, they will be recreated in this scene:
+		for (size_t i = 0; i < other.rigidbodies.GetCount(); ++i)
+		{
+			other.rigidbodies[i].physicsobject = nullptr;
+		}
+		for (size_t i = 0; i < other.softbodies.GetCount(); ++i)
+		{
+			other.softbodies[i].physicsobject = nullptr;
+		}
+
 		names.Merge(other.names);
 		layers.Merge(other.layers);
 		transforms.Merge(other.transforms);
@@ -2457,10 +3266,426 @@ namespace wi::scene
 			}
 		}
 	}
+	size_t Scene::CompressAnimations(float translation_error, float rotation_error, float scale_error)
+	{
+		// Find out how every animation data is used, the same data could be referenced by multiple channels:
+		struct Usage
+		{
+			AnimationComponent::AnimationChannel::Path path = AnimationComponent::AnimationChannel::Path::UNKNOWN;
+			AnimationComponent::AnimationSampler::Mode mode = AnimationComponent::AnimationSampler::Mode::LINEAR;
+			bool conflict = false;
+		};
+		wi::unordered_map<Entity, Usage> usages;
+		for (size_t i = 0; i < animations.GetCount(); ++i)
+		{
+			const AnimationComponent& animation = animations[i];
+			for (const AnimationComponent::AnimationChannel& channel : animation.channels)
+			{
+				if (channel.samplerIndex < 0 || channel.samplerIndex >= (int)animation.samplers.size())
+					continue;
+				const AnimationComponent::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+				auto it = usages.find(sampler.data);
+				if (it == usages.end())
+				{
+					Usage& usage = usages[sampler.data];
+					usage.path = channel.path;
+					usage.mode = sampler.mode;
+				}
+				else if (it->second.path != channel.path || it->second.mode != sampler.mode)
+				{
+					it->second.conflict = true;
+				}
+			}
+		}
+
+		std::atomic<size_t> compressed_count{ 0 };
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)animation_datas.GetCount(), 1, [&](wi::jobsystem::JobArgs args) {
+			auto it = usages.find(animation_datas.GetEntity(args.jobIndex));
+			if (it == usages.end() || it->second.conflict || it->second.mode == AnimationComponent::AnimationSampler::Mode::CUBICSPLINE)
+				return;
+			AnimationDataComponent& animationdata = animation_datas[args.jobIndex];
+			const bool step = it->second.mode == AnimationComponent::AnimationSampler::Mode::STEP;
+			bool compressed = false;
+			switch (it->second.path)
+			{
+			case AnimationComponent::AnimationChannel::Path::TRANSLATION:
+				compressed = animationdata.Compress(false, step, translation_error);
+				break;
+			case AnimationComponent::AnimationChannel::Path::ROTATION:
+				compressed = animationdata.Compress(true, step, rotation_error);
+				break;
+			case AnimationComponent::AnimationChannel::Path::SCALE:
+				compressed = animationdata.Compress(false, step, scale_error);
+				break;
+			default:
+				break;
+			}
+			if (compressed)
+			{
+				compressed_count.fetch_add(1);
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		return compressed_count.load();
+	}
+	size_t Scene::GenerateMeshLODs(const MeshComponent::LODGenerationParams& params)
+	{
+		wi::vector<MeshComponent*> targets;
+		for (size_t i = 0; i < meshes.GetCount(); ++i)
+		{
+			MeshComponent& mesh = meshes[i];
+			if (mesh.subsets_per_lod > 0 || mesh.indices.size() / 3 < params.min_triangles * 2)
+				continue;
+			if (softbodies.Contains(meshes.GetEntity(i)))
+				continue; // soft body simulation uses all indices of the mesh
+			targets.push_back(&mesh);
+		}
+
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)targets.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			MeshComponent& mesh = *targets[args.jobIndex];
+			mesh.GenerateLODs(params);
+			if (mesh.subsets_per_lod > 0)
+			{
+				mesh.CreateRenderData();
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		size_t count = 0;
+		for (const MeshComponent* mesh : targets)
+		{
+			if (mesh->subsets_per_lod > 0)
+			{
+				count++;
+			}
+		}
+		return count;
+	}
+
+	Scene::AtlasGenerationStatistics Scene::GenerateMeshAtlases(const wi::vector<Entity>& meshEntities, uint32_t resolution, const std::function<void(uint32_t finished, uint32_t total)>& progress)
+	{
+		AtlasGenerationStatistics statistics;
+		wi::Timer timer;
+
+		struct Target
+		{
+			Entity entity = INVALID_ENTITY;
+			MeshComponent* mesh = nullptr;
+			float milliseconds = 0;
+			bool success = false;
+		};
+		wi::vector<Target> targets;
+		wi::unordered_set<Entity> unique_entities;
+		for (Entity entity : meshEntities)
+		{
+			MeshComponent* mesh = meshes.GetComponent(entity);
+			if (mesh == nullptr || !unique_entities.insert(entity).second)
+				continue;
+			if (mesh->IsAtlasUpToDate(resolution))
+			{
+				statistics.skipped++;
+				continue;
+			}
+			Target& target = targets.emplace_back();
+			target.entity = entity;
+			target.mesh = mesh;
+		}
+
+		// Bigger meshes are started first, so that the slowest ones don't end up last on a single thread:
+		std::sort(targets.begin(), targets.end(), [](const Target& a, const Target& b) {
+			return a.mesh->indices.size() > b.mesh->indices.size();
+		});
+
+		const uint32_t total = (uint32_t)targets.size();
+		std::atomic<uint32_t> finished{ 0 };
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, total, 1, [&](wi::jobsystem::JobArgs args) {
+			Target& target = targets[args.jobIndex];
+			wi::Timer mesh_timer;
+			target.success = target.mesh->GenerateAtlas(resolution);
+			if (target.success)
+			{
+				target.mesh->CreateRenderData();
+			}
+			target.milliseconds = (float)mesh_timer.elapsed_milliseconds();
+			const uint32_t finished_count = finished.fetch_add(1) + 1;
+			if (progress != nullptr)
+			{
+				progress(finished_count, total);
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		for (const Target& target : targets)
+		{
+			if (!target.success)
+			{
+				statistics.failed++;
+				continue;
+			}
+			statistics.generated++;
+			statistics.mesh_milliseconds_sum += target.milliseconds;
+			if (target.milliseconds > statistics.mesh_milliseconds_max)
+			{
+				statistics.mesh_milliseconds_max = target.milliseconds;
+				statistics.slowest_mesh = target.entity;
+			}
+		}
+		statistics.total_milliseconds = (float)timer.elapsed_milliseconds();
+		return statistics;
+	}
+
+
+	// Finds the keyframes around the animation timer
+	//	The channel remembers the last right keyframe, so continuous playback doesn't need to search at all
+	//	If the timer jumped (looping, seeking, fast playback), a binary search is performed
+	//	get_time	:	returns the time of a keyframe, this way both raw and compressed keyframes can be searched
+	template<typename GetTime>
+	static void FindAnimationKeyframes(int count, const GetTime& get_time, float timer, int& cursor, int& keyLeft, int& keyRight)
+	{
+		if (get_time(count - 1) < timer)
+		{
+			// Rightmost keyframe is already outside animation, so just snap to last keyframe:
+			keyLeft = keyRight = count - 1;
+			cursor = keyRight;
+			return;
+		}
+
+		// The right keyframe is the first one that is greater/equal to anim time:
+		auto is_right_keyframe = [&](int key) {
+			return key >= 0 && key < count && get_time(key) >= timer && (key == 0 || get_time(key - 1) < timer);
+		};
+		if (is_right_keyframe(cursor))
+		{
+			keyRight = cursor;
+		}
+		else if (is_right_keyframe(cursor + 1))
+		{
+			keyRight = cursor + 1;
+		}
+		else
+		{
+			int first = 0;
+			int last = count - 1;
+			while (first < last)
+			{
+				const int middle = first + (last - first) / 2;
+				if (get_time(middle) < timer)
+				{
+					first = middle + 1;
+				}
+				else
+				{
+					last = middle;
+				}
+			}
+			keyRight = first;
+		}
+		cursor = keyRight;
+
+		// Left keyframe is just near right:
+		keyLeft = std::max(0, keyRight - 1);
+	}
+
+	// Samples a compressed translation, rotation or scale channel between two keyframes
+	static void SampleCompressedAnimationChannel(
+		const AnimationComponent::AnimationSampler& sampler,
+		const AnimationDataComponent& animationdata,
+		float timer,
+		int keyLeft,
+		int keyRight,
+		XMFLOAT4& value
+	)
+	{
+		const XMVECTOR vLeft = animationdata.GetCompressedValue(keyLeft);
+		if (keyLeft == keyRight || sampler.mode == AnimationComponent::AnimationSampler::Mode::STEP)
+		{
+			XMStoreFloat4(&value, vLeft);
+			return;
+		}
+		const float left = animationdata.GetCompressedTime(keyLeft);
+		const float right = animationdata.GetCompressedTime(keyRight);
+		const float t = (timer - left) / (right - left);
+		const XMVECTOR vRight = animationdata.GetCompressedValue(keyRight);
+		if (animationdata._flags & AnimationDataComponent::COMPRESSED_QUATERNION)
+		{
+			XMStoreFloat4(&value, XMQuaternionNormalize(XMQuaternionSlerp(vLeft, vRight, t)));
+		}
+		else
+		{
+			XMStoreFloat4(&value, XMVectorLerp(vLeft, vRight, t));
+		}
+	}
+
+	// Samples an animation channel between two keyframes
+	//	value	:	the result of translation, rotation and scale channels
+	//	weights	:	the result of morph target weight channels, weight_count elements
+	static void SampleAnimationChannel(
+		const AnimationComponent::AnimationChannel& channel,
+		const AnimationComponent::AnimationSampler& sampler,
+		const AnimationDataComponent& animationdata,
+		float timer,
+		float dt,
+		int keyLeft,
+		int keyRight,
+		XMFLOAT4& value,
+		float* weights,
+		size_t weight_count
+	)
+	{
+		float t = 0;
+		if (keyLeft != keyRight)
+		{
+			const float left = animationdata.keyframe_times[keyLeft];
+			const float right = animationdata.keyframe_times[keyRight];
+			t = (timer - left) / (right - left);
+		}
+
+		switch (sampler.mode)
+		{
+		default:
+		case AnimationComponent::AnimationSampler::Mode::STEP:
+		{
+			// Nearest neighbor method (snap to left):
+			switch (channel.path)
+			{
+			default:
+			case AnimationComponent::AnimationChannel::Path::TRANSLATION:
+			case AnimationComponent::AnimationChannel::Path::SCALE:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * 3);
+				const XMFLOAT3 data = ((const XMFLOAT3*)animationdata.keyframe_data.data())[keyLeft];
+				value = XMFLOAT4(data.x, data.y, data.z, 0);
+			}
+			break;
+			case AnimationComponent::AnimationChannel::Path::ROTATION:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * 4);
+				value = ((const XMFLOAT4*)animationdata.keyframe_data.data())[keyLeft];
+			}
+			break;
+			case AnimationComponent::AnimationChannel::Path::WEIGHTS:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * weight_count);
+				for (size_t j = 0; j < weight_count; ++j)
+				{
+					weights[j] = animationdata.keyframe_data[keyLeft * weight_count + j];
+				}
+			}
+			break;
+			}
+		}
+		break;
+		case AnimationComponent::AnimationSampler::Mode::LINEAR:
+		{
+			// Linear interpolation method:
+			switch (channel.path)
+			{
+			default:
+			case AnimationComponent::AnimationChannel::Path::TRANSLATION:
+			case AnimationComponent::AnimationChannel::Path::SCALE:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * 3);
+				const XMFLOAT3* data = (const XMFLOAT3*)animationdata.keyframe_data.data();
+				XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft]);
+				XMVECTOR vRight = XMLoadFloat3(&data[keyRight]);
+				XMVECTOR vAnim = XMVectorLerp(vLeft, vRight, t);
+				XMStoreFloat4(&value, vAnim);
+			}
+			break;
+			case AnimationComponent::AnimationChannel::Path::ROTATION:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * 4);
+				const XMFLOAT4* data = (const XMFLOAT4*)animationdata.keyframe_data.data();
+				XMVECTOR vLeft = XMLoadFloat4(&data[keyLeft]);
+				XMVECTOR vRight = XMLoadFloat4(&data[keyRight]);
+				XMVECTOR vAnim = XMQuaternionSlerp(vLeft, vRight, t);
+				vAnim = XMQuaternionNormalize(vAnim);
+				XMStoreFloat4(&value, vAnim);
+			}
+			break;
+			case AnimationComponent::AnimationChannel::Path::WEIGHTS:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * weight_count);
+				for (size_t j = 0; j < weight_count; ++j)
+				{
+					float vLeft = animationdata.keyframe_data[keyLeft * weight_count + j];
+					float vRight = animationdata.keyframe_data[keyRight * weight_count + j];
+					weights[j] = wi::math::Lerp(vLeft, vRight, t);
+				}
+			}
+			break;
+			}
+		}
+		break;
+		case AnimationComponent::AnimationSampler::Mode::CUBICSPLINE:
+		{
+			// Cubic Spline interpolation method:
+			const float t2 = t * t;
+			const float t3 = t2 * t;
+
+			switch (channel.path)
+			{
+			default:
+			case AnimationComponent::AnimationChannel::Path::TRANSLATION:
+			case AnimationComponent::AnimationChannel::Path::SCALE:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * 3 * 3);
+				const XMFLOAT3* data = (const XMFLOAT3*)animationdata.keyframe_data.data();
+				XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft * 3 + 1]);
+				XMVECTOR vLeftTanOut = dt * XMLoadFloat3(&data[keyLeft * 3 + 2]);
+				XMVECTOR vRightTanIn = dt * XMLoadFloat3(&data[keyRight * 3 + 0]);
+				XMVECTOR vRight = XMLoadFloat3(&data[keyRight * 3 + 1]);
+				XMVECTOR vAnim = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
+				XMStoreFloat4(&value, vAnim);
+			}
+			break;
+			case AnimationComponent::AnimationChannel::Path::ROTATION:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * 4 * 3);
+				const XMFLOAT4* data = (const XMFLOAT4*)animationdata.keyframe_data.data();
+				XMVECTOR vLeft = XMLoadFloat4(&data[keyLeft * 3 + 1]);
+				XMVECTOR vLeftTanOut = dt * XMLoadFloat4(&data[keyLeft * 3 + 2]);
+				XMVECTOR vRightTanIn = dt * XMLoadFloat4(&data[keyRight * 3 + 0]);
+				XMVECTOR vRight = XMLoadFloat4(&data[keyRight * 3 + 1]);
+				XMVECTOR vAnim = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
+				vAnim = XMQuaternionNormalize(vAnim);
+				XMStoreFloat4(&value, vAnim);
+			}
+			break;
+			case AnimationComponent::AnimationChannel::Path::WEIGHTS:
+			{
+				assert(animationdata.keyframe_data.size() == animationdata.keyframe_times.size() * weight_count * 3);
+				for (size_t j = 0; j < weight_count; ++j)
+				{
+					float vLeft = animationdata.keyframe_data[(keyLeft * weight_count + j) * 3 + 1];
+					float vLeftTanOut = animationdata.keyframe_data[(keyLeft * weight_count + j) * 3 + 2];
+					float vRightTanIn = animationdata.keyframe_data[(keyRight * weight_count + j) * 3 + 0];
+					float vRight = animationdata.keyframe_data[(keyRight * weight_count + j) * 3 + 1];
+					weights[j] = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
+				}
+			}
+			break;
+			}
+		}
+		break;
+		}
+	}
 
-
 	void Scene::RunAnimationUpdateSystem(wi::jobsystem::context& ctx)
 	{
+		// The animation update waits for its own jobs only, not the ones that were launched before into ctx:
+		wi::jobsystem::context animation_ctx;
+		wi::vector<AnimationChannelJob>& jobs = animation_jobs;
+		wi::vector<uint64_t>& job_keys = animation_job_keys;
+		wi::vector<uint64_t>& job_keys_scratch = animation_job_keys_scratch;
+		wi::vector<uint32_t>& target_offsets = animation_target_offsets;
+		jobs.clear();
+
+		// Gather the channels of active animations:
 		for (size_t i = 0; i < animations.GetCount(); ++i)
 		{
 			AnimationComponent& animation = animations[i];
@@ -2469,7 +3694,18 @@ namespace wi::scene
 				continue;
 			}
 
-			for (const AnimationComponent::AnimationChannel& channel : animation.channels)
+			if (animation.lod_armature != INVALID_ENTITY)
+			{
+				// The animation is sampled only when its armature is updated, the timer is still advanced:
+				const ArmatureComponent* armature = armatures.GetComponent(animation.lod_armature);
+				if (armature != nullptr && !armature->lod_update)
+				{
+					animation_lod_statistics.animations_skipped++;
+					continue;
+				}
+			}
+
+			for (AnimationComponent::AnimationChannel& channel : animation.channels)
 			{
 				assert(channel.samplerIndex < (int)animation.samplers.size());
 				AnimationComponent::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
@@ -2481,268 +3717,150 @@ namespace wi::scene
 					sampler.backwards_compatibility_data.keyframe_times.clear();
 					sampler.backwards_compatibility_data.keyframe_data.clear();
 				}
-				const AnimationDataComponent* animationdata = animation_datas.GetComponent(sampler.data);
-				if (animationdata == nullptr)
-				{
-					continue;
-				}
 
-				int keyLeft = 0;
-				int keyRight = 0;
+				AnimationChannelJob& job = jobs.emplace_back();
+				job.animation = &animation;
+				job.channel = &channel;
+				job.sampler = &sampler;
+			}
+		}
+		if (jobs.empty())
+			return;
+
+		// Resolve targets and sample every channel in parallel, only the channel itself is written here:
+		job_keys.resize(jobs.size());
+		job_keys_scratch.resize(jobs.size());
+		wi::jobsystem::Dispatch(animation_ctx, (uint32_t)jobs.size(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+			AnimationChannelJob& job = jobs[args.jobIndex];
+			Entity target = INVALID_ENTITY;
+			job_keys[args.jobIndex] = uint64_t(args.jobIndex);
+
+			job.animationdata = animation_datas.GetComponent(job.sampler->data);
+			if (job.animationdata == nullptr || job.animationdata->GetKeyframeCount() == 0)
+				return;
+			const bool compressed = job.animationdata->IsCompressed();
+
+			if (job.channel->path == AnimationComponent::AnimationChannel::Path::WEIGHTS)
+			{
+				const ObjectComponent* object = objects.GetComponent(job.channel->target);
+				if (object == nullptr || compressed)
+					return;
+				job.target_mesh = meshes.GetComponent(object->meshID);
+				if (job.target_mesh == nullptr)
+					return;
+				target = object->meshID;
+			}
+			else
+			{
+				job.target_transform = transforms.GetComponent(job.channel->target);
+				if (job.target_transform == nullptr)
+					return;
+				target = job.channel->target;
+			}
 
-				if (animationdata->keyframe_times.back() < animation.timer)
-				{
-					// Rightmost keyframe is already outside animation, so just snap to last keyframe:
-					keyLeft = keyRight = (int)animationdata->keyframe_times.size() - 1;
-				}
-				else
+			if (compressed)
+			{
+				const AnimationDataComponent& animationdata = *job.animationdata;
+				FindAnimationKeyframes((int)animationdata.GetKeyframeCount(), [&](int key) { return animationdata.GetCompressedTime(key); }, job.animation->timer, job.channel->next_key, job.keyLeft, job.keyRight);
+				SampleCompressedAnimationChannel(*job.sampler, animationdata, job.animation->timer, job.keyLeft, job.keyRight, job.value);
+			}
+			else
+			{
+				const wi::vector<float>& keyframe_times = job.animationdata->keyframe_times;
+				FindAnimationKeyframes((int)keyframe_times.size(), [&](int key) { return keyframe_times[key]; }, job.animation->timer, job.channel->next_key, job.keyLeft, job.keyRight);
+				if (job.target_transform != nullptr)
 				{
-					// Search for the right keyframe (greater/equal to anim time):
-					while (animationdata->keyframe_times[keyRight++] < animation.timer) {}
-					keyRight--;
-
-					// Left keyframe is just near right:
-					keyLeft = std::max(0, keyRight - 1);
+					SampleAnimationChannel(*job.channel, *job.sampler, *job.animationdata, job.animation->timer, dt, job.keyLeft, job.keyRight, job.value, nullptr, 0);
 				}
+			}
 
-				float left = animationdata->keyframe_times[keyLeft];
-
-				TransformComponent transform;
+			job_keys[args.jobIndex] |= uint64_t(target) << 32ull;
+		});
+		wi::jobsystem::Wait(animation_ctx);
 
-				TransformComponent* target_transform = nullptr;
-				MeshComponent* target_mesh = nullptr;
+		// Group channels by target, keeping the original order inside groups (animations are blended in order):
+		wi::sort::RadixSortParallel(job_keys.data(), job_keys_scratch.data(), job_keys.size(), animation_job_histograms);
+		target_offsets.clear();
+		for (size_t i = 0; i < job_keys.size(); ++i)
+		{
+			if (i == 0 || (job_keys[i] >> 32ull) != (job_keys[i - 1] >> 32ull))
+			{
+				target_offsets.push_back((uint32_t)i);
+			}
+		}
+		const uint32_t target_count = (uint32_t)target_offsets.size();
+		target_offsets.push_back((uint32_t)job_keys.size());
 
-				if (channel.path == AnimationComponent::AnimationChannel::Path::WEIGHTS)
-				{
-					ObjectComponent* object = objects.GetComponent(channel.target);
-					if (object == nullptr)
-						continue;
-					target_mesh = meshes.GetComponent(object->meshID);
-					if (target_mesh == nullptr)
-						continue;
-					animation.morph_weights_temp.resize(target_mesh->targets.size());
-				}
-				else
-				{
-					target_transform = transforms.GetComponent(channel.target);
-					if (target_transform == nullptr)
-						continue;
-					transform = *target_transform;
-				}
+		// Apply the results, every target is written by only one job:
+		wi::jobsystem::Dispatch(animation_ctx, target_count, small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t begin = target_offsets[args.jobIndex];
+			const uint32_t end = target_offsets[args.jobIndex + 1];
+			if ((job_keys[begin] >> 32ull) == INVALID_ENTITY)
+				return; // channels without valid target
 
-				switch (sampler.mode)
-				{
-				default:
-				case AnimationComponent::AnimationSampler::Mode::STEP:
-				{
-					// Nearest neighbor method (snap to left):
-					switch (channel.path)
-					{
-					default:
-					case AnimationComponent::AnimationChannel::Path::TRANSLATION:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3);
-						transform.translation_local = ((const XMFLOAT3*)animationdata->keyframe_data.data())[keyLeft];
-					}
-					break;
-					case AnimationComponent::AnimationChannel::Path::ROTATION:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 4);
-						transform.rotation_local = ((const XMFLOAT4*)animationdata->keyframe_data.data())[keyLeft];
-					}
-					break;
-					case AnimationComponent::AnimationChannel::Path::SCALE:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3);
-						transform.scale_local = ((const XMFLOAT3*)animationdata->keyframe_data.data())[keyLeft];
-					}
-					break;
-					case AnimationComponent::AnimationChannel::Path::WEIGHTS:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * animation.morph_weights_temp.size());
-						for (size_t j = 0; j < animation.morph_weights_temp.size(); ++j)
-						{
-							animation.morph_weights_temp[j] = animationdata->keyframe_data[keyLeft * animation.morph_weights_temp.size() + j];
-						}
-					}
-					break;
-					}
-				}
-				break;
-				case AnimationComponent::AnimationSampler::Mode::LINEAR:
-				{
-					// Linear interpolation method:
-					float t;
-					if (keyLeft == keyRight)
-					{
-						t = 0;
-					}
-					else
-					{
-						float right = animationdata->keyframe_times[keyRight];
-						t = (animation.timer - left) / (right - left);
-					}
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				const AnimationChannelJob& job = jobs[job_keys[i] & 0xFFFFFFFF];
+				const float t = job.animation->amount;
 
-					switch (channel.path)
-					{
-					default:
-					case AnimationComponent::AnimationChannel::Path::TRANSLATION:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3);
-						const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
-						XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft]);
-						XMVECTOR vRight = XMLoadFloat3(&data[keyRight]);
-						XMVECTOR vAnim = XMVectorLerp(vLeft, vRight, t);
-						XMStoreFloat3(&transform.translation_local, vAnim);
-					}
-					break;
-					case AnimationComponent::AnimationChannel::Path::ROTATION:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 4);
-						const XMFLOAT4* data = (const XMFLOAT4*)animationdata->keyframe_data.data();
-						XMVECTOR vLeft = XMLoadFloat4(&data[keyLeft]);
-						XMVECTOR vRight = XMLoadFloat4(&data[keyRight]);
-						XMVECTOR vAnim = XMQuaternionSlerp(vLeft, vRight, t);
-						vAnim = XMQuaternionNormalize(vAnim);
-						XMStoreFloat4(&transform.rotation_local, vAnim);
-					}
-					break;
-					case AnimationComponent::AnimationChannel::Path::SCALE:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3);
-						const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
-						XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft]);
-						XMVECTOR vRight = XMLoadFloat3(&data[keyRight]);
-						XMVECTOR vAnim = XMVectorLerp(vLeft, vRight, t);
-						XMStoreFloat3(&transform.scale_local, vAnim);
-					}
-					break;
-					case AnimationComponent::AnimationChannel::Path::WEIGHTS:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * animation.morph_weights_temp.size());
-						for (size_t j = 0; j < animation.morph_weights_temp.size(); ++j)
-						{
-							float vLeft = animationdata->keyframe_data[keyLeft * animation.morph_weights_temp.size() + j];
-							float vRight = animationdata->keyframe_data[keyLeft * animation.morph_weights_temp.size() + j];
-							float vAnim = wi::math::Lerp(vLeft, vRight, t);
-							animation.morph_weights_temp[j] = vAnim;
-						}
-					}
-					break;
-					}
-				}
-				break;
-				case AnimationComponent::AnimationSampler::Mode::CUBICSPLINE:
+				if (job.target_transform != nullptr)
 				{
-					// Cubic Spline interpolation method:
-					float t;
-					if (keyLeft == keyRight)
-					{
-						t = 0;
-					}
-					else
-					{
-						float right = animationdata->keyframe_times[keyRight];
-						t = (animation.timer - left) / (right - left);
-					}
-
-					const float t2 = t * t;
-					const float t3 = t2 * t;
+					TransformComponent& target_transform = *job.target_transform;
+					target_transform.SetDirty();
 
-					switch (channel.path)
+					switch (job.channel->path)
 					{
 					default:
 					case AnimationComponent::AnimationChannel::Path::TRANSLATION:
 					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3 * 3);
-						const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
-						XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft * 3 + 1]);
-						XMVECTOR vLeftTanOut = dt * XMLoadFloat3(&data[keyLeft * 3 + 2]);
-						XMVECTOR vRightTanIn = dt * XMLoadFloat3(&data[keyRight * 3 + 0]);
-						XMVECTOR vRight = XMLoadFloat3(&data[keyRight * 3 + 1]);
-						XMVECTOR vAnim = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
-						XMStoreFloat3(&transform.translation_local, vAnim);
+						const XMVECTOR aT = XMLoadFloat3(&target_transform.translation_local);
+						const XMVECTOR bT = XMLoadFloat4(&job.value);
+						XMStoreFloat3(&target_transform.translation_local, XMVectorLerp(aT, bT, t));
 					}
 					break;
 					case AnimationComponent::AnimationChannel::Path::ROTATION:
 					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 4 * 3);
-						const XMFLOAT4* data = (const XMFLOAT4*)animationdata->keyframe_data.data();
-						XMVECTOR vLeft = XMLoadFloat4(&data[keyLeft * 3 + 1]);
-						XMVECTOR vLeftTanOut = dt * XMLoadFloat4(&data[keyLeft * 3 + 2]);
-						XMVECTOR vRightTanIn = dt * XMLoadFloat4(&data[keyRight * 3 + 0]);
-						XMVECTOR vRight = XMLoadFloat4(&data[keyRight * 3 + 1]);
-						XMVECTOR vAnim = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
-						vAnim = XMQuaternionNormalize(vAnim);
-						XMStoreFloat4(&transform.rotation_local, vAnim);
+						const XMVECTOR aR = XMLoadFloat4(&target_transform.rotation_local);
+						const XMVECTOR bR = XMLoadFloat4(&job.value);
+						XMStoreFloat4(&target_transform.rotation_local, XMQuaternionSlerp(aR, bR, t));
 					}
 					break;
 					case AnimationComponent::AnimationChannel::Path::SCALE:
 					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * 3 * 3);
-						const XMFLOAT3* data = (const XMFLOAT3*)animationdata->keyframe_data.data();
-						XMVECTOR vLeft = XMLoadFloat3(&data[keyLeft * 3 + 1]);
-						XMVECTOR vLeftTanOut = dt * XMLoadFloat3(&data[keyLeft * 3 + 2]);
-						XMVECTOR vRightTanIn = dt * XMLoadFloat3(&data[keyRight * 3 + 0]);
-						XMVECTOR vRight = XMLoadFloat3(&data[keyRight * 3 + 1]);
-						XMVECTOR vAnim = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
-						XMStoreFloat3(&transform.scale_local, vAnim);
-					}
-					break;
-					case AnimationComponent::AnimationChannel::Path::WEIGHTS:
-					{
-						assert(animationdata->keyframe_data.size() == animationdata->keyframe_times.size() * animation.morph_weights_temp.size() * 3);
-						for (size_t j = 0; j < animation.morph_weights_temp.size(); ++j)
-						{
-							float vLeft = animationdata->keyframe_data[(keyLeft * animation.morph_weights_temp.size() + j) * 3 + 1];
-							float vLeftTanOut = animationdata->keyframe_data[(keyLeft * animation.morph_weights_temp.size() + j) * 3 + 2];
-							float vRightTanIn = animationdata->keyframe_data[(keyLeft * animation.morph_weights_temp.size() + j) * 3 + 0];
-							float vRight = animationdata->keyframe_data[(keyLeft * animation.morph_weights_temp.size() + j) * 3 + 1];
-							float vAnim = (2 * t3 - 3 * t2 + 1) * vLeft + (t3 - 2 * t2 + t) * vLeftTanOut + (-2 * t3 + 3 * t2) * vRight + (t3 - t2) * vRightTanIn;
-							animation.morph_weights_temp[j] = vAnim;
-						}
+						const XMVECTOR aS = XMLoadFloat3(&target_transform.scale_local);
+						const XMVECTOR bS = XMLoadFloat4(&job.value);
+						XMStoreFloat3(&target_transform.scale_local, XMVectorLerp(aS, bS, t));
 					}
 					break;
 					}
 				}
-				break;
-				}
-
-				if (target_transform != nullptr)
-				{
-					target_transform->SetDirty();
-
-					const float t = animation.amount;
-
-					const XMVECTOR aS = XMLoadFloat3(&target_transform->scale_local);
-					const XMVECTOR aR = XMLoadFloat4(&target_transform->rotation_local);
-					const XMVECTOR aT = XMLoadFloat3(&target_transform->translation_local);
-
-					const XMVECTOR bS = XMLoadFloat3(&transform.scale_local);
-					const XMVECTOR bR = XMLoadFloat4(&transform.rotation_local);
-					const XMVECTOR bT = XMLoadFloat3(&transform.translation_local);
-
-					const XMVECTOR S = XMVectorLerp(aS, bS, t);
-					const XMVECTOR R = XMQuaternionSlerp(aR, bR, t);
-					const XMVECTOR T = XMVectorLerp(aT, bT, t);
-
-					XMStoreFloat3(&target_transform->scale_local, S);
-					XMStoreFloat4(&target_transform->rotation_local, R);
-					XMStoreFloat3(&target_transform->translation_local, T);
-				}
 
-				if (target_mesh != nullptr)
+				if (job.target_mesh != nullptr)
 				{
-					const float t = animation.amount;
-
-					for (size_t j = 0; j < target_mesh->targets.size(); ++j)
+					// Morph weights are sampled here, because their count depends on the target:
+					MeshComponent& target_mesh = *job.target_mesh;
+					static thread_local wi::vector<float> morph_weights;
+					morph_weights.resize(target_mesh.targets.size());
+					XMFLOAT4 unused;
+					SampleAnimationChannel(*job.channel, *job.sampler, *job.animationdata, job.animation->timer, dt, job.keyLeft, job.keyRight, unused, morph_weights.data(), morph_weights.size());
+
+					for (size_t j = 0; j < target_mesh.targets.size(); ++j)
 					{
-						target_mesh->targets[j].weight = wi::math::Lerp(target_mesh->targets[j].weight, animation.morph_weights_temp[j], t);
+						target_mesh.targets[j].weight = wi::math::Lerp(target_mesh.targets[j].weight, morph_weights[j], t);
 					}
 
-					target_mesh->dirty_morph = true;
+					target_mesh.dirty_morph = true;
 				}
+			}
+		});
+		wi::jobsystem::Wait(animation_ctx);
 
+		for (size_t i = 0; i < animations.GetCount(); ++i)
+		{
+			AnimationComponent& animation = animations[i];
+			if (!animation.IsPlaying() && animation.timer == 0.0f)
+			{
+				continue;
 			}
 
 			if (animation.IsPlaying())
@@ -2842,6 +3960,14 @@ namespace wi::scene
 				continue;
 			}
 
+			if (animation_lod.enabled && animation_lod_camera_valid && wi::math::DistanceSquared(transform->GetPosition(), animation_lod_camera_position) > animation_lod.constraint_distance * animation_lod.constraint_distance)
+			{
+				// Far away spring is not simulated, it will restart from rest when it gets close again:
+				spring.Reset();
+				animation_lod_statistics.springs_skipped++;
+				continue;
+			}
+
 			if (spring.IsResetting())
 			{
 				spring.Reset(false);
@@ -2926,6 +4052,11 @@ namespace wi::scene
 			{
 				continue;
 			}
+			if (animation_lod.enabled && animation_lod_camera_valid && wi::math::DistanceSquared(transform->GetPosition(), animation_lod_camera_position) > animation_lod.constraint_distance * animation_lod.constraint_distance)
+			{
+				animation_lod_statistics.inverse_kinematics_skipped++;
+				continue;
+			}
 
 			const XMVECTOR target_pos = target->GetPositionV();
 			for (uint32_t iteration = 0; iteration < ik.iteration_count; ++iteration)
@@ -3007,6 +4138,21 @@ namespace wi::scene
 			}
 		}
 	}
+	// Moves the skinning matrices of a throttled armature one frame further on the way from boneData_prev to boneData_next
+	static void InterpolateArmatureSkinning(ArmatureComponent& armature)
+	{
+		armature.lod_interpolation_frame++;
+		const float t = std::min(1.0f, float(armature.lod_interpolation_frame) / float(std::max(1u, armature.lod_update_interval)));
+		for (size_t i = 0; i < armature.boneData.size(); ++i)
+		{
+			const ShaderTransform& prev = armature.boneData_prev[i];
+			const ShaderTransform& next = armature.boneData_next[i];
+			ShaderTransform& bone = armature.boneData[i];
+			XMStoreFloat4(&bone.mat0, XMVectorLerp(XMLoadFloat4(&prev.mat0), XMLoadFloat4(&next.mat0), t));
+			XMStoreFloat4(&bone.mat1, XMVectorLerp(XMLoadFloat4(&prev.mat1), XMLoadFloat4(&next.mat1), t));
+			XMStoreFloat4(&bone.mat2, XMVectorLerp(XMLoadFloat4(&prev.mat2), XMLoadFloat4(&next.mat2), t));
+		}
+	}
 	void Scene::RunArmatureUpdateSystem(wi::jobsystem::context& ctx)
 	{
 		wi::jobsystem::Dispatch(ctx, (uint32_t)armatures.GetCount(), 1, [&](wi::jobsystem::JobArgs args) {
@@ -3015,6 +4161,14 @@ namespace wi::scene
 			Entity entity = armatures.GetEntity(args.jobIndex);
 			const TransformComponent& transform = *transforms.GetComponent(entity);
 
+			const size_t boneCount = armature.boneCollection.size();
+			if (!armature.lod_update && armature.boneData.size() == boneCount && armature.boneData_prev.size() == boneCount && armature.boneData_next.size() == boneCount)
+			{
+				// Skipped by animation LOD, the skinning matrices are interpolated towards the result of the last update:
+				InterpolateArmatureSkinning(armature);
+				return;
+			}
+
 			// The transform world matrices are in world space, but skinning needs them in armature-local space, 
 			//	so that the skin is reusable for instanced meshes.
 			//	We remove the armature's world matrix from the bone world matrix to obtain the bone local transform
@@ -3027,10 +4181,24 @@ namespace wi::scene
 			//	But this will correct them too.
 			XMMATRIX R = XMMatrixInverse(nullptr, XMLoadFloat4x4(&transform.world));
 
-			if (armature.boneData.size() != armature.boneCollection.size())
+			// Throttled armature computes the new matrices separately and starts interpolating from the current ones:
+			const bool interpolate = animation_lod.enabled && armature.lod_update_interval > 1 && armature.boneData.size() == boneCount;
+			if (interpolate)
+			{
+				armature.boneData_prev = armature.boneData;
+				armature.boneData_next.resize(boneCount);
+			}
+			else
 			{
-				armature.boneData.resize(armature.boneCollection.size());
+				armature.boneData_prev.clear();
+				armature.boneData_next.clear();
 			}
+			armature.lod_interpolation_frame = 0;
+			if (armature.boneData.size() != boneCount)
+			{
+				armature.boneData.resize(boneCount);
+			}
+			wi::vector<ShaderTransform>& boneData = interpolate ? armature.boneData_next : armature.boneData;
 
 			XMFLOAT3 _min = XMFLOAT3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
 			XMFLOAT3 _max = XMFLOAT3(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
@@ -3048,7 +4216,7 @@ namespace wi::scene
 
 				XMFLOAT4X4 mat;
 				XMStoreFloat4x4(&mat, M);
-				armature.boneData[boneIndex++].Create(mat);
+				boneData[boneIndex++].Create(mat);
 
 				const float bone_radius = 1;
 				XMFLOAT3 bonepos = bone->GetPosition();
@@ -3060,6 +4228,11 @@ namespace wi::scene
 
 			armature.aabb = AABB(_min, _max);
 
+			if (interpolate)
+			{
+				InterpolateArmatureSkinning(armature);
+			}
+
 			if (!armature.boneBuffer.IsValid() || armature.boneBuffer.desc.size != armature.boneData.size() * sizeof(ShaderTransform))
 			{
 				armature.CreateRenderData();
@@ -3291,6 +4464,7 @@ namespace wi::scene
 			for (uint32_t i = 0; i < desc.array_size / 3; ++i)
 			{
 				RenderPassDesc renderpassdesc;
+				renderpassdesc.flags = RenderPassDesc::Flags::SYNCHRONOUS_PIPELINE_COMPILATION; // impostors are captured once
 				renderpassdesc.attachments.push_back(
 					RenderPassAttachment::RenderTarget(
 						&impostorArray,
@@ -3621,6 +4795,7 @@ namespace wi::scene
 							device->SetName(&object.lightmap, "lightmap_renderable");
 
 							RenderPassDesc renderpassdesc;
+							renderpassdesc.flags = RenderPassDesc::Flags::SYNCHRONOUS_PIPELINE_COMPILATION; // lightmap iterations are accumulated, a skipped draw would be missing from the result
 
 							renderpassdesc.attachments.push_back(RenderPassAttachment::RenderTarget(&object.lightmap, RenderPassAttachment::LoadOp::CLEAR));
 
@@ -3804,6 +4979,7 @@ namespace wi::scene
 					assert(subresource_index == i);
 
 					RenderPassDesc renderpassdesc;
+					renderpassdesc.flags = RenderPassDesc::Flags::SYNCHRONOUS_PIPELINE_COMPILATION; // probes are not refreshed again until they are invalidated
 					renderpassdesc.attachments.push_back(
 						RenderPassAttachment::DepthStencil(
 							&envrenderingDepthBuffer,
@@ -3827,6 +5003,7 @@ namespace wi::scene
 				// MSAA:
 				{
 					RenderPassDesc renderpassdesc;
+					renderpassdesc.flags = RenderPassDesc::Flags::SYNCHRONOUS_PIPELINE_COMPILATION;
 					renderpassdesc.attachments.clear();
 					renderpassdesc.attachments.push_back(
 						RenderPassAttachment::DepthStencil(
@@ -4114,7 +5291,7 @@ namespace wi::scene
 			}
 
 			const TransformComponent& transform = *transforms.GetComponent(entity);
-			emitter.UpdateCPU(transform, dt);
+			emitter.UpdateCPU(transform, dt, meshes.GetComponent(emitter.meshID));
 
 			GraphicsDevice* device = wi::graphics::GetDevice();
 
@@ -4247,6 +5424,9 @@ namespace wi::scene
 
 	void Scene::UpdateLODsForCamera(const CameraComponent& camera)
 	{
+		// Projected size of one unit at one unit distance from the camera in pixels, used for screen space error LOD selection:
+		const float pixels_per_unit = camera.height <= 0 ? 0 : camera.height * 0.5f / std::tan(camera.fov * 0.5f);
+
 		wi::jobsystem::context ctx;
 		wi::jobsystem::Dispatch(ctx, (uint32_t)objects.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 			ObjectComponent& object = objects[args.jobIndex];
@@ -4267,12 +5447,97 @@ namespace wi::scene
 				{
 					const float dist = std::sqrt(distsq);
 					const float dist_to_sphere = dist - radius;
-					object.lod = uint32_t(dist_to_sphere * object.lod_distance_multiplier);
-					object.lod = std::min(object.lod, mesh->GetLODCount() - 1);
+					const uint32_t lod_count = mesh->GetLODCount();
+					if (pixels_per_unit > 0 && mesh->lod_errors.size() == lod_count && mesh->aabb.IsValid())
+					{
+						// Screen space error: the mesh errors are in object space, the object scale is estimated from the bounds
+						const float object_scale = radius / std::max(mesh->aabb.getRadius(), std::numeric_limits<float>::epsilon());
+						const float error_to_pixels = object_scale * pixels_per_unit / dist_to_sphere;
+						const float max_error = lod_screen_error * object.lod_distance_multiplier;
+						object.lod = 0;
+						while (object.lod + 1 < lod_count && mesh->lod_errors[object.lod + 1] * error_to_pixels <= max_error)
+						{
+							object.lod++;
+						}
+					}
+					else
+					{
+						object.lod = uint32_t(dist_to_sphere * object.lod_distance_multiplier);
+						object.lod = std::min(object.lod, lod_count - 1);
+					}
 				}
 			}
 
 		});
+
+		animation_lod_camera_valid = animation_lod.enabled;
+		animation_lod_camera_position = camera.Eye;
+		if (animation_lod.enabled)
+		{
+			// Armature update intervals from the distance to the camera, the same way as mesh LOD:
+			wi::jobsystem::Dispatch(ctx, (uint32_t)armatures.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
+				ArmatureComponent& armature = armatures[args.jobIndex];
+				const AABB& aabb = armature.aabb;
+				if (!aabb.IsValid())
+				{
+					armature.lod_update_interval = 1;
+					return;
+				}
+				if (!camera.frustum.CheckBoxFast(aabb))
+				{
+					armature.lod_update_interval = std::max(1u, animation_lod.max_interval);
+					return;
+				}
+				const float dist_to_sphere = std::max(0.0f, wi::math::Distance(camera.Eye, aabb.getCenter()) - aabb.getRadius());
+				armature.lod_update_interval = std::max(1u, std::min(animation_lod.max_interval, 1u + uint32_t(dist_to_sphere * animation_lod.distance_multiplier)));
+			});
+
+			// Find the armature of new animations from the bones that they target, this is cached until the channels change:
+			wi::unordered_map<Entity, Entity> bone_to_armature;
+			for (size_t i = 0; i < animations.GetCount(); ++i)
+			{
+				AnimationComponent& animation = animations[i];
+				const Entity source = animation.channels.empty() ? INVALID_ENTITY : animation.channels.front().target;
+				if (source == animation.lod_armature_source)
+					continue;
+				if (bone_to_armature.empty())
+				{
+					for (size_t j = 0; j < armatures.GetCount(); ++j)
+					{
+						for (Entity bone : armatures[j].boneCollection)
+						{
+							bone_to_armature[bone] = armatures.GetEntity(j);
+						}
+					}
+				}
+				animation.lod_armature_source = source;
+				animation.lod_armature = INVALID_ENTITY;
+				for (const AnimationComponent::AnimationChannel& channel : animation.channels)
+				{
+					auto it = bone_to_armature.find(channel.target);
+					if (it == bone_to_armature.end())
+					{
+						// Targets something that is not a bone, it will be animated at full rate:
+						animation.lod_armature = INVALID_ENTITY;
+						break;
+					}
+					if (animation.lod_armature != INVALID_ENTITY && animation.lod_armature != it->second)
+					{
+						// Targets multiple armatures, only one of them could decide the update rate:
+						animation.lod_armature = INVALID_ENTITY;
+						break;
+					}
+					animation.lod_armature = it->second;
+				}
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < armatures.GetCount(); ++i)
+			{
+				armatures[i].lod_update_interval = 1;
+			}
+		}
 		wi::jobsystem::Wait(ctx);
 	}
 
@@ -4292,6 +5557,22 @@ namespace wi::scene
 		waterRipples.push_back(img);
 	}
 
+	// Linear blend of the bone matrices that influence a vertex, the rows are in the ShaderTransform layout
+	inline void BlendBoneMatrices(const ArmatureComponent& armature, const XMUINT4& ind, const XMFLOAT4& wei, XMVECTOR& row0, XMVECTOR& row1, XMVECTOR& row2)
+	{
+		const ShaderTransform& b0 = armature.boneData[ind.x];
+		const ShaderTransform& b1 = armature.boneData[ind.y];
+		const ShaderTransform& b2 = armature.boneData[ind.z];
+		const ShaderTransform& b3 = armature.boneData[ind.w];
+		const XMVECTOR w0 = XMVectorReplicate(wei.x);
+		const XMVECTOR w1 = XMVectorReplicate(wei.y);
+		const XMVECTOR w2 = XMVectorReplicate(wei.z);
+		const XMVECTOR w3 = XMVectorReplicate(wei.w);
+		row0 = XMVectorMultiplyAdd(XMLoadFloat4(&b3.mat0), w3, XMVectorMultiplyAdd(XMLoadFloat4(&b2.mat0), w2, XMVectorMultiplyAdd(XMLoadFloat4(&b1.mat0), w1, XMLoadFloat4(&b0.mat0) * w0)));
+		row1 = XMVectorMultiplyAdd(XMLoadFloat4(&b3.mat1), w3, XMVectorMultiplyAdd(XMLoadFloat4(&b2.mat1), w2, XMVectorMultiplyAdd(XMLoadFloat4(&b1.mat1), w1, XMLoadFloat4(&b0.mat1) * w0)));
+		row2 = XMVectorMultiplyAdd(XMLoadFloat4(&b3.mat2), w3, XMVectorMultiplyAdd(XMLoadFloat4(&b2.mat2), w2, XMVectorMultiplyAdd(XMLoadFloat4(&b1.mat2), w1, XMLoadFloat4(&b0.mat2) * w0)));
+	}
+
 	XMVECTOR SkinVertex(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t index, XMVECTOR* N)
 	{
 		XMVECTOR P;
@@ -4303,44 +5584,138 @@ namespace wi::scene
 		{
 		    P = mesh.vertex_positions_morphed[index].LoadPOS();
 		}
-		const XMUINT4& ind = mesh.vertex_boneindices[index];
-		const XMFLOAT4& wei = mesh.vertex_boneweights[index];
 
-		const XMFLOAT4X4 mat[] = {
-			armature.boneData[ind.x].GetMatrix(),
-			armature.boneData[ind.y].GetMatrix(),
-			armature.boneData[ind.z].GetMatrix(),
-			armature.boneData[ind.w].GetMatrix(),
-		};
-		const XMMATRIX M[] = {
-			XMMatrixTranspose(XMLoadFloat4x4(&mat[0])),
-			XMMatrixTranspose(XMLoadFloat4x4(&mat[1])),
-			XMMatrixTranspose(XMLoadFloat4x4(&mat[2])),
-			XMMatrixTranspose(XMLoadFloat4x4(&mat[3])),
-		};
+		// Blending the matrices first is equivalent to blending the transformed results, because skinning is linear:
+		XMVECTOR row0, row1, row2;
+		BlendBoneMatrices(armature, mesh.vertex_boneindices[index], mesh.vertex_boneweights[index], row0, row1, row2);
+		const XMMATRIX M = XMMatrixTranspose(XMMATRIX(row0, row1, row2, g_XMIdentityR3));
 
-		XMVECTOR skinned;
-		skinned =  XMVector3Transform(P, M[0]) * wei.x;
-		skinned += XMVector3Transform(P, M[1]) * wei.y;
-		skinned += XMVector3Transform(P, M[2]) * wei.z;
-		skinned += XMVector3Transform(P, M[3]) * wei.w;
-		P = skinned;
+		P = XMVector3Transform(P, M);
 
 		if (N != nullptr)
 		{
-			*N = XMLoadFloat3(&mesh.vertex_normals[index]);
-			skinned =  XMVector3TransformNormal(*N, M[0]) * wei.x;
-			skinned += XMVector3TransformNormal(*N, M[1]) * wei.y;
-			skinned += XMVector3TransformNormal(*N, M[2]) * wei.z;
-			skinned += XMVector3TransformNormal(*N, M[3]) * wei.w;
-			*N = XMVector3Normalize(skinned);
+			*N = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&mesh.vertex_normals[index]), M));
 		}
 
 		return P;
 	}
 
+	static void SkinVertexRange(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t first, uint32_t count, XMFLOAT3* positions, XMFLOAT3* normals)
+	{
+		const bool morphed = !mesh.vertex_positions_morphed.empty();
+		const XMVECTOR zero = XMVectorZero();
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			const uint32_t lanes = std::min(4u, count - i);
+			XMVECTOR row0[4];
+			XMVECTOR row1[4];
+			XMVECTOR row2[4];
+			XMVECTOR P[4];
+			XMVECTOR N[4];
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				const uint32_t index = first + i + std::min(lane, lanes - 1); // unused lanes repeat the last vertex
+				BlendBoneMatrices(armature, mesh.vertex_boneindices[index], mesh.vertex_boneweights[index], row0[lane], row1[lane], row2[lane]);
+				P[lane] = morphed ? mesh.vertex_positions_morphed[index].LoadPOS() : XMLoadFloat3(&mesh.vertex_positions[index]);
+				if (normals != nullptr)
+				{
+					N[lane] = XMLoadFloat3(&mesh.vertex_normals[index]);
+				}
+			}
+
+			// Structure of arrays: after the transposes every vector holds the same component of the four vertices
+			const XMMATRIX M0 = XMMatrixTranspose(XMMATRIX(row0[0], row0[1], row0[2], row0[3]));
+			const XMMATRIX M1 = XMMatrixTranspose(XMMATRIX(row1[0], row1[1], row1[2], row1[3]));
+			const XMMATRIX M2 = XMMatrixTranspose(XMMATRIX(row2[0], row2[1], row2[2], row2[3]));
+
+			const XMMATRIX p = XMMatrixTranspose(XMMATRIX(P[0], P[1], P[2], P[3]));
+			const XMVECTOR x = XMVectorMultiplyAdd(M0.r[2], p.r[2], XMVectorMultiplyAdd(M0.r[1], p.r[1], XMVectorMultiplyAdd(M0.r[0], p.r[0], M0.r[3])));
+			const XMVECTOR y = XMVectorMultiplyAdd(M1.r[2], p.r[2], XMVectorMultiplyAdd(M1.r[1], p.r[1], XMVectorMultiplyAdd(M1.r[0], p.r[0], M1.r[3])));
+			const XMVECTOR z = XMVectorMultiplyAdd(M2.r[2], p.r[2], XMVectorMultiplyAdd(M2.r[1], p.r[1], XMVectorMultiplyAdd(M2.r[0], p.r[0], M2.r[3])));
+			const XMMATRIX result = XMMatrixTranspose(XMMATRIX(x, y, z, zero));
+			for (uint32_t lane = 0; lane < lanes; ++lane)
+			{
+				XMStoreFloat3(positions + i + lane, result.r[lane]);
+			}
+
+			if (normals != nullptr)
+			{
+				const XMMATRIX n = XMMatrixTranspose(XMMATRIX(N[0], N[1], N[2], N[3]));
+				XMVECTOR nx = XMVectorMultiplyAdd(M0.r[2], n.r[2], XMVectorMultiplyAdd(M0.r[1], n.r[1], M0.r[0] * n.r[0]));
+				XMVECTOR ny = XMVectorMultiplyAdd(M1.r[2], n.r[2], XMVectorMultiplyAdd(M1.r[1], n.r[1], M1.r[0] * n.r[0]));
+				XMVECTOR nz = XMVectorMultiplyAdd(M2.r[2], n.r[2], XMVectorMultiplyAdd(M2.r[1], n.r[1], M2.r[0] * n.r[0]));
+				const XMVECTOR length = XMVectorSqrt(XMVectorMultiplyAdd(nz, nz, XMVectorMultiplyAdd(ny, ny, nx * nx)));
+				const XMVECTOR rcp = XMVectorSelect(zero, XMVectorReciprocal(length), XMVectorGreater(length, zero));
+				nx *= rcp;
+				ny *= rcp;
+				nz *= rcp;
+				const XMMATRIX normal_result = XMMatrixTranspose(XMMATRIX(nx, ny, nz, zero));
+				for (uint32_t lane = 0; lane < lanes; ++lane)
+				{
+					XMStoreFloat3(normals + i + lane, normal_result.r[lane]);
+				}
+			}
+		}
+	}
+
+	void SkinVertices(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t first, uint32_t count, XMFLOAT3* positions, XMFLOAT3* normals)
+	{
+		if (mesh.vertex_normals.empty())
+		{
+			normals = nullptr;
+		}
+
+		static constexpr uint32_t vertices_per_job = 1024;
+		if (count <= vertices_per_job)
+		{
+			SkinVertexRange(mesh, armature, first, count, positions, normals);
+			return;
+		}
+
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (count + vertices_per_job - 1) / vertices_per_job, 1, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t offset = args.jobIndex * vertices_per_job;
+			SkinVertexRange(mesh, armature, first + offset, std::min(vertices_per_job, count - offset), positions + offset, normals == nullptr ? nullptr : normals + offset);
+		});
+		wi::jobsystem::Wait(ctx);
+	}
+
+	const XMFLOAT3* Scene::GetSkinnedVertexPositions(Entity meshEntity, const MeshComponent& mesh, const ArmatureComponent& armature) const
+	{
+		const size_t vertexCount = mesh.vertex_positions.size();
+		wi::vector<XMFLOAT3> positions;
+
+		skinning_cache.locker.lock();
+		auto it = skinning_cache.entries.find(meshEntity);
+		if (it != skinning_cache.entries.end())
+		{
+			SkinningCache::Entry& entry = it->second;
+			if (entry.generation == skinning_cache.generation && entry.positions.size() == vertexCount)
+			{
+				const XMFLOAT3* result = entry.positions.data();
+				skinning_cache.locker.unlock();
+				return result;
+			}
+			positions = std::move(entry.positions); // reuse the memory of the outdated entry
+		}
+		skinning_cache.locker.unlock();
 
+		// Skinning is not done while locked, because waiting for the skinning jobs could execute other requests on this thread:
+		positions.resize(vertexCount);
+		SkinVertices(mesh, armature, 0, (uint32_t)vertexCount, positions.data());
 
+		skinning_cache.locker.lock();
+		SkinningCache::Entry& entry = skinning_cache.entries[meshEntity];
+		if (entry.generation != skinning_cache.generation || entry.positions.size() != vertexCount)
+		{
+			entry.positions = std::move(positions);
+			entry.generation = skinning_cache.generation;
+		}
+		// else: an other thread finished the same request first, its result is kept because it could be in use already
+		const XMFLOAT3* result = entry.positions.data();
+		skinning_cache.locker.unlock();
+		return result;
+	}
 
 	Entity LoadModel(const std::string& fileName, const XMMATRIX& transformMatrix, bool attached)
 	{
@@ -4442,10 +5817,64 @@ namespace wi::scene
 				const XMVECTOR rayDirection_local = XMVector3Normalize(XMVector3TransformNormal(rayDirection, objectMat_Inverse));
 
 				const ArmatureComponent* armature = mesh.IsSkinned() ? scene.armatures.GetComponent(mesh.armatureID) : nullptr;
+				const XMFLOAT3* skinned_positions = armature == nullptr || softbody_active ? nullptr : scene.GetSkinnedVertexPositions(object.meshID, mesh, *armature);
+
+				auto intersect_triangle = [&](uint32_t subsetIndex, uint32_t i0, uint32_t i1, uint32_t i2, XMVECTOR p0, XMVECTOR p1, XMVECTOR p2) {
+					float distance;
+					XMFLOAT2 bary;
+					if (wi::math::RayTriangleIntersects(rayOrigin_local, rayDirection_local, p0, p1, p2, distance, bary, ray.TMin, ray.TMax))
+					{
+						const XMVECTOR pos = XMVector3Transform(XMVectorAdd(rayOrigin_local, rayDirection_local*distance), objectMat);
+						distance = wi::math::Distance(pos, rayOrigin);
+
+						if (distance < result.distance)
+						{
+							const XMVECTOR nor = XMVector3Normalize(XMVector3TransformNormal(XMVector3Cross(XMVectorSubtract(p2, p1), XMVectorSubtract(p1, p0)), objectMat));
+
+							result.entity = entity;
+							XMStoreFloat3(&result.position, pos);
+							XMStoreFloat3(&result.normal, nor);
+							result.distance = distance;
+							result.subsetIndex = (int)subsetIndex;
+							result.vertexID0 = (int)i0;
+							result.vertexID1 = (int)i1;
+							result.vertexID2 = (int)i2;
+							result.bary = bary;
+						}
+					}
+				};
 
 				uint32_t first_subset = 0;
 				uint32_t last_subset = 0;
 				mesh.GetLODSubsetRange(0, first_subset, last_subset);
+
+				if (!softbody_active && armature == nullptr && mesh.vertex_positions_morphed.empty() && !mesh.clusters.empty())
+				{
+					// Static geometry: only the triangles of clusters whose bounding sphere is hit by the ray are tested
+					const Ray ray_local(rayOrigin_local, rayDirection_local, ray.TMin, ray.TMax);
+					for (const MeshComponent::MeshCluster& cluster : mesh.clusters)
+					{
+						if (cluster.subsetIndex < first_subset || cluster.subsetIndex >= last_subset)
+							continue;
+						if (!ray_local.intersects(Sphere(cluster.center, cluster.radius)))
+							continue;
+						const uint32_t* cluster_vertices = mesh.cluster_vertices.data() + cluster.vertexOffset;
+						const uint8_t* cluster_triangles = mesh.cluster_triangles.data() + cluster.triangleOffset;
+						for (uint32_t i = 0; i < cluster.triangleCount; ++i)
+						{
+							const uint32_t i0 = cluster_vertices[cluster_triangles[i * 3 + 0]];
+							const uint32_t i1 = cluster_vertices[cluster_triangles[i * 3 + 1]];
+							const uint32_t i2 = cluster_vertices[cluster_triangles[i * 3 + 2]];
+							intersect_triangle(cluster.subsetIndex, i0, i1, i2,
+								XMLoadFloat3(&mesh.vertex_positions[i0]),
+								XMLoadFloat3(&mesh.vertex_positions[i1]),
+								XMLoadFloat3(&mesh.vertex_positions[i2])
+							);
+						}
+					}
+					continue;
+				}
+
 				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
 				{
 					const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
@@ -4484,34 +5913,13 @@ namespace wi::scene
 							}
 							else
 							{
-								p0 = SkinVertex(mesh, *armature, i0);
-								p1 = SkinVertex(mesh, *armature, i1);
-								p2 = SkinVertex(mesh, *armature, i2);
+								p0 = XMLoadFloat3(&skinned_positions[i0]);
+								p1 = XMLoadFloat3(&skinned_positions[i1]);
+								p2 = XMLoadFloat3(&skinned_positions[i2]);
 							}
 						}
 
-						float distance;
-						XMFLOAT2 bary;
-						if (wi::math::RayTriangleIntersects(rayOrigin_local, rayDirection_local, p0, p1, p2, distance, bary, ray.TMin, ray.TMax))
-						{
-							const XMVECTOR pos = XMVector3Transform(XMVectorAdd(rayOrigin_local, rayDirection_local*distance), objectMat);
-							distance = wi::math::Distance(pos, rayOrigin);
-
-							if (distance < result.distance)
-							{
-								const XMVECTOR nor = XMVector3Normalize(XMVector3TransformNormal(XMVector3Cross(XMVectorSubtract(p2, p1), XMVectorSubtract(p1, p0)), objectMat));
-
-								result.entity = entity;
-								XMStoreFloat3(&result.position, pos);
-								XMStoreFloat3(&result.normal, nor);
-								result.distance = distance;
-								result.subsetIndex = (int)subsetIndex;
-								result.vertexID0 = (int)i0;
-								result.vertexID1 = (int)i1;
-								result.vertexID2 = (int)i2;
-								result.bary = bary;
-							}
-						}
+						intersect_triangle(subsetIndex, i0, i1, i2, p0, p1, p2);
 					}
 				}
 
@@ -4572,6 +5980,7 @@ namespace wi::scene
 				const XMMATRIX objectMat = XMLoadFloat4x4(&object.worldMatrix);
 
 				const ArmatureComponent* armature = mesh.IsSkinned() ? scene.armatures.GetComponent(mesh.armatureID) : nullptr;
+				const XMFLOAT3* skinned_positions = armature == nullptr || softbody_active ? nullptr : scene.GetSkinnedVertexPositions(object.meshID, mesh, *armature);
 
 				uint32_t first_subset = 0;
 				uint32_t last_subset = 0;
@@ -4605,9 +6014,9 @@ namespace wi::scene
 							}
 							else
 							{
-								p0 = SkinVertex(mesh, *armature, i0);
-								p1 = SkinVertex(mesh, *armature, i1);
-								p2 = SkinVertex(mesh, *armature, i2);
+								p0 = XMLoadFloat3(&skinned_positions[i0]);
+								p1 = XMLoadFloat3(&skinned_positions[i1]);
+								p2 = XMLoadFloat3(&skinned_positions[i2]);
 							}
 						}
 
@@ -4780,6 +6189,7 @@ namespace wi::scene
 				const XMMATRIX objectMat = XMLoadFloat4x4(&object.worldMatrix);
 
 				const ArmatureComponent* armature = mesh.IsSkinned() ? scene.armatures.GetComponent(mesh.armatureID) : nullptr;
+				const XMFLOAT3* skinned_positions = armature == nullptr || softbody_active ? nullptr : scene.GetSkinnedVertexPositions(object.meshID, mesh, *armature);
 
 				uint32_t first_subset = 0;
 				uint32_t last_subset = 0;
@@ -4813,9 +6223,9 @@ namespace wi::scene
 							}
 							else
 							{
-								p0 = SkinVertex(mesh, *armature, i0);
-								p1 = SkinVertex(mesh, *armature, i1);
-								p2 = SkinVertex(mesh, *armature, i2);
+								p0 = XMLoadFloat3(&skinned_positions[i0]);
+								p1 = XMLoadFloat3(&skinned_positions[i1]);
+								p2 = XMLoadFloat3(&skinned_positions[i2]);
 							}
 						}
 						
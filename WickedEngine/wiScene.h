@@ -20,6 +20,7 @@
 #include <string>
 #include <memory>
 #include <limits>
+#include <functional>
 
 namespace wi
 {
@@ -373,6 +374,35 @@ namespace wi::scene
 		wi::vector<MeshMorphTarget> targets;
 
 		uint32_t subsets_per_lod = 0; // this needs to be specified if there are multiple LOD levels
+		wi::vector<float> lod_errors; // optional object space geometric error of every LOD level, which enables screen space error LOD selection
+
+		// Clusters (meshlets) of every subset with bounding sphere and normal cone, for culling on the CPU
+		//	They are rebuilt by every CreateRenderData(), except right after loading when the serialized clusters still match the geometry
+		//	Skinned and morphed meshes don't have clusters
+		static constexpr uint32_t CLUSTER_MAX_VERTICES = 64;
+		static constexpr uint32_t CLUSTER_MAX_TRIANGLES = 124;
+		struct MeshCluster
+		{
+			uint32_t subsetIndex = 0;
+			uint32_t vertexOffset = 0; // offset into cluster_vertices
+			uint32_t vertexCount = 0;
+			uint32_t triangleOffset = 0; // offset into cluster_triangles
+			uint32_t triangleCount = 0;
+			XMFLOAT3 center = XMFLOAT3(0, 0, 0); // object space bounding sphere
+			float radius = 0;
+			XMFLOAT3 cone_apex = XMFLOAT3(0, 0, 0); // object space normal cone
+			XMFLOAT3 cone_axis = XMFLOAT3(0, 0, 0);
+			float cone_cutoff = 1; // cosine of the half cone angle, 1 if the cluster can't be backface culled
+		};
+		wi::vector<MeshCluster> clusters;
+		wi::vector<uint32_t> cluster_vertices; // mesh vertex indices of the clusters
+		wi::vector<uint8_t> cluster_triangles; // three cluster vertex indices per triangle
+		uint64_t cluster_hash = 0; // fingerprint of the geometry that the clusters were built from, it is computed when the mesh is serialized
+
+		// Lightmap atlas that vertex_atlas was generated for by GenerateAtlas()
+		uint32_t atlas_width = 0;
+		uint32_t atlas_height = 0;
+		uint64_t atlas_hash = 0; // fingerprint of the geometry and resolution that the atlas was generated for
 
 		// Non-serialized attributes:
 		wi::primitive::AABB aabb;
@@ -416,6 +446,8 @@ namespace wi::scene
 		mutable BLAS_STATE BLAS_state = BLAS_STATE_NEEDS_REBUILD;
 
 		mutable bool dirty_morph = false;
+		bool cluster_hash_check = false; // the clusters were loaded, CreateRenderData() keeps them if cluster_hash matches the geometry
+		uint64_t geometry_version = 0; // unique for every CreateRenderData() call, 0 if the render data was never created
 
 		inline void SetRenderable(bool value) { if (value) { _flags |= RENDERABLE; } else { _flags &= ~RENDERABLE; } }
 		inline void SetDoubleSided(bool value) { if (value) { _flags |= DOUBLE_SIDED; } else { _flags &= ~DOUBLE_SIDED; } }
@@ -442,7 +474,7 @@ namespace wi::scene
 			}
 		}
 
-		// Recreates GPU resources for index/vertex buffers
+		// Recreates GPU resources for index/vertex buffers and rebuilds the clusters if the geometry changed
 		void CreateRenderData();
 		void CreateStreamoutRenderData();
 
@@ -459,6 +491,39 @@ namespace wi::scene
 		void RecenterToBottom();
 		wi::primitive::Sphere GetBoundingSphere() const;
 
+		struct LODGenerationParams
+		{
+			uint32_t lod_count = 6; // the maximum number of LOD levels, including the original geometry
+			float reduction = 0.5f; // target index count of a level compared to the previous level
+			float target_error = 0.01f; // allowed simplification error of the first generated level relative to the mesh extents, it doubles with every further level
+			uint32_t min_triangles = 32; // levels are not generated below this triangle count
+			bool sloppy = false; // faster simplification that doesn't preserve topology
+		};
+		// Generates LOD levels by simplifying the first LOD level, the geometric error of every level is stored in lod_errors
+		//	Existing LOD levels are replaced. The render data is not recreated, call CreateRenderData() after this
+		//	This only depends on the mesh itself, so multiple meshes can be processed in parallel
+		void GenerateLODs(const LODGenerationParams& params);
+
+		// Rebuilds the clusters of all subsets, this is called by CreateRenderData()
+		void BuildClusters();
+		// Returns the fingerprint of the geometry that the clusters are built from
+		uint64_t ComputeClusterHash() const;
+		// Culls the clusters of a LOD level against a world space frustum, the indices of the visible clusters are appended to visible_clusters
+		//	world: the world matrix of the object
+		//	eye: if specified, clusters that are facing away from this world space position are also culled (don't use it for double sided meshes)
+		//	Usable with a camera frustum, a shadow frustum (with the light position as eye for point and spot lights), or a picking volume
+		void CullClusters(const wi::primitive::Frustum& frustum, const XMFLOAT4X4& world, uint32_t lod, wi::vector<uint32_t>& visible_clusters, const XMFLOAT3* eye = nullptr) const;
+
+		// Generates lightmap UVs into vertex_atlas with xatlas, the charts are packed for a lightmap of resolution * resolution texels
+		//	Vertices are rebuilt because charts can split them, the render data is not recreated, call CreateRenderData() after this
+		//	This only depends on the mesh itself, so multiple meshes can be processed in parallel (see Scene::GenerateMeshAtlases())
+		//	returns false if xatlas couldn't process the mesh
+		bool GenerateAtlas(uint32_t resolution);
+		// Returns the fingerprint of the geometry and resolution that an atlas is generated from
+		uint64_t ComputeAtlasHash(uint32_t resolution) const;
+		// Returns true if vertex_atlas was generated for the current geometry with this resolution
+		bool IsAtlasUpToDate(uint32_t resolution) const { return !vertex_atlas.empty() && atlas_hash == ComputeAtlasHash(resolution); }
+
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 
 
@@ -639,6 +704,7 @@ namespace wi::scene
 			_DEPRECATED_IMPOSTOR_PLACEMENT = 1 << 3,
 			REQUEST_PLANAR_REFLECTION = 1 << 4,
 			LIGHTMAP_RENDER_REQUEST = 1 << 5,
+			OCCLUDER = 1 << 6,
 		};
 		uint32_t _flags = RENDERABLE | CAST_SHADOW;
 
@@ -692,12 +758,15 @@ namespace wi::scene
 		inline void SetDynamic(bool value) { if (value) { _flags |= DYNAMIC; } else { _flags &= ~DYNAMIC; } }
 		inline void SetRequestPlanarReflection(bool value) { if (value) { _flags |= REQUEST_PLANAR_REFLECTION; } else { _flags &= ~REQUEST_PLANAR_REFLECTION; } }
 		inline void SetLightmapRenderRequest(bool value) { if (value) { _flags |= LIGHTMAP_RENDER_REQUEST; } else { _flags &= ~LIGHTMAP_RENDER_REQUEST; } }
+		// Occluder objects are rasterized into the CPU occlusion buffer, they should be big and simple meshes (walls, terrain, buildings)
+		inline void SetOccluder(bool value) { if (value) { _flags |= OCCLUDER; } else { _flags &= ~OCCLUDER; } }
 
 		inline bool IsRenderable() const { return _flags & RENDERABLE; }
 		inline bool IsCastingShadow() const { return _flags & CAST_SHADOW; }
 		inline bool IsDynamic() const { return _flags & DYNAMIC; }
 		inline bool IsRequestPlanarReflection() const { return _flags & REQUEST_PLANAR_REFLECTION; }
 		inline bool IsLightmapRenderRequested() const { return _flags & LIGHTMAP_RENDER_REQUEST; }
+		inline bool IsOccluder() const { return _flags & OCCLUDER; }
 
 		inline float GetTransparency() const { return 1 - color.w; }
 		inline uint32_t GetRenderTypes() const { return rendertypeMask; }
@@ -756,10 +825,27 @@ namespace wi::scene
 			float radius = 1;
 			float height = 1;
 		} capsule;
+		struct ConvexHullParams
+		{
+			uint32_t vertex_limit = 64; // max vertex count of one generated hull
+			uint32_t max_hulls = 1; // if greater than 1, the mesh will be approximately decomposed into at most this many convex hulls
+			float concavity = 0.05f; // decomposition stops splitting parts whose concavity relative to their size is lower than this
+		} convex_hull;
+
+		// Generated convex hulls of CONVEX_HULL shape, they are created from the mesh when empty (see wi::physics::CreateConvexHulls())
+		//	Clear these after modifying the mesh or convex_hull parameters to generate them again
+		wi::vector<XMFLOAT3> convex_hull_vertices; // vertices of all hulls
+		wi::vector<uint32_t> convex_hull_vertex_counts; // vertex count of each hull in convex_hull_vertices
 
 		// Non-serialized attributes:
 		void* physicsobject = nullptr;
 
+		// Body state after the last two fixed simulation steps, the transform is interpolated between them:
+		XMFLOAT3 previous_position = XMFLOAT3(0, 0, 0);
+		XMFLOAT4 previous_rotation = XMFLOAT4(0, 0, 0, 1);
+		XMFLOAT3 current_position = XMFLOAT3(0, 0, 0);
+		XMFLOAT4 current_rotation = XMFLOAT4(0, 0, 0, 1);
+
 		inline void SetDisableDeactivation(bool value) { if (value) { _flags |= DISABLE_DEACTIVATION; } else { _flags &= ~DISABLE_DEACTIVATION; } }
 		inline void SetKinematic(bool value) { if (value) { _flags |= KINEMATIC; } else { _flags &= ~KINEMATIC; } }
 
@@ -823,6 +909,13 @@ namespace wi::scene
 		wi::graphics::GPUBuffer boneBuffer;
 		int descriptor_srv = -1;
 
+		// Animation LOD state (see Scene::AnimationLOD):
+		uint32_t lod_update_interval = 1; // the bones are updated in every Nth frame
+		bool lod_update = true; // whether the bones are updated in the current frame
+		uint32_t lod_interpolation_frame = 0; // frames elapsed since the last update
+		wi::vector<ShaderTransform> boneData_prev; // skinning matrices at the last update, interpolation starts from these
+		wi::vector<ShaderTransform> boneData_next; // skinning matrices computed at the last update, interpolation ends at these
+
 		void CreateRenderData();
 
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
@@ -1065,12 +1158,39 @@ namespace wi::scene
 		enum FLAGS
 		{
 			EMPTY = 0,
+			COMPRESSED_VECTOR = 1 << 0,
+			COMPRESSED_QUATERNION = 1 << 1,
 		};
 		uint32_t _flags = EMPTY;
 
 		wi::vector<float> keyframe_times;
 		wi::vector<float> keyframe_data;
 
+		// Compressed keyframes, these are used instead of keyframe_times and keyframe_data after Compress():
+		//	Times are quantized to 16 bits in the [time_start, time_start + time_range] range
+		//	Vectors are quantized to 16 bits per component in the [range_min, range_min + range_extent] range of the track
+		//	Quaternions store the three smallest components quantized to 15 bits, and the index of the largest component (smallest three)
+		float time_start = 0;
+		float time_range = 0;
+		XMFLOAT3 range_min = XMFLOAT3(0, 0, 0);
+		XMFLOAT3 range_extent = XMFLOAT3(0, 0, 0);
+		wi::vector<uint16_t> compressed_times;
+		wi::vector<uint16_t> compressed_data; // 3 values per keyframe
+
+		inline bool IsCompressed() const { return _flags & (COMPRESSED_VECTOR | COMPRESSED_QUATERNION); }
+		inline size_t GetKeyframeCount() const { return IsCompressed() ? compressed_times.size() : keyframe_times.size(); }
+		inline float GetCompressedTime(size_t key) const { return time_start + float(compressed_times[key]) * (time_range / 65535.0f); }
+		XMVECTOR GetCompressedValue(size_t key) const;
+
+		// Compresses a translation, scale (3 floats per keyframe) or rotation (4 floats per keyframe) track, and removes the raw keyframes
+		//	Keyframes are removed while the result stays within max_error of the original at every original keyframe
+		//	quaternion	:	true for rotation tracks, then max_error is in radians, otherwise it is distance
+		//	step		:	true if the track is sampled with AnimationSampler::Mode::STEP, otherwise as LINEAR
+		//	returns false if the track can't be compressed (cubic spline, morph weights, or time resolution is too low)
+		bool Compress(bool quaternion, bool step, float max_error);
+		// Returns the memory used by keyframes in bytes
+		size_t GetMemorySize() const;
+
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
 
@@ -1109,6 +1229,9 @@ namespace wi::scene
 				UNKNOWN,
 				TYPE_FORCE_UINT32 = 0xFFFFFFFF
 			} path = TRANSLATION;
+
+			// Non-serialized attributes:
+			int next_key = 0; // keyframe search cursor, the last right keyframe that was found
 		};
 		struct AnimationSampler
 		{
@@ -1134,8 +1257,9 @@ namespace wi::scene
 		wi::vector<AnimationChannel> channels;
 		wi::vector<AnimationSampler> samplers;
 
-		// Non-serialzied attributes:
-		wi::vector<float> morph_weights_temp;
+		// Non-serialized attributes:
+		wi::ecs::Entity lod_armature = wi::ecs::INVALID_ENTITY; // the armature whose bones are animated, its LOD decides when the animation is sampled
+		wi::ecs::Entity lod_armature_source = wi::ecs::INVALID_ENTITY; // the channel target that lod_armature was resolved from
 
 		inline bool IsPlaying() const { return _flags & PLAYING; }
 		inline bool IsLooped() const { return _flags & LOOPED; }
@@ -1294,6 +1418,40 @@ namespace wi::scene
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
 
+	// Change tracking for a GPU scene data array (instances, geometries, materials):
+	//	Scene systems write the whole array into cached CPU memory every frame, then Upload() compares it with the
+	//	data that the GPU buffer already contains, and only the changed blocks are written to the mapped upload buffer.
+	//	The renderer only needs to copy copy_ranges from the upload buffer to the GPU buffer.
+	struct GPUArrayTracker
+	{
+		static constexpr size_t block_element_count = 32; // granularity of change tracking in elements
+
+		struct CopyRange
+		{
+			uint64_t offset = 0; // in bytes
+			uint64_t size = 0; // in bytes
+		};
+		wi::vector<uint8_t> current; // written by the scene systems in this frame
+		wi::vector<uint8_t> previous; // matches the GPU buffer contents
+		wi::vector<uint8_t> dirty_blocks;
+		wi::vector<CopyRange> copy_ranges; // result of Upload()
+		size_t stride = 0;
+		size_t count = 0;
+		uint64_t upload_size = 0; // sum of copy_ranges sizes
+		bool full_upload = true;
+		mutable bool consumed = true;
+
+		// Prepares the CPU-side array for this frame and returns it for writing
+		//	gpu_buffer_recreated : if the GPU buffer was recreated, then its contents are undefined and everything will be uploaded
+		void* Begin(size_t element_stride, size_t element_count, bool gpu_buffer_recreated);
+
+		// Writes the changed blocks into the mapped upload buffer and fills copy_ranges
+		void Upload(wi::jobsystem::context& ctx, void* mapped_upload_data);
+
+		// The renderer calls this after it recorded the copies of copy_ranges
+		inline void SetConsumed() const { consumed = true; }
+	};
+
 	struct Scene
 	{
 		wi::ecs::ComponentManager<NameComponent> names;
@@ -1327,6 +1485,69 @@ namespace wi::scene
 
 		// Non-serialized attributes:
 		float dt = 0;
+
+		// Meshes that have lod_errors select the lowest detail LOD whose projected error stays below this many pixels
+		//	The error limit is scaled by the lod_distance_multiplier of the object, meshes without lod_errors use distance based selection
+		float lod_screen_error = 1.0f;
+
+		// Animation LOD: armatures that are far away or outside the camera are updated at a reduced rate
+		//	The update interval of every armature is decided in UpdateLODsForCamera() and updates are staggered across frames
+		//	Animations that target the bones of a skipped armature are not sampled, skinning matrices are interpolated between updates
+		//	Inverse kinematics and springs are not simulated far from the camera
+		struct AnimationLOD
+		{
+			bool enabled = false;
+			float distance_multiplier = 0.1f; // update interval = 1 + distance from the camera * distance_multiplier
+			uint32_t max_interval = 8; // update interval of armatures outside the camera and the upper limit for far away ones
+			float constraint_distance = 50; // inverse kinematics and springs further than this from the camera are not simulated
+		} animation_lod;
+		struct AnimationLODStatistics
+		{
+			uint32_t armatures_updated = 0;
+			uint32_t armatures_skipped = 0; // armatures whose skinning matrices were only interpolated
+			uint32_t animations_skipped = 0;
+			uint32_t inverse_kinematics_skipped = 0;
+			uint32_t springs_skipped = 0;
+		} animation_lod_statistics; // results of the last Update()
+		uint32_t animation_lod_frame = 0;
+		XMFLOAT3 animation_lod_camera_position = XMFLOAT3(0, 0, 0);
+		bool animation_lod_camera_valid = false;
+
+		// One animation channel that is updated in the current frame
+		struct AnimationChannelJob
+		{
+			AnimationComponent* animation = nullptr;
+			AnimationComponent::AnimationChannel* channel = nullptr;
+			const AnimationComponent::AnimationSampler* sampler = nullptr;
+			const AnimationDataComponent* animationdata = nullptr;
+			TransformComponent* target_transform = nullptr;
+			MeshComponent* target_mesh = nullptr;
+			int keyLeft = 0;
+			int keyRight = 0;
+			XMFLOAT4 value = XMFLOAT4(0, 0, 0, 0); // sampled translation, rotation or scale
+		};
+		// Memory of RunAnimationUpdateSystem(), it is reused between frames:
+		wi::vector<AnimationChannelJob> animation_jobs;
+		wi::vector<uint64_t> animation_job_keys; // target entity | job index
+		wi::vector<uint64_t> animation_job_keys_scratch;
+		wi::vector<uint32_t> animation_job_histograms; // radix sort histograms of animation_job_keys
+		wi::vector<uint32_t> animation_target_offsets; // beginning of every target's jobs in animation_job_keys
+
+		// Skinned vertex positions of meshes that CPU queries requested (picking, intersection tests, soft bodies)
+		//	The entries are reused until the armature bones are updated in the next Update()
+		struct SkinningCache
+		{
+			struct Entry
+			{
+				wi::vector<XMFLOAT3> positions;
+				uint32_t generation = 0;
+			};
+			wi::unordered_map<wi::ecs::Entity, Entry> entries; // key: mesh entity
+			uint32_t generation = 1;
+			wi::SpinLock locker;
+		};
+		mutable SkinningCache skinning_cache;
+
 		enum FLAGS
 		{
 			EMPTY = 0,
@@ -1346,6 +1567,9 @@ namespace wi::scene
 		void SetAccelerationStructureUpdateRequested(bool value = true) { acceleration_structure_update_requested = value; }
 		bool IsAccelerationStructureUpdateRequested() const { return acceleration_structure_update_requested; }
 
+		// Physics engine state of this scene, it is created by wi::physics on demand and destroyed with the scene:
+		std::shared_ptr<void> physics_scene;
+
 		// Shader visible scene parameters:
 		ShaderScene shaderscene;
 
@@ -1355,10 +1579,12 @@ namespace wi::scene
 		//		2) hair particles
 		//		3) emitted particles
 		//		4) impostors
+		//	instanceArrayMapped points to CPU-side memory of instanceTracker, the upload buffer only receives the changes
 		wi::graphics::GPUBuffer instanceUploadBuffer[wi::graphics::GraphicsDevice::GetBufferCount()];
 		ShaderMeshInstance* instanceArrayMapped = nullptr;
 		size_t instanceArraySize = 0;
 		wi::graphics::GPUBuffer instanceBuffer;
+		GPUArrayTracker instanceTracker;
 
 		// Geometries for bindless visiblity indexing:
 		//	contains in order:
@@ -1370,6 +1596,7 @@ namespace wi::scene
 		ShaderGeometry* geometryArrayMapped = nullptr;
 		size_t geometryArraySize = 0;
 		wi::graphics::GPUBuffer geometryBuffer;
+		GPUArrayTracker geometryTracker;
 		std::atomic<uint32_t> geometryAllocator{ 0 };
 
 		// Materials for bindless visibility indexing:
@@ -1377,6 +1604,7 @@ namespace wi::scene
 		ShaderMaterial* materialArrayMapped = nullptr;
 		size_t materialArraySize = 0;
 		wi::graphics::GPUBuffer materialBuffer;
+		GPUArrayTracker materialTracker;
 
 		// Meshlets:
 		wi::graphics::GPUBuffer meshletBuffer;
@@ -1541,6 +1769,38 @@ namespace wi::scene
 		// Detaches all children from an entity (if there are any):
 		void Component_DetachChildren(wi::ecs::Entity parent);
 
+		// Compresses all animation data that is used by translation, rotation or scale channels (see AnimationDataComponent::Compress())
+		//	Animation data that is used by different kinds of channels or cubic spline samplers is not compressed
+		//	The error parameters are the maximum allowed error of each kind of track (distance, radians, scale)
+		//	returns the number of compressed animation data components
+		size_t CompressAnimations(float translation_error = 0.001f, float rotation_error = 0.001f, float scale_error = 0.001f);
+
+		// Generates LODs for every mesh that doesn't have LOD levels yet (see MeshComponent::GenerateLODs()) and recreates their render data
+		//	Meshes are processed in parallel, this is meant to be used at load time, for example on a freshly imported scene before merging it
+		//	returns the number of meshes that received LODs
+		size_t GenerateMeshLODs(const MeshComponent::LODGenerationParams& params);
+
+		struct AtlasGenerationStatistics
+		{
+			uint32_t generated = 0; // meshes that received a new atlas
+			uint32_t skipped = 0; // meshes whose atlas was already up to date
+			uint32_t failed = 0; // meshes that xatlas couldn't process
+			float total_milliseconds = 0; // time of the whole batch
+			float mesh_milliseconds_sum = 0; // sum of the times of all generated meshes, compare with total_milliseconds for the parallel speedup
+			float mesh_milliseconds_max = 0; // time of the slowest mesh
+			wi::ecs::Entity slowest_mesh = wi::ecs::INVALID_ENTITY;
+		};
+		// Generates lightmap atlases for a list of meshes (see MeshComponent::GenerateAtlas()) and recreates their render data
+		//	Meshes are processed in parallel, meshes whose atlas is already up to date for this resolution are skipped
+		//	progress: if specified, it is called from worker threads after every mesh with the number of finished and total meshes
+		//	This waits for completion
+		AtlasGenerationStatistics GenerateMeshAtlases(const wi::vector<wi::ecs::Entity>& meshEntities, uint32_t resolution, const std::function<void(uint32_t finished, uint32_t total)>& progress = nullptr);
+
+		// Returns the skinned positions of all vertices of a mesh in armature local space (see SkinVertices())
+		//	They are computed at the first request after the armature was updated, then they are reused from skinning_cache
+		//	The returned memory is valid until the next Update()
+		const XMFLOAT3* GetSkinnedVertexPositions(wi::ecs::Entity meshEntity, const MeshComponent& mesh, const ArmatureComponent& armature) const;
+
 		void Serialize(wi::Archive& archive);
 
 		void RunAnimationUpdateSystem(wi::jobsystem::context& ctx);
@@ -1562,6 +1822,7 @@ namespace wi::scene
 		void RunWeatherUpdateSystem(wi::jobsystem::context& ctx);
 		void RunSoundUpdateSystem(wi::jobsystem::context& ctx);
 
+		// Selects mesh LODs and animation LODs (if animation_lod is enabled) for the camera
 		void UpdateLODsForCamera(const CameraComponent& camera);
 	};
 
@@ -1569,6 +1830,15 @@ namespace wi::scene
 	//	N : normal (out, optional)
 	XMVECTOR SkinVertex(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t index, XMVECTOR* N = nullptr);
 
+	// Skins a range of vertices into armature local space, this is much faster than calling SkinVertex() for each of them
+	//	Bone matrices are blended per vertex, then four vertices are transformed at once in SIMD lanes
+	//	Large ranges are distributed onto wi::jobsystem worker threads
+	//	first		:	first vertex index of the range
+	//	count		:	number of vertices to skin
+	//	positions	:	output positions, must be able to hold count elements
+	//	normals		:	output normals, must be able to hold count elements (optional)
+	void SkinVertices(const MeshComponent& mesh, const ArmatureComponent& armature, uint32_t first, uint32_t count, XMFLOAT3* positions, XMFLOAT3* normals = nullptr);
+
 
 	// Helper that manages a global scene
 	inline Scene& GetScene()
@@ -412,6 +412,42 @@ namespace wi::scene
 				archive >> subsets_per_lod;
 			}
 
+			if (archive.GetVersion() >= 85)
+			{
+				archive >> lod_errors;
+			}
+
+			if (archive.GetVersion() >= 86)
+			{
+				size_t clusterCount;
+				archive >> clusterCount;
+				clusters.resize(clusterCount);
+				for (size_t i = 0; i < clusterCount; ++i)
+				{
+					MeshCluster& cluster = clusters[i];
+					archive >> cluster.subsetIndex;
+					archive >> cluster.vertexOffset;
+					archive >> cluster.vertexCount;
+					archive >> cluster.triangleOffset;
+					archive >> cluster.triangleCount;
+					archive >> cluster.center;
+					archive >> cluster.radius;
+					archive >> cluster.cone_apex;
+					archive >> cluster.cone_axis;
+					archive >> cluster.cone_cutoff;
+				}
+				archive >> cluster_vertices;
+				archive >> cluster_triangles;
+				archive >> cluster_hash;
+				cluster_hash_check = !clusters.empty();
+			}
+			if (archive.GetVersion() >= 87)
+			{
+				archive >> atlas_width;
+				archive >> atlas_height;
+				archive >> atlas_hash;
+			}
+
 			wi::jobsystem::Execute(seri.ctx, [&](wi::jobsystem::JobArgs args) {
 				CreateRenderData();
 			});
@@ -481,6 +517,39 @@ namespace wi::scene
 				archive << subsets_per_lod;
 			}
 
+			if (archive.GetVersion() >= 85)
+			{
+				archive << lod_errors;
+			}
+
+			if (archive.GetVersion() >= 86)
+			{
+				archive << clusters.size();
+				for (const MeshCluster& cluster : clusters)
+				{
+					archive << cluster.subsetIndex;
+					archive << cluster.vertexOffset;
+					archive << cluster.vertexCount;
+					archive << cluster.triangleOffset;
+					archive << cluster.triangleCount;
+					archive << cluster.center;
+					archive << cluster.radius;
+					archive << cluster.cone_apex;
+					archive << cluster.cone_axis;
+					archive << cluster.cone_cutoff;
+				}
+				archive << cluster_vertices;
+				archive << cluster_triangles;
+				cluster_hash = clusters.empty() ? 0 : ComputeClusterHash();
+				archive << cluster_hash;
+			}
+			if (archive.GetVersion() >= 87)
+			{
+				archive << atlas_width;
+				archive << atlas_height;
+				archive << atlas_hash;
+			}
+
 		}
 	}
 	void ImpostorComponent::Serialize(wi::Archive& archive, EntitySerializer& seri)
@@ -605,6 +674,15 @@ namespace wi::scene
 				archive >> capsule.height;
 				archive >> capsule.radius;
 			}
+
+			if (archive.GetVersion() >= 88)
+			{
+				archive >> convex_hull.vertex_limit;
+				archive >> convex_hull.max_hulls;
+				archive >> convex_hull.concavity;
+				archive >> convex_hull_vertices;
+				archive >> convex_hull_vertex_counts;
+			}
 		}
 		else
 		{
@@ -627,6 +705,15 @@ namespace wi::scene
 				archive << capsule.height;
 				archive << capsule.radius;
 			}
+
+			if (archive.GetVersion() >= 88)
+			{
+				archive << convex_hull.vertex_limit;
+				archive << convex_hull.max_hulls;
+				archive << convex_hull.concavity;
+				archive << convex_hull_vertices;
+				archive << convex_hull_vertex_counts;
+			}
 		}
 	}
 	void SoftBodyPhysicsComponent::Serialize(wi::Archive& archive, EntitySerializer& seri)
@@ -993,12 +1080,32 @@ namespace wi::scene
 			archive >> _flags;
 			archive >> keyframe_times;
 			archive >> keyframe_data;
+
+			if (archive.GetVersion() >= 84 && IsCompressed())
+			{
+				archive >> time_start;
+				archive >> time_range;
+				archive >> range_min;
+				archive >> range_extent;
+				archive >> compressed_times;
+				archive >> compressed_data;
+			}
 		}
 		else
 		{
 			archive << _flags;
 			archive << keyframe_times;
 			archive << keyframe_data;
+
+			if (IsCompressed())
+			{
+				archive << time_start;
+				archive << time_range;
+				archive << range_min;
+				archive << range_extent;
+				archive << compressed_times;
+				archive << compressed_data;
+			}
 		}
 	}
 	void WeatherComponent::Serialize(wi::Archive& archive, EntitySerializer& seri)
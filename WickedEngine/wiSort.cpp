@@ -0,0 +1,182 @@
+#include "wiSort.h"
+#include "wiJobSystem.h"
+#include "wiVector.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wi::sort
+{
+	static constexpr uint32_t RADIX_BITS = 8;
+	static constexpr uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+	static constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+	static constexpr size_t PARALLEL_KEYS_PER_JOB = 16384; // below this amount of keys per job, parallel sort is not worth it
+	static constexpr uint32_t PARALLEL_MAX_JOBS = 64;
+
+	inline uint32_t digit(uint64_t key, uint32_t pass)
+	{
+		return uint32_t(key >> uint64_t(pass * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+	}
+
+	void RadixSort(uint64_t* keys, uint64_t* scratch, size_t count)
+	{
+		if (count < 2)
+			return;
+
+		// Histograms of all passes are gathered at once, because the total count of a digit doesn't depend on order:
+		uint32_t histogram[RADIX_PASSES][RADIX_BUCKETS] = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t key = keys[i];
+			for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+			{
+				histogram[pass][digit(key, pass)]++;
+			}
+		}
+
+		uint64_t* src = keys;
+		uint64_t* dst = scratch;
+		for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+		{
+			uint32_t* offsets = histogram[pass];
+			if (offsets[digit(src[0], pass)] == count)
+			{
+				// Every key has the same digit, this pass wouldn't change the order:
+				continue;
+			}
+
+			// Exclusive prefix sum:
+			uint32_t sum = 0;
+			for (uint32_t bucket = 0; bucket < RADIX_BUCKETS; ++bucket)
+			{
+				const uint32_t tmp = offsets[bucket];
+				offsets[bucket] = sum;
+				sum += tmp;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint64_t key = src[i];
+				dst[offsets[digit(key, pass)]++] = key;
+			}
+			std::swap(src, dst);
+		}
+
+		if (src != keys)
+		{
+			std::memcpy(keys, src, count * sizeof(uint64_t));
+		}
+	}
+
+	void RadixSortParallel(uint64_t* keys, uint64_t* scratch, size_t count, wi::vector<uint32_t>& histograms)
+	{
+		const uint32_t jobCount = (uint32_t)std::min(size_t(std::min(wi::jobsystem::GetThreadCount(), PARALLEL_MAX_JOBS)), count / PARALLEL_KEYS_PER_JOB);
+		if (jobCount < 2)
+		{
+			RadixSort(keys, scratch, count);
+			return;
+		}
+		const size_t keysPerJob = (count + jobCount - 1) / jobCount;
+
+		histograms.resize(jobCount * RADIX_PASSES * RADIX_BUCKETS);
+		std::fill(histograms.begin(), histograms.end(), 0u);
+		uint32_t* histogram_data = histograms.data();
+
+		wi::jobsystem::context ctx;
+
+		// Per-job histograms of every pass, these will be used to determine which passes can be skipped:
+		wi::jobsystem::Dispatch(ctx, jobCount, 1, [&](wi::jobsystem::JobArgs args) {
+			uint32_t* histogram = histogram_data + args.jobIndex * RADIX_PASSES * RADIX_BUCKETS;
+			const size_t begin = args.jobIndex * keysPerJob;
+			const size_t end = std::min(begin + keysPerJob, count);
+			for (size_t i = begin; i < end; ++i)
+			{
+				const uint64_t key = keys[i];
+				for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+				{
+					histogram[pass * RADIX_BUCKETS + digit(key, pass)]++;
+				}
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		uint32_t total[RADIX_PASSES][RADIX_BUCKETS] = {};
+		for (uint32_t job = 0; job < jobCount; ++job)
+		{
+			const uint32_t* histogram = histogram_data + job * RADIX_PASSES * RADIX_BUCKETS;
+			for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+			{
+				for (uint32_t bucket = 0; bucket < RADIX_BUCKETS; ++bucket)
+				{
+					total[pass][bucket] += histogram[pass * RADIX_BUCKETS + bucket];
+				}
+			}
+		}
+
+		uint64_t* src = keys;
+		uint64_t* dst = scratch;
+		bool first_pass = true;
+		for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+		{
+			if (total[pass][digit(src[0], pass)] == count)
+			{
+				// Every key has the same digit, this pass wouldn't change the order:
+				continue;
+			}
+
+			// Per-job histograms of this pass (job ranges only contain the same keys as in the beginning before the first scatter):
+			if (!first_pass)
+			{
+				wi::jobsystem::Dispatch(ctx, jobCount, 1, [&](wi::jobsystem::JobArgs args) {
+					uint32_t* histogram = histogram_data + (args.jobIndex * RADIX_PASSES + pass) * RADIX_BUCKETS;
+					std::memset(histogram, 0, sizeof(uint32_t) * RADIX_BUCKETS);
+					const size_t begin = args.jobIndex * keysPerJob;
+					const size_t end = std::min(begin + keysPerJob, count);
+					for (size_t i = begin; i < end; ++i)
+					{
+						histogram[digit(src[i], pass)]++;
+					}
+				});
+				wi::jobsystem::Wait(ctx);
+			}
+			first_pass = false;
+
+			// Convert histograms into scatter offsets: jobs write after the same buckets of preceding jobs to keep the sort stable
+			uint32_t sum = 0;
+			for (uint32_t bucket = 0; bucket < RADIX_BUCKETS; ++bucket)
+			{
+				for (uint32_t job = 0; job < jobCount; ++job)
+				{
+					uint32_t& offset = histogram_data[(job * RADIX_PASSES + pass) * RADIX_BUCKETS + bucket];
+					const uint32_t tmp = offset;
+					offset = sum;
+					sum += tmp;
+				}
+			}
+
+			wi::jobsystem::Dispatch(ctx, jobCount, 1, [&](wi::jobsystem::JobArgs args) {
+				uint32_t* offsets = histogram_data + (args.jobIndex * RADIX_PASSES + pass) * RADIX_BUCKETS;
+				const size_t begin = args.jobIndex * keysPerJob;
+				const size_t end = std::min(begin + keysPerJob, count);
+				for (size_t i = begin; i < end; ++i)
+				{
+					const uint64_t key = src[i];
+					dst[offsets[digit(key, pass)]++] = key;
+				}
+			});
+			wi::jobsystem::Wait(ctx);
+			std::swap(src, dst);
+		}
+
+		if (src != keys)
+		{
+			std::memcpy(keys, src, count * sizeof(uint64_t));
+		}
+	}
+
+	void RadixSortParallel(uint64_t* keys, uint64_t* scratch, size_t count)
+	{
+		wi::vector<uint32_t> histograms;
+		RadixSortParallel(keys, scratch, count, histograms);
+	}
+}
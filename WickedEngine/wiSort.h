@@ -0,0 +1,22 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiVector.h"
+
+namespace wi::sort
+{
+	// Sort 64-bit keys in ascending order with a stable LSD radix sort (8 bits per pass)
+	//	Passes where every key has the same digit are skipped, so keys with few used bits sort faster
+	//	keys	-	the keys to sort, the sorted result is written back here (Read + Write)
+	//	scratch	-	temporary memory, it must be able to hold count elements (Write)
+	//	count	-	number of keys
+	void RadixSort(uint64_t* keys, uint64_t* scratch, size_t count);
+
+	// Same as RadixSort(), but histogram and scatter steps are distributed onto wi::jobsystem worker threads
+	//	It is only worth it for large arrays, small arrays will fall back to RadixSort()
+	//	histograms	-	temporary memory owned by the caller, it will be resized as needed and can be reused between sorts (Write)
+	//	This waits for the jobs it dispatched, and the waiting thread can execute other jobs meanwhile,
+	//	so the caller must not pass memory that such a job could also be using (for example a thread_local buffer)
+	void RadixSortParallel(uint64_t* keys, uint64_t* scratch, size_t count, wi::vector<uint32_t>& histograms);
+	// Same as above, but histogram memory is allocated for this sort
+	void RadixSortParallel(uint64_t* keys, uint64_t* scratch, size_t count);
+};
@@ -0,0 +1,908 @@
+#include "wiTerrain.h"
+#include "wiRenderer.h"
+#include "wiProfiler.h"
+#include "wiHelper.h"
+#include "wiTimer.h"
+#include "wiResourceManager.h"
+
+#include <algorithm>
+
+using namespace wi::ecs;
+using namespace wi::scene;
+using namespace wi::graphics;
+
+namespace wi::terrain
+{
+	static constexpr int height_grid_width = chunk_width + 1; // +1: neighbor samples of the last row and column are needed for normals
+
+	// Vertex data of a chunk that is being generated, this is filled in parallel before it is added to the scene
+	struct ChunkGeneration
+	{
+		Chunk chunk = {};
+		XMFLOAT3 chunk_pos = XMFLOAT3(0, 0, 0);
+		ChunkData* chunk_data = nullptr;
+		MeshComponent* mesh = nullptr;
+		wi::vector<float> heights;
+		wi::vector<XMFLOAT3> vertex_positions;
+		wi::vector<XMFLOAT3> vertex_normals;
+		wi::vector<XMFLOAT2> vertex_uvset_0;
+		wi::vector<float> grass_lengths;
+	};
+
+	static void CreateIndices(wi::vector<uint32_t>& indices, wi::vector<Terrain::LOD>& lods)
+	{
+		indices.clear();
+		lods.clear();
+		lods.resize(max_lod);
+		for (int lod = 0; lod < max_lod; ++lod)
+		{
+			lods[lod].indexOffset = (uint32_t)indices.size();
+
+			if (lod == 0)
+			{
+				for (int x = 0; x < chunk_width - 1; x++)
+				{
+					for (int z = 0; z < chunk_width - 1; z++)
+					{
+						int lowerLeft = x + z * chunk_width;
+						int lowerRight = (x + 1) + z * chunk_width;
+						int topLeft = x + (z + 1) * chunk_width;
+						int topRight = (x + 1) + (z + 1) * chunk_width;
+
+						indices.push_back(topLeft);
+						indices.push_back(lowerLeft);
+						indices.push_back(lowerRight);
+
+						indices.push_back(topLeft);
+						indices.push_back(lowerRight);
+						indices.push_back(topRight);
+					}
+				}
+			}
+			else
+			{
+				const int step = 1 << lod;
+				// inner grid:
+				for (int x = 1; x < chunk_width - 2; x += step)
+				{
+					for (int z = 1; z < chunk_width - 2; z += step)
+					{
+						int lowerLeft = x + z * chunk_width;
+						int lowerRight = (x + step) + z * chunk_width;
+						int topLeft = x + (z + step) * chunk_width;
+						int topRight = (x + step) + (z + step) * chunk_width;
+
+						indices.push_back(topLeft);
+						indices.push_back(lowerLeft);
+						indices.push_back(lowerRight);
+
+						indices.push_back(topLeft);
+						indices.push_back(lowerRight);
+						indices.push_back(topRight);
+					}
+				}
+				// bottom border:
+				for (int x = 0; x < chunk_width - 1; ++x)
+				{
+					const int z = 0;
+					int current = x + z * chunk_width;
+					int neighbor = x + 1 + z * chunk_width;
+					int connection = 1 + ((x + (step + 1) / 2 - 1) / step) * step + (z + 1) * chunk_width;
+
+					indices.push_back(current);
+					indices.push_back(neighbor);
+					indices.push_back(connection);
+
+					if (((x - 1) % (step)) == step / 2) // halfway fill triangle
+					{
+						int connection1 = 1 + (((x - 1) + (step + 1) / 2 - 1) / step) * step + (z + 1) * chunk_width;
+
+						indices.push_back(current);
+						indices.push_back(connection);
+						indices.push_back(connection1);
+					}
+				}
+				// top border:
+				for (int x = 0; x < chunk_width - 1; ++x)
+				{
+					const int z = chunk_width - 1;
+					int current = x + z * chunk_width;
+					int neighbor = x + 1 + z * chunk_width;
+					int connection = 1 + ((x + (step + 1) / 2 - 1) / step) * step + (z - 1) * chunk_width;
+
+					indices.push_back(current);
+					indices.push_back(connection);
+					indices.push_back(neighbor);
+
+					if (((x - 1) % (step)) == step / 2) // halfway fill triangle
+					{
+						int connection1 = 1 + (((x - 1) + (step + 1) / 2 - 1) / step) * step + (z - 1) * chunk_width;
+
+						indices.push_back(current);
+						indices.push_back(connection1);
+						indices.push_back(connection);
+					}
+				}
+				// left border:
+				for (int z = 0; z < chunk_width - 1; ++z)
+				{
+					const int x = 0;
+					int current = x + z * chunk_width;
+					int neighbor = x + (z + 1) * chunk_width;
+					int connection = x + 1 + (((z + (step + 1) / 2 - 1) / step) * step + 1) * chunk_width;
+
+					indices.push_back(current);
+					indices.push_back(connection);
+					indices.push_back(neighbor);
+
+					if (((z - 1) % (step)) == step / 2) // halfway fill triangle
+					{
+						int connection1 = x + 1 + ((((z - 1) + (step + 1) / 2 - 1) / step) * step + 1) * chunk_width;
+
+						indices.push_back(current);
+						indices.push_back(connection1);
+						indices.push_back(connection);
+					}
+				}
+				// right border:
+				for (int z = 0; z < chunk_width - 1; ++z)
+				{
+					const int x = chunk_width - 1;
+					int current = x + z * chunk_width;
+					int neighbor = x + (z + 1) * chunk_width;
+					int connection = x - 1 + (((z + (step + 1) / 2 - 1) / step) * step + 1) * chunk_width;
+
+					indices.push_back(current);
+					indices.push_back(neighbor);
+					indices.push_back(connection);
+
+					if (((z - 1) % (step)) == step / 2) // halfway fill triangle
+					{
+						int connection1 = x - 1 + ((((z - 1) + (step + 1) / 2 - 1) / step) * step + 1) * chunk_width;
+
+						indices.push_back(current);
+						indices.push_back(connection);
+						indices.push_back(connection1);
+					}
+				}
+			}
+
+			lods[lod].indexCount = (uint32_t)indices.size() - lods[lod].indexOffset;
+		}
+	}
+
+	void Terrain::Generation_Restart()
+	{
+		Generation_Cancel();
+		generation_scene.Clear();
+
+		chunks.clear();
+		requests.clear();
+
+		if (lods.empty())
+		{
+			CreateIndices(indices, lods);
+		}
+
+		if (terrainEntity == INVALID_ENTITY)
+		{
+			terrainEntity = CreateEntity();
+		}
+		scene->Entity_Remove(terrainEntity);
+		scene->transforms.Create(terrainEntity);
+		scene->names.Create(terrainEntity) = "terrain";
+
+		perlin.init(seed);
+	}
+
+	void Terrain::Generation_Update(const CameraComponent& camera)
+	{
+		// The generation task is always cancelled every frame so we are sure that generation is not running at this point
+		Generation_Cancel();
+
+		if (terrainEntity == INVALID_ENTITY || !scene->transforms.Contains(terrainEntity))
+		{
+			chunks.clear();
+			requests.clear();
+			return;
+		}
+
+		auto range = wi::profiler::BeginRangeCPU("Terrain Streaming");
+
+		// What was generated, will be merged in to the main scene
+		scene->Merge(generation_scene);
+
+		if (center_to_cam)
+		{
+			center_chunk.x = (int)std::floor((camera.Eye.x + chunk_half_width) * chunk_width_rcp * chunk_scale_rcp);
+			center_chunk.z = (int)std::floor((camera.Eye.z + chunk_half_width) * chunk_width_rcp * chunk_scale_rcp);
+		}
+
+		const int removal_threshold = generation + removal_distance;
+		const float texlodMultiplier = texlod;
+		GraphicsDevice* device = GetDevice();
+		virtual_texture_updates.clear();
+		virtual_texture_barriers_begin.clear();
+		virtual_texture_barriers_end.clear();
+
+		// Check whether there are any materials that would write to virtual textures:
+		uint32_t max_texture_resolution = 0;
+		bool virtual_texture_available[MaterialComponent::TEXTURESLOT_COUNT] = {};
+		virtual_texture_available[MaterialComponent::SURFACEMAP] = true; // this is always needed to bake individual material properties
+		MaterialComponent* virtual_materials[4] = {
+			&material_Base,
+			&material_Slope,
+			&material_LowAltitude,
+			&material_HighAltitude,
+		};
+		for (auto& material : virtual_materials)
+		{
+			for (int i = 0; i < MaterialComponent::TEXTURESLOT_COUNT; ++i)
+			{
+				switch (i)
+				{
+				case MaterialComponent::BASECOLORMAP:
+				case MaterialComponent::NORMALMAP:
+				case MaterialComponent::SURFACEMAP:
+					if (material->textures[i].resource.IsValid())
+					{
+						virtual_texture_available[i] = true;
+						const TextureDesc& desc = material->textures[i].resource.GetTexture().GetDesc();
+						max_texture_resolution = std::max(max_texture_resolution, desc.width);
+						max_texture_resolution = std::max(max_texture_resolution, desc.height);
+					}
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		for (auto it = chunks.begin(); it != chunks.end();)
+		{
+			const Chunk& chunk = it->first;
+			ChunkData& chunk_data = it->second;
+			const int dist = std::max(std::abs(center_chunk.x - chunk.x), std::abs(center_chunk.z - chunk.z));
+
+			// chunk removal:
+			if (removal)
+			{
+				if (dist > removal_threshold)
+				{
+					scene->Entity_Remove(it->second.entity);
+					it = chunks.erase(it);
+					continue; // don't increment iterator
+				}
+				else
+				{
+					// Grass patch removal:
+					if (chunk_data.grass.meshID != INVALID_ENTITY)
+					{
+						if (dist > 1)
+						{
+							scene->Entity_Remove(chunk_data.grass_entity);
+							chunk_data.grass_exists = false; // grass can be generated here by generation thread...
+						}
+					}
+				}
+			}
+
+			// Collect virtual texture update requests:
+			if (max_texture_resolution > 0)
+			{
+				uint32_t texture_lod = 0;
+				const float distsq = wi::math::DistanceSquared(camera.Eye, chunk_data.sphere.center);
+				const float radius = chunk_data.sphere.radius;
+				const float radiussq = radius * radius;
+				if (distsq < radiussq)
+				{
+					texture_lod = 0;
+				}
+				else
+				{
+					const float dist = std::sqrt(distsq);
+					const float dist_to_sphere = dist - radius;
+					texture_lod = uint32_t(dist_to_sphere * texlodMultiplier);
+				}
+
+				uint32_t chunk_required_texture_resolution = uint32_t(max_texture_resolution / std::pow(2.0f, (float)std::max(0u, texture_lod)));
+				chunk_required_texture_resolution = std::max(8u, chunk_required_texture_resolution);
+				if (chunk_data.virtual_texture_resolution != chunk_required_texture_resolution)
+				{
+					chunk_data.virtual_texture_resolution = chunk_required_texture_resolution;
+
+					MaterialComponent* material = scene->materials.GetComponent(chunk_data.entity);
+					if (material != nullptr)
+					{
+						for (int i = 0; i < MaterialComponent::TEXTURESLOT_COUNT; ++i)
+						{
+							if (virtual_texture_available[i])
+							{
+								TextureDesc desc;
+								desc.width = chunk_required_texture_resolution;
+								desc.height = chunk_required_texture_resolution;
+								desc.format = Format::R8G8B8A8_UNORM;
+								desc.bind_flags = BindFlag::SHADER_RESOURCE | BindFlag::UNORDERED_ACCESS;
+								Texture texture;
+								bool success = device->CreateTexture(&desc, nullptr, &texture);
+								assert(success);
+
+								material->textures[i].resource.SetTexture(texture);
+								virtual_texture_barriers_begin.push_back(GPUBarrier::Image(&material->textures[i].resource.GetTexture(), desc.layout, ResourceState::UNORDERED_ACCESS));
+								virtual_texture_barriers_end.push_back(GPUBarrier::Image(&material->textures[i].resource.GetTexture(), ResourceState::UNORDERED_ACCESS, desc.layout));
+							}
+						}
+
+						virtual_texture_updates.push_back(chunk);
+					}
+
+				}
+			}
+
+			it++;
+		}
+
+		// Execute batched virtual texture updates:
+		if (!virtual_texture_updates.empty())
+		{
+			CommandList cmd = device->BeginCommandList();
+			device->EventBegin("TerrainVirtualTextureUpdate", cmd);
+			auto range = wi::profiler::BeginRangeGPU("TerrainVirtualTextureUpdate", cmd);
+			device->Barrier(virtual_texture_barriers_begin.data(), (uint32_t)virtual_texture_barriers_begin.size(), cmd);
+
+			device->BindComputeShader(wi::renderer::GetShader(wi::enums::CSTYPE_TERRAIN_VIRTUALTEXTURE_UPDATE), cmd);
+
+			ShaderMaterial materials[4];
+			material_Base.WriteShaderMaterial(&materials[0]);
+			material_Slope.WriteShaderMaterial(&materials[1]);
+			material_LowAltitude.WriteShaderMaterial(&materials[2]);
+			material_HighAltitude.WriteShaderMaterial(&materials[3]);
+			device->BindDynamicConstantBuffer(materials, 10, cmd);
+
+			for (auto& chunk : virtual_texture_updates)
+			{
+				auto it = chunks.find(chunk);
+				if (it == chunks.end())
+					continue;
+				ChunkData& chunk_data = it->second;
+
+				const GPUResource* res[] = {
+					&chunk_data.region_weights_texture,
+				};
+				device->BindResources(res, 0, arraysize(res), cmd);
+
+				MaterialComponent* material = scene->materials.GetComponent(chunk_data.entity);
+				if (material != nullptr)
+				{
+					// Shrink the uvs to avoid wrap sampling across edge by object rendering shaders:
+					float virtual_texture_resolution_rcp = 1.0f / float(chunk_data.virtual_texture_resolution);
+					material->texMulAdd.x = float(chunk_data.virtual_texture_resolution - 1) * virtual_texture_resolution_rcp;
+					material->texMulAdd.y = float(chunk_data.virtual_texture_resolution - 1) * virtual_texture_resolution_rcp;
+					material->texMulAdd.z = 0.5f * virtual_texture_resolution_rcp;
+					material->texMulAdd.w = 0.5f * virtual_texture_resolution_rcp;
+
+					for (int i = 0; i < MaterialComponent::TEXTURESLOT_COUNT; ++i)
+					{
+						if (virtual_texture_available[i])
+						{
+							device->BindUAV(material->textures[i].GetGPUResource(), i, cmd);
+						}
+					}
+				}
+
+				device->Dispatch(chunk_data.virtual_texture_resolution / 8u, chunk_data.virtual_texture_resolution / 8u, 1, cmd);
+			}
+
+			device->Barrier(virtual_texture_barriers_end.data(), (uint32_t)virtual_texture_barriers_end.size(), cmd);
+			wi::profiler::EndRange(range);
+			device->EventEnd(cmd);
+		}
+
+		// Request every missing chunk in generation distance, nearest first
+		//	Chunks outside the camera frustum are pushed back, so that the visible terrain is completed sooner
+		requests.clear();
+		const XMFLOAT3 priority_origin = center_to_cam ? camera.Eye : XMFLOAT3(float(center_chunk.x * (chunk_width - 1)) * chunk_scale, 0, float(center_chunk.z * (chunk_width - 1)) * chunk_scale);
+		const float chunk_center_height = (bottomLevel + topLevel) * 0.5f;
+		const float chunk_half_extent = chunk_half_width * chunk_scale;
+		const float chunk_half_height = std::abs(topLevel - bottomLevel) * 0.5f;
+		const float chunk_radius = std::sqrt(chunk_half_extent * chunk_half_extent * 2 + chunk_half_height * chunk_half_height);
+		for (int offset_z = -generation; offset_z <= generation; ++offset_z)
+		{
+			for (int offset_x = -generation; offset_x <= generation; ++offset_x)
+			{
+				Chunk chunk = center_chunk;
+				chunk.x += offset_x;
+				chunk.z += offset_z;
+				auto it = chunks.find(chunk);
+				if (it != chunks.end() && it->second.entity != INVALID_ENTITY)
+					continue;
+
+				const XMFLOAT3 chunk_center = XMFLOAT3(float(chunk.x * (chunk_width - 1)) * chunk_scale, chunk_center_height, float(chunk.z * (chunk_width - 1)) * chunk_scale);
+				ChunkRequest& request = requests.emplace_back();
+				request.chunk = chunk;
+				request.priority = std::sqrt(wi::math::DistanceSquared(XMFLOAT2(priority_origin.x, priority_origin.z), XMFLOAT2(chunk_center.x, chunk_center.z)));
+				if (!camera.frustum.CheckSphere(chunk_center, chunk_radius))
+				{
+					request.priority *= outside_frustum_priority;
+				}
+			}
+		}
+		std::sort(requests.begin(), requests.end(), [](const ChunkRequest& a, const ChunkRequest& b) {
+			return a.priority < b.priority;
+		});
+
+		wi::profiler::EndRange(range);
+
+		// Start the generation on a background thread and keep it running until the next frame
+		//	The scalar parameters below are copied, so they can be modified while the generation is running
+		//	The generator, props, materials, requests and chunks are accessed through this, call Generation_Cancel() before modifying those
+		struct GenerationParams
+		{
+			float lod_multiplier;
+			float bottomLevel;
+			float topLevel;
+			float region1;
+			float region2;
+			float region3;
+		} params = { lod_multiplier, bottomLevel, topLevel, region1, region2, region3 };
+		const uint32_t batch_size = std::max(1u, wi::jobsystem::GetThreadCount());
+		wi::jobsystem::Execute(generation_workload, [=](wi::jobsystem::JobArgs args) {
+
+			wi::Timer timer;
+			GraphicsDevice* device = GetDevice();
+			wi::vector<ChunkGeneration> batch;
+			batch.reserve(batch_size);
+
+			// Grass patches are only placed on the center chunk and its neighbors:
+			auto place_grass = [&]() {
+				for (int offset_z = -1; offset_z <= 1; ++offset_z)
+				{
+					for (int offset_x = -1; offset_x <= 1; ++offset_x)
+					{
+						Chunk chunk = center_chunk;
+						chunk.x += offset_x;
+						chunk.z += offset_z;
+						auto it = chunks.find(chunk);
+						if (it == chunks.end() || it->second.entity == INVALID_ENTITY)
+							continue;
+						ChunkData& chunk_data = it->second;
+						if (chunk_data.grass.meshID != INVALID_ENTITY && !chunk_data.grass_exists)
+						{
+							// add patch for this chunk
+							wi::HairParticleSystem& grass = generation_scene.hairs.Create(chunk_data.grass_entity);
+							grass = chunk_data.grass;
+							generation_scene.materials.Create(chunk_data.grass_entity) = material_GrassParticle;
+							generation_scene.transforms.Create(chunk_data.grass_entity);
+							generation_scene.names.Create(chunk_data.grass_entity) = "grass";
+							generation_scene.Component_Attach(chunk_data.grass_entity, chunk_data.entity, true);
+							chunk_data.grass_exists = true; // don't generate more grass here
+						}
+					}
+				}
+			};
+			place_grass();
+
+			for (size_t request_offset = 0; request_offset < requests.size(); request_offset += batch_size)
+			{
+				if (generation_cancelled.load())
+					return;
+
+				// The map entries of the whole batch are created before pointers to them are taken, because insertion can move entries:
+				batch.clear();
+				const size_t request_end = std::min(requests.size(), request_offset + batch_size);
+				for (size_t i = request_offset; i < request_end; ++i)
+				{
+					ChunkGeneration& gen = batch.emplace_back();
+					gen.chunk = requests[i].chunk;
+					gen.chunk_pos = XMFLOAT3(float(gen.chunk.x * (chunk_width - 1)) * chunk_scale, 0, float(gen.chunk.z * (chunk_width - 1)) * chunk_scale);
+					chunks[gen.chunk];
+				}
+				for (ChunkGeneration& gen : batch)
+				{
+					gen.chunk_data = &chunks[gen.chunk];
+					gen.heights.resize(height_grid_width * height_grid_width);
+					gen.vertex_positions.resize(vertexCount);
+					gen.vertex_normals.resize(vertexCount);
+					gen.vertex_uvset_0.resize(vertexCount);
+					gen.grass_lengths.resize(vertexCount);
+				}
+				const uint32_t batch_count = (uint32_t)batch.size();
+
+				// Every height is sampled once per chunk, rows of all chunks in the batch are computed in parallel:
+				wi::jobsystem::context ctx;
+				wi::jobsystem::Dispatch(ctx, batch_count * height_grid_width, 4, [&](wi::jobsystem::JobArgs args) {
+					ChunkGeneration& gen = batch[args.jobIndex / height_grid_width];
+					const int row = int(args.jobIndex % height_grid_width);
+					float world_x[height_grid_width];
+					float world_z[height_grid_width];
+					for (int column = 0; column < height_grid_width; ++column)
+					{
+						world_x[column] = gen.chunk_pos.x + (float(column) - chunk_half_width) * chunk_scale;
+						world_z[column] = gen.chunk_pos.z + (float(row) - chunk_half_width) * chunk_scale;
+					}
+					ComputeHeights(world_x, world_z, gen.heights.data() + row * height_grid_width, height_grid_width);
+				});
+				wi::jobsystem::Wait(ctx);
+
+				// Compute vertex properties from the height grid:
+				wi::jobsystem::Dispatch(ctx, batch_count * chunk_width, 4, [&](wi::jobsystem::JobArgs args) {
+					ChunkGeneration& gen = batch[args.jobIndex / chunk_width];
+					ChunkData& chunk_data = *gen.chunk_data;
+					const int row = int(args.jobIndex % chunk_width);
+					for (int column = 0; column < chunk_width; ++column)
+					{
+						const uint32_t index = uint32_t(column + row * chunk_width);
+						const float x = (float(column) - chunk_half_width) * chunk_scale;
+						const float z = (float(row) - chunk_half_width) * chunk_scale;
+						const float height = gen.heights[column + row * height_grid_width];
+						const float height_right = gen.heights[column + 1 + row * height_grid_width];
+						const float height_forward = gen.heights[column + (row + 1) * height_grid_width];
+						const XMVECTOR corner0 = XMVectorSet(x, height, z, 0);
+						const XMVECTOR corner1 = XMVectorSet(x + chunk_scale, height_right, z, 0);
+						const XMVECTOR corner2 = XMVectorSet(x, height_forward, z + chunk_scale, 0);
+						const XMVECTOR T = XMVectorSubtract(corner2, corner1);
+						const XMVECTOR B = XMVectorSubtract(corner1, corner0);
+						const XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
+						XMFLOAT3 normal;
+						XMStoreFloat3(&normal, N);
+
+						const float region_base = 1;
+						const float region_slope = std::pow(1.0f - wi::math::saturate(normal.y), params.region1);
+						const float region_low_altitude = params.bottomLevel == 0 ? 0 : std::pow(wi::math::saturate(wi::math::InverseLerp(0, params.bottomLevel, height)), params.region2);
+						const float region_high_altitude = params.topLevel == 0 ? 0 : std::pow(wi::math::saturate(wi::math::InverseLerp(0, params.topLevel, height)), params.region3);
+
+						XMFLOAT4 materialBlendWeights(region_base, 0, 0, 0);
+						materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 1, 0, 0), region_slope);
+						materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 0, 1, 0), region_low_altitude);
+						materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 0, 0, 1), region_high_altitude);
+						const float weight_norm = 1.0f / (materialBlendWeights.x + materialBlendWeights.y + materialBlendWeights.z + materialBlendWeights.w);
+						materialBlendWeights.x *= weight_norm;
+						materialBlendWeights.y *= weight_norm;
+						materialBlendWeights.z *= weight_norm;
+						materialBlendWeights.w *= weight_norm;
+
+						chunk_data.region_weights[index] = wi::Color::fromFloat4(materialBlendWeights);
+
+						gen.vertex_positions[index] = XMFLOAT3(x, height, z);
+						gen.vertex_normals[index] = normal;
+						gen.vertex_uvset_0[index] = XMFLOAT2(x * chunk_scale_rcp * chunk_width_rcp + 0.5f, z * chunk_scale_rcp * chunk_width_rcp + 0.5f);
+
+						const XMFLOAT3 vertex_pos(gen.chunk_pos.x + x, height, gen.chunk_pos.z + z);
+						const float grass_noise_frequency = 0.1f;
+						const float grass_noise = perlin.compute(vertex_pos.x * grass_noise_frequency, vertex_pos.y * grass_noise_frequency, vertex_pos.z * grass_noise_frequency) * 0.5f + 0.5f;
+						const float region_grass = std::pow(materialBlendWeights.x * (1 - materialBlendWeights.w), 8.0f) * grass_noise;
+						gen.grass_lengths[index] = region_grass > 0.1f ? region_grass : 0;
+					}
+				});
+				wi::jobsystem::Wait(ctx);
+
+				// Scene entities are created serially, the generation scene is not thread safe:
+				for (ChunkGeneration& gen : batch)
+				{
+					const Chunk& chunk = gen.chunk;
+					ChunkData& chunk_data = *gen.chunk_data;
+
+					chunk_data.entity = generation_scene.Entity_CreateObject("chunk_" + std::to_string(chunk.x) + "_" + std::to_string(chunk.z));
+					ObjectComponent& object = *generation_scene.objects.GetComponent(chunk_data.entity);
+					object.lod_distance_multiplier = params.lod_multiplier;
+					generation_scene.Component_Attach(chunk_data.entity, terrainEntity);
+
+					TransformComponent& transform = *generation_scene.transforms.GetComponent(chunk_data.entity);
+					transform.ClearTransform();
+					transform.Translate(gen.chunk_pos);
+					transform.UpdateTransform();
+
+					MaterialComponent& material = generation_scene.materials.Create(chunk_data.entity);
+					// material params will be 1 because they will be created from only texture maps
+					//	because region materials are blended together into one texture
+					material.SetRoughness(1);
+					material.SetMetalness(1);
+					material.SetReflectance(1);
+
+					MeshComponent& mesh = generation_scene.meshes.Create(chunk_data.entity);
+					object.meshID = chunk_data.entity;
+					mesh.indices = indices;
+					for (auto& lod : lods)
+					{
+						mesh.subsets.emplace_back();
+						mesh.subsets.back().materialID = chunk_data.entity;
+						mesh.subsets.back().indexCount = lod.indexCount;
+						mesh.subsets.back().indexOffset = lod.indexOffset;
+					}
+					mesh.subsets_per_lod = 1;
+					mesh.vertex_positions = std::move(gen.vertex_positions);
+					mesh.vertex_normals = std::move(gen.vertex_normals);
+					mesh.vertex_uvset_0 = std::move(gen.vertex_uvset_0);
+
+					// If there were any vertices in this chunk that could be valid for grass, store the grass particle system:
+					uint32_t grass_valid_vertex_count = 0;
+					for (float length : gen.grass_lengths)
+					{
+						grass_valid_vertex_count += length > 0 ? 1 : 0;
+					}
+					if (grass_valid_vertex_count > 0)
+					{
+						chunk_data.grass_entity = CreateEntity();
+						chunk_data.grass = grass_properties; // the grass will be added to the scene later, only when the chunk is close to the camera (center chunk's neighbors)
+						chunk_data.grass.vertex_lengths = std::move(gen.grass_lengths);
+						chunk_data.grass.meshID = chunk_data.entity;
+						chunk_data.grass.strandCount = grass_valid_vertex_count * 3;
+						chunk_data.grass.viewDistance = chunk_width;
+					}
+				}
+
+				// Mesh pointers are only taken after all meshes of the batch were created:
+				for (ChunkGeneration& gen : batch)
+				{
+					gen.mesh = generation_scene.meshes.GetComponent(gen.chunk_data->entity);
+				}
+				wi::jobsystem::Dispatch(ctx, batch_count, 1, [&](wi::jobsystem::JobArgs args) {
+					ChunkGeneration& gen = batch[args.jobIndex];
+					MeshComponent& mesh = *gen.mesh;
+					mesh.CreateRenderData();
+					gen.chunk_data->sphere.center = mesh.aabb.getCenter();
+					gen.chunk_data->sphere.center.x += gen.chunk_pos.x;
+					gen.chunk_data->sphere.center.y += gen.chunk_pos.y;
+					gen.chunk_data->sphere.center.z += gen.chunk_pos.z;
+					gen.chunk_data->sphere.radius = mesh.aabb.getRadius();
+				});
+
+				// Create the blend weights textures for virtual texture update, while the render data is created:
+				for (ChunkGeneration& gen : batch)
+				{
+					ChunkData& chunk_data = *gen.chunk_data;
+					TextureDesc desc;
+					desc.width = (uint32_t)chunk_width;
+					desc.height = (uint32_t)chunk_width;
+					desc.format = Format::R8G8B8A8_UNORM;
+					desc.bind_flags = BindFlag::SHADER_RESOURCE;
+					SubresourceData data;
+					data.data_ptr = chunk_data.region_weights;
+					data.row_pitch = chunk_width * sizeof(chunk_data.region_weights[0]);
+					bool success = device->CreateTexture(&desc, &data, &chunk_data.region_weights_texture);
+					assert(success);
+				}
+				wi::jobsystem::Wait(ctx); // wait until mesh.CreateRenderData() async tasks finish
+
+				// Prop placement:
+				for (ChunkGeneration& gen : batch)
+				{
+					const Chunk& chunk = gen.chunk;
+					ChunkData& chunk_data = *gen.chunk_data;
+					const MeshComponent& mesh = *gen.mesh;
+					const XMFLOAT3& chunk_pos = gen.chunk_pos;
+					chunk_data.prop_rand.seed((uint32_t)chunk.compute_hash() ^ seed);
+					for (auto& prop : props)
+					{
+						std::uniform_int_distribution<uint32_t> gen_distr(prop.min_count_per_chunk, prop.max_count_per_chunk);
+						int gen_count = gen_distr(chunk_data.prop_rand);
+						for (int i = 0; i < gen_count; ++i)
+						{
+							std::uniform_real_distribution<float> float_distr(0.0f, 1.0f);
+							std::uniform_int_distribution<uint32_t> ind_distr(0, lods[0].indexCount / 3 - 1);
+							uint32_t tri = ind_distr(chunk_data.prop_rand); // random triangle on the chunk mesh
+							uint32_t ind0 = mesh.indices[tri * 3 + 0];
+							uint32_t ind1 = mesh.indices[tri * 3 + 1];
+							uint32_t ind2 = mesh.indices[tri * 3 + 2];
+							const XMFLOAT3& pos0 = mesh.vertex_positions[ind0];
+							const XMFLOAT3& pos1 = mesh.vertex_positions[ind1];
+							const XMFLOAT3& pos2 = mesh.vertex_positions[ind2];
+							const XMFLOAT4 region0 = chunk_data.region_weights[ind0];
+							const XMFLOAT4 region1 = chunk_data.region_weights[ind1];
+							const XMFLOAT4 region2 = chunk_data.region_weights[ind2];
+							// random barycentric coords on the triangle:
+							float f = float_distr(chunk_data.prop_rand);
+							float g = float_distr(chunk_data.prop_rand);
+							if (f + g > 1)
+							{
+								f = 1 - f;
+								g = 1 - g;
+							}
+							XMFLOAT3 vertex_pos;
+							vertex_pos.x = pos0.x + f * (pos1.x - pos0.x) + g * (pos2.x - pos0.x);
+							vertex_pos.y = pos0.y + f * (pos1.y - pos0.y) + g * (pos2.y - pos0.y);
+							vertex_pos.z = pos0.z + f * (pos1.z - pos0.z) + g * (pos2.z - pos0.z);
+							vertex_pos.x += chunk_pos.x;
+							vertex_pos.z += chunk_pos.z;
+							XMFLOAT4 region;
+							region.x = region0.x + f * (region1.x - region0.x) + g * (region2.x - region0.x);
+							region.y = region0.y + f * (region1.y - region0.y) + g * (region2.y - region0.y);
+							region.z = region0.z + f * (region1.z - region0.z) + g * (region2.z - region0.z);
+							region.w = region0.w + f * (region1.w - region0.w) + g * (region2.w - region0.w);
+
+							const float noise = std::pow(perlin.compute(vertex_pos.x * prop.noise_frequency, vertex_pos.y * prop.noise_frequency, vertex_pos.z * prop.noise_frequency) * 0.5f + 0.5f, prop.noise_power);
+							const float chance = std::pow(((float*)&region)[prop.region], prop.region_power) * noise;
+							if (chance > prop.threshold)
+							{
+								Entity entity = generation_scene.Entity_CreateObject(prop.name + std::to_string(i));
+								ObjectComponent* object = generation_scene.objects.GetComponent(entity);
+								*object = prop.object;
+								TransformComponent* transform = generation_scene.transforms.GetComponent(entity);
+								XMFLOAT3 offset = vertex_pos;
+								offset.y += wi::math::Lerp(prop.min_y_offset, prop.max_y_offset, float_distr(chunk_data.prop_rand));
+								transform->Translate(offset);
+								const float scaling = wi::math::Lerp(prop.min_size, prop.max_size, float_distr(chunk_data.prop_rand));
+								transform->Scale(XMFLOAT3(scaling, scaling, scaling));
+								transform->RotateRollPitchYaw(XMFLOAT3(0, XM_2PI * float_distr(chunk_data.prop_rand), 0));
+								transform->UpdateTransform();
+								generation_scene.Component_Attach(entity, chunk_data.entity);
+							}
+						}
+					}
+				}
+
+				place_grass();
+
+				if (timer.elapsed_milliseconds() > generation_time_budget_milliseconds)
+				{
+					// The rest of the requests will be generated in the next frames:
+					break;
+				}
+			}
+
+		});
+
+	}
+
+	void Terrain::Generation_Cancel()
+	{
+		generation_cancelled.store(true); // tell the generation thread that work must be stopped
+		wi::jobsystem::Wait(generation_workload); // waits until generation thread exits
+		generation_cancelled.store(false); // the next generation can run
+	}
+
+	void Terrain::BakeVirtualTexturesToFiles()
+	{
+		if (terrainEntity == INVALID_ENTITY)
+		{
+			return;
+		}
+
+		wi::jobsystem::context ctx;
+
+		static const std::string extension = "PNG";
+
+		for (auto it = chunks.begin(); it != chunks.end(); it++)
+		{
+			const Chunk& chunk = it->first;
+			ChunkData& chunk_data = it->second;
+			MaterialComponent* material = scene->materials.GetComponent(chunk_data.entity);
+			if (material != nullptr)
+			{
+				for (int i = 0; i < MaterialComponent::TEXTURESLOT_COUNT; ++i)
+				{
+					auto& tex = material->textures[i];
+					switch (i)
+					{
+					case MaterialComponent::BASECOLORMAP:
+					case MaterialComponent::SURFACEMAP:
+					case MaterialComponent::NORMALMAP:
+						if (tex.name.empty() && tex.GetGPUResource() != nullptr)
+						{
+							wi::vector<uint8_t> filedata;
+							if (wi::helper::saveTextureToMemory(tex.resource.GetTexture(), filedata))
+							{
+								tex.resource.SetFileData(std::move(filedata));
+								wi::jobsystem::Execute(ctx, [i, &tex, chunk](wi::jobsystem::JobArgs args) {
+									wi::vector<uint8_t> filedata_ktx2;
+									if (wi::helper::saveTextureToMemoryFile(tex.resource.GetFileData(), tex.resource.GetTexture().desc, extension, filedata_ktx2))
+									{
+										tex.name = std::to_string(chunk.x) + "_" + std::to_string(chunk.z);
+										switch (i)
+										{
+										case MaterialComponent::BASECOLORMAP:
+											tex.name += "_basecolormap";
+											break;
+										case MaterialComponent::SURFACEMAP:
+											tex.name += "_surfacemap";
+											break;
+										case MaterialComponent::NORMALMAP:
+											tex.name += "_normalmap";
+											break;
+										default:
+											break;
+										}
+										tex.name += "." + extension;
+										tex.resource = wi::resourcemanager::Load(tex.name, wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA, filedata_ktx2.data(), filedata_ktx2.size());
+									}
+									});
+							}
+						}
+						break;
+					default:
+						break;
+					}
+				}
+			}
+		}
+
+		wi::helper::messageBox("Baking terrain virtual textures, this could take a while!", "Attention!");
+
+		wi::jobsystem::Wait(ctx);
+
+		for (auto it = chunks.begin(); it != chunks.end(); it++)
+		{
+			const Chunk& chunk = it->first;
+			ChunkData& chunk_data = it->second;
+			MaterialComponent* material = scene->materials.GetComponent(chunk_data.entity);
+			if (material != nullptr)
+			{
+				material->CreateRenderData();
+			}
+		}
+	}
+
+	void Terrain::ComputeHeights(const float* world_x, const float* world_z, float* heights, size_t count) const
+	{
+		const XMVECTOR zero = XMVectorZero();
+		const XMVECTOR one = XMVectorReplicate(1);
+		const XMVECTOR half = XMVectorReplicate(0.5f);
+		for (size_t i = 0; i < count; i += 4)
+		{
+			// The last group is padded by repeating the last position:
+			XMFLOAT4 lanes_x;
+			XMFLOAT4 lanes_z;
+			for (size_t lane = 0; lane < 4; ++lane)
+			{
+				const size_t idx = std::min(i + lane, count - 1);
+				(&lanes_x.x)[lane] = world_x[idx];
+				(&lanes_z.x)[lane] = world_z[idx];
+			}
+			const XMVECTOR X = XMLoadFloat4(&lanes_x);
+			const XMVECTOR Z = XMLoadFloat4(&lanes_z);
+
+			XMVECTOR height = zero;
+			if (perlinBlend > 0)
+			{
+				const XMVECTOR noise = perlin.compute(XMVectorScale(X, perlinFrequency), XMVectorScale(Z, perlinFrequency), zero, perlinOctaves);
+				height = XMVectorAdd(height, XMVectorScale(XMVectorAdd(XMVectorMultiply(noise, half), half), perlinBlend));
+			}
+			if (voronoiBlend > 0)
+			{
+				XMVECTOR voronoi_x = XMVectorScale(X, voronoiFrequency);
+				XMVECTOR voronoi_z = XMVectorScale(Z, voronoiFrequency);
+				if (voronoiPerturbation > 0)
+				{
+					const XMVECTOR angle = XMVectorScale(perlin.compute(voronoi_x, voronoi_z, zero, 6), XM_2PI);
+					XMVECTOR sin;
+					XMVECTOR cos;
+					XMVectorSinCos(&sin, &cos, angle);
+					voronoi_x = XMVectorAdd(voronoi_x, XMVectorScale(sin, voronoiPerturbation));
+					voronoi_z = XMVectorAdd(voronoi_z, XMVectorScale(cos, voronoiPerturbation));
+				}
+				XMFLOAT4 lanes_voronoi_x;
+				XMFLOAT4 lanes_voronoi_z;
+				XMFLOAT4 distance;
+				XMStoreFloat4(&lanes_voronoi_x, voronoi_x);
+				XMStoreFloat4(&lanes_voronoi_z, voronoi_z);
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					(&distance.x)[lane] = wi::noise::voronoi::compute((&lanes_voronoi_x.x)[lane], (&lanes_voronoi_z.x)[lane], (float)seed).distance;
+				}
+				const XMVECTOR fade = XMVectorSaturate(XMVectorScale(XMVectorSubtract(XMLoadFloat4(&distance), XMVectorReplicate(voronoiShape)), voronoiFade));
+				const XMVECTOR weight = XMVectorPow(XMVectorSubtract(one, fade), XMVectorReplicate(std::max(0.0001f, voronoiFalloff)));
+				height = XMVectorMultiply(height, XMVectorScale(weight, voronoiBlend));
+			}
+
+			XMFLOAT4 lanes_height;
+			XMStoreFloat4(&lanes_height, height);
+			if (!heightmap.data.empty())
+			{
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					const XMFLOAT2 pixel = XMFLOAT2((&lanes_x.x)[lane] + heightmap.width * 0.5f, (&lanes_z.x)[lane] + heightmap.height * 0.5f);
+					if (pixel.x >= 0 && pixel.x < heightmap.width && pixel.y >= 0 && pixel.y < heightmap.height)
+					{
+						const int idx = int(pixel.x) + int(pixel.y) * heightmap.width;
+						(&lanes_height.x)[lane] = ((float)heightmap.data[idx] / 255.0f) * heightmapBlend;
+					}
+				}
+			}
+
+			for (size_t lane = 0; lane < 4 && i + lane < count; ++lane)
+			{
+				heights[i + lane] = wi::math::Lerp(bottomLevel, topLevel, (&lanes_height.x)[lane]);
+			}
+		}
+	}
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiScene.h"
+#include "wiHairParticle.h"
+#include "wiNoise.h"
+#include "wiJobSystem.h"
+#include "wiGraphicsDevice.h"
+#include "wiUnorderedMap.h"
+#include "wiVector.h"
+
+#include <random>
+#include <string>
+#include <atomic>
+
+namespace wi::terrain
+{
+	struct Chunk
+	{
+		int x, z;
+		constexpr bool operator==(const Chunk& other) const
+		{
+			return (x == other.x) && (z == other.z);
+		}
+		inline size_t compute_hash() const
+		{
+			return ((std::hash<int>()(x) ^ (std::hash<int>()(z) << 1)) >> 1);
+		}
+	};
+}
+
+namespace std
+{
+	template <>
+	struct hash<wi::terrain::Chunk>
+	{
+		inline size_t operator()(const wi::terrain::Chunk& chunk) const
+		{
+			return chunk.compute_hash();
+		}
+	};
+}
+
+namespace wi::terrain
+{
+	inline static const int chunk_width = 64 + 3; // + 3: filler vertices for lod apron and grid perimeter
+	inline static const float chunk_half_width = (chunk_width - 1) * 0.5f;
+	inline static const float chunk_width_rcp = 1.0f / (chunk_width - 1);
+	inline static const uint32_t vertexCount = chunk_width * chunk_width;
+	inline static const int max_lod = (int)std::log2(chunk_width - 3) + 1;
+	inline static const float chunk_scale = 1;
+	inline static const float chunk_scale_rcp = 1.0f / chunk_scale;
+
+	struct ChunkData
+	{
+		wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+		wi::ecs::Entity grass_entity = wi::ecs::INVALID_ENTITY;
+		wi::HairParticleSystem grass;
+		bool grass_exists = false;
+		std::mt19937 prop_rand;
+		wi::Color region_weights[vertexCount] = {};
+		wi::graphics::Texture region_weights_texture;
+		uint32_t virtual_texture_resolution = 0;
+		wi::primitive::Sphere sphere;
+	};
+
+	struct Prop
+	{
+		std::string name = "prop";
+		wi::ecs::Entity mesh_entity = wi::ecs::INVALID_ENTITY;
+		wi::scene::ObjectComponent object;
+		int min_count_per_chunk = 0; // a chunk will try to generate min this many props of this type
+		int max_count_per_chunk = 10; // a chunk will try to generate max this many props of this type
+		int region = 0; // region selection in range [0,3] (0: base/grass, 1: slopes, 2: low altitude (bottom level-0), 3: high altitude (0-top level))
+		float region_power = 1; // region weight affection power factor
+		float noise_frequency = 1; // perlin noise's frequency for placement factor
+		float noise_power = 1; // perlin noise's power
+		float threshold = 0.5f; // the chance of placement (higher is less chance)
+		float min_size = 1; // scaling randomization range min
+		float max_size = 1; // scaling randomization range max
+		float min_y_offset = 0; // min randomized offset on Y axis
+		float max_y_offset = 0; // max randomized offset on Y axis
+	};
+
+	struct Heightmap
+	{
+		wi::vector<uint8_t> data;
+		int width = 0;
+		int height = 0;
+	};
+
+	// Streaming terrain: chunks are generated around a center chunk on a background job and merged into the scene
+	//	Missing chunks are requested every frame, ordered by distance and weighted by camera visibility,
+	//	and generated in batches until the per frame time budget runs out. Chunks that are farther than
+	//	the generation distance + removal distance are evicted, and generated again when they are needed.
+	struct Terrain
+	{
+		wi::ecs::Entity terrainEntity = wi::ecs::INVALID_ENTITY;
+		wi::scene::Scene* scene = &wi::scene::GetScene(); // by default it uses the global scene, but this can be changed
+		wi::scene::MaterialComponent material_Base;
+		wi::scene::MaterialComponent material_Slope;
+		wi::scene::MaterialComponent material_LowAltitude;
+		wi::scene::MaterialComponent material_HighAltitude;
+		wi::scene::MaterialComponent material_GrassParticle;
+		wi::HairParticleSystem grass_properties;
+		wi::unordered_map<Chunk, ChunkData> chunks;
+		wi::vector<uint32_t> indices;
+		struct LOD
+		{
+			uint32_t indexOffset = 0;
+			uint32_t indexCount = 0;
+		};
+		wi::vector<LOD> lods;
+		wi::noise::Perlin perlin;
+		Chunk center_chunk = {};
+		Heightmap heightmap;
+		wi::vector<Prop> props;
+
+		// Generation parameters:
+		bool center_to_cam = true; // automatically generate chunks around camera, this sets the center chunk to camera position
+		bool removal = true; // automatically evict chunks that are farther than generation + removal_distance
+		float lod_multiplier = 0.005f; // mesh LOD distance multiplier of chunk objects
+		float texlod = 0.01f; // virtual texture LOD distance multiplier
+		int generation = 12; // how far out chunks will be generated around the center chunk (in number of chunks)
+		int removal_distance = 2; // chunks are evicted when they are this many chunks farther than the generation distance
+		float outside_frustum_priority = 4; // distance multiplier of chunks that are not visible by the camera, higher values generate visible chunks sooner
+		uint32_t seed = 3926;
+		float bottomLevel = -60;
+		float topLevel = 380;
+		float heightmapBlend = 1;
+		float perlinBlend = 0.5f;
+		float perlinFrequency = 0.0008f;
+		int perlinOctaves = 6;
+		float voronoiBlend = 0.5f;
+		float voronoiFrequency = 0.001f;
+		float voronoiFade = 2.59f;
+		float voronoiShape = 0.7f;
+		float voronoiFalloff = 6;
+		float voronoiPerturbation = 0.1f;
+		float region1 = 1; // slope region falloff power
+		float region2 = 2; // low altitude region falloff power
+		float region3 = 8; // high altitude region falloff power
+
+		// For generating scene on a background thread:
+		wi::scene::Scene generation_scene; // The background generation thread can safely add things to this, it will be merged into the main scene when it is safe to do so
+		wi::jobsystem::context generation_workload;
+		std::atomic_bool generation_cancelled;
+		float generation_time_budget_milliseconds = 12; // after this much time, the generation thread will stop and continue in the next frame
+
+		// Chunk requests of the current frame, sorted by priority (lower value is generated sooner):
+		struct ChunkRequest
+		{
+			Chunk chunk;
+			float priority = 0;
+		};
+		wi::vector<ChunkRequest> requests;
+
+		// Virtual texture updates will be batched like:
+		//	1) Execute all barriers (dst: UNORDERED_ACCESS)
+		//	2) Execute all compute shaders
+		//	3) Execute all barriers (dst: SHADER_RESOURCE)
+		wi::vector<Chunk> virtual_texture_updates;
+		wi::vector<wi::graphics::GPUBarrier> virtual_texture_barriers_begin;
+		wi::vector<wi::graphics::GPUBarrier> virtual_texture_barriers_end;
+
+		// Restarts the terrain generation from scratch
+		//	This will remove previously existing terrain
+		void Generation_Restart();
+		// This will run the actual generation tasks, call it once per frame
+		void Generation_Update(const wi::scene::CameraComponent& camera);
+		// Tells the generation thread that it should be cancelled and blocks until that is confirmed
+		void Generation_Cancel();
+		// The virtual textures will be compressed and saved into resources. They can be serialized from there
+		void BakeVirtualTexturesToFiles();
+
+		// Computes terrain heights for count world space positions on the XZ plane, 4 positions at a time
+		void ComputeHeights(const float* world_x, const float* world_z, float* heights, size_t count) const;
+	};
+}